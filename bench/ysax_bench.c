@@ -0,0 +1,489 @@
+/*
+ * ysax_bench
+ * Throughput and memory use of the SAX and DOM parsers, on generated corpora:
+ * deep nesting, attribute-heavy elements, long texts, many small records,
+ * and (on demand) a file of several GB made of records. Corpora are written
+ * once in a directory, and generated the same way on every run, so that
+ * results could be compared between revisions.
+ *
+ * Each measure runs in a child process, which reads the corpus file once per
+ * run and keeps the best run. Compiled normally, it gives the throughput and
+ * the peak RSS of the child (pages of mapped files included); compiled with
+ * YMEM_PROFILE, it gives the allocations done through the library allocator
+ * (see ymem.h) instead.
+ *
+ * Usage: ysax_bench [-d directory] [-s size in MB] [-g size in GB] [-r runs]
+ *	-d	Directory of the corpora (default bench/corpora).
+ *	-s	Size of the corpora (default 32).
+ *	-g	Size of the huge corpus (default 0: not used).
+ *	-r	Number of runs of each measure (default 3).
+ * Output: one line per corpus and parser:
+ *	corpus size_MB parser MB/s peak_RSS_MB
+ *	corpus size_MB parser allocs/MB alloc_KB/MB	(with YMEM_PROFILE)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include "ychrono.h"
+#include "ymem.h"
+#include "ysax.h"
+#include "ydom.h"
+
+/** @define _BENCH_DEPTH Depth of the elements of the deep corpus. */
+#define _BENCH_DEPTH	512
+
+/** @define _BENCH_MB Number of bytes in a MB. */
+#define _BENCH_MB	(1024.0 * 1024.0)
+
+/**
+ * @typedef	_bench_corpus_t
+ *		Generated corpus.
+ * @field	name	Name of the corpus.
+ * @field	write	Function which writes the i-th part of the corpus, and
+ *			returns the number of written bytes.
+ * @field	records	YTRUE if the corpus is made of <r> records.
+ * @field	huge	YTRUE for the corpus sized in GB.
+ */
+typedef struct _bench_corpus_s {
+	const char	*name;
+	int		(*write)(FILE *file, unsigned long i);
+	ybool_t		records;
+	ybool_t		huge;
+} _bench_corpus_t;
+
+/**
+ * @typedef	_bench_parser_t
+ *		Parser to measure.
+ * @field	name		Name of the parser.
+ * @field	parse		Function which parses a file.
+ * @field	records_only	YTRUE if the parser needs a records corpus.
+ * @field	whole_file	YTRUE if the parser holds the whole document
+ *				(it is not used on the huge corpus).
+ */
+typedef struct _bench_parser_s {
+	const char	*name;
+	yerr_t		(*parse)(const char *filename);
+	ybool_t		records_only;
+	ybool_t		whole_file;
+} _bench_parser_t;
+
+/* *** definition of private functions *** */
+static const char *_bench_corpus(const char *dir, const _bench_corpus_t *corpus, size_t size);
+static void _bench_measure(const char *filename, const _bench_corpus_t *corpus,
+			   const _bench_parser_t *parser, int nbr_runs);
+static void _bench_child(const char *filename, const _bench_corpus_t *corpus,
+			 const _bench_parser_t *parser, int nbr_runs);
+static void _bench_alloc_stats(size_t *nbr_allocs, size_t *nbr_bytes);
+static const char *_bench_word(void);
+static int _bench_write_deep(FILE *file, unsigned long i);
+static int _bench_write_attributes(FILE *file, unsigned long i);
+static int _bench_write_text(FILE *file, unsigned long i);
+static int _bench_write_records(FILE *file, unsigned long i);
+static yerr_t _bench_parse_sax(const char *filename);
+static yerr_t _bench_parse_sax_span(const char *filename);
+static yerr_t _bench_parse_dom(const char *filename);
+static yerr_t _bench_parse_records(const char *filename);
+static void _bench_open(ysax_t *sax, char *name, yvect_t attrs);
+static void _bench_string(ysax_t *sax, char *str);
+static void _bench_process_instr(ysax_t *sax, char *target, char *content);
+static void _bench_span_open(ysax_t *sax, ysax_span_t name, const ysax_span_attr_t *attrs,
+			     size_t nbr_attrs);
+static void _bench_span(ysax_t *sax, ysax_span_t span);
+static void _bench_span_process_instr(ysax_t *sax, ysax_span_t target, ysax_span_t content);
+static void _bench_record(ydom_node_t *node, void *data);
+
+/** @var _bench_corpora Generated corpora. */
+static const _bench_corpus_t _bench_corpora[] = {
+	{"deep", _bench_write_deep, YFALSE, YFALSE},
+	{"attributes", _bench_write_attributes, YFALSE, YFALSE},
+	{"text", _bench_write_text, YFALSE, YFALSE},
+	{"records", _bench_write_records, YTRUE, YFALSE},
+	{"huge", _bench_write_records, YTRUE, YTRUE}
+};
+
+/** @var _bench_parsers Measured parsers. */
+static const _bench_parser_t _bench_parsers[] = {
+	{"sax", _bench_parse_sax, YFALSE, YFALSE},
+	{"sax_span", _bench_parse_sax_span, YFALSE, YFALSE},
+	{"dom", _bench_parse_dom, YFALSE, YTRUE},
+	{"dom_records", _bench_parse_records, YTRUE, YFALSE}
+};
+
+/** @var _bench_words Words of the generated texts. */
+static const char *_bench_words[] = {
+	"lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing", "elit",
+	"sed", "do", "eiusmod", "tempor", "incididunt", "ut", "labore", "et", "dolore",
+	"magna", "aliqua", "enim", "ad", "minim", "veniam", "quis", "nostrud",
+	"exercitation", "ullamco", "laboris", "nisi", "aliquip", "ex", "ea", "commodo",
+	"consequat", "&amp;", "caf\xc3\xa9", "na\xc3\xafve", "\xe6\x97\xa5\xe6\x9c\xac"
+};
+
+/** @var _bench_seed State of the generator of words; reset for each corpus. */
+static unsigned long _bench_seed;
+
+/*
+ * main()
+ * Generate the corpora, and measure each parser on each of them.
+ */
+int main(int argc, char **argv) {
+	const char	*dir = "bench/corpora", *filename;
+	size_t		size = 32, huge_size = 0, i, j;
+	int		nbr_runs = 3, opt;
+
+	while ((opt = getopt(argc, argv, "d:s:g:r:")) != -1) {
+		if (opt == 'd')
+			dir = optarg;
+		else if (opt == 's')
+			size = (size_t)atol(optarg);
+		else if (opt == 'g')
+			huge_size = (size_t)atol(optarg) * 1024;
+		else if (opt == 'r')
+			nbr_runs = atoi(optarg);
+		else {
+			fprintf(stderr, "Usage: %s [-d directory] [-s size_MB] [-g size_GB] [-r runs]\n",
+				argv[0]);
+			return (1);
+		}
+	}
+#ifdef YMEM_PROFILE
+	/* allocations don't change from one run to the other */
+	nbr_runs = 1;
+	printf("# corpus size_MB parser allocs/MB alloc_KB/MB\n");
+#else
+	printf("# corpus size_MB parser MB/s peak_RSS_MB\n");
+#endif /* YMEM_PROFILE */
+	mkdir(dir, 0755);
+	for (i = 0; i < ARRAY_SIZE(_bench_corpora); i++) {
+		if (_bench_corpora[i].huge && !huge_size)
+			continue;
+		if ((filename = _bench_corpus(dir, &_bench_corpora[i],
+					      _bench_corpora[i].huge ? huge_size : size)) == NULL)
+			return (1);
+		for (j = 0; j < ARRAY_SIZE(_bench_parsers); j++) {
+			if ((_bench_parsers[j].records_only && !_bench_corpora[i].records) ||
+			    (_bench_parsers[j].whole_file && _bench_corpora[i].huge))
+				continue;
+			_bench_measure(filename, &_bench_corpora[i], &_bench_parsers[j], nbr_runs);
+		}
+	}
+	return (0);
+}
+
+/* *************** PRIVATE FUNCTIONS ************** */
+/*
+ * _bench_corpus()
+ * Write a corpus file of (about) the given size in MB, unless it already
+ * exists. Return its name, or NULL if an error occurs.
+ */
+static const char *_bench_corpus(const char *dir, const _bench_corpus_t *corpus, size_t size) {
+	static char	filename[1024];
+	struct stat	st;
+	FILE		*file;
+	double		len;
+	unsigned long	i;
+	int		res;
+
+	snprintf(filename, sizeof(filename), "%s/%s-%luMB.xml", dir, corpus->name, (unsigned long)size);
+	if (!stat(filename, &st) && st.st_size >= (off_t)size * 1024 * 1024)
+		return (filename);
+	if ((file = fopen(filename, "w")) == NULL) {
+		perror(filename);
+		return (NULL);
+	}
+	_bench_seed = 1;
+	len = fprintf(file, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<corpus>\n");
+	for (i = 0; len < size * _BENCH_MB; i++) {
+		if ((res = corpus->write(file, i)) < 0)
+			break;
+		len += res;
+	}
+	fprintf(file, "</corpus>\n");
+	if (fclose(file) || len < size * _BENCH_MB) {
+		perror(filename);
+		return (NULL);
+	}
+	return (filename);
+}
+
+/*
+ * _bench_measure()
+ * Run the measure of a parser on a corpus in a child process, so that the
+ * peak RSS (and the allocations) are its own.
+ */
+static void _bench_measure(const char *filename, const _bench_corpus_t *corpus,
+			   const _bench_parser_t *parser, int nbr_runs) {
+	pid_t	pid;
+	int	status;
+
+	fflush(stdout);
+	if ((pid = fork()) == -1) {
+		perror("fork");
+		return;
+	}
+	if (pid == 0) {
+		_bench_child(filename, corpus, parser, nbr_runs);
+		exit(0);
+	}
+	if (waitpid(pid, &status, 0) == -1 || !WIFEXITED(status) || WEXITSTATUS(status))
+		fprintf(stderr, "%s %s: failed\n", corpus->name, parser->name);
+}
+
+/*
+ * _bench_child()
+ * Parse a corpus several times, and print the measures.
+ */
+static void _bench_child(const char *filename, const _bench_corpus_t *corpus,
+			 const _bench_parser_t *parser, int nbr_runs) {
+	ychrono_t	*chrono = ychrono_new();
+	struct stat	st;
+	struct rusage	usage;
+	double		size_mb, mbps, best = 0.0;
+	size_t		nbr_allocs, nbr_bytes, allocs_before, bytes_before;
+	long		usec;
+	int		run;
+
+	if (stat(filename, &st))
+		exit(1);
+	size_mb = st.st_size / _BENCH_MB;
+	_bench_alloc_stats(&allocs_before, &bytes_before);
+	for (run = 0; run < nbr_runs; run++) {
+		ychrono_reset(chrono);
+		ychrono_start(chrono);
+		if (parser->parse(filename) != YENOERR) {
+			fprintf(stderr, "%s %s: parse error\n", corpus->name, parser->name);
+			exit(1);
+		}
+		ychrono_stop(chrono);
+		usec = ychrono_get_usec(chrono);
+		if ((mbps = size_mb / ((usec > 0 ? usec : 1) / 1e6)) > best)
+			best = mbps;
+	}
+	ychrono_del(chrono);
+	_bench_alloc_stats(&nbr_allocs, &nbr_bytes);
+#ifdef YMEM_PROFILE
+	(void)usage;
+	(void)best;
+	printf("%s %.0f %s %.1f %.1f\n", corpus->name, size_mb, parser->name,
+	       (nbr_allocs - allocs_before) / (size_mb * nbr_runs),
+	       (nbr_bytes - bytes_before) / 1024.0 / (size_mb * nbr_runs));
+#else
+	getrusage(RUSAGE_SELF, &usage);
+	printf("%s %.0f %s %.1f %.1f\n", corpus->name, size_mb, parser->name, best,
+	       usage.ru_maxrss / 1024.0);
+#endif /* YMEM_PROFILE */
+}
+
+/*
+ * _bench_alloc_stats()
+ * Sum the number of allocations and of allocated bytes of all tags.
+ */
+static void _bench_alloc_stats(size_t *nbr_allocs, size_t *nbr_bytes) {
+	ymem_stats_t	stats;
+	int		tag;
+
+	*nbr_allocs = *nbr_bytes = 0;
+	for (tag = 0; tag < YMEM_NBR_TAGS; tag++) {
+		ymem_get_stats((ymem_tag_t)tag, &stats);
+		*nbr_allocs += stats.nbr_allocs;
+		*nbr_bytes += stats.total_bytes;
+	}
+}
+
+/*
+ * _bench_word()
+ * Return a word of the generated texts; the same sequence of words is
+ * given for each corpus.
+ */
+static const char *_bench_word() {
+	_bench_seed = _bench_seed * 1103515245UL + 12345UL;
+	return (_bench_words[((_bench_seed >> 16) & 0x7fff) % ARRAY_SIZE(_bench_words)]);
+}
+
+/*
+ * _bench_write_deep()
+ * Write elements nested _BENCH_DEPTH levels deep, with a little text.
+ */
+static int _bench_write_deep(FILE *file, unsigned long i) {
+	int	len = 0, depth;
+
+	for (depth = 0; depth < _BENCH_DEPTH; depth++)
+		len += fprintf(file, "<n d=\"%d\">%s", depth, _bench_word());
+	for (depth = 0; depth < _BENCH_DEPTH; depth++)
+		len += fprintf(file, "</n>");
+	len += fprintf(file, "<!-- %lu -->\n", i);
+	return (len);
+}
+
+/*
+ * _bench_write_attributes()
+ * Write an empty element with many attributes.
+ */
+static int _bench_write_attributes(FILE *file, unsigned long i) {
+	return (fprintf(file, "<item id=\"%lu\" name=\"%s-%s\" category=\"%s %s\" price=\"%lu.99\" "
+			"currency=\"EUR\" url=\"http://www.example.com/%s/%lu.html\" "
+			"note='%s %s %s'/>\n", i, _bench_word(), _bench_word(), _bench_word(),
+			_bench_word(), i % 1000, _bench_word(), i, _bench_word(), _bench_word(),
+			_bench_word()));
+}
+
+/*
+ * _bench_write_text()
+ * Write a paragraph of text.
+ */
+static int _bench_write_text(FILE *file, unsigned long i) {
+	int	len, nbr_words;
+
+	len = fprintf(file, "<p id=\"%lu\">", i);
+	for (nbr_words = 60 + (int)(i % 60); nbr_words; nbr_words--)
+		len += fprintf(file, "%s ", _bench_word());
+	len += fprintf(file, "<![CDATA[%s]]></p>\n", _bench_word());
+	return (len);
+}
+
+/*
+ * _bench_write_records()
+ * Write a small record.
+ */
+static int _bench_write_records(FILE *file, unsigned long i) {
+	return (fprintf(file, "<r id=\"%lu\"><name>%s %s</name><qty>%lu</qty>"
+			"<tags><t>%s</t><t>%s</t></tags></r>\n", i, _bench_word(),
+			_bench_word(), i % 97, _bench_word(), _bench_word()));
+}
+
+/*
+ * _bench_parse_sax()
+ * Parse a file with string handlers, which only free their parameters.
+ */
+static yerr_t _bench_parse_sax(const char *filename) {
+	ysax_t	*sax;
+	yerr_t	res;
+
+	if ((sax = ysax_new(NULL)) == NULL)
+		return (YENOMEM);
+	ysax_set_tag_hdlr(sax, _bench_open, _bench_string);
+	ysax_set_inside_text_hdlr(sax, _bench_string);
+	ysax_set_comment_hdlr(sax, _bench_string);
+	ysax_set_cdata_hdlr(sax, _bench_string);
+	ysax_set_process_instr_hdlr(sax, _bench_process_instr);
+	res = ysax_read_file(sax, filename);
+	ysax_del(sax);
+	return (res);
+}
+
+/*
+ * _bench_parse_sax_span()
+ * Parse a file with span handlers, which do nothing.
+ */
+static yerr_t _bench_parse_sax_span(const char *filename) {
+	ysax_t	*sax;
+	yerr_t	res;
+
+	if ((sax = ysax_new(NULL)) == NULL)
+		return (YENOMEM);
+	ysax_set_span_tag_hdlr(sax, _bench_span_open, _bench_span);
+	ysax_set_span_inside_text_hdlr(sax, _bench_span);
+	ysax_set_span_comment_hdlr(sax, _bench_span);
+	ysax_set_span_cdata_hdlr(sax, _bench_span);
+	ysax_set_span_process_instr_hdlr(sax, _bench_span_process_instr);
+	res = ysax_read_file(sax, filename);
+	ysax_del(sax);
+	return (res);
+}
+
+/*
+ * _bench_parse_dom()
+ * Parse a file into a DOM, and delete it.
+ */
+static yerr_t _bench_parse_dom(const char *filename) {
+	ydom_t	*dom;
+	yerr_t	res;
+
+	if ((dom = ydom_new()) == NULL)
+		return (YENOMEM);
+	res = ydom_read_file(dom, filename);
+	ydom_del(dom);
+	return (res);
+}
+
+/*
+ * _bench_parse_records()
+ * Parse the records of a file into DOMs, on one thread per processor.
+ */
+static yerr_t _bench_parse_records(const char *filename) {
+	return (ydom_read_records(filename, "r", 0, _bench_record, NULL));
+}
+
+/*
+ * _bench_open()
+ * Open tag handler.
+ */
+static void _bench_open(ysax_t *sax, char *name, yvect_t attrs) {
+	(void)sax;
+	free0(name);
+	yv_del(&attrs, ysax_free_attr, NULL);
+}
+
+/*
+ * _bench_string()
+ * Close tag, text, comment and CDATA handler.
+ */
+static void _bench_string(ysax_t *sax, char *str) {
+	(void)sax;
+	free0(str);
+}
+
+/*
+ * _bench_process_instr()
+ * Processing instruction handler.
+ */
+static void _bench_process_instr(ysax_t *sax, char *target, char *content) {
+	(void)sax;
+	free0(target);
+	free0(content);
+}
+
+/*
+ * _bench_span_open()
+ * Span open tag handler.
+ */
+static void _bench_span_open(ysax_t *sax, ysax_span_t name, const ysax_span_attr_t *attrs,
+			     size_t nbr_attrs) {
+	(void)sax;
+	(void)name;
+	(void)attrs;
+	(void)nbr_attrs;
+}
+
+/*
+ * _bench_span()
+ * Span close tag, text, comment and CDATA handler.
+ */
+static void _bench_span(ysax_t *sax, ysax_span_t span) {
+	(void)sax;
+	(void)span;
+}
+
+/*
+ * _bench_span_process_instr()
+ * Span processing instruction handler.
+ */
+static void _bench_span_process_instr(ysax_t *sax, ysax_span_t target, ysax_span_t content) {
+	(void)sax;
+	(void)target;
+	(void)content;
+}
+
+/*
+ * _bench_record()
+ * Record handler.
+ */
+static void _bench_record(ydom_node_t *node, void *data) {
+	(void)node;
+	(void)data;
+}
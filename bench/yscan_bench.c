@@ -0,0 +1,175 @@
+/*
+ * yscan_bench
+ * Throughput of the structural character scanner and of the SAX parser, for
+ * each implementation of yscan_find(), on generated feeds.
+ *
+ * Usage: yscan_bench [size in MB, default 32]
+ * Output: one line per feed and implementation:
+ *	feed impl scan_MB/s parse_MB/s
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ychrono.h"
+#include "yscan.h"
+#include "ysax.h"
+
+/* *** definition of private functions *** */
+static char *_bench_feed(const char *name, size_t size, size_t *len);
+static double _bench_scan(const char *feed, size_t len);
+static double _bench_parse(char *feed, size_t len);
+static double _bench_mbps(size_t len, ychrono_t *chrono);
+static void _bench_open(ysax_t *sax, char *name, yvect_t attrs);
+static void _bench_string(ysax_t *sax, char *str);
+static void _bench_process_instr(ysax_t *sax, char *target, char *content);
+
+/** @var _bench_feeds Names of the generated feeds. */
+static const char *_bench_feeds[] = {"text", "attributes", "records", NULL};
+/** @var _bench_impls Implementations to compare. */
+static const yscan_impl_t _bench_impls[] = {YSCAN_SCALAR, YSCAN_SSE2, YSCAN_AVX2};
+
+/*
+ * main()
+ * Run the benchmark on each feed, with each implementation supported by
+ * the processor.
+ */
+int main(int argc, char **argv) {
+	size_t	size, len, i, j;
+	char	*feed;
+
+	size = (size_t)((argc > 1) ? atoi(argv[1]) : 32) * 1024 * 1024;
+	printf("# feed impl scan_MB/s parse_MB/s\n");
+	for (i = 0; _bench_feeds[i] != NULL; i++) {
+		if ((feed = _bench_feed(_bench_feeds[i], size, &len)) == NULL) {
+			fprintf(stderr, "Unable to allocate memory\n");
+			return (1);
+		}
+		for (j = 0; j < ARRAY_SIZE(_bench_impls); j++) {
+			if (yscan_set_implementation(_bench_impls[j]) != YENOERR)
+				continue;
+			printf("%s %s %.1f %.1f\n", _bench_feeds[i], yscan_implementation_name(),
+			       _bench_scan(feed, len), _bench_parse(feed, len));
+		}
+		free(feed);
+	}
+	return (0);
+}
+
+/* *************** PRIVATE FUNCTIONS ************** */
+/*
+ * _bench_feed()
+ * Generate a feed of about the given size: long texts, attribute-heavy
+ * empty elements, or many small records.
+ */
+static char *_bench_feed(const char *name, size_t size, size_t *len) {
+	char	*feed, *pt;
+	size_t	i;
+
+	if ((feed = (char*)malloc(size + 4096)) == NULL)
+		return (NULL);
+	pt = feed + sprintf(feed, "<?xml version=\"1.0\"?>\n<feed>\n");
+	for (i = 0; (size_t)(pt - feed) < size; i++) {
+		if (!strcmp(name, "text"))
+			pt += sprintf(pt, "<p id=\"%lu\">Lorem ipsum dolor sit amet, consectetur "
+				      "adipiscing elit, sed do eiusmod tempor incididunt ut labore et "
+				      "dolore magna aliqua. Ut enim ad minim veniam, quis nostrud "
+				      "exercitation ullamco laboris nisi ut aliquip ex ea commodo "
+				      "consequat. Duis aute irure dolor in reprehenderit in voluptate "
+				      "velit esse cillum dolore eu fugiat nulla pariatur.</p>\n",
+				      (unsigned long)i);
+		else if (!strcmp(name, "attributes"))
+			pt += sprintf(pt, "<item id=\"%lu\" name=\"product-%lu\" category=\"tools and "
+				      "hardware\" price=\"%lu.99\" currency=\"EUR\" url=\"http://"
+				      "www.example.com/catalog/product-%lu.html\"/>\n",
+				      (unsigned long)i, (unsigned long)i, (unsigned long)(i % 1000),
+				      (unsigned long)i);
+		else
+			pt += sprintf(pt, "<r><a>%lu</a><b>x</b><c/></r>\n", (unsigned long)i);
+	}
+	pt += sprintf(pt, "</feed>\n");
+	*len = pt - feed;
+	return (feed);
+}
+
+/*
+ * _bench_scan()
+ * Find all the structural characters of a feed; return the throughput.
+ */
+static double _bench_scan(const char *feed, size_t len) {
+	yscan_set_t	set;
+	ychrono_t	*chrono = ychrono_new();
+	const char	*pt, *end = feed + len;
+	size_t		nbr_found = 0;
+	double		result;
+
+	yscan_set_init(&set, "<>&\"'\t\n\r", 8);
+	ychrono_start(chrono);
+	for (pt = feed; (pt = yscan_find(pt, end, &set)) < end; pt++)
+		nbr_found++;
+	ychrono_stop(chrono);
+	result = _bench_mbps(len, chrono);
+	ychrono_del(chrono);
+	return (nbr_found ? result : 0.0);
+}
+
+/*
+ * _bench_parse()
+ * Parse a feed with handlers which only free their parameters; return the
+ * throughput.
+ */
+static double _bench_parse(char *feed, size_t len) {
+	ysax_t		*sax = ysax_new(NULL);
+	ychrono_t	*chrono = ychrono_new();
+	double		result;
+
+	ysax_set_tag_hdlr(sax, _bench_open, _bench_string);
+	ysax_set_inside_text_hdlr(sax, _bench_string);
+	ysax_set_process_instr_hdlr(sax, _bench_process_instr);
+	ychrono_start(chrono);
+	if (ysax_read_memory(sax, feed) != YENOERR)
+		fprintf(stderr, "Parse error\n");
+	ychrono_stop(chrono);
+	result = _bench_mbps(len, chrono);
+	ychrono_del(chrono);
+	ysax_del(sax);
+	return (result);
+}
+
+/*
+ * _bench_mbps()
+ * Convert a measure into MB/s.
+ */
+static double _bench_mbps(size_t len, ychrono_t *chrono) {
+	long	usec = ychrono_get_usec(chrono);
+
+	return ((double)len / (1024.0 * 1024.0) / ((usec > 0 ? usec : 1) / 1e6));
+}
+
+/*
+ * _bench_open()
+ * Open tag handler.
+ */
+static void _bench_open(ysax_t *sax, char *name, yvect_t attrs) {
+	(void)sax;
+	free0(name);
+	yv_del(&attrs, ysax_free_attr, NULL);
+}
+
+/*
+ * _bench_string()
+ * Close tag and text handler.
+ */
+static void _bench_string(ysax_t *sax, char *str) {
+	(void)sax;
+	free0(str);
+}
+
+/*
+ * _bench_process_instr()
+ * Processing instruction handler.
+ */
+static void _bench_process_instr(ysax_t *sax, char *target, char *content) {
+	(void)sax;
+	free0(target);
+	free0(content);
+}
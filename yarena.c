@@ -0,0 +1,266 @@
+#define YMEM_TAG	YMEM_TAG_ARENA
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "yarena.h"
+
+/** @define _YARENA_ROUND Round a size up to a multiple of YARENA_ALIGN. */
+#define _YARENA_ROUND(s)	(((s) + YARENA_ALIGN - 1) & ~((size_t)YARENA_ALIGN - 1))
+
+/** @define _YARENA_HUGE_ROUND Round a size up to a multiple of YARENA_HUGEPAGE_SIZE. */
+#define _YARENA_HUGE_ROUND(s)	(((s) + YARENA_HUGEPAGE_SIZE - 1) & ~((size_t)YARENA_HUGEPAGE_SIZE - 1))
+
+/** @define _YARENA_DATA Pointer to the first usable byte of a chunk. */
+#define _YARENA_DATA(chunk)	((char*)(chunk) + _YARENA_ROUND(sizeof(yarena_chunk_t)))
+
+/* *** definition of private functions *** */
+static yarena_t *_yarena_create(size_t chunk_size, ybool_t hugepages);
+static void *_yarena_new_chunk(yarena_t *arena, size_t size, ybool_t zeroed);
+static yarena_chunk_t *_yarena_map_chunk(size_t size);
+static void _yarena_free_chunk(yarena_t *arena, yarena_chunk_t *chunk);
+static void *_yarena_allocator_alloc(void *context, size_t size);
+static void *_yarena_allocator_alloc_raw(void *context, size_t size);
+static void _yarena_allocator_free(void *context, void *ptr);
+
+/*
+ * yarena_new()
+ * Create a new arena.
+ */
+yarena_t *yarena_new(size_t chunk_size) {
+	return (_yarena_create(_YARENA_ROUND(chunk_size ? chunk_size : YARENA_CHUNK_SIZE), YFALSE));
+}
+
+/*
+ * yarena_new_hugepages()
+ * Create a new arena whose chunks are taken from huge pages.
+ */
+yarena_t *yarena_new_hugepages(size_t chunk_size) {
+	size_t	header = _YARENA_ROUND(sizeof(yarena_chunk_t));
+
+	chunk_size = _YARENA_HUGE_ROUND(header + (chunk_size ? chunk_size : 1)) - header;
+	return (_yarena_create(chunk_size, YTRUE));
+}
+
+/*
+ * yarena_delete()
+ * Destroy an arena and all the memory it gave.
+ */
+void yarena_delete(yarena_t *arena) {
+	if (arena == NULL)
+		return;
+	yarena_reset(arena);
+	yarena_trim(arena);
+	YFREE(arena);
+}
+
+/*
+ * yarena_alloc()
+ * Allocate a zeroed memory block from an arena.
+ */
+void *yarena_alloc(yarena_t *arena, size_t size) {
+	char	*ptr;
+
+	size = _YARENA_ROUND(size ? size : 1);
+	if (arena->chunk == NULL || (size_t)(arena->chunk->end - arena->pos) < size)
+		return (_yarena_new_chunk(arena, size, YTRUE));
+	ptr = arena->pos;
+	arena->pos += size;
+	memset(ptr, 0, size);
+	return (ptr);
+}
+
+/*
+ * yarena_alloc_raw()
+ * Allocate a memory block from an arena, without zeroing it.
+ */
+void *yarena_alloc_raw(yarena_t *arena, size_t size) {
+	char	*ptr;
+
+	size = _YARENA_ROUND(size ? size : 1);
+	if (arena->chunk == NULL || (size_t)(arena->chunk->end - arena->pos) < size)
+		return (_yarena_new_chunk(arena, size, YFALSE));
+	ptr = arena->pos;
+	arena->pos += size;
+	return (ptr);
+}
+
+/*
+ * yarena_mark()
+ * Return the current position of an arena.
+ */
+void *yarena_mark(yarena_t *arena) {
+	return (arena->pos);
+}
+
+/*
+ * yarena_release()
+ * Release all the blocks allocated from an arena after a mark.
+ */
+void yarena_release(yarena_t *arena, void *mark) {
+	yarena_chunk_t	*chunk;
+	char		*pt = (char*)mark;
+
+	/* move the chunks which were started after the mark to the spare list */
+	while ((chunk = arena->chunk) != NULL &&
+	       (pt == NULL || pt < _YARENA_DATA(chunk) || pt > chunk->end)) {
+		arena->chunk = chunk->previous;
+		chunk->previous = arena->spare;
+		arena->spare = chunk;
+	}
+	if (arena->chunk == NULL) {
+		arena->oldest = NULL;
+		arena->pos = NULL;
+	} else
+		arena->pos = pt;
+}
+
+/*
+ * yarena_reset()
+ * Release all the blocks allocated from an arena.
+ */
+void yarena_reset(yarena_t *arena) {
+	if (arena->chunk == NULL)
+		return;
+	/* the whole chain is put in front of the spare list */
+	arena->oldest->previous = arena->spare;
+	arena->spare = arena->chunk;
+	arena->chunk = arena->oldest = NULL;
+	arena->pos = NULL;
+}
+
+/*
+ * yarena_trim()
+ * Free the released chunks kept by an arena.
+ */
+void yarena_trim(yarena_t *arena) {
+	yarena_chunk_t	*chunk;
+
+	while ((chunk = arena->spare) != NULL) {
+		arena->spare = chunk->previous;
+		_yarena_free_chunk(arena, chunk);
+	}
+}
+
+/*
+ * yarena_allocator()
+ * Return a runtime allocator which takes its memory from an arena.
+ */
+yalloc_t *yarena_allocator(yarena_t *arena) {
+	return (&arena->allocator);
+}
+
+/* *************** PRIVATE FUNCTIONS ************** */
+/*
+ * _yarena_create()
+ * Allocate and initialize an arena.
+ */
+static yarena_t *_yarena_create(size_t chunk_size, ybool_t hugepages) {
+	yarena_t	*arena;
+
+	if ((arena = (yarena_t*)YMALLOC(sizeof(yarena_t))) == NULL)
+		return (NULL);
+	arena->chunk = arena->oldest = arena->spare = NULL;
+	arena->pos = NULL;
+	arena->chunk_size = chunk_size;
+	arena->hugepages = hugepages;
+	arena->allocator.alloc = _yarena_allocator_alloc;
+	arena->allocator.free = _yarena_allocator_free;
+	arena->allocator.context = arena;
+	arena->allocator.alloc_raw = _yarena_allocator_alloc_raw;
+	return (arena);
+}
+
+/*
+ * _yarena_new_chunk()
+ * Start a new chunk, and allocate a block at its beginning. The first spare
+ * chunk is reused if it is big enough; new chunks are already zeroed.
+ */
+static void *_yarena_new_chunk(yarena_t *arena, size_t size, ybool_t zeroed) {
+	yarena_chunk_t	*chunk;
+	size_t		chunk_size, header = _YARENA_ROUND(sizeof(yarena_chunk_t));
+
+	chunk_size = (size > arena->chunk_size) ? size : arena->chunk_size;
+	if (arena->spare != NULL && (size_t)(arena->spare->end - _YARENA_DATA(arena->spare)) >= size) {
+		chunk = arena->spare;
+		arena->spare = chunk->previous;
+		if (zeroed)
+			memset(_YARENA_DATA(chunk), 0, size);
+	} else {
+		if (arena->hugepages) {
+			chunk_size = _YARENA_HUGE_ROUND(header + chunk_size) - header;
+			chunk = _yarena_map_chunk(header + chunk_size);
+		} else
+			chunk = (yarena_chunk_t*)YMALLOC(header + chunk_size);
+		if (chunk == NULL)
+			return (NULL);
+		chunk->end = _YARENA_DATA(chunk) + chunk_size;
+	}
+	chunk->previous = arena->chunk;
+	if (arena->chunk == NULL)
+		arena->oldest = chunk;
+	arena->chunk = chunk;
+	arena->pos = _YARENA_DATA(chunk) + size;
+	return (_YARENA_DATA(chunk));
+}
+
+/*
+ * _yarena_map_chunk()
+ * Map a chunk on huge pages. Reserved huge pages are tried first; if there
+ * is none, anonymous memory is mapped and the kernel is advised to back it
+ * with transparent huge pages.
+ */
+static yarena_chunk_t *_yarena_map_chunk(size_t size) {
+	void	*ptr = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+	ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif /* MAP_HUGETLB */
+	if (ptr == MAP_FAILED) {
+		ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (ptr == MAP_FAILED)
+			return (NULL);
+#ifdef MADV_HUGEPAGE
+		madvise(ptr, size, MADV_HUGEPAGE);
+#endif /* MADV_HUGEPAGE */
+	}
+	return ((yarena_chunk_t*)ptr);
+}
+
+/*
+ * _yarena_free_chunk()
+ * Give a chunk back to the system.
+ */
+static void _yarena_free_chunk(yarena_t *arena, yarena_chunk_t *chunk) {
+	if (arena->hugepages)
+		munmap(chunk, (size_t)(chunk->end - (char*)chunk));
+	else
+		YFREE(chunk);
+}
+
+/*
+ * _yarena_allocator_alloc()
+ * Allocation function of an arena's runtime allocator.
+ */
+static void *_yarena_allocator_alloc(void *context, size_t size) {
+	return (yarena_alloc((yarena_t*)context, size));
+}
+
+/*
+ * _yarena_allocator_alloc_raw()
+ * Allocation function of an arena's runtime allocator, for memory which
+ * doesn't need to be zeroed.
+ */
+static void *_yarena_allocator_alloc_raw(void *context, size_t size) {
+	return (yarena_alloc_raw((yarena_t*)context, size));
+}
+
+/*
+ * _yarena_allocator_free()
+ * Free function of an arena's runtime allocator. Blocks are not freed one
+ * by one; the arena recovers them when it is reset.
+ */
+static void _yarena_allocator_free(void *context, void *ptr) {
+	(void)context;
+	(void)ptr;
+}
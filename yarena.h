@@ -0,0 +1,176 @@
+/* Process this file with the HeaderBrowser tool (http://www.headerbrowser.org)
+   to create documentation. */
+/*!
+ * @header	yarena.h
+ * @abstract	Stack-like memory arenas.
+ * @discussion	An arena hands out memory blocks from big chunks, by moving a
+ *		pointer forward. Blocks are never freed one by one: the current
+ *		position can be saved with yarena_mark(), and everything that
+ *		was allocated after it is released at once by yarena_release().
+ *		Releasing costs nothing more than a pointer assignment as long
+ *		as no chunk boundary is crossed; released chunks are kept to be
+ *		reused, so that pushing and popping around a boundary does not
+ *		call malloc() each time. yarena_reset() releases everything in
+ *		constant time, whatever the number of chunks, and yarena_trim()
+ *		gives the kept chunks back to the system.
+ *		<p />
+ *		An arena can be used as the memory of a whole request or document:
+ *		yarena_allocator() gives a runtime allocator (yalloc_t) which can
+ *		be handed to ys_new_in(), yv_create_in() or ydom_new_in(), and
+ *		yht_new_in_arena() creates a hash table in an arena. Freeing a
+ *		block given by this allocator does nothing; the memory is
+ *		recovered when the arena is reset, released or deleted.
+ *		<p />
+ *		Arenas created by yarena_new_hugepages() take their chunks from
+ *		huge pages (2 MB), which spares TLB misses for big working sets.
+ *		Chunks are mapped with MAP_HUGETLB when the system has reserved
+ *		huge pages, and with transparent huge pages otherwise.
+ * @version	1.0 Oct 19 2026
+ * @author	Amaury Bouchard <amaury@amaury.net>
+ */
+#ifndef __YARENA_H__
+#define __YARENA_H__
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif /* __cplusplus || c_plusplus */
+
+#include "ydefs.h"
+
+/** @define YARENA_CHUNK_SIZE Default size of arena chunks. */
+#define YARENA_CHUNK_SIZE	65536
+
+/** @define YARENA_ALIGN Alignment of the blocks given by an arena. */
+#define YARENA_ALIGN		16
+
+/** @define YARENA_HUGEPAGE_SIZE Size of huge pages; chunks of huge page arenas are multiples of it. */
+#define YARENA_HUGEPAGE_SIZE	2097152
+
+/**
+ * @typedef	yarena_chunk_t
+ *		Header of a memory chunk. The usable memory follows it.
+ * @field	previous	Pointer to the previously allocated chunk, or to the next
+ *				spare chunk.
+ * @field	end		Pointer to the end of the chunk.
+ */
+typedef struct yarena_chunk_s {
+	struct yarena_chunk_s	*previous;
+	char			*end;
+} yarena_chunk_t;
+
+/**
+ * @typedef	yarena_t
+ *		Memory arena.
+ * @field	chunk		Current chunk.
+ * @field	oldest		First chunk of the current chain.
+ * @field	pos		Next free byte of the current chunk.
+ * @field	spare		List of released chunks, kept to be reused.
+ * @field	chunk_size	Usable size of standard chunks.
+ * @field	hugepages	YTRUE if the chunks are taken from huge pages.
+ * @field	allocator	Runtime allocator taking its memory from the arena.
+ */
+typedef struct yarena_s {
+	yarena_chunk_t	*chunk;
+	yarena_chunk_t	*oldest;
+	char		*pos;
+	yarena_chunk_t	*spare;
+	size_t		chunk_size;
+	ybool_t		hugepages;
+	yalloc_t	allocator;
+} yarena_t;
+
+/* ****************** FUNCTIONS **************** */
+/**
+ * @function	yarena_new
+ *		Create a new arena. No memory chunk is allocated before the first
+ *		allocation.
+ * @param	chunk_size	Usable size of the chunks, 0 for YARENA_CHUNK_SIZE.
+ * @return	The created arena, or NULL if memory is exhausted.
+ */
+yarena_t *yarena_new(size_t chunk_size);
+
+/**
+ * @function	yarena_new_hugepages
+ *		Create a new arena whose chunks are taken from huge pages. No
+ *		memory chunk is allocated before the first allocation.
+ * @param	chunk_size	Usable size of the chunks, rounded up so that chunks
+ *				fill whole huge pages; 0 for one huge page.
+ * @return	The created arena, or NULL if memory is exhausted.
+ */
+yarena_t *yarena_new_hugepages(size_t chunk_size);
+
+/**
+ * @function	yarena_delete
+ *		Destroy an arena and all the memory it gave.
+ * @param	arena	Pointer to the arena.
+ */
+void yarena_delete(yarena_t *arena);
+
+/**
+ * @function	yarena_alloc
+ *		Allocate a zeroed memory block from an arena. Blocks bigger than
+ *		the chunk size get a chunk of their own.
+ * @param	arena	Pointer to the arena.
+ * @param	size	Size of the block.
+ * @return	A pointer to the block, aligned on YARENA_ALIGN bytes, or NULL
+ *		if memory is exhausted.
+ */
+void *yarena_alloc(yarena_t *arena, size_t size);
+
+/**
+ * @function	yarena_alloc_raw
+ *		Allocate a memory block from an arena, without zeroing it. To be
+ *		used for blocks which are entirely written by the caller.
+ * @param	arena	Pointer to the arena.
+ * @param	size	Size of the block.
+ * @return	A pointer to the block, aligned on YARENA_ALIGN bytes, or NULL
+ *		if memory is exhausted.
+ */
+void *yarena_alloc_raw(yarena_t *arena, size_t size);
+
+/**
+ * @function	yarena_mark
+ *		Return the current position of an arena.
+ * @param	arena	Pointer to the arena.
+ * @return	The mark, to be given to yarena_release().
+ */
+void *yarena_mark(yarena_t *arena);
+
+/**
+ * @function	yarena_release
+ *		Release all the blocks allocated from an arena after a mark.
+ * @param	arena	Pointer to the arena.
+ * @param	mark	A value returned by yarena_mark(), or the address of a
+ *			block returned by yarena_alloc(); in the latter case, the
+ *			block itself is released too.
+ */
+void yarena_release(yarena_t *arena, void *mark);
+
+/**
+ * @function	yarena_reset
+ *		Release all the blocks allocated from an arena. The chunks are
+ *		kept to be reused.
+ * @param	arena	Pointer to the arena.
+ */
+void yarena_reset(yarena_t *arena);
+
+/**
+ * @function	yarena_trim
+ *		Free the released chunks kept by an arena.
+ * @param	arena	Pointer to the arena.
+ */
+void yarena_trim(yarena_t *arena);
+
+/**
+ * @function	yarena_allocator
+ *		Return a runtime allocator which takes its memory from an arena.
+ * @param	arena	Pointer to the arena.
+ * @return	A pointer to the allocator, valid as long as the arena.
+ */
+yalloc_t *yarena_allocator(yarena_t *arena);
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif /* __cplusplus || c_plusplus */
+
+#endif /* __YARENA_H__ */
@@ -26,7 +26,7 @@ char *ybase64_encode(ybin_t bin)
   const unsigned char *pt = bin.data;
   int i;
 
-  if (!(str = malloc0(((len + 3 - len % 3) * 4 / 3 + 1))))
+  if (!(str = YMALLOC_RAW(((len + 3 - len % 3) * 4 / 3 + 1))))
     return (NULL);
   for (i = 0; len > 0; len -= 3, pt += 3)
     {
@@ -51,7 +51,7 @@ ybin_t ybase64_decode(const char *pt)
    unsigned char *str;
    int i, len;
 
-   if (!(str = malloc0(strlen(pt) + 2)))
+   if (!(str = YMALLOC_RAW(strlen(pt) + 2)))
      {
 	res.data = NULL;
 	res.len = 0;
@@ -0,0 +1,554 @@
+#define YMEM_TAG	YMEM_TAG_HASH
+
+#include <stdlib.h>
+#include <string.h>
+#include "ybtree.h"
+
+/** @define _YBT_CMP Compare two keys of a tree. */
+#define _YBT_CMP(tree, k1, k2)	(((tree)->key_type == YBT_KEYS_STRING) ? strcmp((k1).s, (k2).s) : \
+				 (((k1).i < (k2).i) ? -1 : ((k1).i > (k2).i)))
+
+/* *** definition of private functions *** */
+static ybt_node_t *_ybt_new_node(ybool_t leaf);
+static void _ybt_free_node(ybtree_t *tree, ybt_node_t *node, ybool_t destroy);
+static ybt_key_t _ybt_copy_key(ybtree_t *tree, ybt_key_t key);
+static void _ybt_free_key(ybtree_t *tree, ybt_key_t key);
+static size_t _ybt_lower_pos(ybtree_t *tree, ybt_node_t *node, ybt_key_t key);
+static size_t _ybt_child_pos(ybtree_t *tree, ybt_node_t *node, ybt_key_t key);
+static ybt_node_t *_ybt_find_leaf(ybtree_t *tree, ybt_key_t key);
+static void _ybt_add(ybtree_t *tree, ybt_key_t key, void *data);
+static int _ybt_insert(ybtree_t *tree, ybt_node_t *node, ybt_key_t key, void *data, ybt_key_t *up_key, ybt_node_t **up_node);
+static void *_ybt_search(ybtree_t *tree, ybt_key_t key);
+static ybool_t _ybt_remove(ybtree_t *tree, ybt_key_t key);
+static void _ybt_lower_bound(ybtree_t *tree, ybt_key_t key, ybt_iter_t *iter);
+
+/*
+ * ybt_new()
+ * Create a new B+tree.
+ */
+ybtree_t *ybt_new(ybt_key_type_t key_type, ybt_function_t destroy_func, void *destroy_data) {
+	ybtree_t	*tree;
+
+	tree = (ybtree_t*)YMALLOC(sizeof(ybtree_t));
+	tree->key_type = key_type;
+	tree->root = tree->first = _ybt_new_node(YTRUE);
+	tree->nbr_elements = 0;
+	tree->height = 1;
+	tree->destroy_func = destroy_func;
+	tree->destroy_data = destroy_data;
+	return (tree);
+}
+
+/*
+ * ybt_delete()
+ * Destroy a B+tree.
+ */
+void ybt_delete(ybtree_t *tree) {
+	if (tree == NULL)
+		return;
+	_ybt_free_node(tree, tree->root, YTRUE);
+	YFREE(tree);
+}
+
+/*
+ * ybt_add_from_string()
+ * Add an element to a tree with string keys.
+ */
+void ybt_add_from_string(ybtree_t *tree, const char *key, void *data) {
+	ybt_key_t	k;
+
+	k.s = (char*)key;
+	_ybt_add(tree, k, data);
+}
+
+/*
+ * ybt_add_from_int()
+ * Add an element to a tree with integer keys.
+ */
+void ybt_add_from_int(ybtree_t *tree, size_t key, void *data) {
+	ybt_key_t	k;
+
+	k.i = key;
+	_ybt_add(tree, k, data);
+}
+
+/*
+ * ybt_search_from_string()
+ * Search an element in a tree with string keys.
+ */
+void *ybt_search_from_string(ybtree_t *tree, const char *key) {
+	ybt_key_t	k;
+
+	k.s = (char*)key;
+	return (_ybt_search(tree, k));
+}
+
+/*
+ * ybt_search_from_int()
+ * Search an element in a tree with integer keys.
+ */
+void *ybt_search_from_int(ybtree_t *tree, size_t key) {
+	ybt_key_t	k;
+
+	k.i = key;
+	return (_ybt_search(tree, k));
+}
+
+/*
+ * ybt_remove_from_string()
+ * Remove an element from a tree with string keys.
+ */
+ybool_t ybt_remove_from_string(ybtree_t *tree, const char *key) {
+	ybt_key_t	k;
+
+	k.s = (char*)key;
+	return (_ybt_remove(tree, k));
+}
+
+/*
+ * ybt_remove_from_int()
+ * Remove an element from a tree with integer keys.
+ */
+ybool_t ybt_remove_from_int(ybtree_t *tree, size_t key) {
+	ybt_key_t	k;
+
+	k.i = key;
+	return (_ybt_remove(tree, k));
+}
+
+/*
+ * ybt_load()
+ * Fill an empty tree from a sorted vector of elements.
+ */
+ybool_t ybt_load(ybtree_t *tree, yvect_t v, ybt_key_func_t key_func) {
+	ybt_node_t	**nodes, *node = NULL, *previous = NULL;
+	ybt_key_t	*lows, key, last_key;
+	size_t		nbr_elements, nbr_nodes, i, j, k;
+
+	if (tree->nbr_elements > 0)
+		return (YFALSE);
+	nbr_elements = yv_len(v);
+	/* check the order of the keys */
+	for (i = 0; i < nbr_elements; i++) {
+		key = key_func(v[i]);
+		if (i > 0 && _YBT_CMP(tree, last_key, key) >= 0)
+			return (YFALSE);
+		last_key = key;
+	}
+	_ybt_free_node(tree, tree->root, YFALSE);
+	tree->height = 1;
+	if (nbr_elements == 0) {
+		tree->root = tree->first = _ybt_new_node(YTRUE);
+		return (YTRUE);
+	}
+	/* build the full leaves, keeping the lowest key of each node */
+	nbr_nodes = (nbr_elements + YBT_NODE_KEYS - 1) / YBT_NODE_KEYS;
+	nodes = (ybt_node_t**)YCALLOC(nbr_nodes, sizeof(ybt_node_t*));
+	lows = (ybt_key_t*)YCALLOC(nbr_nodes, sizeof(ybt_key_t));
+	for (i = 0; i < nbr_elements; i++) {
+		if (i % YBT_NODE_KEYS == 0) {
+			node = nodes[i / YBT_NODE_KEYS] = _ybt_new_node(YTRUE);
+			if (previous != NULL)
+				previous->next = node;
+			previous = node;
+		}
+		node->keys[node->nbr_keys] = _ybt_copy_key(tree, key_func(v[i]));
+		node->u.data[node->nbr_keys] = v[i];
+		if (i % YBT_NODE_KEYS == 0)
+			lows[i / YBT_NODE_KEYS] = node->keys[0];
+		node->nbr_keys++;
+	}
+	tree->first = nodes[0];
+	tree->nbr_elements = nbr_elements;
+	/* build the upper levels; the lowest key of each child but the first is a separator */
+	while (nbr_nodes > 1) {
+		for (i = j = 0; i < nbr_nodes; j++) {
+			node = _ybt_new_node(YFALSE);
+			node->u.children[0] = nodes[i];
+			lows[j] = lows[i];
+			for (k = 1, i++; k <= YBT_NODE_KEYS && i < nbr_nodes; k++, i++) {
+				node->keys[node->nbr_keys++] = _ybt_copy_key(tree, lows[i]);
+				node->u.children[k] = nodes[i];
+			}
+			nodes[j] = node;
+		}
+		nbr_nodes = j;
+		tree->height++;
+	}
+	tree->root = nodes[0];
+	YFREE(nodes);
+	YFREE(lows);
+	return (YTRUE);
+}
+
+/*
+ * ybt_first()
+ * Set an iterator on the first element of a tree.
+ */
+void ybt_first(ybtree_t *tree, ybt_iter_t *iter) {
+	iter->tree = tree;
+	iter->node = tree->first;
+	iter->pos = 0;
+}
+
+/*
+ * ybt_lower_bound_from_string()
+ * Set an iterator on the first element whose key is not lower than a string.
+ */
+void ybt_lower_bound_from_string(ybtree_t *tree, const char *key, ybt_iter_t *iter) {
+	ybt_key_t	k;
+
+	k.s = (char*)key;
+	_ybt_lower_bound(tree, k, iter);
+}
+
+/*
+ * ybt_lower_bound_from_int()
+ * Set an iterator on the first element whose key is not lower than an integer.
+ */
+void ybt_lower_bound_from_int(ybtree_t *tree, size_t key, ybt_iter_t *iter) {
+	ybt_key_t	k;
+
+	k.i = key;
+	_ybt_lower_bound(tree, k, iter);
+}
+
+/*
+ * ybt_next()
+ * Get the element an iterator is set on, and move the iterator forward.
+ */
+ybool_t ybt_next(ybt_iter_t *iter, ybt_key_t *key, void **data) {
+	/* skip the end of the leaf, and the leaves emptied by removals */
+	while (iter->node != NULL && iter->pos >= iter->node->nbr_keys) {
+		iter->node = iter->node->next;
+		iter->pos = 0;
+	}
+	if (iter->node == NULL)
+		return (YFALSE);
+	if (key != NULL)
+		*key = iter->node->keys[iter->pos];
+	if (data != NULL)
+		*data = iter->node->u.data[iter->pos];
+	iter->pos++;
+	return (YTRUE);
+}
+
+/*
+ * ybt_foreach()
+ * Apply a function on every element of a tree, in order.
+ */
+void ybt_foreach(ybtree_t *tree, ybt_function_t func, void *user_data) {
+	ybt_node_t	*node;
+	size_t		i;
+
+	for (node = tree->first; node != NULL; node = node->next)
+		for (i = 0; i < node->nbr_keys; i++)
+			func(node->keys[i], node->u.data[i], user_data);
+}
+
+/*
+ * ybt_foreach_range_from_string()
+ * Apply a function on the elements whose string key is in a range.
+ */
+size_t ybt_foreach_range_from_string(ybtree_t *tree, const char *from, const char *to, ybt_function_t func, void *user_data) {
+	ybt_iter_t	iter;
+	ybt_key_t	key;
+	void		*data;
+	size_t		nbr = 0;
+
+	ybt_lower_bound_from_string(tree, from, &iter);
+	while (ybt_next(&iter, &key, &data) && (to == NULL || strcmp(key.s, to) < 0)) {
+		func(key, data, user_data);
+		nbr++;
+	}
+	return (nbr);
+}
+
+/*
+ * ybt_foreach_range_from_int()
+ * Apply a function on the elements whose integer key is in a range.
+ */
+size_t ybt_foreach_range_from_int(ybtree_t *tree, size_t from, size_t to, ybt_function_t func, void *user_data) {
+	ybt_iter_t	iter;
+	ybt_key_t	key;
+	void		*data;
+	size_t		nbr = 0;
+
+	ybt_lower_bound_from_int(tree, from, &iter);
+	while (ybt_next(&iter, &key, &data) && key.i < to) {
+		func(key, data, user_data);
+		nbr++;
+	}
+	return (nbr);
+}
+
+/*
+ * ybt_foreach_prefix()
+ * Apply a function on the elements whose string key starts with a prefix.
+ */
+size_t ybt_foreach_prefix(ybtree_t *tree, const char *prefix, ybt_function_t func, void *user_data) {
+	ybt_iter_t	iter;
+	ybt_key_t	key;
+	void		*data;
+	size_t		nbr = 0, len;
+
+	len = strlen(prefix);
+	ybt_lower_bound_from_string(tree, prefix, &iter);
+	while (ybt_next(&iter, &key, &data) && !strncmp(key.s, prefix, len)) {
+		func(key, data, user_data);
+		nbr++;
+	}
+	return (nbr);
+}
+
+/* *************** PRIVATE FUNCTIONS ************** */
+/*
+ * _ybt_new_node()
+ * Allocate an empty node.
+ */
+static ybt_node_t *_ybt_new_node(ybool_t leaf) {
+	ybt_node_t	*node;
+
+	node = (ybt_node_t*)YMALLOC(sizeof(ybt_node_t));
+	node->leaf = leaf;
+	return (node);
+}
+
+/*
+ * _ybt_free_node()
+ * Free a node and its subtree, calling the destroy function on the
+ * elements if asked.
+ */
+static void _ybt_free_node(ybtree_t *tree, ybt_node_t *node, ybool_t destroy) {
+	size_t	i;
+
+	for (i = 0; i < node->nbr_keys; i++) {
+		if (node->leaf && destroy && tree->destroy_func != NULL)
+			tree->destroy_func(node->keys[i], node->u.data[i], tree->destroy_data);
+		_ybt_free_key(tree, node->keys[i]);
+	}
+	if (!node->leaf)
+		for (i = 0; i <= node->nbr_keys; i++)
+			_ybt_free_node(tree, node->u.children[i], destroy);
+	YFREE(node);
+}
+
+/*
+ * _ybt_copy_key()
+ * Copy a key; only string keys need it. Separators of internal nodes are
+ * copies too, so that removing an element from a leaf never leaves them
+ * dangling.
+ */
+static ybt_key_t _ybt_copy_key(ybtree_t *tree, ybt_key_t key) {
+	ybt_key_t	copy;
+	size_t		len;
+
+	if (tree->key_type != YBT_KEYS_STRING)
+		return (key);
+	len = strlen(key.s);
+	copy.s = (char*)YMALLOC_RAW(len + 1);
+	memcpy(copy.s, key.s, len + 1);
+	return (copy);
+}
+
+/*
+ * _ybt_free_key()
+ * Free a key copied by _ybt_copy_key().
+ */
+static void _ybt_free_key(ybtree_t *tree, ybt_key_t key) {
+	if (tree->key_type == YBT_KEYS_STRING)
+		YFREE(key.s);
+}
+
+/*
+ * _ybt_lower_pos()
+ * Return the position of the first key of a node which is not lower than
+ * a given key.
+ */
+static size_t _ybt_lower_pos(ybtree_t *tree, ybt_node_t *node, ybt_key_t key) {
+	size_t	low = 0, high = node->nbr_keys, middle;
+
+	while (low < high) {
+		middle = (low + high) / 2;
+		if (_YBT_CMP(tree, node->keys[middle], key) < 0)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	return (low);
+}
+
+/*
+ * _ybt_child_pos()
+ * Return the position of the child of an internal node which may hold a key:
+ * the position of the first separator greater than the key.
+ */
+static size_t _ybt_child_pos(ybtree_t *tree, ybt_node_t *node, ybt_key_t key) {
+	size_t	low = 0, high = node->nbr_keys, middle;
+
+	while (low < high) {
+		middle = (low + high) / 2;
+		if (_YBT_CMP(tree, node->keys[middle], key) <= 0)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	return (low);
+}
+
+/*
+ * _ybt_find_leaf()
+ * Return the leaf which may hold a key.
+ */
+static ybt_node_t *_ybt_find_leaf(ybtree_t *tree, ybt_key_t key) {
+	ybt_node_t	*node;
+
+	for (node = tree->root; !node->leaf; node = node->u.children[_ybt_child_pos(tree, node, key)])
+		;
+	return (node);
+}
+
+/*
+ * _ybt_add()
+ * Add an element to a tree, and grow the tree if its root was split.
+ */
+static void _ybt_add(ybtree_t *tree, ybt_key_t key, void *data) {
+	ybt_key_t	up_key;
+	ybt_node_t	*up_node, *root;
+
+	if (_ybt_insert(tree, tree->root, key, data, &up_key, &up_node) != 2)
+		return;
+	root = _ybt_new_node(YFALSE);
+	root->nbr_keys = 1;
+	root->keys[0] = up_key;
+	root->u.children[0] = tree->root;
+	root->u.children[1] = up_node;
+	tree->root = root;
+	tree->height++;
+}
+
+/*
+ * _ybt_insert()
+ * Insert an element in a subtree. Return 0 if an existing element was
+ * updated, 1 if the element was added, 2 if it was added and the node was
+ * split: the new right node and its separator are then given back.
+ */
+static int _ybt_insert(ybtree_t *tree, ybt_node_t *node, ybt_key_t key, void *data, ybt_key_t *up_key, ybt_node_t **up_node) {
+	ybt_key_t	keys[YBT_NODE_KEYS + 1], child_key;
+	ybt_node_t	*children[YBT_NODE_KEYS + 2], *child, *right;
+	size_t		pos, half, i;
+	int		res;
+
+	if (node->leaf) {
+		pos = _ybt_lower_pos(tree, node, key);
+		if (pos < node->nbr_keys && !_YBT_CMP(tree, node->keys[pos], key)) {
+			if (tree->destroy_func != NULL && node->u.data[pos] != data)
+				tree->destroy_func(node->keys[pos], node->u.data[pos], tree->destroy_data);
+			node->u.data[pos] = data;
+			return (0);
+		}
+		key = _ybt_copy_key(tree, key);
+		tree->nbr_elements++;
+		right = NULL;
+		if (node->nbr_keys == YBT_NODE_KEYS) {
+			/* split the leaf in two halves, then insert in one of them */
+			half = (YBT_NODE_KEYS + 1) / 2;
+			right = _ybt_new_node(YTRUE);
+			right->nbr_keys = node->nbr_keys - half;
+			memcpy(right->keys, &(node->keys[half]), right->nbr_keys * sizeof(ybt_key_t));
+			memcpy(right->u.data, &(node->u.data[half]), right->nbr_keys * sizeof(void*));
+			node->nbr_keys = half;
+			right->next = node->next;
+			node->next = right;
+			if (pos > half) {
+				node = right;
+				pos -= half;
+			}
+		}
+		memmove(&(node->keys[pos + 1]), &(node->keys[pos]), (node->nbr_keys - pos) * sizeof(ybt_key_t));
+		memmove(&(node->u.data[pos + 1]), &(node->u.data[pos]), (node->nbr_keys - pos) * sizeof(void*));
+		node->keys[pos] = key;
+		node->u.data[pos] = data;
+		node->nbr_keys++;
+		if (right == NULL)
+			return (1);
+		*up_key = _ybt_copy_key(tree, right->keys[0]);
+		*up_node = right;
+		return (2);
+	}
+	pos = _ybt_child_pos(tree, node, key);
+	if ((res = _ybt_insert(tree, node->u.children[pos], key, data, &child_key, &child)) != 2)
+		return (res);
+	if (node->nbr_keys < YBT_NODE_KEYS) {
+		memmove(&(node->keys[pos + 1]), &(node->keys[pos]), (node->nbr_keys - pos) * sizeof(ybt_key_t));
+		memmove(&(node->u.children[pos + 2]), &(node->u.children[pos + 1]), (node->nbr_keys - pos) * sizeof(ybt_node_t*));
+		node->keys[pos] = child_key;
+		node->u.children[pos + 1] = child;
+		node->nbr_keys++;
+		return (1);
+	}
+	/* split the internal node: the middle separator goes up */
+	for (i = 0; i <= YBT_NODE_KEYS; i++) {
+		keys[i] = (i < pos) ? node->keys[i] : ((i == pos) ? child_key : node->keys[i - 1]);
+		children[i + 1] = (i < pos) ? node->u.children[i + 1] : ((i == pos) ? child : node->u.children[i]);
+	}
+	children[0] = node->u.children[0];
+	half = (YBT_NODE_KEYS + 1) / 2;
+	right = _ybt_new_node(YFALSE);
+	node->nbr_keys = half;
+	right->nbr_keys = YBT_NODE_KEYS - half;
+	memcpy(node->keys, keys, half * sizeof(ybt_key_t));
+	memcpy(node->u.children, children, (half + 1) * sizeof(ybt_node_t*));
+	memcpy(right->keys, &(keys[half + 1]), right->nbr_keys * sizeof(ybt_key_t));
+	memcpy(right->u.children, &(children[half + 1]), (right->nbr_keys + 1) * sizeof(ybt_node_t*));
+	*up_key = keys[half];
+	*up_node = right;
+	return (2);
+}
+
+/*
+ * _ybt_search()
+ * Search an element in a tree.
+ */
+static void *_ybt_search(ybtree_t *tree, ybt_key_t key) {
+	ybt_node_t	*node;
+	size_t		pos;
+
+	node = _ybt_find_leaf(tree, key);
+	pos = _ybt_lower_pos(tree, node, key);
+	if (pos < node->nbr_keys && !_YBT_CMP(tree, node->keys[pos], key))
+		return (node->u.data[pos]);
+	return (NULL);
+}
+
+/*
+ * _ybt_remove()
+ * Remove an element from its leaf. Nodes are not merged.
+ */
+static ybool_t _ybt_remove(ybtree_t *tree, ybt_key_t key) {
+	ybt_node_t	*node;
+	size_t		pos;
+
+	node = _ybt_find_leaf(tree, key);
+	pos = _ybt_lower_pos(tree, node, key);
+	if (pos == node->nbr_keys || _YBT_CMP(tree, node->keys[pos], key))
+		return (YFALSE);
+	if (tree->destroy_func != NULL)
+		tree->destroy_func(node->keys[pos], node->u.data[pos], tree->destroy_data);
+	_ybt_free_key(tree, node->keys[pos]);
+	node->nbr_keys--;
+	memmove(&(node->keys[pos]), &(node->keys[pos + 1]), (node->nbr_keys - pos) * sizeof(ybt_key_t));
+	memmove(&(node->u.data[pos]), &(node->u.data[pos + 1]), (node->nbr_keys - pos) * sizeof(void*));
+	tree->nbr_elements--;
+	return (YTRUE);
+}
+
+/*
+ * _ybt_lower_bound()
+ * Set an iterator on the first element whose key is not lower than a key.
+ */
+static void _ybt_lower_bound(ybtree_t *tree, ybt_key_t key, ybt_iter_t *iter) {
+	iter->tree = tree;
+	iter->node = _ybt_find_leaf(tree, key);
+	iter->pos = _ybt_lower_pos(tree, iter->node, key);
+}
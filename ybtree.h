@@ -0,0 +1,315 @@
+/* Process this file with the HeaderBrowser tool (http://www.headerbrowser.org)
+   to create documentation. */
+/*!
+ * @header	ybtree.h
+ * @abstract	Ordered maps, implemented as B+trees.
+ * @discussion	A B+tree keeps its elements sorted by key: besides searches,
+ *		it gives ordered iteration, range and prefix scans, and the
+ *		first element whose key is not lower than a given one. All the
+ *		elements are stored in the leaves, which are chained from left
+ *		to right; internal nodes only hold separator keys. Nodes are
+ *		wide (YBT_NODE_KEYS keys, a few cache lines), so that the tree
+ *		is shallow and each node is searched without following pointers.
+ *		<p />
+ *		A tree has either string keys, which are copied, or integer keys.
+ *		<p />
+ *		Removal is lazy: the element is removed from its leaf, but nodes
+ *		are never merged, and emptied leaves stay in the chain. Trees
+ *		with many removals can be rebuilt compactly with ybt_load().
+ * @version	1.0 Oct 19 2026
+ * @author	Amaury Bouchard <amaury@amaury.net>
+ */
+#ifndef __YBTREE_H__
+#define __YBTREE_H__
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif /* __cplusplus || c_plusplus */
+
+#include "ydefs.h"
+#include "yvect.h"
+
+/** @define YBT_NODE_KEYS Maximum number of keys in a node (a node fills 4 cache lines of 64 bytes). */
+#define YBT_NODE_KEYS	14
+
+/**
+ * @typedef	ybt_key_type_t
+ *		Type of the keys of a tree.
+ * @constant	YBT_KEYS_STRING	Null-terminated strings, compared with strcmp().
+ * @constant	YBT_KEYS_INT	Unsigned integers.
+ */
+typedef enum ybt_key_type_e {
+	YBT_KEYS_STRING = 0,
+	YBT_KEYS_INT
+} ybt_key_type_t;
+
+/**
+ * @typedef	ybt_key_t
+ *		Key of an element.
+ * @field	s	String key.
+ * @field	i	Integer key.
+ */
+typedef union ybt_key_u {
+	char	*s;
+	size_t	i;
+} ybt_key_t;
+
+/**
+ * @typedef	ybt_node_t
+ *		Node of a B+tree. In a leaf, data[i] is the data of keys[i]. In an
+ *		internal node, children[i] holds the keys lower than keys[i], and
+ *		children[nbr_keys] the others.
+ * @field	nbr_keys	Number of keys in the node.
+ * @field	leaf		YTRUE if the node is a leaf.
+ * @field	next		Next leaf, for leaves.
+ * @field	keys		Keys.
+ * @field	children	Child nodes, for internal nodes.
+ * @field	data		Data of the elements, for leaves.
+ */
+typedef struct ybt_node_s {
+	unsigned short	nbr_keys;
+	unsigned short	leaf;
+	struct ybt_node_s	*next;
+	ybt_key_t	keys[YBT_NODE_KEYS];
+	union {
+		struct ybt_node_s	*children[YBT_NODE_KEYS + 1];
+		void			*data[YBT_NODE_KEYS + 1];
+	} u;
+} ybt_node_t;
+
+/**
+ * @typedef	ybt_function_t
+ *		Function pointer, used to apply a procedure to an element.
+ * @param	key		The element's key.
+ * @param	data		The element's data.
+ * @param	user_data	Pointer to some user data.
+ */
+typedef void (*ybt_function_t)(ybt_key_t key, void *data, void *user_data);
+
+/**
+ * @typedef	ybt_key_func_t
+ *		Function pointer, used to get the key of an element given to ybt_load().
+ * @param	data	The element.
+ * @return	The element's key.
+ */
+typedef ybt_key_t (*ybt_key_func_t)(void *data);
+
+/**
+ * @typedef	ybtree_t
+ *		B+tree.
+ * @field	key_type	Type of the keys.
+ * @field	root		Root node.
+ * @field	first		Leftmost leaf.
+ * @field	nbr_elements	Number of elements.
+ * @field	height		Number of levels of nodes.
+ * @field	destroy_func	Pointer to the function called when an element is removed.
+ * @field	destroy_data	Pointer to some user data given to the destroy function.
+ */
+typedef struct ybtree_s {
+	ybt_key_type_t	key_type;
+	ybt_node_t	*root;
+	ybt_node_t	*first;
+	size_t		nbr_elements;
+	size_t		height;
+	ybt_function_t	destroy_func;
+	void		*destroy_data;
+} ybtree_t;
+
+/**
+ * @typedef	ybt_iter_t
+ *		Position in a tree, used to iterate over its elements in order.
+ *		An iterator is invalidated when an element is added to the tree.
+ * @field	tree	The tree.
+ * @field	node	Current leaf.
+ * @field	pos	Position in the leaf.
+ */
+typedef struct ybt_iter_s {
+	ybtree_t	*tree;
+	ybt_node_t	*node;
+	size_t		pos;
+} ybt_iter_t;
+
+/* ****************** FUNCTIONS **************** */
+/**
+ * @function	ybt_new
+ *		Create a new B+tree.
+ * @param	key_type	Type of the keys.
+ * @param	destroy_func	Pointer to the function called when an element is removed.
+ * @param	destroy_data	Pointer to some user data given to the destroy function.
+ * @return	The created tree.
+ */
+ybtree_t *ybt_new(ybt_key_type_t key_type, ybt_function_t destroy_func, void *destroy_data);
+
+/**
+ * @function	ybt_delete
+ *		Destroy a B+tree, calling the destroy function on every element.
+ * @param	tree	Pointer to the tree.
+ */
+void ybt_delete(ybtree_t *tree);
+
+/**
+ * @function	ybt_add_from_string
+ *		Add an element to a tree with string keys, or replace the data of
+ *		an existing element.
+ * @param	tree	Pointer to the tree.
+ * @param	key	The key. It is copied.
+ * @param	data	The element's data.
+ */
+void ybt_add_from_string(ybtree_t *tree, const char *key, void *data);
+
+/**
+ * @function	ybt_add_from_int
+ *		Add an element to a tree with integer keys, or replace the data of
+ *		an existing element.
+ * @param	tree	Pointer to the tree.
+ * @param	key	The key.
+ * @param	data	The element's data.
+ */
+void ybt_add_from_int(ybtree_t *tree, size_t key, void *data);
+
+/**
+ * @function	ybt_search_from_string
+ *		Search an element in a tree with string keys.
+ * @param	tree	Pointer to the tree.
+ * @param	key	The key.
+ * @return	The element's data, or NULL.
+ */
+void *ybt_search_from_string(ybtree_t *tree, const char *key);
+
+/**
+ * @function	ybt_search_from_int
+ *		Search an element in a tree with integer keys.
+ * @param	tree	Pointer to the tree.
+ * @param	key	The key.
+ * @return	The element's data, or NULL.
+ */
+void *ybt_search_from_int(ybtree_t *tree, size_t key);
+
+/**
+ * @function	ybt_remove_from_string
+ *		Remove an element from a tree with string keys.
+ * @param	tree	Pointer to the tree.
+ * @param	key	The key.
+ * @return	YTRUE if the element was found.
+ */
+ybool_t ybt_remove_from_string(ybtree_t *tree, const char *key);
+
+/**
+ * @function	ybt_remove_from_int
+ *		Remove an element from a tree with integer keys.
+ * @param	tree	Pointer to the tree.
+ * @param	key	The key.
+ * @return	YTRUE if the element was found.
+ */
+ybool_t ybt_remove_from_int(ybtree_t *tree, size_t key);
+
+/**
+ * @function	ybt_load
+ *		Fill an empty tree from a vector of elements sorted by key, by
+ *		building full leaves and then the upper levels. Much faster than
+ *		adding the elements one by one.
+ * @param	tree		Pointer to the tree. It must be empty.
+ * @param	v		Vector of elements, sorted by strictly increasing keys.
+ * @param	key_func	Function giving the key of an element. String keys
+ *				are copied.
+ * @return	YTRUE if the tree was loaded, YFALSE if it wasn't empty or if
+ *		the elements were not sorted.
+ */
+ybool_t ybt_load(ybtree_t *tree, yvect_t v, ybt_key_func_t key_func);
+
+/**
+ * @function	ybt_first
+ *		Set an iterator on the first element of a tree.
+ * @param	tree	Pointer to the tree.
+ * @param	iter	Pointer to the iterator.
+ */
+void ybt_first(ybtree_t *tree, ybt_iter_t *iter);
+
+/**
+ * @function	ybt_lower_bound_from_string
+ *		Set an iterator on the first element whose key is not lower than
+ *		a given string.
+ * @param	tree	Pointer to the tree.
+ * @param	key	The key.
+ * @param	iter	Pointer to the iterator.
+ */
+void ybt_lower_bound_from_string(ybtree_t *tree, const char *key, ybt_iter_t *iter);
+
+/**
+ * @function	ybt_lower_bound_from_int
+ *		Set an iterator on the first element whose key is not lower than
+ *		a given integer.
+ * @param	tree	Pointer to the tree.
+ * @param	key	The key.
+ * @param	iter	Pointer to the iterator.
+ */
+void ybt_lower_bound_from_int(ybtree_t *tree, size_t key, ybt_iter_t *iter);
+
+/**
+ * @function	ybt_next
+ *		Get the element an iterator is set on, and move the iterator to
+ *		the next one.
+ *		<pre>
+ *		ybt_lower_bound_from_int(tree, 10, &iter);
+ *		while (ybt_next(&iter, &key, &data) && key.i < 20)
+ *			...
+ *		</pre>
+ * @param	iter	Pointer to the iterator.
+ * @param	key	Pointer to the element's key, set by the function. Could be NULL.
+ * @param	data	Pointer to the element's data, set by the function. Could be NULL.
+ * @return	YFALSE if there is no more element.
+ */
+ybool_t ybt_next(ybt_iter_t *iter, ybt_key_t *key, void **data);
+
+/**
+ * @function	ybt_foreach
+ *		Apply a function on every element of a tree, in order.
+ * @param	tree		Pointer to the tree.
+ * @param	func		Pointer to the executed function.
+ * @param	user_data	Pointer to some user data given to the function.
+ */
+void ybt_foreach(ybtree_t *tree, ybt_function_t func, void *user_data);
+
+/**
+ * @function	ybt_foreach_range_from_string
+ *		Apply a function, in order, on the elements of a tree with string
+ *		keys whose key is in a range.
+ * @param	tree		Pointer to the tree.
+ * @param	from		Lowest key of the range (included).
+ * @param	to		Highest key of the range (excluded), or NULL for no limit.
+ * @param	func		Pointer to the executed function.
+ * @param	user_data	Pointer to some user data given to the function.
+ * @return	The number of processed elements.
+ */
+size_t ybt_foreach_range_from_string(ybtree_t *tree, const char *from, const char *to, ybt_function_t func, void *user_data);
+
+/**
+ * @function	ybt_foreach_range_from_int
+ *		Apply a function, in order, on the elements of a tree with integer
+ *		keys whose key is in a range.
+ * @param	tree		Pointer to the tree.
+ * @param	from		Lowest key of the range (included).
+ * @param	to		Highest key of the range (excluded).
+ * @param	func		Pointer to the executed function.
+ * @param	user_data	Pointer to some user data given to the function.
+ * @return	The number of processed elements.
+ */
+size_t ybt_foreach_range_from_int(ybtree_t *tree, size_t from, size_t to, ybt_function_t func, void *user_data);
+
+/**
+ * @function	ybt_foreach_prefix
+ *		Apply a function, in order, on the elements of a tree with string
+ *		keys whose key starts with a prefix.
+ * @param	tree		Pointer to the tree.
+ * @param	prefix		The prefix.
+ * @param	func		Pointer to the executed function.
+ * @param	user_data	Pointer to some user data given to the function.
+ * @return	The number of processed elements.
+ */
+size_t ybt_foreach_prefix(ybtree_t *tree, const char *prefix, ybt_function_t func, void *user_data);
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif /* __cplusplus || c_plusplus */
+
+#endif /* __YBTREE_H__ */
@@ -0,0 +1,323 @@
+#define YMEM_TAG	YMEM_TAG_HASH
+
+#include <stdlib.h>
+#include <string.h>
+#include "ycache.h"
+
+/* *** definition of private functions *** */
+static void _ycache_unlink(ycache_t *cache, ycache_entry_t *entry);
+static void _ycache_link_first(ycache_t *cache, ycache_entry_t *entry);
+static void _ycache_drop(ycache_t *cache, ycache_entry_t *entry);
+static ycache_shard_t *_ycache_shard(ycache_sharded_t *cache, const char *key);
+
+/*
+ * ycache_new()
+ * Create a new cache.
+ */
+ycache_t *ycache_new(size_t max_entries, size_t max_bytes, ycache_size_func_t size_func, ycache_function_t destroy_func, void *user_data) {
+	ycache_t	*cache;
+
+	cache = (ycache_t*)YMALLOC(sizeof(ycache_t));
+	cache->hashtable = yht_new(YHT_SIZE_MINI, NULL, NULL);
+	cache->first = cache->last = NULL;
+	cache->max_entries = max_entries;
+	cache->max_bytes = max_bytes;
+	cache->size_func = size_func;
+	cache->destroy_func = destroy_func;
+	cache->user_data = user_data;
+	return (cache);
+}
+
+/*
+ * ycache_delete()
+ * Destroy a cache.
+ */
+void ycache_delete(ycache_t *cache) {
+	ycache_entry_t	*entry, *next;
+
+	if (cache == NULL)
+		return;
+	for (entry = cache->first; entry != NULL; entry = next) {
+		next = entry->next;
+		if (cache->destroy_func != NULL)
+			cache->destroy_func(entry->key, entry->data, cache->user_data);
+		YFREE(entry);
+	}
+	yht_delete(cache->hashtable);
+	YFREE(cache);
+}
+
+/*
+ * ycache_set()
+ * Add an entry to a cache, or replace the data of an existing entry.
+ */
+ybool_t ycache_set(ycache_t *cache, const char *key, void *data, unsigned int ttl) {
+	ycache_entry_t	*entry;
+	size_t		key_len;
+
+	key_len = strlen(key);
+	if ((entry = (ycache_entry_t*)yht_search_from_string(cache->hashtable, key)) != NULL) {
+		/* replace the data of the existing entry */
+		if (cache->destroy_func != NULL && entry->data != data)
+			cache->destroy_func(entry->key, entry->data, cache->user_data);
+		cache->stats.bytes -= entry->size;
+		_ycache_unlink(cache, entry);
+	} else {
+		/* the key is stored right after the entry, and borrowed by the hash table */
+		entry = (ycache_entry_t*)YMALLOC(sizeof(ycache_entry_t) + key_len + 1);
+		entry->key = (char*)(entry + 1);
+		memcpy(entry->key, key, key_len + 1);
+		yht_add_from_string(cache->hashtable, entry->key, entry);
+		cache->stats.nbr_entries++;
+	}
+	entry->data = data;
+	entry->size = sizeof(ycache_entry_t) + key_len + 1;
+	if (cache->size_func != NULL)
+		entry->size += cache->size_func(entry->key, data, cache->user_data);
+	entry->expire = ttl ? (time(NULL) + ttl) : 0;
+	cache->stats.bytes += entry->size;
+	_ycache_link_first(cache, entry);
+	/* evict the least recently used entries */
+	while ((cache->max_entries && cache->stats.nbr_entries > cache->max_entries) ||
+	       (cache->max_bytes && cache->stats.bytes > cache->max_bytes)) {
+		if (cache->last == entry) {
+			/* the new entry doesn't fit in the cache by itself */
+			_ycache_drop(cache, entry);
+			return (YFALSE);
+		}
+		cache->stats.evictions++;
+		_ycache_drop(cache, cache->last);
+	}
+	return (YTRUE);
+}
+
+/*
+ * ycache_get()
+ * Search an entry in a cache, and mark it as the most recently used.
+ */
+void *ycache_get(ycache_t *cache, const char *key) {
+	ycache_entry_t	*entry;
+
+	if ((entry = (ycache_entry_t*)yht_search_from_string(cache->hashtable, key)) == NULL) {
+		cache->stats.misses++;
+		return (NULL);
+	}
+	if (entry->expire && entry->expire <= time(NULL)) {
+		cache->stats.expirations++;
+		cache->stats.misses++;
+		_ycache_drop(cache, entry);
+		return (NULL);
+	}
+	cache->stats.hits++;
+	if (cache->first != entry) {
+		_ycache_unlink(cache, entry);
+		_ycache_link_first(cache, entry);
+	}
+	return (entry->data);
+}
+
+/*
+ * ycache_remove()
+ * Remove an entry from a cache.
+ */
+ybool_t ycache_remove(ycache_t *cache, const char *key) {
+	ycache_entry_t	*entry;
+
+	if ((entry = (ycache_entry_t*)yht_search_from_string(cache->hashtable, key)) == NULL)
+		return (YFALSE);
+	_ycache_drop(cache, entry);
+	return (YTRUE);
+}
+
+/*
+ * ycache_purge()
+ * Remove all the expired entries of a cache.
+ */
+size_t ycache_purge(ycache_t *cache) {
+	ycache_entry_t	*entry, *next;
+	time_t		now;
+	size_t		nbr_removed = 0;
+
+	now = time(NULL);
+	for (entry = cache->first; entry != NULL; entry = next) {
+		next = entry->next;
+		if (entry->expire && entry->expire <= now) {
+			_ycache_drop(cache, entry);
+			nbr_removed++;
+		}
+	}
+	cache->stats.expirations += nbr_removed;
+	return (nbr_removed);
+}
+
+/*
+ * ycache_get_stats()
+ * Get the counters of a cache.
+ */
+void ycache_get_stats(ycache_t *cache, ycache_stats_t *stats) {
+	*stats = cache->stats;
+}
+
+/*
+ * ycache_sharded_new()
+ * Create a new thread-safe cache.
+ */
+ycache_sharded_t *ycache_sharded_new(size_t nbr_shards, size_t max_entries, size_t max_bytes, ycache_size_func_t size_func, ycache_function_t destroy_func, void *user_data) {
+	ycache_sharded_t	*cache;
+	size_t			i;
+
+	if (nbr_shards == 0)
+		nbr_shards = 1;
+	cache = (ycache_sharded_t*)YMALLOC(sizeof(ycache_sharded_t));
+	cache->nbr_shards = nbr_shards;
+	cache->shards = (ycache_shard_t*)YCALLOC(nbr_shards, sizeof(ycache_shard_t));
+	for (i = 0; i < nbr_shards; i++) {
+		pthread_mutex_init(&(cache->shards[i].mutex), NULL);
+		cache->shards[i].cache = ycache_new((max_entries + nbr_shards - 1) / nbr_shards,
+		                                    (max_bytes + nbr_shards - 1) / nbr_shards,
+		                                    size_func, destroy_func, user_data);
+	}
+	return (cache);
+}
+
+/*
+ * ycache_sharded_delete()
+ * Destroy a thread-safe cache.
+ */
+void ycache_sharded_delete(ycache_sharded_t *cache) {
+	size_t	i;
+
+	if (cache == NULL)
+		return;
+	for (i = 0; i < cache->nbr_shards; i++) {
+		ycache_delete(cache->shards[i].cache);
+		pthread_mutex_destroy(&(cache->shards[i].mutex));
+	}
+	YFREE(cache->shards);
+	YFREE(cache);
+}
+
+/*
+ * ycache_sharded_set()
+ * Add an entry to a thread-safe cache.
+ */
+ybool_t ycache_sharded_set(ycache_sharded_t *cache, const char *key, void *data, unsigned int ttl) {
+	ycache_shard_t	*shard;
+	ybool_t		res;
+
+	shard = _ycache_shard(cache, key);
+	pthread_mutex_lock(&(shard->mutex));
+	res = ycache_set(shard->cache, key, data, ttl);
+	pthread_mutex_unlock(&(shard->mutex));
+	return (res);
+}
+
+/*
+ * ycache_sharded_get()
+ * Search an entry in a thread-safe cache.
+ */
+void *ycache_sharded_get(ycache_sharded_t *cache, const char *key, ycache_copy_func_t copy_func, void *user_data) {
+	ycache_shard_t	*shard;
+	void		*data;
+
+	shard = _ycache_shard(cache, key);
+	pthread_mutex_lock(&(shard->mutex));
+	data = ycache_get(shard->cache, key);
+	if (data != NULL && copy_func != NULL)
+		data = copy_func(key, data, user_data);
+	pthread_mutex_unlock(&(shard->mutex));
+	return (data);
+}
+
+/*
+ * ycache_sharded_remove()
+ * Remove an entry from a thread-safe cache.
+ */
+ybool_t ycache_sharded_remove(ycache_sharded_t *cache, const char *key) {
+	ycache_shard_t	*shard;
+	ybool_t		res;
+
+	shard = _ycache_shard(cache, key);
+	pthread_mutex_lock(&(shard->mutex));
+	res = ycache_remove(shard->cache, key);
+	pthread_mutex_unlock(&(shard->mutex));
+	return (res);
+}
+
+/*
+ * ycache_sharded_get_stats()
+ * Get the counters of a thread-safe cache, summed over its shards.
+ */
+void ycache_sharded_get_stats(ycache_sharded_t *cache, ycache_stats_t *stats) {
+	ycache_shard_t	*shard;
+	size_t		i;
+
+	memset(stats, 0, sizeof(ycache_stats_t));
+	for (i = 0; i < cache->nbr_shards; i++) {
+		shard = &(cache->shards[i]);
+		pthread_mutex_lock(&(shard->mutex));
+		stats->hits += shard->cache->stats.hits;
+		stats->misses += shard->cache->stats.misses;
+		stats->evictions += shard->cache->stats.evictions;
+		stats->expirations += shard->cache->stats.expirations;
+		stats->nbr_entries += shard->cache->stats.nbr_entries;
+		stats->bytes += shard->cache->stats.bytes;
+		pthread_mutex_unlock(&(shard->mutex));
+	}
+}
+
+/* *************** PRIVATE FUNCTIONS ************** */
+/*
+ * _ycache_unlink()
+ * Remove an entry from the LRU list.
+ */
+static void _ycache_unlink(ycache_t *cache, ycache_entry_t *entry) {
+	if (entry->previous != NULL)
+		entry->previous->next = entry->next;
+	else
+		cache->first = entry->next;
+	if (entry->next != NULL)
+		entry->next->previous = entry->previous;
+	else
+		cache->last = entry->previous;
+	entry->previous = entry->next = NULL;
+}
+
+/*
+ * _ycache_link_first()
+ * Put an entry at the head of the LRU list.
+ */
+static void _ycache_link_first(ycache_t *cache, ycache_entry_t *entry) {
+	entry->previous = NULL;
+	entry->next = cache->first;
+	if (cache->first != NULL)
+		cache->first->previous = entry;
+	else
+		cache->last = entry;
+	cache->first = entry;
+}
+
+/*
+ * _ycache_drop()
+ * Remove an entry from a cache and destroy it.
+ */
+static void _ycache_drop(ycache_t *cache, ycache_entry_t *entry) {
+	_ycache_unlink(cache, entry);
+	yht_remove_from_string(cache->hashtable, entry->key);
+	cache->stats.nbr_entries--;
+	cache->stats.bytes -= entry->size;
+	if (cache->destroy_func != NULL)
+		cache->destroy_func(entry->key, entry->data, cache->user_data);
+	YFREE(entry);
+}
+
+/*
+ * _ycache_shard()
+ * Return the shard of a key.
+ */
+static ycache_shard_t *_ycache_shard(ycache_sharded_t *cache, const char *key) {
+	u64_t	mix;
+
+	mix = (u64_t)yht_hash(key) * (((u64_t)0x9E3779B9 << 32) | 0x7F4A7C15);
+	return (&(cache->shards[(mix >> 32) % cache->nbr_shards]));
+}
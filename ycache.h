@@ -0,0 +1,285 @@
+/* Process this file with the HeaderBrowser tool (http://www.headerbrowser.org)
+   to create documentation. */
+/*!
+ * @header	ycache.h
+ * @abstract	LRU caches with optional expiration and size budget.
+ * @discussion	A cache maps string keys to data, like a hash table, but has a
+ *		limited capacity: when it holds more entries or more bytes than
+ *		allowed, the least recently used entries are evicted. Each entry
+ *		can also be given a time to live. Gets and puts are O(1).
+ *		<p />
+ *		The cache owns the data it stores: the destroy function is called
+ *		when an entry is evicted, expired, removed or replaced.
+ *		<p />
+ *		ycache_t is not thread-safe. ycache_sharded_t splits the keys over
+ *		several caches, each protected by its own mutex.
+ * @version	1.0 Oct 19 2026
+ * @author	Amaury Bouchard <amaury@amaury.net>
+ */
+#ifndef __YCACHE_H__
+#define __YCACHE_H__
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif /* __cplusplus || c_plusplus */
+
+#include <time.h>
+#include <pthread.h>
+#include "ydefs.h"
+#include "yhashtable.h"
+
+/**
+ * @typedef	ycache_function_t
+ *		Function pointer, called when an entry leaves a cache.
+ * @param	key		The entry's key.
+ * @param	data		The entry's data.
+ * @param	user_data	Pointer to some user data.
+ */
+typedef void (*ycache_function_t)(const char *key, void *data, void *user_data);
+
+/**
+ * @typedef	ycache_size_func_t
+ *		Function pointer, used to get the size of an entry's data.
+ * @param	key		The entry's key.
+ * @param	data		The entry's data.
+ * @param	user_data	Pointer to some user data.
+ * @return	The size of the data, in bytes.
+ */
+typedef size_t (*ycache_size_func_t)(const char *key, void *data, void *user_data);
+
+/**
+ * @typedef	ycache_copy_func_t
+ *		Function pointer, used to copy the data of an entry found in a
+ *		sharded cache, while the shard is still locked.
+ * @param	key		The entry's key.
+ * @param	data		The entry's data.
+ * @param	user_data	Pointer to some user data.
+ * @return	The copied data.
+ */
+typedef void *(*ycache_copy_func_t)(const char *key, void *data, void *user_data);
+
+/**
+ * @typedef	ycache_entry_t
+ *		Entry of a cache. The key is stored right after the structure.
+ * @field	key		Pointer to the entry's key.
+ * @field	data		The entry's data.
+ * @field	size		Size of the entry, including the structure and the key.
+ * @field	expire		Expiration date, 0 if the entry doesn't expire.
+ * @field	previous	Pointer to the more recently used entry.
+ * @field	next		Pointer to the less recently used entry.
+ */
+typedef struct ycache_entry_s {
+	char			*key;
+	void			*data;
+	size_t			size;
+	time_t			expire;
+	struct ycache_entry_s	*previous;
+	struct ycache_entry_s	*next;
+} ycache_entry_t;
+
+/**
+ * @typedef	ycache_stats_t
+ *		Counters of a cache.
+ * @field	hits		Number of successful gets.
+ * @field	misses		Number of failed gets.
+ * @field	evictions	Number of entries evicted to respect the limits.
+ * @field	expirations	Number of entries removed because they expired.
+ * @field	nbr_entries	Current number of entries.
+ * @field	bytes		Current size of the entries.
+ */
+typedef struct ycache_stats_s {
+	u64_t	hits;
+	u64_t	misses;
+	u64_t	evictions;
+	u64_t	expirations;
+	size_t	nbr_entries;
+	size_t	bytes;
+} ycache_stats_t;
+
+/**
+ * @typedef	ycache_t
+ *		LRU cache.
+ * @field	hashtable	Hash table of the entries, whose keys are borrowed from the entries.
+ * @field	first		Most recently used entry.
+ * @field	last		Least recently used entry.
+ * @field	max_entries	Maximum number of entries, 0 for no limit.
+ * @field	max_bytes	Maximum size of the entries, 0 for no limit.
+ * @field	size_func	Function giving the size of entries' data. Could be NULL.
+ * @field	destroy_func	Function called when an entry leaves the cache. Could be NULL.
+ * @field	user_data	Pointer given to the size and destroy functions.
+ * @field	stats		Counters.
+ */
+typedef struct ycache_s {
+	yhashtable_t		*hashtable;
+	ycache_entry_t		*first;
+	ycache_entry_t		*last;
+	size_t			max_entries;
+	size_t			max_bytes;
+	ycache_size_func_t	size_func;
+	ycache_function_t	destroy_func;
+	void			*user_data;
+	ycache_stats_t		stats;
+} ycache_t;
+
+/**
+ * @typedef	ycache_shard_t
+ *		Shard of a thread-safe cache.
+ * @field	mutex	Mutex protecting the cache.
+ * @field	cache	The cache.
+ */
+typedef struct ycache_shard_s {
+	pthread_mutex_t	mutex;
+	ycache_t	*cache;
+} ycache_shard_t;
+
+/**
+ * @typedef	ycache_sharded_t
+ *		Thread-safe cache, made of independent shards.
+ * @field	nbr_shards	Number of shards.
+ * @field	shards		Array of shards.
+ */
+typedef struct ycache_sharded_s {
+	size_t		nbr_shards;
+	ycache_shard_t	*shards;
+} ycache_sharded_t;
+
+/* ****************** FUNCTIONS **************** */
+/**
+ * @function	ycache_new
+ *		Create a new cache.
+ * @param	max_entries	Maximum number of entries, 0 for no limit.
+ * @param	max_bytes	Maximum size of the entries, 0 for no limit. The size
+ *				of an entry is the size of its structure and key, plus
+ *				the size returned by the size function.
+ * @param	size_func	Function giving the size of entries' data. Could be NULL.
+ * @param	destroy_func	Function called when an entry leaves the cache. Could be NULL.
+ * @param	user_data	Pointer given to the size and destroy functions.
+ * @return	The created cache.
+ */
+ycache_t *ycache_new(size_t max_entries, size_t max_bytes, ycache_size_func_t size_func, ycache_function_t destroy_func, void *user_data);
+
+/**
+ * @function	ycache_delete
+ *		Destroy a cache, calling the destroy function on every entry.
+ * @param	cache	Pointer to the cache.
+ */
+void ycache_delete(ycache_t *cache);
+
+/**
+ * @function	ycache_set
+ *		Add an entry to a cache, or replace the data of an existing entry.
+ *		Least recently used entries are then evicted until the cache is
+ *		within its limits.
+ * @param	cache	Pointer to the cache.
+ * @param	key	The key. It is copied.
+ * @param	data	The data.
+ * @param	ttl	Time to live of the entry in seconds, 0 if it doesn't expire.
+ * @return	YTRUE if the entry was stored, YFALSE if it is bigger than the
+ *		whole cache (its data is destroyed).
+ */
+ybool_t ycache_set(ycache_t *cache, const char *key, void *data, unsigned int ttl);
+
+/**
+ * @function	ycache_get
+ *		Search an entry in a cache, and mark it as the most recently used.
+ * @param	cache	Pointer to the cache.
+ * @param	key	The key.
+ * @return	The entry's data, or NULL if it isn't in the cache or it expired.
+ */
+void *ycache_get(ycache_t *cache, const char *key);
+
+/**
+ * @function	ycache_remove
+ *		Remove an entry from a cache.
+ * @param	cache	Pointer to the cache.
+ * @param	key	The key.
+ * @return	YTRUE if the entry was found.
+ */
+ybool_t ycache_remove(ycache_t *cache, const char *key);
+
+/**
+ * @function	ycache_purge
+ *		Remove all the expired entries of a cache. Expired entries are
+ *		otherwise removed when they are accessed or evicted.
+ * @param	cache	Pointer to the cache.
+ * @return	The number of removed entries.
+ */
+size_t ycache_purge(ycache_t *cache);
+
+/**
+ * @function	ycache_get_stats
+ *		Get the counters of a cache.
+ * @param	cache	Pointer to the cache.
+ * @param	stats	Pointer to the structure filled with the counters.
+ */
+void ycache_get_stats(ycache_t *cache, ycache_stats_t *stats);
+
+/**
+ * @function	ycache_sharded_new
+ *		Create a new thread-safe cache. The limits are evenly split
+ *		between the shards.
+ * @param	nbr_shards	Number of shards.
+ * @param	max_entries	Maximum number of entries, 0 for no limit.
+ * @param	max_bytes	Maximum size of the entries, 0 for no limit.
+ * @param	size_func	Function giving the size of entries' data. Could be NULL.
+ * @param	destroy_func	Function called when an entry leaves the cache. Could be NULL.
+ * @param	user_data	Pointer given to the size and destroy functions.
+ * @return	The created cache.
+ */
+ycache_sharded_t *ycache_sharded_new(size_t nbr_shards, size_t max_entries, size_t max_bytes, ycache_size_func_t size_func, ycache_function_t destroy_func, void *user_data);
+
+/**
+ * @function	ycache_sharded_delete
+ *		Destroy a thread-safe cache. No other thread may use it anymore.
+ * @param	cache	Pointer to the cache.
+ */
+void ycache_sharded_delete(ycache_sharded_t *cache);
+
+/**
+ * @function	ycache_sharded_set
+ *		Add an entry to a thread-safe cache. See ycache_set().
+ * @param	cache	Pointer to the cache.
+ * @param	key	The key. It is copied.
+ * @param	data	The data.
+ * @param	ttl	Time to live of the entry in seconds, 0 if it doesn't expire.
+ * @return	YTRUE if the entry was stored.
+ */
+ybool_t ycache_sharded_set(ycache_sharded_t *cache, const char *key, void *data, unsigned int ttl);
+
+/**
+ * @function	ycache_sharded_get
+ *		Search an entry in a thread-safe cache. As the entry may be
+ *		evicted by another thread as soon as the shard is unlocked, its
+ *		data should be copied by the given function.
+ * @param	cache		Pointer to the cache.
+ * @param	key		The key.
+ * @param	copy_func	Function called on the found data while the shard is
+ *				locked. If NULL, the data itself is returned.
+ * @param	user_data	Pointer given to the copy function.
+ * @return	The value returned by the copy function, or NULL if the entry
+ *		isn't in the cache.
+ */
+void *ycache_sharded_get(ycache_sharded_t *cache, const char *key, ycache_copy_func_t copy_func, void *user_data);
+
+/**
+ * @function	ycache_sharded_remove
+ *		Remove an entry from a thread-safe cache.
+ * @param	cache	Pointer to the cache.
+ * @param	key	The key.
+ * @return	YTRUE if the entry was found.
+ */
+ybool_t ycache_sharded_remove(ycache_sharded_t *cache, const char *key);
+
+/**
+ * @function	ycache_sharded_get_stats
+ *		Get the counters of a thread-safe cache, summed over its shards.
+ * @param	cache	Pointer to the cache.
+ * @param	stats	Pointer to the structure filled with the counters.
+ */
+void ycache_sharded_get_stats(ycache_sharded_t *cache, ycache_stats_t *stats);
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif /* __cplusplus || c_plusplus */
+
+#endif /* __YCACHE_H__ */
@@ -1,8 +1,11 @@
+#define YMEM_TAG	YMEM_TAG_CGI
+
 #include <unistd.h>
 #include <stdio.h>
 #include <string.h>
 #include "ylog.h"
 #include "ycgi.h"
+#include "yslab.h"
 
 /*
 ** ycgi_header_nochange()
@@ -105,11 +108,11 @@ yvect_t ycgi_read_cookies()
 	  (sep = strchr(begin, VALUE_SEPARATOR)) &&
 	  sep < pt)
 	{
-	  item = malloc0(sizeof(ycgi_item_t));
-	  name = malloc0(sep - begin + 1);
+	  item = YSLAB_ALLOC(sizeof(ycgi_item_t));
+	  name = YMALLOC_RAW(sep - begin + 1);
 	  strncpy(name, begin, sep - begin);
 	  name[sep - begin] = '\0';
-	  value = malloc0(pt - sep);
+	  value = YMALLOC_RAW(pt - sep);
 	  strncpy(value, sep + 1, pt - sep - 1);
 	  value[pt - sep - 1] = '\0';
 	  item->name = yurl_decode(name);
@@ -167,7 +170,7 @@ yvect_t ycgi_read_post_request()
 
   if ((pt = getenv(CONTENT_LENGTH)) && (content_length = atoi(pt)))
     {
-      pt = malloc0(content_length + 1);
+      pt = YMALLOC_RAW(content_length + 1);
       while (readed < content_length)
 	readed += read(0, pt + readed, content_length);
       pt[content_length] = '\0';
@@ -199,7 +202,7 @@ void ycgi_del_item(ycgi_item_t *item)
     ys_del(&item->name);
   if (item->value)
     ys_del(&item->value);
-  free0(item);
+  YSLAB_FREE(item, sizeof(ycgi_item_t));
 }
 
 /*
@@ -221,11 +224,11 @@ yvect_t ycgi_separate_items(const char *query)
 	  (sep = strchr(begin, VALUE_SEPARATOR)) &&
 	  sep < pt)
 	{
-	  item = malloc0(sizeof(ycgi_item_t));
-	  name = malloc0(sep - begin + 1);
+	  item = YSLAB_ALLOC(sizeof(ycgi_item_t));
+	  name = YMALLOC_RAW(sep - begin + 1);
 	  strncpy(name, begin, sep - begin);
 	  name[sep - begin] = '\0';
-	  value = malloc0(pt - sep);
+	  value = YMALLOC_RAW(pt - sep);
 	  strncpy(value, sep + 1, pt - sep - 1);
 	  value[pt - sep - 1] = '\0';
 	  item->name = yurl_decode(name);
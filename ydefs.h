@@ -216,19 +216,117 @@ typedef long double f96_t;
 # define	YMALLOC(s)	(GC_MALLOC(s))
 /*! @define YCALLOC Memory allocation macro. */
 # define	YCALLOC(n, s)	(GC_MALLOC(n * s))
+/*! @define YMALLOC_RAW Allocation of memory which will be entirely written by the caller. */
+# define	YMALLOC_RAW(s)	(GC_MALLOC(s))
 /*! @define YFREE Memory liberation macro. */
 # define	YFREE(p)	((void*)p ? (GC_FREE((void*)p), NULL) : NULL, p = NULL)
-#else
+#elif defined(YMEM_PROFILE)
+/*! @define YMEM_TAG Tag of the allocations of a source file (see ymem.h). */
+# ifndef YMEM_TAG
+#  define	YMEM_TAG	YMEM_TAG_OTHER
+# endif /* YMEM_TAG */
+/*! @define YMALLOC Memory allocation macro. */
+# define	YMALLOC(s)	(ymem_alloc(YMEM_TAG, (s)))
 /*! @define YCALLOC Memory allocation macro. */
+# define	YCALLOC(n, s)	(ymem_alloc(YMEM_TAG, (n) * (s)))
+/*! @define YMALLOC_RAW Allocation of memory which will be entirely written by the caller. */
+# define	YMALLOC_RAW(s)	(ymem_alloc_raw(YMEM_TAG, (s)))
+/*! @define YFREE Memory liberation macro. */
+# define	YFREE(p)	((void*)p ? (ymem_free((void*)p), NULL) : NULL, p = NULL)
+/*! @define malloc0 Allocation of zeroed memory, counted by the profiler. */
+# define	malloc0(s)	((s) ? ymem_alloc(YMEM_TAG, (s)) : NULL)
+/*! @define free0 Memory liberation, counted by the profiler. */
+# define	free0(p)	(ymem_free(p))
+#else
+/*! @define YMALLOC Memory allocation macro. The memory is zeroed; big blocks
+    are fresh pages mapped by the system, which are not filled again. */
 # define	YMALLOC(s)	(calloc(1, s))
 /*! @define YCALLOC Memory allocation macro. */
 # define	YCALLOC(n, s)	(calloc(n, s))
+/*! @define YMALLOC_RAW Allocation of memory which will be entirely written by
+    the caller (copies, growing buffers), and which is not zeroed. */
+# define	YMALLOC_RAW(s)	(malloc(s))
 /*! @define YFREE Memory liberation macro. */
 # define	YFREE(p)	((void*)p ? (free((void*)p), NULL) : NULL, p = NULL)
 #endif /* USE_BOEHM_GC */
 
+#ifndef YMEM_PROFILE
+/*! @function malloc0 Allocation of zeroed memory (see ymalloc.c). */
+void *malloc0(size_t size);
+/*! @define free0 Liberation of memory given by malloc0(). */
+# define	free0(p)	(free(p))
+#endif /* YMEM_PROFILE */
+
+/*!
+ * @function	ygrow
+ *		Replace an array allocated by YMALLOC() or YMALLOC_RAW() by one
+ *		twice as big, or big enough for one more element than used.
+ *		Only the used elements are copied; the old array is freed.
+ *		With YMEM_PROFILE, the new array is counted as YMEM_TAG_OTHER.
+ * @param	array		The array, or NULL.
+ * @param	size		Pointer to the number of elements the array can
+ *				hold, updated on success.
+ * @param	elem_size	Size of an element.
+ * @param	used		Number of used elements.
+ * @param	min_size	Size of the array when it is first allocated.
+ * @return	The new array, or NULL (then the old one is kept).
+ */
+void *ygrow(void *array, size_t *size, size_t elem_size, size_t used, size_t min_size);
+
+/* ******* RUNTIME ALLOCATORS ********** */
+/*!
+ * @typedef	yalloc_func_t
+ *		Function pointer, used by an allocator to give zeroed memory.
+ * @param	context	Pointer to the allocator's context.
+ * @param	size	Size of the memory block.
+ * @return	A pointer to the block, or NULL.
+ */
+typedef void *(*yalloc_func_t)(void *context, size_t size);
+
+/*!
+ * @typedef	yfree_func_t
+ *		Function pointer, used by an allocator to take back memory.
+ * @param	context	Pointer to the allocator's context.
+ * @param	ptr	Pointer to the memory block.
+ */
+typedef void (*yfree_func_t)(void *context, void *ptr);
+
+/*!
+ * @struct	yalloc_s
+ *		Allocator, given at runtime to the objects which can take their
+ *		memory from somewhere else than YMALLOC() (ystrings, yvectors,
+ *		DOM documents). A NULL allocator stands for YMALLOC() and YFREE().
+ * @field	alloc		Allocation function.
+ * @field	free		Liberation function.
+ * @field	context		Pointer given to the functions (an arena, for example).
+ * @field	alloc_raw	Allocation function which doesn't need to zero the
+ *				memory. Could be NULL; alloc is used instead.
+ */
+struct yalloc_s
+{
+  yalloc_func_t alloc;
+  yfree_func_t free;
+  void *context;
+  yalloc_func_t alloc_raw;
+};
+
+/*! @typedef yalloc_t See struct yalloc_s. */
+typedef struct yalloc_s yalloc_t;
+
+/*! @define YALLOC_MALLOC Memory allocation macro, using an allocator (or YMALLOC() if it is NULL). */
+#define	YALLOC_MALLOC(a, s)	((a) ? (a)->alloc((a)->context, (s)) : YMALLOC(s))
+/*! @define YALLOC_MALLOC_RAW Allocation of memory which will be entirely written by the caller, using an allocator (or YMALLOC_RAW() if it is NULL). */
+#define	YALLOC_MALLOC_RAW(a, s)	((a) ? ((a)->alloc_raw ? (a)->alloc_raw((a)->context, (s)) : \
+					(a)->alloc((a)->context, (s))) : YMALLOC_RAW(s))
+/*! @define YALLOC_FREE Memory liberation macro, using an allocator (or YFREE() if it is NULL). */
+#define	YALLOC_FREE(a, p)	((a) ? ((a)->free((a)->context, (void*)(p)), p = NULL) : YFREE(p))
+
 #if defined(__cplusplus) || defined(c_plusplus)
 }
 #endif /* __cplusplus || c_plusplus */
 
+#if defined(YMEM_PROFILE) && !defined(USE_BOEHM_GC)
+# include "ymem.h"
+#endif /* YMEM_PROFILE && !USE_BOEHM_GC */
+
 #endif /* __YDEFS_H__ */
@@ -1,6 +1,9 @@
+#define YMEM_TAG	YMEM_TAG_DOM
+
 #include <stdio.h>
 #include "ylog.h"
 #include "ydom.h"
+#include "yslab.h"
 
 /* Private prototypes */
 static void _ydom_open_hdlr(ysax_t *sax, char *tag_name, yvect_t attrs);
@@ -9,6 +12,12 @@ static void _ydom_inside_hdlr(ysax_t *sax, char *str);
 static void _ydom_comment_hdlr(ysax_t *sax, char *s);
 static void _ydom_process_instr_hdlr(ysax_t *sax, char *target, char *content);
 static void _ydom_cdata_hdlr(ysax_t *sax, char *content);
+static ydom_node_t *_ydom_new_node(yalloc_t *allocator);
+static void _ydom_free_node(ydom_node_t *node);
+static char *_ydom_strndup(yalloc_t *allocator, const char *s, size_t len);
+static char *_ydom_adopt(yalloc_t *allocator, char *s);
+static char *_ydom_concat(yalloc_t *allocator, const char *s1, const char *s2);
+static void _ydom_free_str(yalloc_t *allocator, char *s);
 static void _ydom_add_child_to_node(ydom_node_t *node, ydom_node_t *child);
 static void _ydom_add_next_to_node(ydom_node_t *node, ydom_node_t *next);
 static ydom_node_t *_ydom_add_attr_to_node(ydom_node_t *node,
@@ -24,19 +33,29 @@ static void _ydom_dump_node_attr(ydom_node_t *node, ystr_t *s);
 ** Create a new XML DOM object.
 */
 ydom_t *ydom_new()
+{
+  return (ydom_new_in(NULL));
+}
+
+/*
+** ydom_new_in()
+** Create a new XML DOM object, whose nodes are allocated by an allocator.
+*/
+ydom_t *ydom_new_in(yalloc_t *allocator)
 {
   ydom_t *dom;
   ydom_node_t *node;
 
   YLOG_MOD("ydom", YLOG_DEBUG, "Entering");
-  if (!(dom = malloc0(sizeof(ydom_t))))
+  if (!(dom = YALLOC_MALLOC(allocator, sizeof(ydom_t))))
     {
       YLOG_ADD(YLOG_ERR, "Unable to allocate memory");
       return (NULL);
     }
-  if (!(node = malloc0(sizeof(ydom_node_t))))
+  dom->allocator = allocator;
+  if (!(node = _ydom_new_node(allocator)))
     {
-      free0(dom);
+      YALLOC_FREE(allocator, dom);
       YLOG_ADD(YLOG_ERR, "Unable to allocate memory");
       return (NULL);
     }
@@ -57,13 +76,10 @@ void ydom_del(ydom_t *dom)
 {
   YLOG_MOD("ydom", YLOG_DEBUG, "Entering");
   ydom_node_rm(dom->document_element);
-  if (dom->xml_version)
-    free0(dom->xml_version);
-  if (dom->encoding)
-    free0(dom->encoding);
-  if (dom->standalone)
-    free0(dom->standalone);
-  free0(dom);
+  _ydom_free_str(dom->allocator, dom->xml_version);
+  _ydom_free_str(dom->allocator, dom->encoding);
+  _ydom_free_str(dom->allocator, dom->standalone);
+  YALLOC_FREE(dom->allocator, dom);
   YLOG_MOD("ydom", YLOG_DEBUG, "Exiting");
 }
 
@@ -158,6 +174,36 @@ yerr_t ydom_read_memory(ydom_t *dom, char *mem)
   return (dom->error);
 }
 
+/*
+** ydom_read_buffer()
+** Parse a buffer of known length that contains XML.
+*/
+yerr_t ydom_read_buffer(ydom_t *dom, const char *data, size_t len)
+{
+  ysax_t *sax;
+
+  YLOG_MOD("ydom", YLOG_DEBUG, "Entering");
+  if (!dom)
+    {
+      YLOG_ADD(YLOG_WARN, "NULL dom pointer");
+      return (YENOERR);
+    }
+  if ((sax = ysax_new(dom)) == NULL)
+    {
+      YLOG_ADD(YLOG_ERR, "Bad SAX creation");
+      return (YENOENT);
+    }
+  ysax_set_tag_hdlr(sax, _ydom_open_hdlr, _ydom_close_hdlr);
+  ysax_set_inside_text_hdlr(sax, _ydom_inside_hdlr);
+  ysax_set_comment_hdlr(sax, _ydom_comment_hdlr);
+  ysax_set_process_instr_hdlr(sax, _ydom_process_instr_hdlr);
+  ysax_set_cdata_hdlr(sax, _ydom_cdata_hdlr);
+  dom->error = ysax_read_buffer(sax, data, len);
+  ysax_del(sax);
+  YLOG_MOD("ydom", YLOG_DEBUG, "Exiting");
+  return (dom->error);
+}
+
 /*
 ** ydom_write()
 ** Write the content of an XML tree to a stream.
@@ -230,9 +276,8 @@ void ydom_set_version(ydom_t *dom, char *version)
 {
   if (!dom)
     return ;
-  free0(dom->xml_version);
-  if (version)
-    dom->xml_version = strdup(version);
+  _ydom_free_str(dom->allocator, dom->xml_version);
+  dom->xml_version = version ? _ydom_strndup(dom->allocator, version, strlen(version)) : NULL;
 }
 
 /*
@@ -243,9 +288,8 @@ void ydom_set_encoding(ydom_t *dom, char *encoding)
 {
   if (!dom)
     return ;
-  free0(dom->encoding);
-  if (encoding)
-    dom->encoding = strdup(encoding);
+  _ydom_free_str(dom->allocator, dom->encoding);
+  dom->encoding = encoding ? _ydom_strndup(dom->allocator, encoding, strlen(encoding)) : NULL;
 }
 
 /*
@@ -256,9 +300,8 @@ void ydom_set_standalone(ydom_t *dom, char *standalone)
 {
   if (!dom)
     return ;
-  free0(dom->standalone);
-  if (standalone)
-    dom->standalone = strdup(standalone);
+  _ydom_free_str(dom->allocator, dom->standalone);
+  dom->standalone = standalone ? _ydom_strndup(dom->allocator, standalone, strlen(standalone)) : NULL;
 }
 
 /*
@@ -438,8 +481,8 @@ ydom_node_t *ydom_node_add_attr(ydom_node_t *node, char *attr_name, char *attr_v
 
   if (!node)
     return (NULL);
-  value = str2xmlentity(attr_value);
-  name = strdup(attr_name);
+  value = _ydom_adopt(node->allocator, str2xmlentity(attr_value));
+  name = _ydom_strndup(node->allocator, attr_name, strlen(attr_name));
   return (_ydom_add_attr_to_node(node, name, value));
 }
 
@@ -454,17 +497,17 @@ ydom_node_t *ydom_node_set_attr(ydom_node_t *node, char *attr_name, char *attr_v
 
   if (!node)
     return (NULL);
-  value = str2xmlentity(attr_value);
+  value = _ydom_adopt(node->allocator, str2xmlentity(attr_value));
   for (pt = node->attributes; pt; pt = pt->next)
     {
       if (!strcmp(pt->name, attr_name))
 	{
-	  free0(pt->value);
+	  _ydom_free_str(pt->allocator, pt->value);
 	  pt->value = value;
 	  return (pt);
 	}
     }
-  name = strdup(attr_name);
+  name = _ydom_strndup(node->allocator, attr_name, strlen(attr_name));
   return (_ydom_add_attr_to_node(node, name, value));
 }
 
@@ -477,10 +520,10 @@ ydom_node_t *ydom_node_add_elem(ydom_node_t *node, char *tagname)
 {
   ydom_node_t *new_node;
 
-  if (!node || !(new_node = malloc0(sizeof(ydom_node_t))))
+  if (!node || !(new_node = _ydom_new_node(node->allocator)))
     return (NULL);
   new_node->node_type = ELEMENT_NODE;
-  new_node->name = tagname;
+  new_node->name = _ydom_adopt(node->allocator, tagname);
   new_node->complete = YTRUE;
   _ydom_add_child_to_node(node, new_node);
   return (new_node);
@@ -499,18 +542,17 @@ ydom_node_t *ydom_node_add_text(ydom_node_t *node, char *data)
     return (NULL);
   if (node->last_child && node->last_child->node_type == TEXT_NODE)
     {
-      tmp = malloc0(strlen(node->last_child->value) + strlen(data) + 1);
-      strcpy(tmp, node->last_child->value);
-      strcat(tmp, data);
-      free0(node->last_child->value);
+      if (!(tmp = _ydom_concat(node->allocator, node->last_child->value, data)))
+	return (NULL);
+      _ydom_free_str(node->allocator, node->last_child->value);
       node->last_child->value = tmp;
     }
   else
     {
-      if (!(text_node = malloc0(sizeof(ydom_node_t))))
+      if (!(text_node = _ydom_new_node(node->allocator)))
 	return (NULL);
       text_node->node_type = TEXT_NODE;
-      text_node->value = str2xmlentity(data);
+      text_node->value = _ydom_adopt(node->allocator, str2xmlentity(data));
       text_node->complete = YTRUE;
       _ydom_add_child_to_node(node, text_node);
     }
@@ -525,10 +567,10 @@ ydom_node_t *ydom_node_add_comment(ydom_node_t *node, char *data)
 {
   ydom_node_t *new_node;
 
-  if (!node || !(new_node = malloc0(sizeof(ydom_node_t))))
+  if (!node || !(new_node = _ydom_new_node(node->allocator)))
     return (NULL);
   new_node->node_type = COMMENT_NODE;
-  new_node->value = data;
+  new_node->value = _ydom_adopt(node->allocator, data);
   new_node->complete = YTRUE;
   _ydom_add_child_to_node(node, new_node);
   return (new_node);
@@ -544,11 +586,11 @@ ydom_node_t *ydom_node_add_process_instr(ydom_node_t *node, char *target,
 {
   ydom_node_t *new_node;
 
-  if (!node || !(new_node = malloc0(sizeof(ydom_node_t))))
+  if (!node || !(new_node = _ydom_new_node(node->allocator)))
     return (NULL);
   new_node->node_type = PROCESSING_INSTRUCTION_NODE;
-  new_node->name = target;
-  new_node->value = data;
+  new_node->name = _ydom_adopt(node->allocator, target);
+  new_node->value = _ydom_adopt(node->allocator, data);
   new_node->complete = YTRUE;
   _ydom_add_child_to_node(node, new_node);
   return (new_node);
@@ -562,10 +604,10 @@ ydom_node_t *ydom_node_add_cdata(ydom_node_t *node, char *data)
 {
   ydom_node_t *new_node;
 
-  if (!node || !(new_node = malloc0(sizeof(ydom_node_t))))
+  if (!node || !(new_node = _ydom_new_node(node->allocator)))
     return (NULL);
   new_node->node_type = CDATA_SECTION_NODE;
-  new_node->value = data;
+  new_node->value = _ydom_adopt(node->allocator, data);
   new_node->complete = YTRUE;
   _ydom_add_child_to_node(node, new_node);
   return (new_node);
@@ -826,9 +868,9 @@ ydom_node_t *ydom_node_rm(ydom_node_t *node)
     node->parent->first_child = node->next;
   if (node->parent && node->parent->last_child == node)
     node->parent->last_child = node->prev;
-  free0(node->name);
-  free0(node->value);
-  free0(node);
+  _ydom_free_str(node->allocator, node->name);
+  _ydom_free_str(node->allocator, node->value);
+  _ydom_free_node(node);
   return (res);
 }
 
@@ -846,11 +888,11 @@ void ydom_node_rm_children(ydom_node_t *node)
     {
       ydom_node_rm_children(node->first_child);
       ydom_node_rm_attributes(node->first_child);
-      free0(node->first_child->name);
-      free0(node->first_child->value);
+      _ydom_free_str(node->first_child->allocator, node->first_child->name);
+      _ydom_free_str(node->first_child->allocator, node->first_child->value);
       pt = node->first_child;
       node->first_child = pt->next;
-      free0(pt);
+      _ydom_free_node(pt);
     }
   node->last_child = NULL;
 }
@@ -875,9 +917,9 @@ void ydom_node_rm_attr(ydom_node_t *node, char *attr_name)
 	    attr->prev->next = attr->next;
 	  if (attr->next)
 	    attr->next->prev = attr->prev;
-	  free0(attr->name);
-	  free0(attr->value);
-	  free0(attr);
+	  _ydom_free_str(attr->allocator, attr->name);
+	  _ydom_free_str(attr->allocator, attr->value);
+	  _ydom_free_node(attr);
 	  return ;
 	}
     }
@@ -897,9 +939,9 @@ void ydom_node_rm_attributes(ydom_node_t *node)
     {
       to_rm = attr;
       attr = attr->next;
-      free0(to_rm->name);
-      free0(to_rm->value);
-      free0(to_rm);
+      _ydom_free_str(to_rm->allocator, to_rm->name);
+      _ydom_free_str(to_rm->allocator, to_rm->value);
+      _ydom_free_node(to_rm);
     }
   node->attributes = NULL;
 }
@@ -919,16 +961,17 @@ static void _ydom_open_hdlr(ysax_t *sax, char *tag_name, yvect_t attrs)
 
   YLOG_MOD("ydom", YLOG_DEBUG, "Entering");
   dom = (ydom_t*)YSAX_DATA(sax);
-  if (!(node = malloc0(sizeof(ydom_node_t))))
+  if (!(node = _ydom_new_node(dom->allocator)))
     {
       YLOG_ADD(YLOG_ERR, "Memory alloc error");
       return ;
     }
   node->node_type = ELEMENT_NODE;
-  node->name = tag_name;
+  node->name = _ydom_adopt(dom->allocator, tag_name);
   while ((pt = yv_pop(attrs)))
     {
-      _ydom_add_attr_to_node(node, pt->name, pt->value);
+      _ydom_add_attr_to_node(node, _ydom_adopt(dom->allocator, pt->name),
+			     _ydom_adopt(dom->allocator, pt->value));
       free0(pt);
     }
   yv_del(&attrs, NULL, NULL);
@@ -959,7 +1002,9 @@ static void _ydom_close_hdlr(ysax_t *sax, char *tag_name)
       dom->current_parsed_node->complete = YTRUE;
       dom->current_parsed_node = dom->current_parsed_node->parent;
     }
-  if (strcmp(dom->current_parsed_node->name, tag_name))
+  /* the document node has no name: no element is open */
+  if (!dom->current_parsed_node->name ||
+      strcmp(dom->current_parsed_node->name, tag_name))
     {
       dom->error = YEINVAL;
       ysax_stop(sax);
@@ -987,22 +1032,25 @@ static void _ydom_inside_hdlr(ysax_t *sax, char *str)
   dom = (ydom_t*)YSAX_DATA(sax);
   if (dom->current_parsed_node->node_type == TEXT_NODE)
     {
-      tmp = malloc0(strlen(dom->current_parsed_node->value) + strlen(str) + 1);
-      strcpy(tmp, dom->current_parsed_node->value);
-      strcat(tmp, str);
+      tmp = _ydom_concat(dom->allocator, dom->current_parsed_node->value, str);
       free0(str);
-      free0(dom->current_parsed_node->value);
+      if (!tmp)
+	{
+	  YLOG_ADD(YLOG_ERR, "Unable to allocate memory");
+	  return ;
+	}
+      _ydom_free_str(dom->allocator, dom->current_parsed_node->value);
       dom->current_parsed_node->value = tmp;
     }
   else
     {
-      if (!(text = malloc0(sizeof(ydom_node_t))))
+      if (!(text = _ydom_new_node(dom->allocator)))
 	{
 	  YLOG_ADD(YLOG_ERR, "Unable to allocate memory");
 	  return ;
 	}
       text->node_type = TEXT_NODE;
-      text->value = str;
+      text->value = _ydom_adopt(dom->allocator, str);
       _ydom_add_child_to_node(dom->current_parsed_node, text);
       dom->current_parsed_node = text;
     }
@@ -1020,13 +1068,13 @@ static void _ydom_comment_hdlr(ysax_t *sax, char *s)
 
   YLOG_MOD("ydom", YLOG_DEBUG, "Entering");
   dom = (ydom_t*)YSAX_DATA(sax);
-  if (!(node = malloc0(sizeof(ydom_node_t))))
+  if (!(node = _ydom_new_node(dom->allocator)))
     {
       YLOG_ADD(YLOG_ERR, "Unable to allocate memory");
       return ;
     }
   node->node_type = COMMENT_NODE;
-  node->value = s;
+  node->value = _ydom_adopt(dom->allocator, s);
   node->complete = YTRUE;
   if (dom->current_parsed_node->node_type == TEXT_NODE)
     {
@@ -1056,54 +1104,48 @@ static void _ydom_process_instr_hdlr(ysax_t *sax, char *target, char *content)
     {
       if (content && (pt = strstr(content, XML_VERSION)))
 	{
-	  if ((pt = strchr(pt, EQ)) &&
-	      ((pt = strchr(pt, DQUOTE)) || (pt = strchr(pt, QUOTE))) &&
-	      ((pt2 = strchr(pt + 1, DQUOTE)) || (pt2 = strchr(pt + 1, QUOTE))))
+	  if ((pt = strchr(pt, EQ)) && (pt = strpbrk(pt, "\"'")) &&
+	      (pt2 = strchr(pt + 1, *pt)))
 	    {
-	      if ((dom->xml_version = malloc0(pt2 - pt)))
-		{
-		  memcpy(dom->xml_version, pt + 1, pt2 - pt - 1);
-		  dom->xml_version[pt2 - pt - 1] = '\0';
-		}
+	      _ydom_free_str(dom->allocator, dom->xml_version);
+	      dom->xml_version = _ydom_strndup(dom->allocator, pt + 1, pt2 - pt - 1);
 	    }
 	}
       if (content && (pt = strstr(content, ENCODING)))
 	{
-	  if ((pt = strchr(pt, EQ)) &&
-	      ((pt = strchr(pt, DQUOTE)) || (pt = strchr(pt, QUOTE))) &&
-	      ((pt2 = strchr(pt + 1, DQUOTE)) || (pt2 = strchr(pt + 1, QUOTE))))
+	  if ((pt = strchr(pt, EQ)) && (pt = strpbrk(pt, "\"'")) &&
+	      (pt2 = strchr(pt + 1, *pt)))
 	    {
-	      if ((dom->encoding = malloc0(pt2 - pt)))
-		{
-		  memcpy(dom->encoding, pt + 1, pt2 - pt - 1);
-		  dom->encoding[pt2 - pt - 1] = '\0';
-		}
+	      _ydom_free_str(dom->allocator, dom->encoding);
+	      dom->encoding = _ydom_strndup(dom->allocator, pt + 1, pt2 - pt - 1);
 	    }
+	  /* the parser converted the document, nodes are in UTF-8 */
+	  if (ysax_get_encoding(sax) != YENC_UTF8 &&
+	      ysax_get_encoding(sax) != YENC_UNKNOWN)
+	    ydom_set_encoding(dom, "UTF-8");
 	}
       if (content && (pt = strstr(content, STANDALONE)))
 	{
-	  if ((pt = strchr(pt, EQ)) &&
-	      ((pt = strchr(pt, DQUOTE)) || (pt = strchr(pt, QUOTE))) &&
-	      ((pt2 = strchr(pt + 1, DQUOTE)) || (pt2 = strchr(pt + 1, QUOTE))))
+	  if ((pt = strchr(pt, EQ)) && (pt = strpbrk(pt, "\"'")) &&
+	      (pt2 = strchr(pt + 1, *pt)))
 	    {
-	      if ((dom->standalone = malloc0(pt2 - pt)))
-		{
-		  memcpy(dom->standalone, pt + 1, pt2 - pt - 1);
-		  dom->standalone[pt2 - pt - 1] = '\0';
-		}
+	      _ydom_free_str(dom->allocator, dom->standalone);
+	      dom->standalone = _ydom_strndup(dom->allocator, pt + 1, pt2 - pt - 1);
 	    }
 	}
+      free0(target);
+      free0(content);
     }
   else
     {
-      if (!(node = malloc0(sizeof(ydom_node_t))))
+      if (!(node = _ydom_new_node(dom->allocator)))
 	{
 	  YLOG_ADD(YLOG_DEBUG, "Unable to allocate memory");
 	  return ;
 	}
       node->node_type = PROCESSING_INSTRUCTION_NODE;
-      node->name = target;
-      node->value = content;
+      node->name = _ydom_adopt(dom->allocator, target);
+      node->value = _ydom_adopt(dom->allocator, content);
       node->complete = YTRUE;
       if (dom->current_parsed_node->node_type == TEXT_NODE)
 	{
@@ -1128,13 +1170,13 @@ static void _ydom_cdata_hdlr(ysax_t *sax, char *content)
 
   YLOG_MOD("ydom", YLOG_DEBUG, "Entering");
   dom = (ydom_t*)YSAX_DATA(sax);
-  if (!(node = malloc0(sizeof(ydom_node_t))))
+  if (!(node = _ydom_new_node(dom->allocator)))
     {
       YLOG_MOD("ydom", YLOG_DEBUG, "Unable to allocate memory");
       return ;
     }
   node->node_type = CDATA_SECTION_NODE;
-  node->value = content;
+  node->value = _ydom_adopt(dom->allocator, content);
   node->complete = YTRUE;
   if (dom->current_parsed_node->node_type == TEXT_NODE)
     {
@@ -1147,6 +1189,111 @@ static void _ydom_cdata_hdlr(ysax_t *sax, char *content)
   YLOG_MOD("ydom", YLOG_DEBUG, "Exiting");
 }
 
+/*
+** _ydom_new_node()
+** Allocate an empty node, which remembers its allocator. Without allocator,
+** nodes are taken from the slab allocator.
+*/
+static ydom_node_t *_ydom_new_node(yalloc_t *allocator)
+{
+  ydom_node_t *node;
+
+  if (allocator)
+    node = allocator->alloc(allocator->context, sizeof(ydom_node_t));
+  else
+    node = YSLAB_ALLOC(sizeof(ydom_node_t));
+  if (node)
+    node->allocator = allocator;
+  return (node);
+}
+
+/*
+** _ydom_free_node()
+** Free a node allocated by _ydom_new_node(). Its name and value must have
+** been freed.
+*/
+static void _ydom_free_node(ydom_node_t *node)
+{
+  if (node->allocator)
+    node->allocator->free(node->allocator->context, node);
+  else
+    YSLAB_FREE(node, sizeof(ydom_node_t));
+}
+
+/*
+** _ydom_strndup()
+** Copy a string, with an allocator (or on the heap if it is NULL).
+*/
+static char *_ydom_strndup(yalloc_t *allocator, const char *s, size_t len)
+{
+  char *res;
+
+  if (allocator)
+    res = YALLOC_MALLOC_RAW(allocator, len + 1);
+  else
+    res = malloc0(len + 1);
+  if (res)
+    {
+      memcpy(res, s, len);
+      res[len] = '\0';
+    }
+  return (res);
+}
+
+/*
+** _ydom_adopt()
+** Take a string allocated on the heap (by the SAX parser or by the caller).
+** With an allocator, the string is moved into its memory.
+*/
+static char *_ydom_adopt(yalloc_t *allocator, char *s)
+{
+  char *res;
+
+  if (!allocator || !s)
+    return (s);
+  res = _ydom_strndup(allocator, s, strlen(s));
+  free0(s);
+  return (res);
+}
+
+/*
+** _ydom_concat()
+** Return the concatenation of two strings, allocated with an allocator (or
+** on the heap if it is NULL).
+*/
+static char *_ydom_concat(yalloc_t *allocator, const char *s1, const char *s2)
+{
+  size_t len1, len2;
+  char *res;
+
+  len1 = strlen(s1);
+  len2 = strlen(s2);
+  if (allocator)
+    res = YALLOC_MALLOC_RAW(allocator, len1 + len2 + 1);
+  else
+    res = YMALLOC_RAW(len1 + len2 + 1);
+  if (res)
+    {
+      memcpy(res, s1, len1);
+      memcpy(res + len1, s2, len2 + 1);
+    }
+  return (res);
+}
+
+/*
+** _ydom_free_str()
+** Free a string of a node, with the node's allocator.
+*/
+static void _ydom_free_str(yalloc_t *allocator, char *s)
+{
+  if (!s)
+    return ;
+  if (allocator)
+    allocator->free(allocator->context, s);
+  else
+    free0(s);
+}
+
 /*
 ** _ydom_add_child_to_node()
 ** Add a node child to an existing node
@@ -1200,7 +1347,7 @@ static ydom_node_t *_ydom_add_attr_to_node(ydom_node_t *node,
   ydom_node_t *attribute;
   ydom_node_t *pt;
 
-  if (!(attribute = malloc0(sizeof(ydom_node_t))))
+  if (!(attribute = _ydom_new_node(node->allocator)))
     return (NULL);
   attribute->node_type = ATTRIBUTE_NODE;
   attribute->complete = YTRUE;
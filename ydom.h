@@ -170,6 +170,7 @@ typedef enum ydom_node_type_e ydom_node_type_t;
  * @field	encoding		String which contains the type of
  *					document encoding.
  * @field	standalone		"yes" if the document has a DTD.
+ * @field	allocator		Allocator of the nodes, NULL for YMALLOC().
  */
 struct ydom_s
 {
@@ -179,6 +180,7 @@ struct ydom_s
 	char *xml_version;
 	char *encoding;
 	char *standalone;
+	yalloc_t *allocator;
 };
 
 /*! @typedef ydom_t See struct ydom_s. */
@@ -200,6 +202,7 @@ typedef struct ydom_s ydom_t;
  * @field	first_child	Pointer to the first child of the node.
  * @field	last_child	Pointer to the last child of the node.
  * @field	document	Pointer to the document node of this node.
+ * @field	allocator	Allocator of the node, NULL for YMALLOC().
  */
 struct ydom_node_s
 {
@@ -215,6 +218,7 @@ struct ydom_node_s
 	struct ydom_node_s *first_child;
 	struct ydom_node_s *last_child;
 	struct ydom_node_s *document;
+	yalloc_t *allocator;
 };
 
 /*! @typedef ydom_node_t See struct ydom_node_s. */
@@ -227,6 +231,21 @@ typedef struct ydom_node_s ydom_node_t;
  */
 ydom_t *ydom_new(void);
 
+/*!
+ * @function	ydom_new_in
+ *		Create a new XML DOM object, whose nodes are allocated by an
+ *		allocator. The nodes added to the document later, when it is
+ *		parsed or by the ydom_node_add_*() functions, use the same
+ *		allocator, and so do their names and values, and the version,
+ *		encoding and standalone strings of the document. Strings given
+ *		to the ydom_node_add_*() functions are moved into the allocator's
+ *		memory. With an arena allocator, a whole document is freed at once
+ *		when the arena is released, without calling ydom_del().
+ * @param	allocator	The allocator (NULL for YMALLOC()).
+ * @return	A pointer to the created DOM object.
+ */
+ydom_t *ydom_new_in(yalloc_t *allocator);
+
 /*!
  * @function	ydom_del
  *		Delete a previously created XML DOM object and all
@@ -237,7 +256,8 @@ void ydom_del(ydom_t *dom);
 
 /*!
  * @function	ydom_read_file
- *		Parse an existing XML file.
+ *		Parse an existing XML file. The file is mapped in
+ *		memory when possible (see ysax_read_file()).
  * @param	dom		A pointer to the DOM object.
  * @param	filename	Path to the file to parse.
  * @return	YENOERR if OK, an error code otherwise.
@@ -264,6 +284,63 @@ yerr_t ydom_read_stream(ydom_t *dom, FILE *stream);
  */
 yerr_t ydom_read_memory(ydom_t *dom, char *mem);
 
+/*!
+ * @function	ydom_read_buffer
+ *		Parse a buffer of known length that contains XML.
+ * @param	dom	A pointer to the DOM object.
+ * @param	data	The buffer to parse (not necessarily nul-terminated).
+ * @param	len	Length of the buffer.
+ * @return	YENOERR if OK, an error code otherwise.
+ */
+yerr_t ydom_read_buffer(ydom_t *dom, const char *data, size_t len);
+
+/*!
+ * @function	ydom_read_records
+ *		Parse, on several threads, an XML file made of many sibling
+ *		records (children of the root element), and call a handler
+ *		for each record, in the order of the file. The file is
+ *		mapped in memory and cut into chunks just before record
+ *		start tags; each chunk is parsed into a DOM by a thread of
+ *		a pool. The handler is called by the calling thread. To
+ *		find where to cut, the file is scanned once, skipping
+ *		comments, CDATA sections, processing instructions and
+ *		attribute values, so only the records which are children of
+ *		the root element start a chunk. Only the records are
+ *		given: the root element and what is around it are
+ *		ignored. The file must be in UTF-8 (chunks are parsed
+ *		without the XML declaration); other encodings make the
+ *		function fail with YEINVAL.
+ * @param	filename	Path to the file to parse.
+ * @param	record_name	Tag name of the records.
+ * @param	nbr_threads	Number of parsing threads (0 for the number
+ *				of processors).
+ * @param	record_hdlr	Handler called for each record element. The
+ *				node is deleted after the call.
+ * @param	data		Pointer given to the handler.
+ * @return	YENOERR if OK, an error code otherwise.
+ */
+yerr_t ydom_read_records(const char *filename, const char *record_name,
+			 int nbr_threads,
+			 void (*record_hdlr)(ydom_node_t*, void*), void *data);
+
+/*!
+ * @function	ydom_read_chunks
+ *		Same as ydom_read_records(), but give each chunk of records
+ *		as a DOM whose document node contains the records.
+ * @param	filename	Path to the file to parse.
+ * @param	record_name	Tag name of the records.
+ * @param	nbr_threads	Number of parsing threads (0 for the number
+ *				of processors).
+ * @param	chunk_hdlr	Handler called for each chunk, in the order
+ *				of the file. It must delete the DOM with
+ *				ydom_del().
+ * @param	data		Pointer given to the handler.
+ * @return	YENOERR if OK, an error code otherwise.
+ */
+yerr_t ydom_read_chunks(const char *filename, const char *record_name,
+			int nbr_threads,
+			void (*chunk_hdlr)(ydom_t*, void*), void *data);
+
 /*!
  * @function	_ydom_get_root_node_of_node
  *		INTERNAL FUNCTION.
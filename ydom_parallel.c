@@ -0,0 +1,447 @@
+#define YMEM_TAG	YMEM_TAG_DOM
+
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "ydom.h"
+#include "yenc.h"
+#include "ylog.h"
+
+/* Minimal size of a chunk of records. */
+#define _YDOM_CHUNK_SIZE	(4 * 1024 * 1024)
+/* Number of chunks parsed in advance, for each thread. */
+#define _YDOM_CHUNKS_AHEAD	4
+
+/*
+** _ydom_chunk_t
+** A chunk of records, and the DOM of its records once parsed.
+*/
+typedef struct _ydom_chunk_s
+{
+  const char *begin;
+  const char *end;
+  ydom_t *dom;
+  yerr_t error;
+  ybool_t done;
+} _ydom_chunk_t;
+
+/*
+** _ydom_pool_t
+** Chunks of a file, shared by the parsing threads.
+*/
+typedef struct _ydom_pool_s
+{
+  _ydom_chunk_t *chunks;
+  size_t nbr_chunks;
+  size_t next;
+  size_t delivered;
+  size_t ahead;
+  ybool_t abort;
+  const char *record_name;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+} _ydom_pool_t;
+
+/* Private prototypes -- DON'T USE THEM */
+static yerr_t _ydom_read_parallel(const char *filename, const char *record_name,
+				  int nbr_threads,
+				  void (*record_hdlr)(ydom_node_t*, void*),
+				  void (*chunk_hdlr)(ydom_t*, void*),
+				  void *data);
+static ybool_t _ydom_is_record(const char *pt, const char *end,
+			       const char *record_name, size_t len);
+static const char *_ydom_find_first_record(const char *pt, const char *end,
+					   const char *record_name);
+static const char *_ydom_skip(const char *pt, const char *end,
+			      const char *delim);
+static const char *_ydom_skip_tag(const char *pt, const char *end);
+static const char *_ydom_find_records_end(const char *begin, const char *end);
+static size_t _ydom_split(_ydom_pool_t *pool, const char *begin,
+			  const char *end, size_t nbr);
+static void *_ydom_parse_chunks(void *param);
+static void _ydom_parse_chunk(_ydom_pool_t *pool, _ydom_chunk_t *chunk);
+static yerr_t _ydom_check_chunk(ydom_t *dom, const char *record_name);
+
+/*
+** ydom_read_records()
+** Parse a file of records on several threads, and call a handler
+** for each record.
+*/
+yerr_t ydom_read_records(const char *filename, const char *record_name,
+			 int nbr_threads,
+			 void (*record_hdlr)(ydom_node_t*, void*), void *data)
+{
+  return (_ydom_read_parallel(filename, record_name, nbr_threads,
+			      record_hdlr, NULL, data));
+}
+
+/*
+** ydom_read_chunks()
+** Parse a file of records on several threads, and call a handler
+** for each chunk of records.
+*/
+yerr_t ydom_read_chunks(const char *filename, const char *record_name,
+			int nbr_threads,
+			void (*chunk_hdlr)(ydom_t*, void*), void *data)
+{
+  return (_ydom_read_parallel(filename, record_name, nbr_threads,
+			      NULL, chunk_hdlr, data));
+}
+
+/*
+** _ydom_read_parallel() -- PRIVATE FUNCTION
+** Map a file, cut it into chunks of records, parse them on a pool of
+** threads, and give them to the handlers in the order of the file.
+*/
+static yerr_t _ydom_read_parallel(const char *filename, const char *record_name,
+				  int nbr_threads,
+				  void (*record_hdlr)(ydom_node_t*, void*),
+				  void (*chunk_hdlr)(ydom_t*, void*),
+				  void *data)
+{
+  _ydom_pool_t pool;
+  pthread_t *tids;
+  struct stat st;
+  ydom_node_t *node, *next;
+  const char *map, *begin, *end;
+  yerr_t res = YENOERR;
+  size_t i, nbr_chunks, nbr_started;
+  int fd;
+
+  if (!filename || !record_name || !*record_name ||
+      (fd = open(filename, O_RDONLY)) == -1)
+    {
+      YLOG_ADD(YLOG_ERR, "Bad file parameter");
+      return (YEUNDEF);
+    }
+  if (fstat(fd, &st) || !S_ISREG(st.st_mode))
+    {
+      close(fd);
+      YLOG_ADD(YLOG_ERR, "Bad file parameter");
+      return (YEUNDEF);
+    }
+  if (!st.st_size)
+    {
+      close(fd);
+      return (YENOERR);
+    }
+  map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    {
+      YLOG_ADD(YLOG_ERR, "Unable to map file");
+      return (YEIO);
+    }
+  /* chunks don't have the XML declaration, they are parsed as UTF-8 */
+  if (yenc_detect(map, (size_t)st.st_size, NULL) != YENC_UTF8)
+    {
+      munmap((void*)map, (size_t)st.st_size);
+      YLOG_ADD(YLOG_ERR, "Records files must be encoded in UTF-8");
+      return (YEINVAL);
+    }
+  /* records are between the first record start tag and the end tag
+     of the root element */
+  end = map + st.st_size;
+  if ((begin = _ydom_find_first_record(map, end, record_name)) == end)
+    {
+      munmap((void*)map, (size_t)st.st_size);
+      return (YENOERR);
+    }
+  end = _ydom_find_records_end(begin, end);
+  if (nbr_threads <= 0 && (nbr_threads = (int)sysconf(_SC_NPROCESSORS_ONLN)) <= 0)
+    nbr_threads = 1;
+  memset(&pool, 0, sizeof(pool));
+  pool.record_name = record_name;
+  pool.ahead = (size_t)nbr_threads * _YDOM_CHUNKS_AHEAD;
+  /* at least one chunk per thread, and chunks of a few MB on big files */
+  nbr_chunks = (end - begin) / _YDOM_CHUNK_SIZE + 1;
+  if (nbr_chunks < (size_t)nbr_threads &&
+      (size_t)(end - begin) >= (size_t)nbr_threads * 4096)
+    nbr_chunks = nbr_threads;
+  if (!(pool.chunks = YMALLOC(nbr_chunks * sizeof(_ydom_chunk_t))) ||
+      !(tids = YMALLOC(nbr_threads * sizeof(pthread_t))))
+    {
+      YFREE(pool.chunks);
+      munmap((void*)map, (size_t)st.st_size);
+      YLOG_ADD(YLOG_ERR, "Unable to allocate memory");
+      return (YENOMEM);
+    }
+  pool.nbr_chunks = _ydom_split(&pool, begin, end, nbr_chunks);
+  pthread_mutex_init(&pool.mutex, NULL);
+  pthread_cond_init(&pool.cond, NULL);
+  for (nbr_started = 0; nbr_started < (size_t)nbr_threads &&
+	 nbr_started < pool.nbr_chunks; ++nbr_started)
+    if (pthread_create(&tids[nbr_started], NULL, _ydom_parse_chunks, &pool))
+      break;
+  if (!nbr_started)
+    {
+      /* no thread: parse everything before giving it */
+      pool.ahead = pool.nbr_chunks;
+      _ydom_parse_chunks(&pool);
+    }
+  /* give the chunks to the handlers, in order */
+  for (i = 0; i < pool.nbr_chunks && res == YENOERR; ++i)
+    {
+      pthread_mutex_lock(&pool.mutex);
+      while (!pool.chunks[i].done)
+	pthread_cond_wait(&pool.cond, &pool.mutex);
+      pthread_mutex_unlock(&pool.mutex);
+      if ((res = pool.chunks[i].error) != YENOERR)
+	break;
+      if (chunk_hdlr)
+	chunk_hdlr(pool.chunks[i].dom, data);
+      else
+	{
+	  for (node = ydom_get_document(pool.chunks[i].dom)->first_child;
+	       node; node = next)
+	    {
+	      next = node->next;
+	      if (node->node_type == ELEMENT_NODE && record_hdlr)
+		record_hdlr(node, data);
+	    }
+	  ydom_del(pool.chunks[i].dom);
+	}
+      pool.chunks[i].dom = NULL;
+      pthread_mutex_lock(&pool.mutex);
+      pool.delivered = i + 1;
+      pthread_cond_broadcast(&pool.cond);
+      pthread_mutex_unlock(&pool.mutex);
+    }
+  pthread_mutex_lock(&pool.mutex);
+  pool.abort = YTRUE;
+  pthread_cond_broadcast(&pool.cond);
+  pthread_mutex_unlock(&pool.mutex);
+  for (i = 0; i < nbr_started; ++i)
+    pthread_join(tids[i], NULL);
+  for (i = 0; i < pool.nbr_chunks; ++i)
+    if (pool.chunks[i].dom)
+      ydom_del(pool.chunks[i].dom);
+  pthread_cond_destroy(&pool.cond);
+  pthread_mutex_destroy(&pool.mutex);
+  YFREE(tids);
+  YFREE(pool.chunks);
+  munmap((void*)map, (size_t)st.st_size);
+  return (res);
+}
+
+/*
+** _ydom_is_record() -- PRIVATE FUNCTION
+** Tell if a tag is a start tag of record.
+*/
+static ybool_t _ydom_is_record(const char *pt, const char *end,
+			       const char *record_name, size_t len)
+{
+  return ((size_t)(end - pt) > len + 1 && !memcmp(pt + 1, record_name, len) &&
+	  (IS_SPACE(pt[len + 1]) || pt[len + 1] == '>' || pt[len + 1] == '/'));
+}
+
+/*
+** _ydom_find_first_record() -- PRIVATE FUNCTION
+** Return a pointer to the start tag of the first record, or the end
+** of the buffer if there is none. Comments, processing instructions,
+** CDATA sections, DTD and attribute values before it are skipped.
+*/
+static const char *_ydom_find_first_record(const char *pt, const char *end,
+					   const char *record_name)
+{
+  size_t len = strlen(record_name);
+
+  while ((pt = memchr(pt, '<', end - pt)))
+    {
+      if (end - pt > 4 && !memcmp(pt, "<!--", 4))
+	pt = _ydom_skip(pt + 4, end, "-->");
+      else if (end - pt > 9 && !memcmp(pt, "<![CDATA[", 9))
+	pt = _ydom_skip(pt + 9, end, "]]>");
+      else if (end - pt > 1 && pt[1] == '?')
+	pt = _ydom_skip(pt + 2, end, "?>");
+      else if (end - pt > 1 && pt[1] == '!')
+	{
+	  /* DTD, with its internal subset */
+	  for (++pt; pt < end && *pt != '>' && *pt != '['; ++pt)
+	    ;
+	  pt = _ydom_skip(pt, end, (pt < end && *pt == '[') ? "]>" : ">");
+	}
+      else if (_ydom_is_record(pt, end, record_name, len))
+	return (pt);
+      else
+	pt = _ydom_skip_tag(pt + 1, end);
+      if (pt >= end)
+	return (end);
+    }
+  return (end);
+}
+
+/*
+** _ydom_skip() -- PRIVATE FUNCTION
+** Return a pointer after the next occurrence of a delimiter, or the
+** end of the buffer if there is none.
+*/
+static const char *_ydom_skip(const char *pt, const char *end,
+			      const char *delim)
+{
+  size_t len = strlen(delim);
+
+  for (; (pt = memchr(pt, *delim, end - pt)); ++pt)
+    if ((size_t)(end - pt) >= len && !memcmp(pt, delim, len))
+      return (pt + len);
+  return (end);
+}
+
+/*
+** _ydom_skip_tag() -- PRIVATE FUNCTION
+** Return a pointer after the end of a tag, out of its attribute values,
+** or the end of the buffer if there is none.
+*/
+static const char *_ydom_skip_tag(const char *pt, const char *end)
+{
+  char quote;
+
+  for (; pt < end && *pt != '>'; ++pt)
+    if (*pt == '"' || *pt == '\'')
+      {
+	quote = *pt;
+	if (!(pt = memchr(pt + 1, quote, end - pt - 1)))
+	  return (end);
+      }
+  return ((pt < end) ? pt + 1 : end);
+}
+
+/*
+** _ydom_find_records_end() -- PRIVATE FUNCTION
+** Return a pointer to the last end tag of the buffer (the end tag of
+** the root element), or the end of the buffer if there is none.
+*/
+static const char *_ydom_find_records_end(const char *begin, const char *end)
+{
+  const char *pt = end;
+
+  while ((pt = memrchr(begin, '<', pt - begin)))
+    if (pt + 1 < end && pt[1] == '/')
+      return (pt);
+  return (end);
+}
+
+/*
+** _ydom_split() -- PRIVATE FUNCTION
+** Cut the records into (at most) the given number of chunks of about
+** the same size, just before record start tags. The records are
+** scanned from the start: comments, CDATA sections, processing
+** instructions and attribute values are skipped, and the depth of the
+** elements is followed, so that chunks are cut only before records
+** which are children of the root element. Return the number of chunks.
+*/
+static size_t _ydom_split(_ydom_pool_t *pool, const char *begin,
+			  const char *end, size_t nbr)
+{
+  size_t n = 0, size, depth = 0, len = strlen(pool->record_name);
+  const char *pt = begin, *tag;
+
+  size = (end - begin) / nbr;
+  pool->chunks[0].begin = begin;
+  while (n + 1 < nbr && pt < end && (pt = memchr(pt, '<', end - pt)))
+    {
+      tag = pt;
+      if (end - pt > 4 && !memcmp(pt, "<!--", 4))
+	pt = _ydom_skip(pt + 4, end, "-->");
+      else if (end - pt > 9 && !memcmp(pt, "<![CDATA[", 9))
+	pt = _ydom_skip(pt + 9, end, "]]>");
+      else if (end - pt > 1 && pt[1] == '?')
+	pt = _ydom_skip(pt + 2, end, "?>");
+      else if (end - pt > 1 && pt[1] == '/')
+	{
+	  if (depth)
+	    depth--;
+	  pt = _ydom_skip(pt + 2, end, ">");
+	}
+      else if (end - pt > 1 && pt[1] == '!')
+	pt = _ydom_skip_tag(pt + 2, end);
+      else
+	{
+	  if (!depth && tag >= begin + (n + 1) * size &&
+	      _ydom_is_record(tag, end, pool->record_name, len))
+	    {
+	      pool->chunks[n].end = tag;
+	      pool->chunks[++n].begin = tag;
+	    }
+	  pt = _ydom_skip_tag(pt + 1, end);
+	  /* empty-element tags don't open an element */
+	  if (pt[-1] == '>' && pt[-2] != '/')
+	    depth++;
+	}
+    }
+  pool->chunks[n].end = end;
+  return (n + 1);
+}
+
+/*
+** _ydom_parse_chunks() -- PRIVATE FUNCTION
+** Thread of the pool: parse chunks until there is no more.
+*/
+static void *_ydom_parse_chunks(void *param)
+{
+  _ydom_pool_t *pool = param;
+  _ydom_chunk_t *chunk;
+  size_t i;
+
+  for (; ; )
+    {
+      pthread_mutex_lock(&pool->mutex);
+      /* don't parse too far ahead of the handlers */
+      while (!pool->abort && pool->next < pool->nbr_chunks &&
+	     pool->next >= pool->delivered + pool->ahead)
+	pthread_cond_wait(&pool->cond, &pool->mutex);
+      if (pool->abort || pool->next >= pool->nbr_chunks)
+	{
+	  pthread_mutex_unlock(&pool->mutex);
+	  return (NULL);
+	}
+      i = pool->next++;
+      pthread_mutex_unlock(&pool->mutex);
+      chunk = &pool->chunks[i];
+      _ydom_parse_chunk(pool, chunk);
+      pthread_mutex_lock(&pool->mutex);
+      chunk->done = YTRUE;
+      pthread_cond_broadcast(&pool->cond);
+      pthread_mutex_unlock(&pool->mutex);
+    }
+}
+
+/*
+** _ydom_parse_chunk() -- PRIVATE FUNCTION
+** Parse a chunk, and check that it contains complete records.
+*/
+static void _ydom_parse_chunk(_ydom_pool_t *pool, _ydom_chunk_t *chunk)
+{
+  if (!(chunk->dom = ydom_new()))
+    chunk->error = YENOMEM;
+  else if ((chunk->error = ydom_read_buffer(chunk->dom, chunk->begin,
+					     chunk->end - chunk->begin)) == YENOERR)
+    chunk->error = _ydom_check_chunk(chunk->dom, pool->record_name);
+}
+
+/*
+** _ydom_check_chunk() -- PRIVATE FUNCTION
+** Check that a chunk was cut at the right places: all its elements
+** must be complete records.
+*/
+static yerr_t _ydom_check_chunk(ydom_t *dom, const char *record_name)
+{
+  ydom_node_t *node;
+
+  if (dom->current_parsed_node != dom->document_element)
+    {
+      YLOG_ADD(YLOG_ERR, "Incomplete record");
+      return (YESYNTAX);
+    }
+  for (node = dom->document_element->first_child; node; node = node->next)
+    if (node->node_type == TEXT_NODE ||
+	(node->node_type == ELEMENT_NODE && strcmp(node->name, record_name)))
+      {
+	YLOG_ADD(YLOG_ERR, "Data outside of records");
+	return (YESYNTAX);
+      }
+  return (YENOERR);
+}
@@ -1,3 +1,5 @@
+#define YMEM_TAG	YMEM_TAG_DOM
+
 #include "ydom.h"
 #include "ylog.h"
 
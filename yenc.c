@@ -0,0 +1,407 @@
+#include <string.h>
+#include <strings.h>
+#include "yenc.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define _YENC_X86
+# include <immintrin.h>
+#endif /* __GNUC__ && (__x86_64__ || __i386__) */
+
+/**
+ * @typedef	_yenc_ascii_func_t
+ *		Search the first non-ASCII byte of a buffer.
+ */
+typedef const unsigned char *(*_yenc_ascii_func_t)(const unsigned char *begin, const unsigned char *end);
+
+/**
+ * @typedef	_yenc_narrow_func_t
+ *		Convert the ASCII characters which begin some UTF-16 data.
+ */
+typedef void (*_yenc_narrow_func_t)(const unsigned char **src, const unsigned char *end,
+				    unsigned char **dest, ybool_t big_endian);
+
+/**
+ * @typedef	_yenc_name_t
+ *		Name of an encoding.
+ * @field	name	The name.
+ * @field	enc	The encoding.
+ */
+typedef struct _yenc_name_s {
+	const char	*name;
+	yenc_t		enc;
+} _yenc_name_t;
+
+/* *** definition of private functions *** */
+static const unsigned char *_yenc_ascii_dispatch(const unsigned char *begin, const unsigned char *end);
+static void _yenc_narrow_dispatch(const unsigned char **src, const unsigned char *end,
+				  unsigned char **dest, ybool_t big_endian);
+static const unsigned char *_yenc_ascii_scalar(const unsigned char *begin, const unsigned char *end);
+static void _yenc_narrow_scalar(const unsigned char **src, const unsigned char *end,
+				unsigned char **dest, ybool_t big_endian);
+#ifdef _YENC_X86
+static const unsigned char *_yenc_ascii_sse2(const unsigned char *begin, const unsigned char *end) __attribute__((target("sse2")));
+static const unsigned char *_yenc_ascii_avx2(const unsigned char *begin, const unsigned char *end) __attribute__((target("avx2")));
+static void _yenc_narrow_sse2(const unsigned char **src, const unsigned char *end,
+			      unsigned char **dest, ybool_t big_endian) __attribute__((target("sse2")));
+#endif /* _YENC_X86 */
+static int _yenc_utf8_seq(const unsigned char *pt, const unsigned char *end);
+static void _yenc_latin1_to_utf8(const unsigned char **src, const unsigned char *end, unsigned char **dest);
+static yerr_t _yenc_utf16_to_utf8(const unsigned char **src, const unsigned char *end,
+				  unsigned char **dest, ybool_t big_endian);
+
+/** @var _yenc_ascii_func Current search of non-ASCII bytes; the first call chooses it. */
+static _yenc_ascii_func_t _yenc_ascii_func = _yenc_ascii_dispatch;
+
+/** @var _yenc_narrow_func Current conversion of UTF-16 ASCII; the first call chooses it. */
+static _yenc_narrow_func_t _yenc_narrow_func = _yenc_narrow_dispatch;
+
+/** @var _yenc_names Names of the supported encodings. UTF-16 without byte
+    order mark is not supported. */
+static const _yenc_name_t _yenc_names[] = {
+	{"UTF-8", YENC_UTF8},
+	{"UTF8", YENC_UTF8},
+	{"US-ASCII", YENC_UTF8},
+	{"ASCII", YENC_UTF8},
+	{"ISO-8859-1", YENC_LATIN1},
+	{"ISO8859-1", YENC_LATIN1},
+	{"ISO_8859-1", YENC_LATIN1},
+	{"LATIN1", YENC_LATIN1},
+	{"LATIN-1", YENC_LATIN1},
+	{"UTF-16LE", YENC_UTF16LE},
+	{"UTF-16BE", YENC_UTF16BE},
+	{NULL, YENC_UNKNOWN}
+};
+
+/*
+ * yenc_detect()
+ * Detect the encoding of an XML document from its first bytes.
+ */
+yenc_t yenc_detect(const char *data, size_t len, size_t *bom_len) {
+	const unsigned char	*pt = (const unsigned char*)data;
+	const char		*decl_end, *name, *name_end;
+	yenc_t			enc;
+
+	if (bom_len)
+		*bom_len = 0;
+	/* byte order marks */
+	if (len >= 3 && pt[0] == 0xEF && pt[1] == 0xBB && pt[2] == 0xBF) {
+		if (bom_len)
+			*bom_len = 3;
+		return (YENC_UTF8);
+	}
+	if (len >= 2 && pt[0] == 0xFF && pt[1] == 0xFE) {
+		if (bom_len)
+			*bom_len = 2;
+		return (YENC_UTF16LE);
+	}
+	if (len >= 2 && pt[0] == 0xFE && pt[1] == 0xFF) {
+		if (bom_len)
+			*bom_len = 2;
+		return (YENC_UTF16BE);
+	}
+	/* UTF-16 declaration without byte order mark */
+	if (len >= 4 && pt[0] == '<' && !pt[1] && pt[2] == '?' && !pt[3])
+		return (YENC_UTF16LE);
+	if (len >= 4 && !pt[0] && pt[1] == '<' && !pt[2] && pt[3] == '?')
+		return (YENC_UTF16BE);
+	/* encoding declaration: <?xml version="1.0" encoding="..."?> */
+	if (len < 5 || memcmp(data, "<?xml", 5) ||
+	    (decl_end = memmem(data, len, "?>", 2)) == NULL ||
+	    (name = memmem(data, decl_end - data, "encoding", 8)) == NULL)
+		return (YENC_UTF8);
+	for (name += 8; name < decl_end && (IS_SPACE(*name) || *name == '='); name++)
+		;
+	if (name == decl_end || (*name != '"' && *name != '\'') ||
+	    (name_end = memchr(name + 1, *name, decl_end - name - 1)) == NULL)
+		return (YENC_UTF8);
+	enc = yenc_from_name(name + 1, name_end - name - 1);
+	/* these bytes are not UTF-16, whatever the declaration says */
+	return ((enc == YENC_UTF16LE || enc == YENC_UTF16BE) ? YENC_UTF8 : enc);
+}
+
+/*
+ * yenc_from_name()
+ * Return the encoding which has a name.
+ */
+yenc_t yenc_from_name(const char *name, size_t len) {
+	const _yenc_name_t	*pt;
+
+	for (pt = _yenc_names; pt->name != NULL; pt++)
+		if (strlen(pt->name) == len && !strncasecmp(pt->name, name, len))
+			return (pt->enc);
+	return (YENC_UNKNOWN);
+}
+
+/*
+ * yenc_utf8_check()
+ * Search the first invalid UTF-8 sequence of a buffer.
+ */
+const char *yenc_utf8_check(const char *begin, const char *end) {
+	const unsigned char	*pt = (const unsigned char*)begin;
+	const unsigned char	*uend = (const unsigned char*)end;
+	int			len;
+
+	while (pt < uend) {
+		pt = _yenc_ascii_func(pt, uend);
+		for (; pt < uend && *pt >= 0x80; pt += len)
+			if ((len = _yenc_utf8_seq(pt, uend)) <= 0)
+				return ((const char*)pt);
+	}
+	return (end);
+}
+
+/*
+ * yenc_utf8_truncated()
+ * Tell if a buffer holds the beginning of a valid UTF-8 sequence.
+ */
+ybool_t yenc_utf8_truncated(const char *begin, const char *end) {
+	return ((begin < end &&
+		 _yenc_utf8_seq((const unsigned char*)begin, (const unsigned char*)end) == -1) ?
+		YTRUE : YFALSE);
+}
+
+/*
+ * yenc_to_utf8()
+ * Convert data into UTF-8.
+ */
+yerr_t yenc_to_utf8(yenc_t enc, const char **src, const char *src_end, char **dest) {
+	switch (enc) {
+	case YENC_LATIN1:
+		_yenc_latin1_to_utf8((const unsigned char**)src, (const unsigned char*)src_end,
+				     (unsigned char**)dest);
+		return (YENOERR);
+	case YENC_UTF16LE:
+	case YENC_UTF16BE:
+		return (_yenc_utf16_to_utf8((const unsigned char**)src, (const unsigned char*)src_end,
+					    (unsigned char**)dest, enc == YENC_UTF16BE));
+	default:
+		memcpy(*dest, *src, src_end - *src);
+		*dest += src_end - *src;
+		*src = src_end;
+		return (YENOERR);
+	}
+}
+
+/* *************** PRIVATE FUNCTIONS ************** */
+/*
+ * _yenc_ascii_dispatch()
+ * Initial search of non-ASCII bytes: choose the best one, and use it.
+ */
+static const unsigned char *_yenc_ascii_dispatch(const unsigned char *begin, const unsigned char *end) {
+	_yenc_ascii_func = _yenc_ascii_scalar;
+#ifdef _YENC_X86
+	if (__builtin_cpu_supports("avx2"))
+		_yenc_ascii_func = _yenc_ascii_avx2;
+	else if (__builtin_cpu_supports("sse2"))
+		_yenc_ascii_func = _yenc_ascii_sse2;
+#endif /* _YENC_X86 */
+	return (_yenc_ascii_func(begin, end));
+}
+
+/*
+ * _yenc_narrow_dispatch()
+ * Initial conversion of UTF-16 ASCII: choose the best one, and use it.
+ */
+static void _yenc_narrow_dispatch(const unsigned char **src, const unsigned char *end,
+				  unsigned char **dest, ybool_t big_endian) {
+	_yenc_narrow_func = _yenc_narrow_scalar;
+#ifdef _YENC_X86
+	if (__builtin_cpu_supports("sse2"))
+		_yenc_narrow_func = _yenc_narrow_sse2;
+#endif /* _YENC_X86 */
+	_yenc_narrow_func(src, end, dest, big_endian);
+}
+
+/*
+ * _yenc_ascii_scalar()
+ * Byte by byte search of non-ASCII bytes. Also used for the tail of the
+ * buffer by the vectorized ones.
+ */
+static const unsigned char *_yenc_ascii_scalar(const unsigned char *begin, const unsigned char *end) {
+	while (begin < end && *begin < 0x80)
+		begin++;
+	return (begin);
+}
+
+/*
+ * _yenc_narrow_scalar()
+ * Convert UTF-16 ASCII characters one by one.
+ */
+static void _yenc_narrow_scalar(const unsigned char **src, const unsigned char *end,
+				unsigned char **dest, ybool_t big_endian) {
+	const unsigned char	*pt = *src;
+	unsigned char		*out = *dest;
+
+	for (; end - pt >= 2 && !pt[!big_endian] && pt[big_endian] < 0x80; pt += 2)
+		*out++ = pt[big_endian];
+	*src = pt;
+	*dest = out;
+}
+
+#ifdef _YENC_X86
+/*
+ * _yenc_ascii_sse2()
+ * Check the high bits of 16 bytes at a time.
+ */
+static const unsigned char *_yenc_ascii_sse2(const unsigned char *begin, const unsigned char *end) {
+	int	mask;
+
+	for (; end - begin >= 16; begin += 16)
+		if ((mask = _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)begin))) != 0)
+			return (begin + __builtin_ctz((unsigned int)mask));
+	return (_yenc_ascii_scalar(begin, end));
+}
+
+/*
+ * _yenc_ascii_avx2()
+ * Check the high bits of 32 bytes at a time.
+ */
+static const unsigned char *_yenc_ascii_avx2(const unsigned char *begin, const unsigned char *end) {
+	unsigned int	mask;
+
+	for (; end - begin >= 32; begin += 32)
+		if ((mask = (unsigned int)_mm256_movemask_epi8(_mm256_loadu_si256((const __m256i*)begin))) != 0)
+			return (begin + __builtin_ctz(mask));
+	return (_yenc_ascii_sse2(begin, end));
+}
+
+/*
+ * _yenc_narrow_sse2()
+ * Convert 8 UTF-16 ASCII characters at a time, by packing them into bytes.
+ */
+static void _yenc_narrow_sse2(const unsigned char **src, const unsigned char *end,
+			      unsigned char **dest, ybool_t big_endian) {
+	const unsigned char	*pt = *src;
+	unsigned char		*out = *dest;
+	__m128i			units;
+	const __m128i		high = _mm_set1_epi16((short)0xFF80);
+	const __m128i		zero = _mm_setzero_si128();
+
+	for (; end - pt >= 16; pt += 16, out += 8) {
+		units = _mm_loadu_si128((const __m128i*)pt);
+		if (big_endian)
+			units = _mm_or_si128(_mm_slli_epi16(units, 8), _mm_srli_epi16(units, 8));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(units, high), zero)) != 0xFFFF)
+			break;
+		_mm_storel_epi64((__m128i*)out, _mm_packus_epi16(units, units));
+	}
+	*src = pt;
+	*dest = out;
+	_yenc_narrow_scalar(src, end, dest, big_endian);
+}
+#endif /* _YENC_X86 */
+
+/*
+ * _yenc_utf8_seq()
+ * Return the length of the UTF-8 sequence which begins a buffer, 0 if it
+ * is invalid, -1 if it is truncated by the end of the buffer.
+ */
+static int _yenc_utf8_seq(const unsigned char *pt, const unsigned char *end) {
+	unsigned char	low = 0x80, high = 0xBF;
+	int		len, i;
+
+	if (*pt < 0x80)
+		return (1);
+	if (*pt < 0xC2)
+		return (0);
+	if (*pt < 0xE0)
+		len = 2;
+	else if (*pt < 0xF0) {
+		/* no overlong forms, no surrogates */
+		len = 3;
+		if (*pt == 0xE0)
+			low = 0xA0;
+		else if (*pt == 0xED)
+			high = 0x9F;
+	} else if (*pt < 0xF5) {
+		/* no overlong forms, nothing over U+10FFFF */
+		len = 4;
+		if (*pt == 0xF0)
+			low = 0x90;
+		else if (*pt == 0xF4)
+			high = 0x8F;
+	} else
+		return (0);
+	for (i = 1; i < len; i++) {
+		if (pt + i == end)
+			return (-1);
+		if (pt[i] < low || pt[i] > high)
+			return (0);
+		low = 0x80;
+		high = 0xBF;
+	}
+	return (len);
+}
+
+/*
+ * _yenc_latin1_to_utf8()
+ * Convert ISO-8859-1 data into UTF-8. Runs of ASCII characters are copied
+ * at once.
+ */
+static void _yenc_latin1_to_utf8(const unsigned char **src, const unsigned char *end, unsigned char **dest) {
+	const unsigned char	*pt = *src, *ascii;
+	unsigned char		*out = *dest;
+
+	while (pt < end) {
+		ascii = _yenc_ascii_func(pt, end);
+		memcpy(out, pt, ascii - pt);
+		out += ascii - pt;
+		for (pt = ascii; pt < end && *pt >= 0x80; pt++) {
+			*out++ = 0xC0 | (*pt >> 6);
+			*out++ = 0x80 | (*pt & 0x3F);
+		}
+	}
+	*src = pt;
+	*dest = out;
+}
+
+/*
+ * _yenc_utf16_to_utf8()
+ * Convert UTF-16 data into UTF-8.
+ */
+static yerr_t _yenc_utf16_to_utf8(const unsigned char **src, const unsigned char *end,
+				  unsigned char **dest, ybool_t big_endian) {
+	const unsigned char	*pt = *src;
+	unsigned char		*out = *dest;
+	unsigned long		c, c2;
+	yerr_t			res = YENOERR;
+
+	while (end - pt >= 2) {
+		c = big_endian ? ((pt[0] << 8) | pt[1]) : ((pt[1] << 8) | pt[0]);
+		if (c < 0x80) {
+			_yenc_narrow_func(&pt, end, &out, big_endian);
+			continue;
+		}
+		if (c < 0x800) {
+			*out++ = 0xC0 | (c >> 6);
+			*out++ = 0x80 | (c & 0x3F);
+		} else if (c < 0xD800 || c > 0xDFFF) {
+			*out++ = 0xE0 | (c >> 12);
+			*out++ = 0x80 | ((c >> 6) & 0x3F);
+			*out++ = 0x80 | (c & 0x3F);
+		} else {
+			/* surrogate pair */
+			if (c >= 0xDC00) {
+				res = YEILSEQ;
+				break;
+			}
+			if (end - pt < 4)
+				break;
+			c2 = big_endian ? ((pt[2] << 8) | pt[3]) : ((pt[3] << 8) | pt[2]);
+			if (c2 < 0xDC00 || c2 > 0xDFFF) {
+				res = YEILSEQ;
+				break;
+			}
+			c = 0x10000 + ((c - 0xD800) << 10) + (c2 - 0xDC00);
+			*out++ = 0xF0 | (c >> 18);
+			*out++ = 0x80 | ((c >> 12) & 0x3F);
+			*out++ = 0x80 | ((c >> 6) & 0x3F);
+			*out++ = 0x80 | (c & 0x3F);
+			pt += 2;
+		}
+		pt += 2;
+	}
+	*src = pt;
+	*dest = out;
+	return (res);
+}
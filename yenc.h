@@ -0,0 +1,114 @@
+/* Process this file with the HeaderBrowser tool (http://www.headerbrowser.org)
+   to create documentation. */
+/*!
+ * @header	yenc.h
+ * @abstract	Detection of XML encodings, UTF-8 validation and transcoding.
+ * @discussion	The encoding of an XML document is given by its byte order
+ *		mark, or by the encoding declaration of its first line, and
+ *		is UTF-8 otherwise. ISO-8859-1 and UTF-16 (little or big
+ *		endian) data could be converted into UTF-8 by blocks; UTF-8
+ *		data could be validated by blocks. On x86 processors, runs of
+ *		ASCII characters are skipped or copied 32 bytes at a time with
+ *		AVX2, or 16 bytes at a time with SSE2, chosen at runtime as in
+ *		yscan.h; other characters are handled one by one.
+ * @version	1.0 Oct 19 2026
+ * @author	Amaury Bouchard <amaury@amaury.net>
+ */
+#ifndef __YENC_H__
+#define __YENC_H__
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif /* __cplusplus || c_plusplus */
+
+#include "ydefs.h"
+#include "yerror.h"
+
+/** @define YENC_DETECT_SIZE Number of bytes needed to detect an encoding. */
+#define YENC_DETECT_SIZE	256
+
+/**
+ * @typedef	yenc_t
+ *		Character encodings.
+ * @constant	YENC_UNKNOWN	Unsupported encoding: data is given as is.
+ * @constant	YENC_UTF8	UTF-8 (or ASCII).
+ * @constant	YENC_LATIN1	ISO-8859-1.
+ * @constant	YENC_UTF16LE	UTF-16, little endian.
+ * @constant	YENC_UTF16BE	UTF-16, big endian.
+ */
+typedef enum yenc_e {
+	YENC_UNKNOWN = 0,
+	YENC_UTF8,
+	YENC_LATIN1,
+	YENC_UTF16LE,
+	YENC_UTF16BE
+} yenc_t;
+
+/* ****************** FUNCTIONS **************** */
+/**
+ * @function	yenc_detect
+ *		Detect the encoding of an XML document from its first bytes
+ *		(YENC_DETECT_SIZE bytes are enough).
+ * @param	data	Beginning of the document.
+ * @param	len	Number of bytes.
+ * @param	bom_len	Set to the length of the byte order mark (0 if
+ *			there is none). Could be NULL.
+ * @return	The encoding; YENC_UNKNOWN if the declared encoding is not
+ *		supported.
+ */
+yenc_t yenc_detect(const char *data, size_t len, size_t *bom_len);
+
+/**
+ * @function	yenc_from_name
+ *		Return the encoding which has a name (case insensitive), like
+ *		"UTF-8" or "ISO-8859-1".
+ * @param	name	The name.
+ * @param	len	Length of the name.
+ * @return	The encoding, or YENC_UNKNOWN.
+ */
+yenc_t yenc_from_name(const char *name, size_t len);
+
+/**
+ * @function	yenc_utf8_check
+ *		Search the first invalid UTF-8 sequence of a buffer (overlong
+ *		forms, surrogates and code points over U+10FFFF are invalid).
+ * @param	begin	Beginning of the buffer.
+ * @param	end	End of the buffer (first byte after it).
+ * @return	A pointer to the first sequence which is invalid or truncated
+ *		by the end of the buffer, or end if the buffer is valid.
+ */
+const char *yenc_utf8_check(const char *begin, const char *end);
+
+/**
+ * @function	yenc_utf8_truncated
+ *		Tell if a buffer holds the beginning of a valid UTF-8 sequence,
+ *		to complete with the next block of data.
+ * @param	begin	Beginning of the sequence.
+ * @param	end	End of the buffer.
+ * @return	YTRUE if the sequence is truncated, YFALSE otherwise.
+ */
+ybool_t yenc_utf8_truncated(const char *begin, const char *end);
+
+/**
+ * @function	yenc_to_utf8
+ *		Convert data into UTF-8. Conversion stops before a character
+ *		which is truncated by the end of the source (its bytes must be
+ *		given again with the next block of data). UTF-8 and unknown
+ *		encodings are copied as is.
+ * @param	enc	Encoding of the source.
+ * @param	src	Pointer to the source; moved after the converted
+ *			characters.
+ * @param	src_end	End of the source.
+ * @param	dest	Pointer to the destination, which must have room for
+ *			two bytes per byte of source; moved after the
+ *			written bytes.
+ * @return	YENOERR if OK, YEILSEQ if the source holds an invalid
+ *		UTF-16 sequence (*src points to it).
+ */
+yerr_t yenc_to_utf8(yenc_t enc, const char **src, const char *src_end, char **dest);
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif /* __cplusplus || c_plusplus */
+
+#endif /* __YENC_H__ */
@@ -0,0 +1,505 @@
+#define YMEM_TAG	YMEM_TAG_HASH
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "ycrc.h"
+#include "yhashfile.h"
+
+/** @define _YHF_ALIGN Round a size up to the next multiple of 8. */
+#define _YHF_ALIGN(s)	(((s) + 7) & ~((u64_t)7))
+
+/** @define _YHF_MIN_BUCKETS Minimum number of buckets in a hash file. */
+#define _YHF_MIN_BUCKETS	16
+
+/**
+ * @typedef	_yhf_writer_t
+ *		Context used while writing a hash file.
+ * @field	file		The opened temporary file.
+ * @field	offset		Current offset in the file.
+ * @field	crc		Running CRC of the content after the header.
+ * @field	entries		Array of entries, in insertion order.
+ * @field	nbr_entries	Number of entries.
+ * @field	size_entries	Allocated size of the array of entries.
+ * @field	value_func	Function used to get elements' values.
+ * @field	user_data	Pointer given to the value function.
+ * @field	status		YENOERR, or the first error that occured.
+ */
+typedef struct _yhf_writer_s {
+	FILE			*file;
+	u64_t			offset;
+	ycrc_t			crc;
+	yhf_entry_t		*entries;
+	size_t			nbr_entries;
+	size_t			size_entries;
+	yhf_value_func_t	value_func;
+	void			*user_data;
+	yerr_t			status;
+} _yhf_writer_t;
+
+/* *** definition of private functions *** */
+static yerr_t _yhf_errno_to_yerr(int err);
+static yerr_t _yhf_writer_open(_yhf_writer_t *writer, char *tmp_filename, const char *filename,
+			       yhf_value_func_t value_func, void *user_data);
+static void _yhf_writer_write(_yhf_writer_t *writer, const void *data, size_t len);
+static void _yhf_writer_pad(_yhf_writer_t *writer);
+static void _yhf_writer_add(_yhf_writer_t *writer, const char *key, void *data);
+static yerr_t _yhf_writer_close(_yhf_writer_t *writer, const char *tmp_filename, const char *filename);
+static void _yhf_hashtable_func(yht_hash_value_t hash_value, char *key, void *data, void *user_data);
+static void _yhf_hashmap_func(char *key, void *data, void *user_data);
+static char *_yhf_tmp_filename(const char *filename);
+static void _yhf_sync_dir(const char *filename);
+
+/*
+ * yhf_write_hashtable()
+ * Write the elements of a hash table in a hash file.
+ */
+yerr_t yhf_write_hashtable(yhashtable_t *hashtable, const char *filename, yhf_value_func_t value_func, void *user_data) {
+	_yhf_writer_t	writer;
+	char		*tmp_filename;
+	yerr_t		res;
+
+	if (!hashtable || !filename)
+		return (YEINVAL);
+	if ((tmp_filename = _yhf_tmp_filename(filename)) == NULL)
+		return (YENOMEM);
+	if ((res = _yhf_writer_open(&writer, tmp_filename, filename, value_func, user_data)) != YENOERR) {
+		YFREE(tmp_filename);
+		return (res);
+	}
+	yht_foreach(hashtable, _yhf_hashtable_func, &writer);
+	res = _yhf_writer_close(&writer, tmp_filename, filename);
+	YFREE(tmp_filename);
+	return (res);
+}
+
+/*
+ * yhf_write_hashmap()
+ * Write the elements of a hash map in a hash file.
+ */
+yerr_t yhf_write_hashmap(yhashmap_t *hashmap, const char *filename, yhf_value_func_t value_func, void *user_data) {
+	_yhf_writer_t	writer;
+	char		*tmp_filename;
+	yerr_t		res;
+
+	if (!hashmap || !filename)
+		return (YEINVAL);
+	if ((tmp_filename = _yhf_tmp_filename(filename)) == NULL)
+		return (YENOMEM);
+	if ((res = _yhf_writer_open(&writer, tmp_filename, filename, value_func, user_data)) != YENOERR) {
+		YFREE(tmp_filename);
+		return (res);
+	}
+	yhm_foreach(hashmap, _yhf_hashmap_func, &writer);
+	res = _yhf_writer_close(&writer, tmp_filename, filename);
+	YFREE(tmp_filename);
+	return (res);
+}
+
+/*
+ * yhf_open()
+ * Map a hash file in memory.
+ */
+yerr_t yhf_open(const char *filename, ybool_t check_crc, yhashfile_t **hashfile) {
+	int			fd;
+	struct stat		st;
+	void			*map;
+	const yhf_header_t	*header;
+	const u64_t		*buckets;
+	u64_t			i;
+	ycrc_t			crc;
+	ybin_t			bin;
+	yhashfile_t		*result;
+
+	if (!filename || !hashfile)
+		return (YEINVAL);
+	*hashfile = NULL;
+	if ((fd = open(filename, O_RDONLY)) == -1)
+		return (_yhf_errno_to_yerr(errno));
+	if (fstat(fd, &st) == -1) {
+		close(fd);
+		return (_yhf_errno_to_yerr(errno));
+	}
+	if ((size_t)st.st_size < sizeof(yhf_header_t)) {
+		close(fd);
+		return (YEBADMSG);
+	}
+	map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return (_yhf_errno_to_yerr(errno));
+	/* check the header */
+	header = (const yhf_header_t*)map;
+	if (memcmp(header->magic, YHF_MAGIC, sizeof(header->magic)) ||
+	    header->version != YHF_VERSION ||
+	    header->byte_order != YHF_BYTE_ORDER ||
+	    header->file_size != (u64_t)st.st_size ||
+	    !header->nbr_buckets ||
+	    (header->nbr_buckets & (header->nbr_buckets - 1)) ||
+	    header->buckets_offset % 8 || header->entries_offset % 8 ||
+	    header->buckets_offset < sizeof(yhf_header_t) ||
+	    header->nbr_buckets >= header->file_size / sizeof(u64_t) ||
+	    header->buckets_offset + (header->nbr_buckets + 1) * sizeof(u64_t) != header->entries_offset ||
+	    header->nbr_entries > header->file_size / sizeof(yhf_entry_t) ||
+	    header->entries_offset + header->nbr_entries * sizeof(yhf_entry_t) != header->file_size) {
+		munmap(map, (size_t)st.st_size);
+		return (YEBADMSG);
+	}
+	/* check the bucket indexes */
+	buckets = (const u64_t*)((const char*)map + header->buckets_offset);
+	for (i = 0; i < header->nbr_buckets; i++) {
+		if (buckets[i] > buckets[i + 1])
+			break;
+	}
+	if (buckets[0] || i < header->nbr_buckets || buckets[i] != header->nbr_entries) {
+		munmap(map, (size_t)st.st_size);
+		return (YEBADMSG);
+	}
+	/* check the CRC */
+	if (check_crc) {
+		crc = ycrc_init();
+		for (i = sizeof(yhf_header_t); i < header->file_size; i += bin.len) {
+			bin.data = (char*)map + i;
+			bin.len = (header->file_size - i > 0x40000000) ? 0x40000000 : (unsigned int)(header->file_size - i);
+			ycrc_add_bin(&crc, &bin);
+		}
+		if (ycrc_compute(&crc) != header->crc) {
+			munmap(map, (size_t)st.st_size);
+			return (YEBADMSG);
+		}
+	}
+	result = (yhashfile_t*)YMALLOC(sizeof(yhashfile_t));
+	if (!result) {
+		munmap(map, (size_t)st.st_size);
+		return (YENOMEM);
+	}
+	result->map = map;
+	result->map_size = (size_t)st.st_size;
+	result->header = header;
+	result->buckets = buckets;
+	result->entries = (const yhf_entry_t*)((const char*)map + header->entries_offset);
+	*hashfile = result;
+	return (YENOERR);
+}
+
+/*
+ * yhf_close()
+ * Unmap a hash file.
+ */
+void yhf_close(yhashfile_t *hashfile) {
+	if (!hashfile)
+		return;
+	munmap(hashfile->map, hashfile->map_size);
+	YFREE(hashfile);
+}
+
+/*
+ * yhf_search()
+ * Search a value in a hash file, from its key.
+ */
+const void *yhf_search(yhashfile_t *hashfile, const char *key, size_t *value_len) {
+	u64_t			hash_value, i, end, bucket;
+	size_t			key_len;
+	const yhf_entry_t	*entry;
+	const char		*ptr;
+
+	if (!hashfile || !key)
+		return (NULL);
+	key_len = strlen(key);
+	hash_value = yhf_hash(key, key_len);
+	bucket = hash_value & (hashfile->header->nbr_buckets - 1);
+	end = hashfile->buckets[bucket + 1];
+	for (i = hashfile->buckets[bucket]; i < end; i++) {
+		entry = &hashfile->entries[i];
+		if (entry->hash_value != hash_value || entry->key_len != key_len)
+			continue;
+		/* the entry must lie in the data area */
+		if (entry->key_offset < sizeof(yhf_header_t) ||
+		    _YHF_ALIGN(entry->key_offset + key_len + 1) + entry->value_len > hashfile->header->buckets_offset)
+			return (NULL);
+		ptr = (const char*)hashfile->map + entry->key_offset;
+		if (memcmp(ptr, key, key_len))
+			continue;
+		if (value_len)
+			*value_len = entry->value_len;
+		return ((const char*)hashfile->map + _YHF_ALIGN(entry->key_offset + key_len + 1));
+	}
+	return (NULL);
+}
+
+/*
+ * yhf_get_nbr_entries()
+ * Return the number of entries of a hash file.
+ */
+size_t yhf_get_nbr_entries(yhashfile_t *hashfile) {
+	return (hashfile ? (size_t)hashfile->header->nbr_entries : 0);
+}
+
+/*
+ * yhf_hash()
+ * Compute the hash value of a key, as stored in hash files.
+ */
+u64_t yhf_hash(const char *key, size_t key_len) {
+	u64_t			hash_value;
+	const unsigned char	*ptr;
+
+	for (hash_value = 0, ptr = (const unsigned char*)key; key_len; key_len--, ptr++)
+		hash_value = *ptr + (hash_value << 6) + (hash_value << 16) - hash_value;
+	return (hash_value);
+}
+
+/* *************** PRIVATE FUNCTIONS ************** */
+/*
+ * _yhf_errno_to_yerr()
+ * Convert a system error number to an error code.
+ */
+static yerr_t _yhf_errno_to_yerr(int err) {
+	if (err == ENOENT)
+		return (YENOENT);
+	if (err == EACCES)
+		return (YEACCES);
+	if (err == ENOMEM)
+		return (YENOMEM);
+	return (YEIO);
+}
+
+/*
+ * _yhf_tmp_filename()
+ * Return the template of the name of the temporary file used to write a
+ * hash file, in the same directory (see mkstemp()).
+ */
+static char *_yhf_tmp_filename(const char *filename) {
+	char	*tmp_filename;
+	size_t	len;
+
+	len = strlen(filename);
+	if ((tmp_filename = (char*)YMALLOC_RAW(len + 8)) == NULL)
+		return (NULL);
+	memcpy(tmp_filename, filename, len);
+	memcpy(tmp_filename + len, ".XXXXXX", 8);
+	return (tmp_filename);
+}
+
+/*
+ * _yhf_sync_dir()
+ * Flush the directory of a file to disk, so that its renaming is durable.
+ * Errors are ignored: the file itself is already safe.
+ */
+static void _yhf_sync_dir(const char *filename) {
+	char		*dirname;
+	const char	*slash;
+	int		fd;
+
+	if ((slash = strrchr(filename, '/')) == NULL)
+		fd = open(".", O_RDONLY);
+	else if (slash == filename)
+		fd = open("/", O_RDONLY);
+	else {
+		if ((dirname = (char*)YMALLOC_RAW(slash - filename + 1)) == NULL)
+			return;
+		memcpy(dirname, filename, slash - filename);
+		dirname[slash - filename] = '\0';
+		fd = open(dirname, O_RDONLY);
+		YFREE(dirname);
+	}
+	if (fd == -1)
+		return;
+	fsync(fd);
+	close(fd);
+}
+
+/*
+ * _yhf_writer_open()
+ * Create a unique temporary file and write an empty header in it. The file
+ * gets the permissions of the file it will replace, or 0644.
+ */
+static yerr_t _yhf_writer_open(_yhf_writer_t *writer, char *tmp_filename, const char *filename,
+			       yhf_value_func_t value_func, void *user_data) {
+	yhf_header_t	header;
+	struct stat	st;
+	int		fd, err;
+
+	memset(writer, 0, sizeof(_yhf_writer_t));
+	if ((fd = mkstemp(tmp_filename)) == -1)
+		return (_yhf_errno_to_yerr(errno));
+	if (fchmod(fd, stat(filename, &st) ? 0644 : (st.st_mode & 07777)) ||
+	    (writer->file = fdopen(fd, "wb")) == NULL) {
+		err = errno;
+		close(fd);
+		unlink(tmp_filename);
+		return (_yhf_errno_to_yerr(err));
+	}
+	writer->value_func = value_func;
+	writer->user_data = user_data;
+	writer->status = YENOERR;
+	memset(&header, 0, sizeof(header));
+	if (fwrite(&header, sizeof(header), 1, writer->file) != 1) {
+		fclose(writer->file);
+		unlink(tmp_filename);
+		return (YEIO);
+	}
+	writer->offset = sizeof(header);
+	writer->crc = ycrc_init();
+	return (YENOERR);
+}
+
+/*
+ * _yhf_writer_write()
+ * Write data in the file, after the header.
+ */
+static void _yhf_writer_write(_yhf_writer_t *writer, const void *data, size_t len) {
+	ybin_t	bin;
+
+	if (writer->status != YENOERR || !len)
+		return;
+	if (fwrite(data, 1, len, writer->file) != len) {
+		writer->status = YEIO;
+		return;
+	}
+	bin.data = (void*)data;
+	bin.len = (unsigned int)len;
+	ycrc_add_bin(&writer->crc, &bin);
+	writer->offset += len;
+}
+
+/*
+ * _yhf_writer_pad()
+ * Write zeros up to the next offset aligned on 8 bytes.
+ */
+static void _yhf_writer_pad(_yhf_writer_t *writer) {
+	static const char	zeros[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+
+	_yhf_writer_write(writer, zeros, (size_t)(_YHF_ALIGN(writer->offset) - writer->offset));
+}
+
+/*
+ * _yhf_writer_add()
+ * Write an element's key and value in the data area, and keep its entry.
+ */
+static void _yhf_writer_add(_yhf_writer_t *writer, const char *key, void *data) {
+	ybin_t		value;
+	yhf_entry_t	*entry;
+	size_t		key_len;
+
+	if (writer->status != YENOERR)
+		return;
+	if (writer->nbr_entries == writer->size_entries) {
+		writer->size_entries = writer->size_entries ? (writer->size_entries * 2) : 1024;
+		entry = (yhf_entry_t*)YMALLOC_RAW(writer->size_entries * sizeof(yhf_entry_t));
+		if (!entry) {
+			writer->status = YENOMEM;
+			return;
+		}
+		if (writer->entries != NULL) {
+			memcpy(entry, writer->entries, writer->nbr_entries * sizeof(yhf_entry_t));
+			YFREE(writer->entries);
+		}
+		writer->entries = entry;
+	}
+	if (writer->value_func)
+		value = writer->value_func(key, data, writer->user_data);
+	else {
+		value.data = data;
+		value.len = data ? (unsigned int)strlen((char*)data) : 0;
+	}
+	key_len = strlen(key);
+	entry = &writer->entries[writer->nbr_entries++];
+	entry->hash_value = yhf_hash(key, key_len);
+	entry->key_offset = writer->offset;
+	entry->key_len = (u32_t)key_len;
+	entry->value_len = value.len;
+	_yhf_writer_write(writer, key, key_len + 1);
+	_yhf_writer_pad(writer);
+	_yhf_writer_write(writer, value.data, value.len);
+}
+
+/*
+ * _yhf_writer_close()
+ * Write the index and the header, flush the temporary file to disk, and
+ * rename it.
+ */
+static yerr_t _yhf_writer_close(_yhf_writer_t *writer, const char *tmp_filename, const char *filename) {
+	yhf_header_t	header;
+	u64_t		nbr_buckets, *buckets = NULL, i, bucket;
+	yhf_entry_t	*sorted = NULL;
+
+	/* build the bucket indexes, and sort the entries by bucket */
+	for (nbr_buckets = _YHF_MIN_BUCKETS; nbr_buckets < writer->nbr_entries; nbr_buckets <<= 1)
+		;
+	if (writer->status == YENOERR &&
+	    ((buckets = (u64_t*)YCALLOC(nbr_buckets + 1, sizeof(u64_t))) == NULL ||
+	     (sorted = (yhf_entry_t*)YMALLOC_RAW(writer->nbr_entries * sizeof(yhf_entry_t) + 1)) == NULL))
+		writer->status = YENOMEM;
+	if (writer->status == YENOERR) {
+		for (i = 0; i < writer->nbr_entries; i++)
+			buckets[(writer->entries[i].hash_value & (nbr_buckets - 1)) + 1]++;
+		for (i = 0; i < nbr_buckets; i++)
+			buckets[i + 1] += buckets[i];
+		for (i = 0; i < writer->nbr_entries; i++) {
+			bucket = writer->entries[i].hash_value & (nbr_buckets - 1);
+			sorted[buckets[bucket]++] = writer->entries[i];
+		}
+		/* the insertion loop shifted each index to the start of the next bucket */
+		for (i = nbr_buckets; i > 0; i--)
+			buckets[i] = buckets[i - 1];
+		buckets[0] = 0;
+		/* write the index */
+		_yhf_writer_pad(writer);
+		memset(&header, 0, sizeof(header));
+		header.buckets_offset = writer->offset;
+		_yhf_writer_write(writer, buckets, (size_t)((nbr_buckets + 1) * sizeof(u64_t)));
+		header.entries_offset = writer->offset;
+		_yhf_writer_write(writer, sorted, writer->nbr_entries * sizeof(yhf_entry_t));
+	}
+	/* write the header */
+	if (writer->status == YENOERR) {
+		memcpy(header.magic, YHF_MAGIC, sizeof(header.magic));
+		header.version = YHF_VERSION;
+		header.byte_order = YHF_BYTE_ORDER;
+		header.crc = ycrc_compute(&writer->crc);
+		header.file_size = writer->offset;
+		header.nbr_buckets = nbr_buckets;
+		header.nbr_entries = writer->nbr_entries;
+		if (fseek(writer->file, 0, SEEK_SET) ||
+		    fwrite(&header, sizeof(header), 1, writer->file) != 1 ||
+		    fflush(writer->file) ||
+		    fsync(fileno(writer->file)))
+			writer->status = YEIO;
+	}
+	if (fclose(writer->file) && writer->status == YENOERR)
+		writer->status = YEIO;
+	if (writer->status == YENOERR && rename(tmp_filename, filename))
+		writer->status = _yhf_errno_to_yerr(errno);
+	if (writer->status != YENOERR)
+		unlink(tmp_filename);
+	else
+		_yhf_sync_dir(filename);
+	YFREE(buckets);
+	YFREE(sorted);
+	YFREE(writer->entries);
+	return (writer->status);
+}
+
+/*
+ * _yhf_hashtable_func()
+ * Callback used to write the elements of a hash table.
+ */
+static void _yhf_hashtable_func(yht_hash_value_t hash_value, char *key, void *data, void *user_data) {
+	(void)hash_value;
+	if (key)
+		_yhf_writer_add((_yhf_writer_t*)user_data, key, data);
+}
+
+/*
+ * _yhf_hashmap_func()
+ * Callback used to write the elements of a hash map.
+ */
+static void _yhf_hashmap_func(char *key, void *data, void *user_data) {
+	_yhf_writer_add((_yhf_writer_t*)user_data, key, data);
+}
@@ -0,0 +1,198 @@
+/* Process this file with the HeaderBrowser tool (http://www.headerbrowser.org)
+   to create documentation. */
+/*!
+ * @header	yhashfile.h
+ * @abstract	Persistent snapshots of hash tables and hash maps.
+ * @discussion	A hash file is a read-only image of a hash table or a hash map
+ *		whose keys are strings and whose values are byte blobs. The file
+ *		only contains offsets, so it is mapped in memory with mmap() and
+ *		searched in place, without any deserialization. A CRC of the
+ *		whole content is stored in the header to detect corrupted files.
+ *		<p />
+ *		File layout (all integers in host byte order):
+ *		<ul>
+ *		<li>the header (see yhf_header_t);</li>
+ *		<li>the data area, where each key is stored (followed by a '\0')
+ *		and immediately followed by its value, aligned on 8 bytes;</li>
+ *		<li>an array of (nbr_buckets + 1) 64 bits indexes; the entries
+ *		of bucket <i>n</i> are those between indexes <i>n</i> and
+ *		<i>n + 1</i>;</li>
+ *		<li>the array of entries (see yhf_entry_t), sorted by bucket.</li>
+ *		</ul>
+ *		The data area comes first so that a snapshot is written in one
+ *		pass over the elements.
+ * @version	1.0 Oct 19 2026
+ * @author	Amaury Bouchard <amaury@amaury.net>
+ */
+#ifndef __YHASHFILE_H__
+#define __YHASHFILE_H__
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif /* __cplusplus || c_plusplus */
+
+#include "ydefs.h"
+#include "yerror.h"
+#include "yhashtable.h"
+#include "yhashmap.h"
+
+/** @define YHF_MAGIC Magic string at the beginning of hash files. */
+#define YHF_MAGIC	"YHF1"
+
+/** @define YHF_VERSION Version of the hash file format. */
+#define YHF_VERSION	1
+
+/** @define YHF_BYTE_ORDER Value used to check that a file was written with the same byte order. */
+#define YHF_BYTE_ORDER	0x01020304
+
+/**
+ * @typedef	yhf_header_t
+ *		Header of a hash file.
+ * @field	magic		Magic string (YHF_MAGIC).
+ * @field	version		File format version (YHF_VERSION).
+ * @field	byte_order	Byte order mark (YHF_BYTE_ORDER).
+ * @field	crc		CRC of the file content following the header.
+ * @field	file_size	Total size of the file.
+ * @field	nbr_buckets	Number of buckets (a power of 2).
+ * @field	nbr_entries	Number of entries.
+ * @field	buckets_offset	Offset of the array of bucket indexes.
+ * @field	entries_offset	Offset of the array of entries.
+ */
+typedef struct yhf_header_s {
+	char	magic[4];
+	u32_t	version;
+	u32_t	byte_order;
+	u32_t	crc;
+	u64_t	file_size;
+	u64_t	nbr_buckets;
+	u64_t	nbr_entries;
+	u64_t	buckets_offset;
+	u64_t	entries_offset;
+} yhf_header_t;
+
+/**
+ * @typedef	yhf_entry_t
+ *		Entry of a hash file.
+ * @field	hash_value	Hash value of the key (see yhf_hash()).
+ * @field	key_offset	Offset of the key in the file. The value is stored
+ *				after the key, at the next offset aligned on 8 bytes.
+ * @field	key_len		Length of the key.
+ * @field	value_len	Size of the value.
+ */
+typedef struct yhf_entry_s {
+	u64_t	hash_value;
+	u64_t	key_offset;
+	u32_t	key_len;
+	u32_t	value_len;
+} yhf_entry_t;
+
+/**
+ * @typedef	yhashfile_t
+ *		Opened hash file.
+ * @field	map		Address of the memory mapping.
+ * @field	map_size	Size of the memory mapping.
+ * @field	header		Pointer to the file header.
+ * @field	buckets		Pointer to the array of bucket indexes.
+ * @field	entries		Pointer to the array of entries.
+ */
+typedef struct yhashfile_s {
+	void			*map;
+	size_t			map_size;
+	const yhf_header_t	*header;
+	const u64_t		*buckets;
+	const yhf_entry_t	*entries;
+} yhashfile_t;
+
+/**
+ * @typedef	yhf_value_func_t
+ *		Function pointer, used to get the byte blob stored for an element.
+ * @param	key		The element's key.
+ * @param	data		The element's data.
+ * @param	user_data	Pointer to some user data.
+ * @return	The value to store.
+ */
+typedef ybin_t (*yhf_value_func_t)(const char *key, void *data, void *user_data);
+
+/* ****************** FUNCTIONS **************** */
+/**
+ * @function	yhf_write_hashtable
+ *		Write the elements of a hash table in a hash file. Elements with
+ *		an integer key are skipped. The file is written under a unique
+ *		temporary name in the same directory, flushed to disk and renamed
+ *		when complete, so readers never see a partial file, even after a
+ *		crash, and concurrent writers don't overwrite each other's data
+ *		(the last renamed file wins). The file gets the permissions of the
+ *		file it replaces, or 0644.
+ * @param	hashtable	Pointer to the hash table.
+ * @param	filename	Path to the file.
+ * @param	value_func	Function called to get the value of each element. If
+ *				NULL, elements' data are taken as '\0'-terminated strings.
+ * @param	user_data	Pointer to some user data given to the value function.
+ * @return	YENOERR if OK, an error code otherwise.
+ */
+yerr_t yhf_write_hashtable(yhashtable_t *hashtable, const char *filename, yhf_value_func_t value_func, void *user_data);
+
+/**
+ * @function	yhf_write_hashmap
+ *		Write the elements of a hash map in a hash file. See yhf_write_hashtable().
+ * @param	hashmap		Pointer to the hash map.
+ * @param	filename	Path to the file.
+ * @param	value_func	Function called to get the value of each element. If
+ *				NULL, elements' data are taken as '\0'-terminated strings.
+ * @param	user_data	Pointer to some user data given to the value function.
+ * @return	YENOERR if OK, an error code otherwise.
+ */
+yerr_t yhf_write_hashmap(yhashmap_t *hashmap, const char *filename, yhf_value_func_t value_func, void *user_data);
+
+/**
+ * @function	yhf_open
+ *		Map a hash file in memory.
+ * @param	filename	Path to the file.
+ * @param	check_crc	YTRUE to check the file's CRC (reads the whole file).
+ * @param	hashfile	Pointer to the opened hash file, set on success.
+ * @return	YENOERR if OK, YEBADMSG if the file is not a valid hash file, or
+ *		another error code if it can't be opened.
+ */
+yerr_t yhf_open(const char *filename, ybool_t check_crc, yhashfile_t **hashfile);
+
+/**
+ * @function	yhf_close
+ *		Unmap a hash file. Pointers returned by yhf_search() become invalid.
+ * @param	hashfile	Pointer to the hash file.
+ */
+void yhf_close(yhashfile_t *hashfile);
+
+/**
+ * @function	yhf_search
+ *		Search a value in a hash file, from its key.
+ * @param	hashfile	Pointer to the hash file.
+ * @param	key		The key.
+ * @param	value_len	Pointer to the value's size, set if the key was found. Could be NULL.
+ * @return	A pointer to the value inside the mapping, or NULL if the key was not found.
+ */
+const void *yhf_search(yhashfile_t *hashfile, const char *key, size_t *value_len);
+
+/**
+ * @function	yhf_get_nbr_entries
+ *		Return the number of entries of a hash file.
+ * @param	hashfile	Pointer to the hash file.
+ * @return	The number of entries.
+ */
+size_t yhf_get_nbr_entries(yhashfile_t *hashfile);
+
+/**
+ * @function	yhf_hash
+ *		Compute the hash value of a key, as stored in hash files. It uses
+ *		the SDBM algorithm on unsigned 64 bits integers, so it doesn't
+ *		depend on the platform.
+ * @param	key	The key.
+ * @param	key_len	Length of the key.
+ * @return	The hash value.
+ */
+u64_t yhf_hash(const char *key, size_t key_len);
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif /* __cplusplus || c_plusplus */
+
+#endif /* __YHASHFILE_H__ */
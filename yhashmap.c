@@ -1,10 +1,26 @@
+#define YMEM_TAG	YMEM_TAG_HASH
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include "yhashmap.h"
+#include "yslab.h"
+
+/** @define _YHM_ELEMENT_SIZE Size of an element, including its key when it is stored inside. */
+#define _YHM_ELEMENT_SIZE(hashmap, key_len) \
+	(((hashmap)->key_mode == YHM_KEYS_OWNED && (key_len) < YHM_INLINE_KEY_SIZE) ? \
+	 sizeof(yhm_element_t) + (key_len) + 1 : sizeof(yhm_element_t))
 
 /* *** definition of private functions *** */
-static yhm_hash_value_t _yhm_hash(const char *key);
+static yhm_hash_value_t _yhm_hash_len(const char *key, size_t *key_len);
+static yhm_element_t *_yhm_search(yhashmap_t *hashmap, yhm_hash_value_t hash_value, const char *key, size_t key_len);
+static yhm_element_t *_yhm_new_element(yhashmap_t *hashmap, char *key, size_t key_len);
+static void _yhm_free_element(yhashmap_t *hashmap, yhm_element_t *element);
+
+/** @define _YHM_MATCH Tell if an element matches a key: length, then hash value, then content. */
+#define _YHM_MATCH(element, hash_value, key, key_len) \
+	((element)->key_len == (key_len) && (element)->hash_value == (hash_value) && \
+	 !memcmp((element)->key, (key), (key_len)))
 
 /*
  * yhm_new()
@@ -17,6 +33,8 @@ yhashmap_t *yhm_new(yhm_size_t size, yhm_function_t destroy_func, void *destroy_
 	hash->buckets = (yhm_bucket_t*)YCALLOC(size, sizeof(yhm_bucket_t));
 	hash->size = size;
 	hash->used = 0;
+	hash->key_mode = YHM_KEYS_BORROWED;
+	hash->stats = NULL;
 	hash->destroy_func = destroy_func;
 	hash->destroy_data = destroy_data;
 	return (hash);
@@ -42,69 +60,69 @@ void yhm_delete(yhashmap_t *hashmap) {
 					hashmap->destroy_func(element->key, element->data, hashmap->destroy_data);
 				old_element = element;
 				element = element->next;
-				YFREE(old_element);
+				_yhm_free_element(hashmap, old_element);
 			}
 		}
 	}
-	/* remove buckets and the hash map itself */
+	/* remove buckets, counters and the hash map itself */
 	YFREE(hashmap->buckets);
+	if (hashmap->stats != NULL)
+		YFREE(hashmap->stats);
 	YFREE(hashmap);
 }
 
+/*
+ * yhm_set_key_mode
+ * Define how a hash map stores its keys.
+ */
+ybool_t yhm_set_key_mode(yhashmap_t *hashmap, yhm_key_mode_t mode) {
+	if (hashmap->used > 0)
+		return (YFALSE);
+	hashmap->key_mode = mode;
+	return (YTRUE);
+}
+
 /*
  * yhm_add
  * Add an element to an hash map.
  */
 void yhm_add(yhashmap_t *hashmap, char *key, void *data) {
-	float			load_factor;
 	yhm_hash_value_t	hash_value;
+	size_t			key_len;
 	yhm_bucket_t		*bucket;
 	yhm_element_t		*element;
 
+	/* compute the key's hash value */
+	hash_value = _yhm_hash_len(key, &key_len);
+	/* checking if the element exists and must be updated */
+	if ((element = _yhm_search(hashmap, hash_value, key, key_len)) != NULL) {
+		/* removing old data */
+		if (hashmap->destroy_func != NULL)
+			hashmap->destroy_func(element->key, element->data, hashmap->destroy_data);
+		/* updating the element (an owned key is kept, as it is identical) */
+		if (hashmap->key_mode == YHM_KEYS_BORROWED)
+			element->key = key;
+		element->data = data;
+		return;
+	}
 	/* resize the map if its load factor would excess the limit */
-	load_factor = (float)(hashmap->used + 1) / hashmap->size;
-	if (load_factor > YHM_MAX_LOAD_FACTOR)
+	if (YHM_MUST_GROW(hashmap->used, hashmap->size))
 		yhm_resize(hashmap, (hashmap->size * 2));
-	/* compute the key's hash value */
-	hash_value = _yhm_hash(key);
-	hash_value %= hashmap->size;
-	/* checking the bucket */
-	bucket = &(hashmap->buckets[hash_value]);
+	/* create the element */
+	element = _yhm_new_element(hashmap, key, key_len);
+	element->hash_value = hash_value;
+	element->data = data;
+	/* add the element to the bucket */
+	bucket = &(hashmap->buckets[hash_value % hashmap->size]);
 	if (bucket->nbr_elements == 0) {
-		/* create the first element */
-		element = (yhm_element_t*)YMALLOC(sizeof(yhm_element_t));
 		element->previous = element->next = element;
-		/* add the element to the bucket */
 		bucket->elements = element;
 	} else {
-		/* there is already some elements in the bucket, checking if the element exists and must be updated */
-		size_t	offset;
-
-		for (offset = 0, element = bucket->elements;
-		     offset < bucket->nbr_elements;
-		     offset++, element = element->next) {
-			if (!strcmp(key, element->key)) {
-				/* an existing element was found */
-				/* removing old data */
-				if (hashmap->destroy_func != NULL)
-					hashmap->destroy_func(element->key, element->data, hashmap->destroy_data);
-				/* updating the element */
-				element->key = key;
-				element->data = data;
-				return;
-			}
-		}
-		/* no element was already existing with this key */
-		element = (yhm_element_t*)YMALLOC(sizeof(yhm_element_t));
-		/* add the element to the bucket */
 		element->next = bucket->elements;
 		element->previous = bucket->elements->previous;
 		bucket->elements->previous->next = element;
 		bucket->elements->previous = element;
 	}
-	/* filling the element */
-	element->key = key;
-	element->data = data;
 	/* update the bucket */
 	bucket->nbr_elements++;
 	/* update the hash map */
@@ -130,25 +148,22 @@ void *yhm_search(yhashmap_t *hashmap, const char *key) {
  */
 yhm_element_t *yhm_search_element(yhashmap_t *hashmap, const char *key) {
 	yhm_hash_value_t	hash_value;
-	yhm_bucket_t		*bucket;
-	yhm_element_t		*element;
-	size_t			offset;
+	size_t			key_len;
 
-	/* compute the key's hash value */
-	hash_value = _yhm_hash(key);
-	hash_value %= hashmap->size;
-	/* retreiving the bucket */
-	bucket = &(hashmap->buckets[hash_value]);
-	if (bucket->nbr_elements == 0)
-		return (NULL);
-	if (bucket->nbr_elements == 1)
-		return (bucket->elements);
-	for (offset = 0, element = bucket->elements;
-	     offset < bucket->nbr_elements;
-	     offset++, element = element->next) {
-		if (!strcmp(key, element->key))
-			return (element);
-	}
+	hash_value = _yhm_hash_len(key, &key_len);
+	return (_yhm_search(hashmap, hash_value, key, key_len));
+}
+
+/*
+ * yhm_search_hashed()
+ * Search an element in a hash map, from its key and the key's hash value.
+ */
+void *yhm_search_hashed(yhashmap_t *hashmap, yhm_hash_value_t hash_value, const char *key) {
+	yhm_element_t	*element;
+
+	element = _yhm_search(hashmap, hash_value, key, strlen(key));
+	if (element != NULL)
+		return (element->data);
 	return (NULL);
 }
 
@@ -158,84 +173,78 @@ yhm_element_t *yhm_search_element(yhashmap_t *hashmap, const char *key) {
  */
 ybool_t yhm_remove(yhashmap_t *hashmap, const char *key) {
 	yhm_hash_value_t	hash_value;
+	size_t			key_len;
 	yhm_bucket_t		*bucket;
 	yhm_element_t		*element;
-	size_t			offset;
-	ybool_t			found = YFALSE;
-	float			load_factor;
 
 	/* compute the key's hash value */
-	hash_value = _yhm_hash(key);
-	hash_value %= hashmap->size;
-	/* retreiving the bucket */
-	bucket = &(hashmap->buckets[hash_value]);
-	if (bucket->nbr_elements == 0)
+	hash_value = _yhm_hash_len(key, &key_len);
+	if ((element = _yhm_search(hashmap, hash_value, key, key_len)) == NULL)
 		return (YFALSE);
-	if (bucket->nbr_elements == 1) {
-		found = YTRUE;
-		if (hashmap->destroy_func)
-			hashmap->destroy_func(bucket->elements->key, bucket->elements->data, hashmap->destroy_data);
-		YFREE(bucket->elements);
+	/* unlink the element from its bucket */
+	bucket = &(hashmap->buckets[hash_value % hashmap->size]);
+	if (bucket->nbr_elements == 1)
 		bucket->elements = NULL;
-	} else {
-		for (offset = 0, element = bucket->elements;
-		     offset < bucket->nbr_elements;
-		     offset++, element = element->next) {
-			if (!strcmp(key, element->key)) {
-				found = YTRUE;
-				if (offset == 0)
-					bucket->elements = element->next;
-				element->previous->next = element->next;
-				element->next->previous = element->previous;
-				/* call the destroy function */
-				if (hashmap->destroy_func)
-					hashmap->destroy_func(element->key, element->data, hashmap->destroy_data);
-				YFREE(element);
-				break;
-			}
-		}
+	else {
+		if (bucket->elements == element)
+			bucket->elements = element->next;
+		element->previous->next = element->next;
+		element->next->previous = element->previous;
 	}
-	if (found) {
-		bucket->nbr_elements--;
-		hashmap->used--;
-		/* resize the map if its load factor will fall under the limit */
-		load_factor = (float)(hashmap->used + 1) / hashmap->size;
-		if (load_factor < YHM_MIN_LOAD_FACTOR)
-			yhm_resize(hashmap, (hashmap->size / 2));
-	}
-	return (found);
+	/* call the destroy function */
+	if (hashmap->destroy_func)
+		hashmap->destroy_func(element->key, element->data, hashmap->destroy_data);
+	_yhm_free_element(hashmap, element);
+	bucket->nbr_elements--;
+	hashmap->used--;
+	/* resize the map if its load factor will fall under the limit */
+	if (YHM_MUST_SHRINK(hashmap->used, hashmap->size))
+		yhm_resize(hashmap, (hashmap->size / 2));
+	return (YTRUE);
 }
 
 /*
  * yhm_resize
- * Resize an hashmap.
+ * Resize an hashmap. Elements are moved to the new buckets using their
+ * stored hash value; keys are not hashed again.
  */
 void yhm_resize(yhashmap_t *hashmap, size_t size) {
-	yhashmap_t	*new_hashmap;
-	size_t		offset, offset2;
-	yhm_bucket_t	*bucket, *old_buckets;
-	yhm_element_t	*element, *old_element;
+	size_t		offset, offset2, nbr_elements;
+	yhm_bucket_t	*new_buckets, *bucket, *new_bucket;
+	yhm_element_t	*element, *next_element;
+	u64_t		start = 0;
 
-	new_hashmap = yhm_new(size, NULL, NULL);
+	if (hashmap->stats != NULL)
+		start = yhash_stats_now();
+	new_buckets = (yhm_bucket_t*)YCALLOC(size, sizeof(yhm_bucket_t));
 	for (offset = 0; offset < hashmap->size; offset++) {
 		bucket = &(hashmap->buckets[offset]);
-		if (bucket->nbr_elements == 0)
-			continue;
+		nbr_elements = bucket->nbr_elements;
 		for (offset2 = 0, element = bucket->elements;
-		     offset2 < bucket->nbr_elements;
-		     offset2++, element = element->next) {
-			yhm_add(new_hashmap, element->key, element->data);
-			old_element = element;
-			YFREE(old_element);
+		     offset2 < nbr_elements;
+		     offset2++, element = next_element) {
+			next_element = element->next;
+			new_bucket = &(new_buckets[element->hash_value % size]);
+			if (new_bucket->nbr_elements == 0) {
+				element->previous = element->next = element;
+				new_bucket->elements = element;
+			} else {
+				element->next = new_bucket->elements;
+				element->previous = new_bucket->elements->previous;
+				new_bucket->elements->previous->next = element;
+				new_bucket->elements->previous = element;
+			}
+			new_bucket->nbr_elements++;
 		}
 	}
+	/* swapping buckets */
+	YFREE(hashmap->buckets);
+	hashmap->buckets = new_buckets;
 	hashmap->size = size;
-	/* moving the list of buckets */
-	old_buckets = hashmap->buckets;
-	hashmap->buckets = new_hashmap->buckets;
-	/* free memory */
-	YFREE(old_buckets);
-	YFREE(new_hashmap);
+	if (hashmap->stats != NULL) {
+		hashmap->stats->nbr_resizes++;
+		hashmap->stats->resize_usec += yhash_stats_now() - start;
+	}
 }
 
 /*
@@ -261,20 +270,132 @@ void yhm_foreach(yhashmap_t *hashmap, yhm_function_t func, void *user_data) {
 	}
 }
 
+/*
+ * yhm_stats_enable
+ * Enable or disable the activity counters of a hash map.
+ */
+void yhm_stats_enable(yhashmap_t *hashmap, ybool_t enable) {
+	if (hashmap->stats != NULL)
+		YFREE(hashmap->stats);
+	if (enable)
+		hashmap->stats = (yhash_stats_t*)YMALLOC(sizeof(yhash_stats_t));
+}
+
+/*
+ * yhm_stats_report
+ * Fill a report about a hash map.
+ */
+void yhm_stats_report(yhashmap_t *hashmap, yhash_report_t *report) {
+	size_t		offset, offset2;
+	yhm_bucket_t	*bucket;
+	yhm_element_t	*element;
+
+	yhash_report_init(report);
+	report->nbr_containers = 1;
+	report->memory = sizeof(yhashmap_t) + hashmap->size * sizeof(yhm_bucket_t) +
+			 hashmap->used * sizeof(yhm_element_t);
+	for (offset = 0; offset < hashmap->size; offset++) {
+		bucket = &(hashmap->buckets[offset]);
+		yhash_report_add_bucket(report, bucket->nbr_elements);
+		if (hashmap->key_mode != YHM_KEYS_OWNED)
+			continue;
+		for (offset2 = 0, element = bucket->elements;
+		     offset2 < bucket->nbr_elements;
+		     offset2++, element = element->next)
+			report->memory += element->key_len + 1;
+	}
+	if (hashmap->stats != NULL) {
+		report->memory += sizeof(yhash_stats_t);
+		report->stats = *hashmap->stats;
+	}
+}
+
+/*
+ * yhm_hash()
+ * Compute the hash value of a key, using the SDBM algorithm.
+ */
+yhm_hash_value_t yhm_hash(const char *key) {
+	size_t	key_len;
+
+	return (_yhm_hash_len(key, &key_len));
+}
+
 /* ************ PRIVATE FUNCTIONS ********* */
 /**
- * @function	yhm_hash
- *		Compute the hash value of a key, using the SDBM algorithm.
+ * @function	_yhm_hash_len
+ *		Compute the hash value of a key, using the SDBM algorithm, and
+ *		its length.
  * @see		http://www.cse.yorku.ca/~oz/hash.html
  * @see		http://en.literateprograms.org/Hash_function_comparison_%28C,_sh%29
- * @param	Key	The data to hash.
+ * @param	key	The data to hash.
+ * @param	key_len	Pointer to the key's length, set by the function.
  * @return	The computed hash value.
  */
-static yhm_hash_value_t _yhm_hash(const char *key) {
+static yhm_hash_value_t _yhm_hash_len(const char *key, size_t *key_len) {
 	yhm_hash_value_t	hash_value;
+	const char		*pt;
 
-	for (hash_value = 0; *key; key++)
-		hash_value = *key + (hash_value << 6) + (hash_value << 16) - hash_value;
+	for (hash_value = 0, pt = key; *pt; pt++)
+		hash_value = *pt + (hash_value << 6) + (hash_value << 16) - hash_value;
+	*key_len = pt - key;
 	return (hash_value);
 }
 
+/**
+ * @function	_yhm_search
+ *		Search an element in a hash map, from its key and hash value.
+ * @return	A pointer to the element, or NULL.
+ */
+static yhm_element_t *_yhm_search(yhashmap_t *hashmap, yhm_hash_value_t hash_value, const char *key, size_t key_len) {
+	yhm_bucket_t	*bucket;
+	yhm_element_t	*element;
+	size_t		offset;
+
+	/* retreiving the bucket */
+	bucket = &(hashmap->buckets[hash_value % hashmap->size]);
+	for (offset = 0, element = bucket->elements;
+	     offset < bucket->nbr_elements;
+	     offset++, element = element->next) {
+		if (_YHM_MATCH(element, hash_value, key, key_len)) {
+			YHASH_STATS_LOOKUP(hashmap->stats, offset + 1, YTRUE);
+			return (element);
+		}
+	}
+	YHASH_STATS_LOOKUP(hashmap->stats, offset, YFALSE);
+	return (NULL);
+}
+
+/**
+ * @function	_yhm_new_element
+ *		Allocate an element. When the hash map owns its keys, the key is
+ *		copied right after the element if it is short enough, or in its
+ *		own buffer.
+ */
+static yhm_element_t *_yhm_new_element(yhashmap_t *hashmap, char *key, size_t key_len) {
+	yhm_element_t	*element;
+
+	if (hashmap->key_mode == YHM_KEYS_BORROWED) {
+		element = (yhm_element_t*)YSLAB_ALLOC(sizeof(yhm_element_t));
+		element->key = key;
+	} else if (key_len < YHM_INLINE_KEY_SIZE) {
+		element = (yhm_element_t*)YSLAB_ALLOC(_YHM_ELEMENT_SIZE(hashmap, key_len));
+		element->key = (char*)(element + 1);
+		memcpy(element->key, key, key_len + 1);
+	} else {
+		element = (yhm_element_t*)YSLAB_ALLOC(sizeof(yhm_element_t));
+		element->key = (char*)YMALLOC_RAW(key_len + 1);
+		memcpy(element->key, key, key_len + 1);
+	}
+	element->key_len = key_len;
+	return (element);
+}
+
+/**
+ * @function	_yhm_free_element
+ *		Free an element, and its key if it was copied outside of the element.
+ */
+static void _yhm_free_element(yhashmap_t *hashmap, yhm_element_t *element) {
+	if (hashmap->key_mode == YHM_KEYS_OWNED && element->key_len >= YHM_INLINE_KEY_SIZE)
+		YFREE(element->key);
+	YSLAB_FREE(element, _YHM_ELEMENT_SIZE(hashmap, element->key_len));
+}
@@ -15,6 +15,7 @@ extern "C" {
 #endif /* __cplusplus || c_plusplus */
 
 #include "ydefs.h"
+#include "yhashstats.h"
 
 #ifdef USE_BOEHM_GC
 # include "gc.h"
@@ -26,6 +27,15 @@ extern "C" {
 /** @define YHM_MIN_LOAD_FACTOR Minimum load factor of a hash map before reducing it. */
 #define YHM_MIN_LOAD_FACTOR	0.25
 
+/** @define YHM_MUST_GROW Tell if a hash map must grow before receiving a new element. */
+#define YHM_MUST_GROW(used, size)	((float)((used) + 1) / (size) > YHM_MAX_LOAD_FACTOR)
+
+/** @define YHM_MUST_SHRINK Tell if a hash map must shrink after an element was removed. */
+#define YHM_MUST_SHRINK(used, size)	((float)((used) + 1) / (size) < YHM_MIN_LOAD_FACTOR)
+
+/** @define YHM_INLINE_KEY_SIZE Owned keys shorter than this are stored inside their element. */
+#define YHM_INLINE_KEY_SIZE	48
+
 /**
  * @typedef	yhm_size_t
  *		Enum used to define the size of a hash map.
@@ -45,16 +55,39 @@ typedef enum yhm_size_e {
 	YHM_SIZE_HUGE		= 1048576
 } yhm_size_t;
 
+/**
+ * @typedef	yhm_key_mode_t
+ *		Enum used to define how a hash map manages its keys.
+ * @constant	YHM_KEYS_BORROWED	Keys are pointers given by the caller, which must keep
+ *					them alive as long as the element exists (default).
+ * @constant	YHM_KEYS_OWNED		Keys are copied by the hash map. Short keys are stored
+ *					inline, right after their element.
+ */
+typedef enum yhm_key_mode_e {
+	YHM_KEYS_BORROWED = 0,
+	YHM_KEYS_OWNED
+} yhm_key_mode_t;
+
+/**
+ * typedef	yhm_hash_value_t
+ * 		An hash value.
+ */
+typedef long int yhm_hash_value_t;
+
 /**
  * typedef	yhm_element_t
  *		Structure used to store a hash map's element.
+ * @field	hash_value	Element's hash value.
  * @field	key		Element's key.
+ * @field	key_len		Length of the element's key.
  * @field	data		Element's data.
  * @field	previous	Pointer to the previous element with the same hash value.
  * @field	next		Pointer to the next element with the same hash value.
  */
 typedef struct yhm_element_s {
+	yhm_hash_value_t	hash_value;
 	char			*key;
+	size_t			key_len;
 	void			*data;
 	struct yhm_element_s	*previous;
 	struct yhm_element_s	*next;
@@ -80,17 +113,13 @@ typedef struct yhm_bucket_s {
  */
 typedef void (*yhm_function_t)(char *key, void *data, void *user_data);
 
-/**
- * typedef	yhm_hash_value_t
- * 		An hash value.
- */
-typedef long int yhm_hash_value_t;
-
 /**
  * @typedef	yhashmap_t
  * @field	size		Current size of the hash map.
  * @field	used		Current number of elements stored in the hash map.
  * @field	buckets		Array of buckets.
+ * @field	key_mode	How keys are stored.
+ * @field	stats		Activity counters, NULL if they are disabled.
  * @field	destroy_func	Pointer to the function called when an element is removed.
  * @field	destroy_data	Pointer to some user data given to the destroy function.
  */
@@ -98,6 +127,8 @@ typedef struct yhashmap_s {
 	size_t		size;
 	size_t		used;
 	yhm_bucket_t	*buckets;
+	yhm_key_mode_t	key_mode;
+	yhash_stats_t	*stats;
 	yhm_function_t	destroy_func;
 	void		*destroy_data;
 } yhashmap_t;
@@ -120,6 +151,18 @@ yhashmap_t *yhm_new(yhm_size_t size, yhm_function_t destroy_func, void *destroy_
  */
 void yhm_delete(yhashmap_t *hashmap);
 
+/**
+ * @function	yhm_set_key_mode
+ *		Define how a hash map stores its keys. With owned keys, the given
+ *		keys are copied and the caller may free them as soon as yhm_add()
+ *		returns; the keys given to the destroy function are then the map's
+ *		copies and must not be freed.
+ * @param	hashmap	Pointer to the hash map. It must be empty.
+ * @param	mode	The key mode.
+ * @return	YTRUE if the mode was set, YFALSE if the hash map is not empty.
+ */
+ybool_t yhm_set_key_mode(yhashmap_t *hashmap, yhm_key_mode_t mode);
+
 /**
  * @function	yhm_add
  *		Add an element to a hash map.
@@ -152,6 +195,18 @@ void *yhm_search(yhashmap_t *hashmap, const char *key);
  */
 yhm_element_t *yhm_search_element(yhashmap_t *hahsmap, const char *key);
 
+/**
+ * @function	yhm_search_hashed
+ *		Search an element in a hash map, from its key and the key's hash
+ *		value (as computed by yhm_hash()). Useful when the same key is
+ *		searched in several hash maps.
+ * @param	hashmap		Pointer to the hash map.
+ * @param	hash_value	Hash value of the key.
+ * @param	key		Key used to index the element.
+ * @return	A pointer to the element's data.
+ */
+void *yhm_search_hashed(yhashmap_t *hashmap, yhm_hash_value_t hash_value, const char *key);
+
 /*
  * @function	yhm_remove
  * 		Remove an element from a hash map.
@@ -178,6 +233,34 @@ void yhm_resize(yhashmap_t *hashmap, size_t size);
  */
 void yhm_foreach(yhashmap_t *hashmap, yhm_function_t func, void *user_data);
 
+/**
+ * @function	yhm_stats_enable
+ *		Enable or disable the activity counters of a hash map. Enabling
+ *		them again resets them.
+ * @param	hashmap	Pointer to the hash map.
+ * @param	enable	YTRUE to enable the counters, YFALSE to disable them.
+ */
+void yhm_stats_enable(yhashmap_t *hashmap, ybool_t enable);
+
+/**
+ * @function	yhm_stats_report
+ *		Fill a report about a hash map. Its buckets are scanned, so the
+ *		cost is linear in the size of the hash map.
+ * @param	hashmap	Pointer to the hash map.
+ * @param	report	Pointer to the report.
+ */
+void yhm_stats_report(yhashmap_t *hashmap, yhash_report_t *report);
+
+/**
+ * @function	yhm_hash
+ *		Compute the hash value of a key, using the SDBM algorithm.
+ * @param	key	The string that will be hashed.
+ * @return	The string's hash value.
+ * @see		http://www.cse.yorku.ca/~oz/hash.html
+ * @see		http://en.literateprograms.org/Hash_function_comparison_%28C,_sh%29
+ */
+yhm_hash_value_t yhm_hash(const char *key);
+
 #if defined(__cplusplus) || defined(c_plusplus)
 }
 #endif /* __cplusplus || c_plusplus */
@@ -0,0 +1,267 @@
+/* Process this file with the HeaderBrowser tool (http://www.headerbrowser.org)
+   to create documentation. */
+/*!
+ * @header	yhashmap_tpl.h
+ * @abstract	Type-specialized hash maps, generated by macros.
+ * @discussion	yhashmap_t indexes its elements with string keys and stores
+ *		their data as void pointers, so that integer keys must be printed
+ *		and structures must be allocated apart. The macros of this file
+ *		generate a hash map type and its functions for given key and
+ *		value types: keys and values are stored inline in an array of
+ *		slots (open addressing, linear probing), and the hash and equality
+ *		functions are expanded in place, so that the compiler can inline
+ *		them.
+ *		<p />
+ *		The generated maps follow the rules of yhashmap_t: same initial
+ *		sizes (yhm_size_t), same load factors (YHM_MUST_GROW() and
+ *		YHM_MUST_SHRINK()) and same activity counters (yhash_stats_t).
+ *		<p />
+ *		YHM_DECLARE() defines the types and the prototypes, and is usually
+ *		written in a header file; YHM_DEFINE() defines the functions, and
+ *		must be written once, in a C file.
+ *		<pre>
+ *		YHM_DECLARE(intmap, int, double)
+ *		YHM_DEFINE(intmap, int, double, YHM_INT_HASH, YHM_INT_EQUAL)
+ *		...
+ *		intmap_t *map = intmap_new(YHM_SIZE_MINI);
+ *		double *pt;
+ *		intmap_put(map, 42, 3.14);
+ *		if ((pt = intmap_get(map, 42)) != NULL)
+ *			printf("%f\n", *pt);
+ *		intmap_delete(map);
+ *		</pre>
+ *		The functions generated for a map named "name" are: name_new(),
+ *		name_delete(), name_put(), name_get(), name_remove(),
+ *		name_resize(), name_foreach(), name_stats_enable() and
+ *		name_stats_report().
+ * @version	1.0 Oct 19 2026
+ * @author	Amaury Bouchard <amaury@amaury.net>
+ */
+#ifndef __YHASHMAP_TPL_H__
+#define __YHASHMAP_TPL_H__
+
+#include <string.h>
+#include "ydefs.h"
+#include "yhashmap.h"
+#include "yhashstats.h"
+
+/** @define YHM_TPL_MIX Multiplier used to spread hash values over the slots (64 bits golden ratio). */
+#define YHM_TPL_MIX	(((u64_t)0x9E3779B9 << 32) | 0x7F4A7C15)
+
+/** @define YHM_INT_HASH Hash function for integer keys. */
+#define YHM_INT_HASH(key)		((size_t)(key))
+
+/** @define YHM_INT_EQUAL Equality function for integer keys. */
+#define YHM_INT_EQUAL(key1, key2)	((key1) == (key2))
+
+/** @define YHM_STR_HASH Hash function for string keys. */
+#define YHM_STR_HASH(key)		((size_t)yhm_hash(key))
+
+/** @define YHM_STR_EQUAL Equality function for string keys. */
+#define YHM_STR_EQUAL(key1, key2)	(!strcmp((key1), (key2)))
+
+/**
+ * @define	YHM_DECLARE
+ *		Define the types and the function prototypes of a specialized
+ *		hash map. The types are name_slot_t (a slot, whose hash_value is
+ *		0 when it is empty) and name_t (the hash map).
+ * @param	name	Prefix of the generated types and functions.
+ * @param	key_t	Type of the keys.
+ * @param	val_t	Type of the values.
+ */
+#define YHM_DECLARE(name, key_t, val_t) \
+typedef struct name##_slot_s { \
+	size_t	hash_value; \
+	key_t	key; \
+	val_t	value; \
+} name##_slot_t; \
+typedef struct name##_s { \
+	size_t		size; \
+	size_t		used; \
+	unsigned int	shift; \
+	name##_slot_t	*slots; \
+	yhash_stats_t	*stats; \
+} name##_t; \
+name##_t *name##_new(size_t size); \
+void name##_delete(name##_t *map); \
+ybool_t name##_put(name##_t *map, key_t key, val_t value); \
+val_t *name##_get(name##_t *map, key_t key); \
+ybool_t name##_remove(name##_t *map, key_t key, val_t *value); \
+void name##_resize(name##_t *map, size_t size); \
+void name##_foreach(name##_t *map, void (*func)(key_t *key, val_t *value, void *user_data), void *user_data); \
+void name##_stats_enable(name##_t *map, ybool_t enable); \
+void name##_stats_report(name##_t *map, yhash_report_t *report);
+
+/**
+ * @define	YHM_DEFINE
+ *		Define the functions of a specialized hash map, declared by
+ *		YHM_DECLARE() with the same name and types.
+ *		<ul>
+ *		<li>name_new(size): create a map; the size is rounded up to a
+ *		power of two.</li>
+ *		<li>name_delete(map): destroy a map.</li>
+ *		<li>name_put(map, key, value): add or update an element; return
+ *		YTRUE if it was added.</li>
+ *		<li>name_get(map, key): return a pointer to the value of an
+ *		element, or NULL. The pointer is valid until the next put or
+ *		remove.</li>
+ *		<li>name_remove(map, key, value): remove an element and copy its
+ *		value if the pointer is not NULL; return YFALSE if the element
+ *		doesn't exist.</li>
+ *		<li>name_resize(map, size): change the number of slots.</li>
+ *		<li>name_foreach(map, func, user_data): apply a function on every
+ *		element.</li>
+ *		<li>name_stats_enable(map, enable), name_stats_report(map,
+ *		report): see yhm_stats_enable() and yhm_stats_report(); the
+ *		histogram gives the distance of elements from their ideal
+ *		slot.</li>
+ *		</ul>
+ * @param	name	Prefix of the generated types and functions.
+ * @param	key_t	Type of the keys.
+ * @param	val_t	Type of the values.
+ * @param	hashfn	Function or macro returning the size_t hash value of a key.
+ * @param	eqfn	Function or macro telling if two keys are equal.
+ */
+#define YHM_DEFINE(name, key_t, val_t, hashfn, eqfn) \
+static size_t name##_hash_(key_t key) { \
+	size_t	hash_value = (size_t)(hashfn(key)); \
+	return (hash_value ? hash_value : 1); \
+} \
+static size_t name##_ideal_(name##_t *map, size_t hash_value) { \
+	return ((size_t)(((u64_t)hash_value * YHM_TPL_MIX) >> map->shift)); \
+} \
+static size_t name##_find_(name##_t *map, size_t hash_value, key_t key) { \
+	size_t	i, mask = map->size - 1, nbr_probes = 1; \
+	for (i = name##_ideal_(map, hash_value); map->slots[i].hash_value; \
+	     i = (i + 1) & mask, nbr_probes++) { \
+		if (map->slots[i].hash_value == hash_value && eqfn(map->slots[i].key, key)) { \
+			YHASH_STATS_LOOKUP(map->stats, nbr_probes, YTRUE); \
+			return (i); \
+		} \
+	} \
+	YHASH_STATS_LOOKUP(map->stats, nbr_probes - 1, YFALSE); \
+	return (map->size); \
+} \
+static void name##_init_(name##_t *map, size_t size) { \
+	size_t	real_size = YHM_SIZE_NANO; \
+	for (map->shift = 62; real_size < size; real_size <<= 1) \
+		map->shift--; \
+	map->size = real_size; \
+	map->slots = (name##_slot_t*)YCALLOC(real_size, sizeof(name##_slot_t)); \
+} \
+name##_t *name##_new(size_t size) { \
+	name##_t	*map; \
+	map = (name##_t*)YMALLOC(sizeof(name##_t)); \
+	name##_init_(map, size); \
+	map->used = 0; \
+	map->stats = NULL; \
+	return (map); \
+} \
+void name##_delete(name##_t *map) { \
+	if (map == NULL) \
+		return; \
+	YFREE(map->slots); \
+	if (map->stats != NULL) \
+		YFREE(map->stats); \
+	YFREE(map); \
+} \
+void name##_resize(name##_t *map, size_t size) { \
+	name##_slot_t	*old_slots = map->slots; \
+	size_t		old_size = map->size, i, j, mask; \
+	u64_t		start = 0; \
+	if (size < map->used + 1) \
+		return; \
+	if (map->stats != NULL) \
+		start = yhash_stats_now(); \
+	name##_init_(map, size); \
+	mask = map->size - 1; \
+	for (i = 0; i < old_size; i++) { \
+		if (!old_slots[i].hash_value) \
+			continue; \
+		for (j = name##_ideal_(map, old_slots[i].hash_value); map->slots[j].hash_value; j = (j + 1) & mask) \
+			; \
+		map->slots[j] = old_slots[i]; \
+	} \
+	YFREE(old_slots); \
+	if (map->stats != NULL) { \
+		map->stats->nbr_resizes++; \
+		map->stats->resize_usec += yhash_stats_now() - start; \
+	} \
+} \
+ybool_t name##_put(name##_t *map, key_t key, val_t value) { \
+	size_t	hash_value = name##_hash_(key), i, mask; \
+	if ((i = name##_find_(map, hash_value, key)) < map->size) { \
+		map->slots[i].value = value; \
+		return (YFALSE); \
+	} \
+	if (YHM_MUST_GROW(map->used, map->size)) \
+		name##_resize(map, map->size * 2); \
+	mask = map->size - 1; \
+	for (i = name##_ideal_(map, hash_value); map->slots[i].hash_value; i = (i + 1) & mask) \
+		; \
+	map->slots[i].hash_value = hash_value; \
+	map->slots[i].key = key; \
+	map->slots[i].value = value; \
+	map->used++; \
+	return (YTRUE); \
+} \
+val_t *name##_get(name##_t *map, key_t key) { \
+	size_t	i; \
+	if ((i = name##_find_(map, name##_hash_(key), key)) < map->size) \
+		return (&(map->slots[i].value)); \
+	return (NULL); \
+} \
+ybool_t name##_remove(name##_t *map, key_t key, val_t *value) { \
+	size_t	i, j, ideal, mask = map->size - 1; \
+	if ((i = name##_find_(map, name##_hash_(key), key)) == map->size) \
+		return (YFALSE); \
+	if (value != NULL) \
+		*value = map->slots[i].value; \
+	/* shift back the following elements of the cluster, no tombstone needed */ \
+	for (j = (i + 1) & mask; map->slots[j].hash_value; j = (j + 1) & mask) { \
+		ideal = name##_ideal_(map, map->slots[j].hash_value); \
+		if (((j - ideal) & mask) >= ((j - i) & mask)) { \
+			map->slots[i] = map->slots[j]; \
+			i = j; \
+		} \
+	} \
+	memset(&(map->slots[i]), 0, sizeof(name##_slot_t)); \
+	map->used--; \
+	if (map->size > YHM_SIZE_NANO && YHM_MUST_SHRINK(map->used, map->size)) \
+		name##_resize(map, map->size / 2); \
+	return (YTRUE); \
+} \
+void name##_foreach(name##_t *map, void (*func)(key_t *key, val_t *value, void *user_data), void *user_data) { \
+	size_t	i; \
+	for (i = 0; i < map->size; i++) \
+		if (map->slots[i].hash_value) \
+			func(&(map->slots[i].key), &(map->slots[i].value), user_data); \
+} \
+void name##_stats_enable(name##_t *map, ybool_t enable) { \
+	if (enable && map->stats == NULL) \
+		map->stats = (yhash_stats_t*)YMALLOC(sizeof(yhash_stats_t)); \
+	else if (!enable && map->stats != NULL) \
+		YFREE(map->stats); \
+} \
+void name##_stats_report(name##_t *map, yhash_report_t *report) { \
+	size_t	i, mask = map->size - 1, distance; \
+	yhash_report_init(report); \
+	report->nbr_containers = 1; \
+	report->size = map->size; \
+	report->used = report->used_buckets = map->used; \
+	report->memory = sizeof(name##_t) + map->size * sizeof(name##_slot_t); \
+	for (i = 0; i < map->size; i++) { \
+		if (!map->slots[i].hash_value) \
+			continue; \
+		distance = (i - name##_ideal_(map, map->slots[i].hash_value)) & mask; \
+		if (distance + 1 > report->max_chain) \
+			report->max_chain = distance + 1; \
+		report->histogram[(distance < YHASH_HISTOGRAM_SIZE) ? distance : (YHASH_HISTOGRAM_SIZE - 1)]++; \
+	} \
+	if (map->stats != NULL) { \
+		report->memory += sizeof(yhash_stats_t); \
+		report->stats = *map->stats; \
+	} \
+}
+
+#endif /* __YHASHMAP_TPL_H__ */
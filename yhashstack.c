@@ -1,12 +1,38 @@
+#define YMEM_TAG	YMEM_TAG_HASH
+
 #include <stdio.h>
+#include <string.h>
+#include <limits.h>
 #include "yhashstack.h"
 
+/** @define _YHS_STAMP Stamp of a hash stack, kept in the head of its yvector. */
+#define _YHS_STAMP(hashstack)	(((yvect_head_t*)((void*)(hashstack) - sizeof(yvect_head_t)))->stamp)
+
+/** @define _YHS_STAMP_SHIFT The upper half of a stamp identifies the stack, the lower half counts its changes. */
+#define _YHS_STAMP_SHIFT	(sizeof(size_t) * CHAR_BIT / 2)
+
+/** @define _YHS_CACHE_SET Index of the set of a hash value in a cache. */
+#define _YHS_CACHE_SET(hash_value) \
+	((((u64_t)(hash_value) * (((u64_t)0x9E3779B9 << 32) | 0x7F4A7C15)) >> 40) & (YHS_CACHE_SIZE / 2 - 1))
+
+/** @define _YHS_CACHE_MATCH Tell if a cache entry is valid and holds a key. */
+#define _YHS_CACHE_MATCH(cache, entry, hval, str, str_len) \
+	((entry)->generation == (cache)->generation && (entry)->hash_value == (hval) && \
+	 (entry)->key_len == (str_len) && !memcmp((entry)->key, (str), (str_len)))
+
+/* number of hash stacks created, to give each one its own stamps */
+static size_t _yhs_nbr_stacks = 0;
+
+/* *** definition of private functions *** */
+static yhashstack_t _yhs_stamp(yhashstack_t hashstack);
+static void _yhs_cache_check(yhs_cache_t *cache, yhashstack_t hashstack);
+
 /*
  * yhs_new
  * Creates a new hash stack.
  */
 yhashstack_t yhs_new(yhs_size_t size) {
-	return ((yhashstack_t)yv_create((yv_size_t)size));
+	return (_yhs_stamp((yhashstack_t)yv_create((yv_size_t)size)));
 }
 
 /*
@@ -22,7 +48,7 @@ void yhs_delete(yhashstack_t *hashstack) {
  * Duplicate a hash stack.
  */
 yhashstack_t yhs_duplicate(yhashstack_t hashstack) {
-	return (yv_dup((yvect_t)hashstack));
+	return (_yhs_stamp(yv_dup((yvect_t)hashstack)));
 }
 
 /*
@@ -77,10 +103,11 @@ void yhs_push_hash(yhashstack_t *hashstack, yhashtable_t *hashtable) {
 	size_t	len;
 
 	for (len = yv_len((yvect_t)*hashstack); len > 0; --len) {
-		if ((yhashtable_t*)hashstack[len - 1] == hashtable)
+		if ((yhashtable_t*)(*hashstack)[len - 1] == hashtable)
 			return;
 	}
 	yv_add((yvect_t*)hashstack, hashtable);
+	_YHS_STAMP(*hashstack)++;
 }
 
 /*
@@ -92,10 +119,11 @@ void yhs_add_hash(yhashstack_t *hashstack, yhashtable_t *hashtable) {
 	size_t	len;
 
 	for (len = yv_len((yvect_t)*hashstack); len > 0; --len) {
-		if ((yhashtable_t*)hashstack[len - 1] == hashtable)
+		if ((yhashtable_t*)(*hashstack)[len - 1] == hashtable)
 			return;
 	}
 	yv_put((yvect_t*)hashstack, hashtable);
+	_YHS_STAMP(*hashstack)++;
 }
 
 /*
@@ -103,9 +131,41 @@ void yhs_add_hash(yhashstack_t *hashstack, yhashtable_t *hashtable) {
  * Remove the last hash table of a hash stack, and return it.
  */
 yhashtable_t *yhs_pop_hash(yhashstack_t hashstack) {
+	if (hashstack == NULL)
+		return (NULL);
+	_YHS_STAMP(hashstack)++;
 	return (yv_get((yvect_t)hashstack));
 }
 
+/*
+ * yhs_push_scope
+ * Create a hash table in an arena and push it at the end of a hash stack.
+ */
+yhashtable_t *yhs_push_scope(yhashstack_t *hashstack, yarena_t *arena) {
+	yhashtable_t	*hashtable;
+
+	hashtable = yht_new_in_arena(arena, NULL, NULL);
+	yv_add((yvect_t*)hashstack, hashtable);
+	_YHS_STAMP(*hashstack)++;
+	return (hashtable);
+}
+
+/*
+ * yhs_pop_scope
+ * Remove the last hash table of a hash stack, and release its arena's memory.
+ * A hash table which doesn't come from an arena is left in the stack.
+ */
+ybool_t yhs_pop_scope(yhashstack_t hashstack) {
+	yhashtable_t	*hashtable;
+
+	hashtable = yhs_get_last_hash(hashstack);
+	if (hashtable == NULL || hashtable->arena == NULL)
+		return (YFALSE);
+	yhs_pop_hash(hashstack);
+	yarena_release(hashtable->arena, hashtable);
+	return (YTRUE);
+}
+
 /*
  * yhs_add_from_string
  * Add an element in the last hash table of a hash stack, from its string key.
@@ -177,3 +237,140 @@ void *yhs_search_from_int(yhashstack_t hashstack, size_t key) {
 	}
 	return (NULL);
 }
+
+/*
+ * yhs_bloom_enable
+ * Enable or disable the Bloom filters of all the hash tables of a hash stack.
+ */
+void yhs_bloom_enable(yhashstack_t hashstack, ybool_t enable) {
+	size_t	len;
+
+	for (len = yv_len((yvect_t)hashstack); len > 0; --len)
+		yht_bloom_enable((yhashtable_t*)hashstack[len - 1], enable);
+}
+
+/*
+ * yhs_cache_new
+ * Create a lookup cache for hash stacks.
+ */
+yhs_cache_t *yhs_cache_new(void) {
+	yhs_cache_t	*cache;
+
+	cache = (yhs_cache_t*)YMALLOC(sizeof(yhs_cache_t));
+	/* entries are zeroed, generation 0 is never used */
+	cache->generation = 1;
+	return (cache);
+}
+
+/*
+ * yhs_cache_delete
+ * Destroy a lookup cache.
+ */
+void yhs_cache_delete(yhs_cache_t *cache) {
+	if (cache == NULL)
+		return;
+	YFREE(cache);
+}
+
+/*
+ * yhs_cache_search
+ * Search an element in a hash stack, from its string key, using a cache.
+ */
+void *yhs_cache_search(yhs_cache_t *cache, yhashstack_t hashstack, const char *key) {
+	yht_hash_value_t	hval;
+	size_t			key_len, len;
+	yhs_cache_entry_t	*entry;
+	void			*res = NULL;
+
+	key_len = strlen(key);
+	if (key_len >= YHS_CACHE_KEY_SIZE)
+		return (yhs_search_from_string(hashstack, key));
+	hval = yht_hash(key);
+	_yhs_cache_check(cache, hashstack);
+	/* two-way set: the most recent entry first */
+	entry = &(cache->entries[_YHS_CACHE_SET(hval) * 2]);
+	if (_YHS_CACHE_MATCH(cache, &entry[0], hval, key, key_len))
+		return (entry[0].data);
+	if (_YHS_CACHE_MATCH(cache, &entry[1], hval, key, key_len))
+		return (entry[1].data);
+	/* walk the stack from the top */
+	for (len = yv_len((yvect_t)hashstack); len > 0; --len) {
+		res = yht_search_from_hashed_string((yhashtable_t*)hashstack[len - 1], hval, key);
+		if (res != NULL)
+			break;
+	}
+	entry[1] = entry[0];
+	entry[0].generation = cache->generation;
+	entry[0].hash_value = hval;
+	entry[0].key_len = key_len;
+	memcpy(entry[0].key, key, key_len);
+	entry[0].data = res;
+	return (res);
+}
+
+/*
+ * yhs_stats_enable
+ * Enable or disable the activity counters of all the hash tables of a hash stack.
+ */
+void yhs_stats_enable(yhashstack_t hashstack, ybool_t enable) {
+	size_t	len;
+
+	for (len = yv_len((yvect_t)hashstack); len > 0; --len)
+		yht_stats_enable((yhashtable_t*)hashstack[len - 1], enable);
+}
+
+/*
+ * yhs_stats_report
+ * Fill a report aggregating all the hash tables of a hash stack.
+ */
+void yhs_stats_report(yhashstack_t hashstack, yhash_report_t *report) {
+	size_t		len;
+	yhash_report_t	table_report;
+
+	yhash_report_init(report);
+	for (len = yv_len((yvect_t)hashstack); len > 0; --len) {
+		yht_stats_report((yhashtable_t*)hashstack[len - 1], &table_report);
+		yhash_report_merge(report, &table_report);
+	}
+}
+
+/* ************ PRIVATE FUNCTIONS ********* */
+/*
+ * _yhs_stamp
+ * Give its first stamp to a new hash stack. A stack could take the address of
+ * a deleted one; its stamps are different.
+ */
+static yhashstack_t _yhs_stamp(yhashstack_t hashstack) {
+	size_t	id;
+
+	if (hashstack == NULL)
+		return (NULL);
+#ifdef __GNUC__
+	id = __sync_add_and_fetch(&_yhs_nbr_stacks, 1);
+#else
+	id = ++_yhs_nbr_stacks;
+#endif /* __GNUC__ */
+	_YHS_STAMP(hashstack) = id << _YHS_STAMP_SHIFT;
+	return (hashstack);
+}
+
+/*
+ * _yhs_cache_check
+ * Compare the hash stack, its stamp and the versions of its hash tables with
+ * those seen by a cache. If anything changed, the cache is invalidated.
+ * While the stamp doesn't change, the stack holds the same hash tables, whose
+ * versions only grow: their sum is enough to see a change.
+ */
+static void _yhs_cache_check(yhs_cache_t *cache, yhashstack_t hashstack) {
+	size_t	stamp, versions = 0, len;
+
+	stamp = (hashstack != NULL) ? _YHS_STAMP(hashstack) : 0;
+	for (len = yv_len((yvect_t)hashstack); len > 0; --len)
+		versions += ((yhashtable_t*)hashstack[len - 1])->version;
+	if (hashstack == cache->hashstack && stamp == cache->stamp && versions == cache->versions)
+		return;
+	cache->hashstack = hashstack;
+	cache->stamp = stamp;
+	cache->versions = versions;
+	cache->generation++;
+}
@@ -28,6 +28,52 @@ typedef yvect_t yhashstack_t;
 /*! @typedef yhs_size_t Same as yv_size_t. */
 typedef yv_size_t yhs_size_t;
 
+/** @define YHS_CACHE_SIZE Number of entries of a hash stack cache (a power of 2), grouped in sets of two. */
+#define YHS_CACHE_SIZE		256
+
+/** @define YHS_CACHE_KEY_SIZE Keys must be shorter than this to be cached. */
+#define YHS_CACHE_KEY_SIZE	32
+
+/**
+ * @typedef	yhs_cache_entry_t
+ *		Result of a lookup, kept in a hash stack cache.
+ * @field	generation	Generation of the cache when the entry was written.
+ * @field	hash_value	Hash value of the key.
+ * @field	key_len		Length of the key.
+ * @field	data		The found data, or NULL if the key is in no hash table.
+ * @field	key		Copy of the key.
+ */
+typedef struct yhs_cache_entry_s {
+	size_t			generation;
+	yht_hash_value_t	hash_value;
+	size_t			key_len;
+	void			*data;
+	char			key[YHS_CACHE_KEY_SIZE];
+} yhs_cache_entry_t;
+
+/**
+ * @typedef	yhs_cache_t
+ *		Flattened view of a hash stack: the results of string lookups
+ *		are cached, hits and misses alike. The cache keeps the hash
+ *		stack it last saw, the stack's stamp (which changes when a hash
+ *		table is pushed or popped) and the sum of the versions of its
+ *		hash tables (which grows when any of them is modified); when
+ *		one of them differs, the whole cache is invalidated by
+ *		incrementing its generation.
+ * @field	generation	Current generation; entries of older generations are invalid.
+ * @field	hashstack	The hash stack seen by the cache.
+ * @field	stamp		Stamp of the hash stack when the cache was last checked.
+ * @field	versions	Sum of the versions of its hash tables at that time.
+ * @field	entries		Array of cached lookups, in two-way sets.
+ */
+typedef struct yhs_cache_s {
+	size_t			generation;
+	yhashstack_t		hashstack;
+	size_t			stamp;
+	size_t			versions;
+	yhs_cache_entry_t	entries[YHS_CACHE_SIZE];
+} yhs_cache_t;
+
 /* ******************** FUNCTIONS ******************** */
 
 /* ---------- creation / deletion ---------- */
@@ -110,6 +156,34 @@ void yhs_add_hash(yhashstack_t *hashstack, yhashtable_t *hashtable);
  */
 yhashtable_t *yhs_pop_hash(yhashstack_t hashstack);
 
+/**
+ * @function	yhs_push_scope
+ *		Create a hash table in an arena and push it at the end of a hash
+ *		stack. Scopes must be popped in the reverse order of their
+ *		creation, with yhs_pop_scope(). While a scope is open, nothing
+ *		must be added to the hash tables of the outer scopes of the same
+ *		arena: their new elements would be allocated after the scope's
+ *		mark, and released with it.
+ * @param	hashstack	Pointer to the hash stack.
+ * @param	arena		Pointer to the arena.
+ * @return	A pointer to the created hash table.
+ */
+yhashtable_t *yhs_push_scope(yhashstack_t *hashstack, yarena_t *arena);
+
+/**
+ * @function	yhs_pop_scope
+ *		Remove the last hash table of a hash stack, which must have been
+ *		pushed by yhs_push_scope(), and release at once all the memory
+ *		taken from the arena since it was pushed. Destroy functions are
+ *		not called. A hash table which doesn't come from an arena (pushed
+ *		with yhs_push_hash()) is not popped; it must be removed with
+ *		yhs_pop_hash() and deleted by its owner.
+ * @param	hashstack	The hash stack.
+ * @return	YTRUE if the scope was popped, YFALSE if the stack is empty or
+ *		if its last hash table is not a scope.
+ */
+ybool_t yhs_pop_scope(yhashstack_t hashstack);
+
 /* ---------- data management ---------- */
 
 /**
@@ -152,6 +226,67 @@ void *yhs_search_from_string(yhashstack_t hashstack, const char *key);
  */
 void *yhs_search_from_int(yhashstack_t hashstack, size_t key);
 
+/* ---------- lookup acceleration ---------- */
+
+/**
+ * @function	yhs_bloom_enable
+ *		Enable or disable the Bloom filters of all the hash tables of a
+ *		hash stack, so that searches skip the tables which surely don't
+ *		contain a key. See yht_bloom_enable().
+ * @param	hashstack	The hash stack.
+ * @param	enable		YTRUE to enable the filters, YFALSE to disable them.
+ */
+void yhs_bloom_enable(yhashstack_t hashstack, ybool_t enable);
+
+/**
+ * @function	yhs_cache_new
+ *		Create a lookup cache for hash stacks.
+ * @return	The created cache.
+ */
+yhs_cache_t *yhs_cache_new(void);
+
+/**
+ * @function	yhs_cache_delete
+ *		Destroy a lookup cache.
+ * @param	cache	Pointer to the cache.
+ */
+void yhs_cache_delete(yhs_cache_t *cache);
+
+/**
+ * @function	yhs_cache_search
+ *		Search an element in a hash stack, from its string key, using a
+ *		cache. The result is the same as yhs_search_from_string(), as
+ *		long as the stack is only changed with the yhs_*() functions.
+ *		Checking the cache reads the version of each hash table, without
+ *		any lookup; a change of one of the stack's hash tables
+ *		invalidates it. A cache should always be used with the same hash
+ *		stack; giving it another stack just invalidates it.
+ * @param	cache		Pointer to the cache.
+ * @param	hashstack	The hash stack.
+ * @param	key		Key used to index the element.
+ * @return	A pointer to the element's data.
+ */
+void *yhs_cache_search(yhs_cache_t *cache, yhashstack_t hashstack, const char *key);
+
+/* ---------- instrumentation ---------- */
+
+/**
+ * @function	yhs_stats_enable
+ *		Enable or disable the activity counters of all the hash tables
+ *		of a hash stack.
+ * @param	hashstack	The hash stack.
+ * @param	enable		YTRUE to enable the counters, YFALSE to disable them.
+ */
+void yhs_stats_enable(yhashstack_t hashstack, ybool_t enable);
+
+/**
+ * @function	yhs_stats_report
+ *		Fill a report aggregating all the hash tables of a hash stack.
+ * @param	hashstack	The hash stack.
+ * @param	report		Pointer to the report.
+ */
+void yhs_stats_report(yhashstack_t hashstack, yhash_report_t *report);
+
 #if defined(__cplusplus) || defined(c_plusplus)
 }
 #endif /* __cplusplus || c_plusplus */
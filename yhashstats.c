@@ -0,0 +1,101 @@
+#define YMEM_TAG	YMEM_TAG_HASH
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include "yhashstats.h"
+
+/*
+ * yhash_stats_now()
+ * Return the current time in microseconds.
+ */
+u64_t yhash_stats_now(void) {
+	struct timeval	tv;
+
+	gettimeofday(&tv, NULL);
+	return ((u64_t)tv.tv_sec * 1000000 + (u64_t)tv.tv_usec);
+}
+
+/*
+ * yhash_report_init()
+ * Reset a report.
+ */
+void yhash_report_init(yhash_report_t *report) {
+	memset(report, 0, sizeof(yhash_report_t));
+}
+
+/*
+ * yhash_report_add_bucket()
+ * Account a bucket in a report.
+ */
+void yhash_report_add_bucket(yhash_report_t *report, size_t nbr_elements) {
+	report->size++;
+	report->used += nbr_elements;
+	if (nbr_elements > 0)
+		report->used_buckets++;
+	if (nbr_elements > report->max_chain)
+		report->max_chain = nbr_elements;
+	if (nbr_elements >= YHASH_HISTOGRAM_SIZE)
+		nbr_elements = YHASH_HISTOGRAM_SIZE - 1;
+	report->histogram[nbr_elements]++;
+}
+
+/*
+ * yhash_report_merge()
+ * Add a report to another one.
+ */
+void yhash_report_merge(yhash_report_t *report, const yhash_report_t *source) {
+	size_t	i;
+
+	report->nbr_containers += source->nbr_containers;
+	report->size += source->size;
+	report->used += source->used;
+	report->used_buckets += source->used_buckets;
+	if (source->max_chain > report->max_chain)
+		report->max_chain = source->max_chain;
+	report->memory += source->memory;
+	for (i = 0; i < YHASH_HISTOGRAM_SIZE; i++)
+		report->histogram[i] += source->histogram[i];
+	report->stats.nbr_lookups += source->stats.nbr_lookups;
+	report->stats.nbr_hits += source->stats.nbr_hits;
+	report->stats.nbr_probes += source->stats.nbr_probes;
+	report->stats.nbr_resizes += source->stats.nbr_resizes;
+	report->stats.resize_usec += source->stats.resize_usec;
+}
+
+/*
+ * yhash_report_dump()
+ * Format a report as text.
+ */
+ystr_t yhash_report_dump(const yhash_report_t *report, const char *name) {
+	ystr_t	s;
+	char	buf[256];
+	size_t	i;
+
+	s = ys_new("");
+	ys_cat(&s, name);
+	sprintf(buf, ": containers=%lu size=%lu used=%lu load=%.3f used_buckets=%lu max_chain=%lu mean_chain=%.3f memory=%lu\n",
+		(unsigned long)report->nbr_containers, (unsigned long)report->size,
+		(unsigned long)report->used,
+		report->size ? ((double)report->used / report->size) : 0.0,
+		(unsigned long)report->used_buckets, (unsigned long)report->max_chain,
+		report->used_buckets ? ((double)report->used / report->used_buckets) : 0.0,
+		(unsigned long)report->memory);
+	ys_cat(&s, buf);
+	ys_cat(&s, name);
+	sprintf(buf, ": lookups=%lu hits=%lu probes=%lu probes_per_lookup=%.3f resizes=%lu resize_usec=%lu\n",
+		(unsigned long)report->stats.nbr_lookups, (unsigned long)report->stats.nbr_hits,
+		(unsigned long)report->stats.nbr_probes,
+		report->stats.nbr_lookups ? ((double)report->stats.nbr_probes / report->stats.nbr_lookups) : 0.0,
+		(unsigned long)report->stats.nbr_resizes, (unsigned long)report->stats.resize_usec);
+	ys_cat(&s, buf);
+	ys_cat(&s, name);
+	ys_cat(&s, ": histogram");
+	for (i = 0; i < YHASH_HISTOGRAM_SIZE; i++) {
+		sprintf(buf, " %lu%s=%lu", (unsigned long)i, ((i == YHASH_HISTOGRAM_SIZE - 1) ? "+" : ""),
+			(unsigned long)report->histogram[i]);
+		ys_cat(&s, buf);
+	}
+	ys_cat(&s, "\n");
+	return (s);
+}
@@ -0,0 +1,131 @@
+/* Process this file with the HeaderBrowser tool (http://www.headerbrowser.org)
+   to create documentation. */
+/*!
+ * @header	yhashstats.h
+ * @abstract	Instrumentation of hash containers.
+ * @discussion	Hash tables and hash maps can keep a few counters about their
+ *		activity (lookups, compared elements, resizes). Counting is
+ *		disabled by default; when enabled, it costs a pointer test and
+ *		some increments per lookup, and a call to gettimeofday() per
+ *		resize. The structural figures (bucket occupancy, chain lengths,
+ *		memory) are computed only when a report is asked for.
+ * @version	1.0 Oct 19 2026
+ * @author	Amaury Bouchard <amaury@amaury.net>
+ */
+#ifndef __YHASHSTATS_H__
+#define __YHASHSTATS_H__
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif /* __cplusplus || c_plusplus */
+
+#include "ydefs.h"
+#include "ystr.h"
+
+/** @define YHASH_HISTOGRAM_SIZE Number of slots of the bucket occupancy histogram. The last one counts the buckets with that many elements or more. */
+#define YHASH_HISTOGRAM_SIZE	8
+
+/**
+ * @typedef	yhash_stats_t
+ *		Activity counters of a hash container.
+ * @field	nbr_lookups	Number of bucket lookups (searches, and the lookups done
+ *				by additions and removals).
+ * @field	nbr_hits	Number of lookups that found an element.
+ * @field	nbr_probes	Number of elements compared to a key during lookups.
+ * @field	nbr_resizes	Number of resizes.
+ * @field	resize_usec	Time spent in resizes, in microseconds.
+ */
+typedef struct yhash_stats_s {
+	u64_t	nbr_lookups;
+	u64_t	nbr_hits;
+	u64_t	nbr_probes;
+	u64_t	nbr_resizes;
+	u64_t	resize_usec;
+} yhash_stats_t;
+
+/**
+ * @typedef	yhash_report_t
+ *		Snapshot of the state of one or more hash containers.
+ * @field	nbr_containers	Number of containers included in the report.
+ * @field	size		Number of buckets.
+ * @field	used		Number of elements.
+ * @field	used_buckets	Number of non-empty buckets.
+ * @field	max_chain	Number of elements of the most loaded bucket.
+ * @field	memory		Memory used by the containers, in bytes (data excluded).
+ * @field	histogram	Number of buckets per count of elements.
+ * @field	stats		Sum of the activity counters.
+ */
+typedef struct yhash_report_s {
+	size_t		nbr_containers;
+	size_t		size;
+	size_t		used;
+	size_t		used_buckets;
+	size_t		max_chain;
+	size_t		memory;
+	size_t		histogram[YHASH_HISTOGRAM_SIZE];
+	yhash_stats_t	stats;
+} yhash_report_t;
+
+/**
+ * @define	YHASH_STATS_LOOKUP
+ *		Update the counters of a container after a lookup. Does nothing
+ *		if the counters are disabled (NULL pointer).
+ * @param	stats	Pointer to the counters.
+ * @param	probes	Number of compared elements.
+ * @param	found	True if an element was found.
+ */
+#define YHASH_STATS_LOOKUP(stats, probes, found) \
+	do { \
+		if ((stats) != NULL) { \
+			(stats)->nbr_lookups++; \
+			(stats)->nbr_probes += (probes); \
+			if (found) \
+				(stats)->nbr_hits++; \
+		} \
+	} while (0)
+
+/* ****************** FUNCTIONS **************** */
+/**
+ * @function	yhash_stats_now
+ *		Return the current time, used to measure resizes.
+ * @return	The current time in microseconds.
+ */
+u64_t yhash_stats_now(void);
+
+/**
+ * @function	yhash_report_init
+ *		Reset a report.
+ * @param	report	Pointer to the report.
+ */
+void yhash_report_init(yhash_report_t *report);
+
+/**
+ * @function	yhash_report_add_bucket
+ *		Account a bucket in a report.
+ * @param	report		Pointer to the report.
+ * @param	nbr_elements	Number of elements in the bucket.
+ */
+void yhash_report_add_bucket(yhash_report_t *report, size_t nbr_elements);
+
+/**
+ * @function	yhash_report_merge
+ *		Add a report to another one.
+ * @param	report	Pointer to the destination report.
+ * @param	source	Pointer to the added report.
+ */
+void yhash_report_merge(yhash_report_t *report, const yhash_report_t *source);
+
+/**
+ * @function	yhash_report_dump
+ *		Format a report as text, one "name: key=value ..." line per topic.
+ * @param	report	Pointer to the report.
+ * @param	name	Name written at the beginning of each line.
+ * @return	A new ystring, to be freed with ys_del().
+ */
+ystr_t yhash_report_dump(const yhash_report_t *report, const char *name);
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif /* __cplusplus || c_plusplus */
+
+#endif /* __YHASHSTATS_H__ */
@@ -1,12 +1,65 @@
+#define YMEM_TAG	YMEM_TAG_HASH
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include "yhashtable.h"
+#include "yslab.h"
+
+/** @define _YHT_PREFETCH Hint the processor to fetch a memory location in cache. */
+#ifdef __GNUC__
+# define _YHT_PREFETCH(addr)	__builtin_prefetch(addr)
+#else
+# define _YHT_PREFETCH(addr)
+#endif /* __GNUC__ */
+
+/** @define _YHT_BLOOM_MIX Spread a hash value over 64 bits; the Bloom filter's bits are taken from the upper half. */
+#define _YHT_BLOOM_MIX(hash_value)	((u64_t)(hash_value) * (((u64_t)0x9E3779B9 << 32) | 0x7F4A7C15))
+
+/** @define _YHT_ALLOC Allocate zeroed memory for a hash table, from its arena if it has one. */
+#define _YHT_ALLOC(hashtable, s)	((hashtable)->arena ? yarena_alloc((hashtable)->arena, (s)) : YMALLOC(s))
+
+/** @define _YHT_FREE Free memory of a hash table. Memory taken from an arena is left to it. */
+#define _YHT_FREE(hashtable, p) \
+	do { \
+		if ((hashtable)->arena == NULL) \
+			YFREE(p); \
+		else \
+			(p) = NULL; \
+	} while (0)
+
+/** @define _YHT_ALLOC_OBJ Allocate an element or an item of a hash table, from its arena or from the slab allocator. */
+#define _YHT_ALLOC_OBJ(hashtable, s)	((hashtable)->arena ? yarena_alloc((hashtable)->arena, (s)) : YSLAB_ALLOC(s))
+
+/** @define _YHT_FREE_OBJ Free an element or an item of a hash table, given its size. */
+#define _YHT_FREE_OBJ(hashtable, p, s) \
+	do { \
+		if ((hashtable)->arena == NULL) \
+			YSLAB_FREE(p, s); \
+		else \
+			(p) = NULL; \
+	} while (0)
+
+/** @define _YHT_ELEMENT_SIZE Size of an element, including its key when it is stored inside. */
+#define _YHT_ELEMENT_SIZE(hashtable, key, key_len) \
+	(((key) != NULL && (hashtable)->key_mode == YHT_KEYS_OWNED && (key_len) < YHT_INLINE_KEY_SIZE) ? \
+	 sizeof(yht_element_t) + (key_len) + 1 : sizeof(yht_element_t))
 
 /* *** definition of private functions *** */
-static ybool_t _yht_remove(yhashtable_t *hashtable, yht_hash_value_t hash_value, const char *key, ybool_t try_to_destroy);
-static void *_yht_search(yhashtable_t *hashtable, yht_hash_value_t hash_value, const char *key);
-static void _yht_add(yhashtable_t *hashtable, yht_hash_value_t hash_value, char *key, void *data);
+static yht_hash_value_t _yht_hash_len(const char *key, size_t *key_len);
+static ybool_t _yht_match(yht_element_t *element, yht_hash_value_t hash_value, const char *key, size_t key_len);
+static yht_element_t *_yht_new_element(yhashtable_t *hashtable, char *key, size_t key_len);
+static void _yht_free_element(yhashtable_t *hashtable, yht_element_t *element);
+static void _yht_update_element(yhashtable_t *hashtable, yht_element_t *element, char *key, void *data);
+static void _yht_unlink_item(yhashtable_t *hashtable, yht_list_t *item);
+static yht_list_t *_yht_small_find(yhashtable_t *hashtable, yht_hash_value_t hash_value, const char *key, size_t key_len);
+static ybool_t _yht_remove(yhashtable_t *hashtable, yht_hash_value_t hash_value, const char *key, size_t key_len, ybool_t try_to_destroy);
+static void *_yht_search(yhashtable_t *hashtable, yht_hash_value_t hash_value, const char *key, size_t key_len);
+static void _yht_add(yhashtable_t *hashtable, yht_hash_value_t hash_value, char *key, size_t key_len, void *data);
+static void _yht_bloom_build(yhashtable_t *hashtable);
+static void _yht_bloom_set(yhashtable_t *hashtable, yht_hash_value_t hash_value);
+static ybool_t _yht_bloom_test(yhashtable_t *hashtable, yht_hash_value_t hash_value);
+static void _yht_prefetch_batch(yhashtable_t *hashtable, const char **keys, size_t nbr_keys, yht_hash_value_t *hash_values, size_t *key_lens);
 
 /*
  * yht_new()
@@ -21,6 +74,37 @@ yhashtable_t *yht_new(yht_size_t size, yht_function_t destroy_func, void *destro
 	hash->used = 0;
 	hash->items = NULL;
 	hash->next_offset = 0;
+	hash->key_mode = YHT_KEYS_BORROWED;
+	hash->stats = NULL;
+	hash->version = 0;
+	hash->bloom = NULL;
+	hash->bloom_bits = 0;
+	hash->arena = NULL;
+	hash->destroy_func = destroy_func;
+	hash->destroy_data = destroy_data;
+	return (hash);
+}
+
+/*
+ * yht_new_in_arena()
+ * Creates a new hash table whose memory comes from an arena.
+ */
+yhashtable_t *yht_new_in_arena(yarena_t *arena, yht_function_t destroy_func, void *destroy_data) {
+	yhashtable_t	*hash;
+
+	hash = (yhashtable_t*)yarena_alloc(arena, sizeof(yhashtable_t));
+	/* no buckets until the table holds more than YHT_SMALL_SIZE elements */
+	hash->buckets = NULL;
+	hash->size = 0;
+	hash->used = 0;
+	hash->items = NULL;
+	hash->next_offset = 0;
+	hash->key_mode = YHT_KEYS_BORROWED;
+	hash->stats = NULL;
+	hash->version = 0;
+	hash->bloom = NULL;
+	hash->bloom_bits = 0;
+	hash->arena = arena;
 	hash->destroy_func = destroy_func;
 	hash->destroy_data = destroy_data;
 	return (hash);
@@ -46,13 +130,29 @@ void yht_delete(yhashtable_t *hashtable) {
 				hashtable->destroy_func(element->hash_value, element->key, element->data, hashtable->destroy_data);
 			old_item = item;
 			item = item->next;
-			YFREE(old_item);
-			YFREE(element);
+			_YHT_FREE_OBJ(hashtable, old_item, sizeof(yht_list_t));
+			_yht_free_element(hashtable, element);
 		}
 	}
-	/* remove buckets and the hash table itself */
-	YFREE(hashtable->buckets);
-	YFREE(hashtable);
+	/* remove buckets, counters, filter and the hash table itself */
+	_YHT_FREE(hashtable, hashtable->buckets);
+	if (hashtable->stats != NULL)
+		_YHT_FREE(hashtable, hashtable->stats);
+	if (hashtable->bloom != NULL)
+		_YHT_FREE(hashtable, hashtable->bloom);
+	if (hashtable->arena == NULL)
+		YFREE(hashtable);
+}
+
+/*
+ * yht_set_key_mode
+ * Define how a hash table stores its string keys.
+ */
+ybool_t yht_set_key_mode(yhashtable_t *hashtable, yht_key_mode_t mode) {
+	if (hashtable->used > 0)
+		return (YFALSE);
+	hashtable->key_mode = mode;
+	return (YTRUE);
 }
 
 /*
@@ -60,7 +160,11 @@ void yht_delete(yhashtable_t *hashtable) {
  * Add an element to a hash table, using a string key.
  */
 void yht_add_from_string(yhashtable_t *hashtable, char *key, void *data) {
-	_yht_add(hashtable, 0, key, data);
+	yht_hash_value_t	hash_value;
+	size_t			key_len;
+
+	hash_value = _yht_hash_len(key, &key_len);
+	_yht_add(hashtable, hash_value, key, key_len, data);
 }
 
 /*
@@ -70,7 +174,7 @@ void yht_add_from_string(yhashtable_t *hashtable, char *key, void *data) {
 void yht_add_from_int(yhashtable_t *hashtable, size_t key, void *data) {
 	if (key >= hashtable->next_offset)
 		hashtable->next_offset = key + 1;
-	_yht_add(hashtable, key, NULL, data);
+	_yht_add(hashtable, key, NULL, 0, data);
 }
 
 /*
@@ -86,7 +190,11 @@ void yht_push_data(yhashtable_t *hashtable, void *data) {
  * Search an element in a hash table, from its string key.
  */
 void *yht_search_from_string(yhashtable_t *hashtable, const char *key) {
-	return (_yht_search(hashtable, 0, key));
+	yht_hash_value_t	hash_value;
+	size_t			key_len;
+
+	hash_value = _yht_hash_len(key, &key_len);
+	return (_yht_search(hashtable, hash_value, key, key_len));
 }
 
 /*
@@ -94,7 +202,7 @@ void *yht_search_from_string(yhashtable_t *hashtable, const char *key) {
  * Search an element in a hash table, from its integer key.
  */
 void *yht_search_from_int(yhashtable_t *hashtable, size_t key) {
-	return (_yht_search(hashtable, key, NULL));
+	return (_yht_search(hashtable, key, NULL, 0));
 }
 
 /*
@@ -102,7 +210,62 @@ void *yht_search_from_int(yhashtable_t *hashtable, size_t key) {
  * Search an element in a hash table, from its hashed string key.
  */
 void *yht_search_from_hashed_string(yhashtable_t *hashtable, size_t hash_value, const char *key) {
-	return (_yht_search(hashtable, hash_value, key));
+	if (hash_value == 0 && key != NULL)
+		return (yht_search_from_string(hashtable, key));
+	return (_yht_search(hashtable, (yht_hash_value_t)hash_value, key, (key ? strlen(key) : 0)));
+}
+
+/*
+ * yht_search_many
+ * Search a batch of elements in a hash table, from their string keys.
+ */
+size_t yht_search_many(yhashtable_t *hashtable, const char **keys, size_t nbr_keys, void **results) {
+	yht_hash_value_t	hash_values[YHT_BATCH_SIZE];
+	size_t			key_lens[YHT_BATCH_SIZE];
+	size_t			offset, batch, i, found = 0;
+
+	for (offset = 0; offset < nbr_keys; offset += batch) {
+		batch = nbr_keys - offset;
+		if (batch > YHT_BATCH_SIZE)
+			batch = YHT_BATCH_SIZE;
+		_yht_prefetch_batch(hashtable, keys + offset, batch, hash_values, key_lens);
+		/* resolve the batch, its memory should be in cache by now */
+		for (i = 0; i < batch; i++) {
+			results[offset + i] = _yht_search(hashtable, hash_values[i], keys[offset + i], key_lens[i]);
+			if (results[offset + i] != NULL)
+				found++;
+		}
+	}
+	return (found);
+}
+
+/*
+ * yht_add_many
+ * Add a batch of elements to a hash table, using string keys.
+ */
+void yht_add_many(yhashtable_t *hashtable, char **keys, void **data, size_t nbr_keys) {
+	yht_hash_value_t	hash_values[YHT_BATCH_SIZE];
+	size_t			key_lens[YHT_BATCH_SIZE];
+	size_t			offset, batch, i, new_size;
+
+	/* resize once, so buckets don't move while a batch is in flight */
+	new_size = hashtable->size;
+	if (new_size == 0 && hashtable->used + nbr_keys > YHT_SMALL_SIZE)
+		new_size = YHT_SIZE_MINI;
+	for (; new_size != 0 &&
+	     (float)(hashtable->used + nbr_keys) / new_size > YHT_MAX_LOAD_FACTOR;
+	     new_size *= 2)
+		;
+	if (new_size != hashtable->size)
+		yht_resize(hashtable, new_size);
+	for (offset = 0; offset < nbr_keys; offset += batch) {
+		batch = nbr_keys - offset;
+		if (batch > YHT_BATCH_SIZE)
+			batch = YHT_BATCH_SIZE;
+		_yht_prefetch_batch(hashtable, (const char**)keys + offset, batch, hash_values, key_lens);
+		for (i = 0; i < batch; i++)
+			_yht_add(hashtable, hash_values[i], keys[offset + i], key_lens[i], data[offset + i]);
+	}
 }
 
 /*
@@ -117,7 +280,7 @@ void *yht_pop_data(yhashtable_t *hashtable) {
 		return (NULL);
 	element = hashtable->items->previous->element;
 	data = element->data;
-	_yht_remove(hashtable, element->hash_value, element->key, YFALSE);
+	_yht_remove(hashtable, element->hash_value, element->key, element->key_len, YFALSE);
 	return (data);
 }
 
@@ -126,7 +289,11 @@ void *yht_pop_data(yhashtable_t *hashtable) {
  * Remove an element from a hash table, using its string key.
  */
 ybool_t yht_remove_from_string(yhashtable_t *hashtable, const char *key) {
-	return (_yht_remove(hashtable, 0, key, YTRUE));
+	yht_hash_value_t	hash_value;
+	size_t			key_len;
+
+	hash_value = _yht_hash_len(key, &key_len);
+	return (_yht_remove(hashtable, hash_value, key, key_len, YTRUE));
 }
 
 /*
@@ -134,7 +301,7 @@ ybool_t yht_remove_from_string(yhashtable_t *hashtable, const char *key) {
  * Remove an element from a hash table, using its integer key.
  */
 ybool_t yht_remove_from_int(yhashtable_t *hashtable, size_t key) {
-	return (_yht_remove(hashtable, key, NULL, YTRUE));
+	return (_yht_remove(hashtable, key, NULL, 0, YTRUE));
 }
 
 /*
@@ -147,8 +314,11 @@ void yht_resize(yhashtable_t *hashtable, size_t size) {
 	yht_bucket_t		*new_buckets, *bucket;
 	yht_list_t		*item;
 	yht_element_t		*element;
+	u64_t			start = 0;
 
-	new_buckets = (yht_bucket_t*)YCALLOC(size, sizeof(yht_bucket_t));
+	if (hashtable->stats != NULL)
+		start = yhash_stats_now();
+	new_buckets = (yht_bucket_t*)_YHT_ALLOC(hashtable, size * sizeof(yht_bucket_t));
 	for (offset = 0, item = hashtable->items;
 	     offset < hashtable->used;
 	     offset++, item = item->next) {
@@ -168,10 +338,17 @@ void yht_resize(yhashtable_t *hashtable, size_t size) {
 		bucket->nbr_elements++;
 	}
 	/* freeing old array of buckets */
-	YFREE(hashtable->buckets);
+	_YHT_FREE(hashtable, hashtable->buckets);
 	/* swapping buckets */
 	hashtable->buckets = new_buckets;
 	hashtable->size = size;
+	/* the Bloom filter is rebuilt at the new size, forgetting removed elements */
+	if (hashtable->bloom != NULL)
+		_yht_bloom_build(hashtable);
+	if (hashtable->stats != NULL) {
+		hashtable->stats->nbr_resizes++;
+		hashtable->stats->resize_usec += yhash_stats_now() - start;
+	}
 }
 
 /*
@@ -191,6 +368,62 @@ void yht_foreach(yhashtable_t *hashtable, yht_function_t func, void *user_data)
 	}
 }
 
+/*
+ * yht_stats_enable
+ * Enable or disable the activity counters of a hash table.
+ */
+void yht_stats_enable(yhashtable_t *hashtable, ybool_t enable) {
+	if (hashtable->stats != NULL)
+		_YHT_FREE(hashtable, hashtable->stats);
+	if (enable)
+		hashtable->stats = (yhash_stats_t*)_YHT_ALLOC(hashtable, sizeof(yhash_stats_t));
+}
+
+/*
+ * yht_stats_report
+ * Fill a report about a hash table.
+ */
+void yht_stats_report(yhashtable_t *hashtable, yhash_report_t *report) {
+	size_t		offset;
+	yht_list_t	*item;
+	yht_element_t	*element;
+
+	yhash_report_init(report);
+	report->nbr_containers = 1;
+	for (offset = 0; offset < hashtable->size; offset++)
+		yhash_report_add_bucket(report, hashtable->buckets[offset].nbr_elements);
+	report->memory = sizeof(yhashtable_t) + hashtable->size * sizeof(yht_bucket_t) +
+			 hashtable->used * (sizeof(yht_element_t) + sizeof(yht_list_t));
+	if (hashtable->key_mode == YHT_KEYS_OWNED) {
+		for (offset = 0, item = hashtable->items;
+		     offset < hashtable->used;
+		     offset++, item = item->next) {
+			element = item->element;
+			if (element->key != NULL)
+				report->memory += element->key_len + 1;
+		}
+	}
+	if (hashtable->bloom != NULL)
+		report->memory += hashtable->bloom_bits / 8;
+	if (hashtable->stats != NULL) {
+		report->memory += sizeof(yhash_stats_t);
+		report->stats = *hashtable->stats;
+	}
+}
+
+/*
+ * yht_bloom_enable
+ * Enable or disable the Bloom filter of a hash table.
+ */
+void yht_bloom_enable(yhashtable_t *hashtable, ybool_t enable) {
+	if (enable)
+		_yht_bloom_build(hashtable);
+	else if (hashtable->bloom != NULL) {
+		_YHT_FREE(hashtable, hashtable->bloom);
+		hashtable->bloom_bits = 0;
+	}
+}
+
 /*
  * yht_hash()
  * Compute the hash value of a key, using the SDBM algorithm.
@@ -204,11 +437,204 @@ yht_hash_value_t yht_hash(const char *key) {
 }
 
 /* ****** PRIVATE FUNCTIONS ******* */
+/**
+ * _yht_hash_len
+ * Compute the hash value of a key (same algorithm than yht_hash()) and its length.
+ */
+static yht_hash_value_t _yht_hash_len(const char *key, size_t *key_len) {
+	yht_hash_value_t	hash_value;
+	const char		*pt;
+
+	for (hash_value = 0, pt = key; *pt; pt++)
+		hash_value = *pt + (hash_value << 6) + (hash_value << 16) - hash_value;
+	*key_len = pt - key;
+	return (hash_value);
+}
+
+/**
+ * _yht_bloom_build
+ * (Re)allocate the Bloom filter of a hash table at a size matching its
+ * number of buckets, and fill it with the stored hash values.
+ */
+static void _yht_bloom_build(yhashtable_t *hashtable) {
+	size_t		offset, bits;
+	yht_list_t	*item;
+
+	for (bits = YHT_BLOOM_BITS; bits < hashtable->size * YHT_BLOOM_RATIO; bits *= 2)
+		;
+	if (hashtable->bloom != NULL && bits == hashtable->bloom_bits)
+		memset(hashtable->bloom, 0, bits / 8);
+	else {
+		if (hashtable->bloom != NULL)
+			_YHT_FREE(hashtable, hashtable->bloom);
+		hashtable->bloom = (u64_t*)_YHT_ALLOC(hashtable, bits / 8);
+		hashtable->bloom_bits = bits;
+	}
+	for (offset = 0, item = hashtable->items;
+	     offset < hashtable->used;
+	     offset++, item = item->next)
+		_yht_bloom_set(hashtable, item->element->hash_value);
+}
+
+/**
+ * _yht_bloom_set
+ * Set the two bits of a hash value in the Bloom filter of a hash table.
+ */
+static void _yht_bloom_set(yhashtable_t *hashtable, yht_hash_value_t hash_value) {
+	u64_t	mix, bit1, bit2;
+
+	mix = _YHT_BLOOM_MIX(hash_value);
+	bit1 = (mix >> 32) & (hashtable->bloom_bits - 1);
+	bit2 = (_YHT_BLOOM_MIX(mix) >> 32) & (hashtable->bloom_bits - 1);
+	hashtable->bloom[bit1 / 64] |= (u64_t)1 << (bit1 % 64);
+	hashtable->bloom[bit2 / 64] |= (u64_t)1 << (bit2 % 64);
+}
+
+/**
+ * _yht_bloom_test
+ * Tell if a hash value may be in the Bloom filter of a hash table.
+ */
+static ybool_t _yht_bloom_test(yhashtable_t *hashtable, yht_hash_value_t hash_value) {
+	u64_t	mix, bit1, bit2;
+
+	mix = _YHT_BLOOM_MIX(hash_value);
+	bit1 = (mix >> 32) & (hashtable->bloom_bits - 1);
+	bit2 = (_YHT_BLOOM_MIX(mix) >> 32) & (hashtable->bloom_bits - 1);
+	if ((hashtable->bloom[bit1 / 64] & ((u64_t)1 << (bit1 % 64))) &&
+	    (hashtable->bloom[bit2 / 64] & ((u64_t)1 << (bit2 % 64))))
+		return (YTRUE);
+	return (YFALSE);
+}
+
+/**
+ * _yht_prefetch_batch
+ * Hash a batch of keys and prefetch their buckets, then the first element of
+ * each bucket. Each pass issues all its loads before any of them is waited for.
+ */
+static void _yht_prefetch_batch(yhashtable_t *hashtable, const char **keys, size_t nbr_keys, yht_hash_value_t *hash_values, size_t *key_lens) {
+	yht_bucket_t	*bucket;
+	size_t		i;
+
+	if (hashtable->buckets == NULL) {
+		for (i = 0; i < nbr_keys; i++)
+			hash_values[i] = _yht_hash_len(keys[i], &key_lens[i]);
+		return;
+	}
+	for (i = 0; i < nbr_keys; i++) {
+		hash_values[i] = _yht_hash_len(keys[i], &key_lens[i]);
+		_YHT_PREFETCH(&(hashtable->buckets[hash_values[i] % hashtable->size]));
+	}
+	for (i = 0; i < nbr_keys; i++) {
+		bucket = &(hashtable->buckets[hash_values[i] % hashtable->size]);
+		if (bucket->nbr_elements != 0)
+			_YHT_PREFETCH(bucket->elements);
+	}
+}
+
+/**
+ * _yht_match
+ * Tell if an element matches a key. String keys are compared by length first,
+ * then by hash value, and their content is checked only when both are equal.
+ */
+static ybool_t _yht_match(yht_element_t *element, yht_hash_value_t hash_value, const char *key, size_t key_len) {
+	if (key == NULL)
+		return ((element->key == NULL && element->hash_value == hash_value) ? YTRUE : YFALSE);
+	if (element->key == NULL || element->key_len != key_len || element->hash_value != hash_value)
+		return (YFALSE);
+	return (memcmp(element->key, key, key_len) ? YFALSE : YTRUE);
+}
+
+/**
+ * _yht_new_element
+ * Allocate an element. When the hash table owns its keys, the key is copied
+ * right after the element if it is short enough, or in its own buffer.
+ */
+static yht_element_t *_yht_new_element(yhashtable_t *hashtable, char *key, size_t key_len) {
+	yht_element_t	*element;
+
+	if (key == NULL || hashtable->key_mode == YHT_KEYS_BORROWED) {
+		element = (yht_element_t*)_YHT_ALLOC_OBJ(hashtable, sizeof(yht_element_t));
+		element->key = key;
+	} else if (key_len < YHT_INLINE_KEY_SIZE) {
+		element = (yht_element_t*)_YHT_ALLOC_OBJ(hashtable, _YHT_ELEMENT_SIZE(hashtable, key, key_len));
+		element->key = (char*)(element + 1);
+		memcpy(element->key, key, key_len + 1);
+	} else {
+		element = (yht_element_t*)_YHT_ALLOC_OBJ(hashtable, sizeof(yht_element_t));
+		element->key = (char*)_YHT_ALLOC(hashtable, key_len + 1);
+		memcpy(element->key, key, key_len + 1);
+	}
+	element->key_len = key_len;
+	return (element);
+}
+
+/**
+ * _yht_free_element
+ * Free an element, and its key if it was copied outside of the element.
+ */
+static void _yht_free_element(yhashtable_t *hashtable, yht_element_t *element) {
+	if (element->key != NULL && hashtable->key_mode == YHT_KEYS_OWNED &&
+	    element->key_len >= YHT_INLINE_KEY_SIZE)
+		_YHT_FREE(hashtable, element->key);
+	_YHT_FREE_OBJ(hashtable, element, _YHT_ELEMENT_SIZE(hashtable, element->key, element->key_len));
+}
+
+/**
+ * _yht_update_element
+ * Give new data to an existing element.
+ */
+static void _yht_update_element(yhashtable_t *hashtable, yht_element_t *element, char *key, void *data) {
+	/* removing old data */
+	if (hashtable->destroy_func != NULL)
+		hashtable->destroy_func(element->hash_value, element->key, element->data, hashtable->destroy_data);
+	/* updating the element (an owned key is kept, as it is identical) */
+	if (hashtable->key_mode == YHT_KEYS_BORROWED)
+		element->key = key;
+	element->data = data;
+}
+
+/**
+ * _yht_unlink_item
+ * Remove an item from the list of a hash table's elements, and free it.
+ */
+static void _yht_unlink_item(yhashtable_t *hashtable, yht_list_t *item) {
+	if (hashtable->used == 1)
+		_YHT_FREE_OBJ(hashtable, hashtable->items, sizeof(yht_list_t));
+	else {
+		if (hashtable->items == item)
+			hashtable->items = item->next;
+		item->next->previous = item->previous;
+		item->previous->next = item->next;
+		_YHT_FREE_OBJ(hashtable, item, sizeof(yht_list_t));
+	}
+}
+
+/**
+ * _yht_small_find
+ * Search an element in a hash table which has no buckets yet, by walking its
+ * list of elements.
+ */
+static yht_list_t *_yht_small_find(yhashtable_t *hashtable, yht_hash_value_t hash_value, const char *key, size_t key_len) {
+	yht_list_t	*item;
+	size_t		offset;
+
+	for (offset = 0, item = hashtable->items;
+	     offset < hashtable->used;
+	     offset++, item = item->next) {
+		if (_yht_match(item->element, hash_value, key, key_len)) {
+			YHASH_STATS_LOOKUP(hashtable->stats, offset + 1, YTRUE);
+			return (item);
+		}
+	}
+	YHASH_STATS_LOOKUP(hashtable->stats, offset, YFALSE);
+	return (NULL);
+}
+
 /**
  * _yht_remove
  * Remove an element from a hash table, using a string or an integer key.
  */
-static ybool_t _yht_remove(yhashtable_t *hashtable, yht_hash_value_t hash_value, const char *key, ybool_t try_to_destroy) {
+static ybool_t _yht_remove(yhashtable_t *hashtable, yht_hash_value_t hash_value, const char *key, size_t key_len, ybool_t try_to_destroy) {
 	yht_hash_value_t	modulo_value;
 	yht_bucket_t		*bucket;
 	yht_element_t		*element;
@@ -217,43 +643,52 @@ static ybool_t _yht_remove(yhashtable_t *hashtable, yht_hash_value_t hash_value,
 	ybool_t			found = YFALSE;
 	float			load_factor;
 
-	/* compute the key's hash value */
-	if (key != NULL)
-		hash_value = yht_hash(key);
+	/* small hash table: the element is only in the list */
+	if (hashtable->buckets == NULL) {
+		if ((item = _yht_small_find(hashtable, hash_value, key, key_len)) == NULL)
+			return (YFALSE);
+		hashtable->version++;
+		element = item->element;
+		if (try_to_destroy && hashtable->destroy_func != NULL)
+			hashtable->destroy_func(element->hash_value, element->key, element->data, hashtable->destroy_data);
+		_yht_unlink_item(hashtable, item);
+		_yht_free_element(hashtable, element);
+		hashtable->used--;
+		return (YTRUE);
+	}
 	modulo_value = hash_value % hashtable->size;
 	/* retreiving the bucket */
 	bucket = &(hashtable->buckets[modulo_value]);
-	if (bucket->nbr_elements == 0)
+	if (bucket->nbr_elements == 0) {
+		YHASH_STATS_LOOKUP(hashtable->stats, 0, YFALSE);
 		return (YFALSE);
+	}
 	/* searching in the bucket */
 	for (offset = 0, element = bucket->elements;
 	     offset < bucket->nbr_elements;
 	     offset++, element = element->next) {
-		if (element->hash_value == hash_value &&
-		    ((key == NULL && element->key == NULL) ||
-		     (key != NULL && element->key != NULL && !strcmp(key, element->key)))) {
+		if (_yht_match(element, hash_value, key, key_len)) {
 			found = YTRUE;
+			hashtable->version++;
+			YHASH_STATS_LOOKUP(hashtable->stats, offset + 1, YTRUE);
 			if (try_to_destroy && hashtable->destroy_func != NULL)
 				hashtable->destroy_func(element->hash_value, element->key, element->data, hashtable->destroy_data);
-			item = element->item;
-			if (hashtable->used == 1)
-				YFREE(hashtable->items);
-			else {
-				item->next->previous = item->previous;
-				item->previous->next = item->next;
-				YFREE(item);
-			}
+			_yht_unlink_item(hashtable, element->item);
 			if (bucket->nbr_elements == 1)
-				YFREE(bucket->elements);
+				bucket->elements = NULL;
 			else {
+				if (bucket->elements == element)
+					bucket->elements = element->next;
 				element->next->previous = element->previous;
 				element->previous->next = element->next;
-				YFREE(element);
 			}
+			_yht_free_element(hashtable, element);
 			break;
 		}
 	}
-	if (found) {
+	if (!found)
+		YHASH_STATS_LOOKUP(hashtable->stats, offset, YFALSE);
+	else {
 		bucket->nbr_elements--;
 		hashtable->used--;
 		/* resize the map if its load factor will fall under the limit */
@@ -268,30 +703,36 @@ static ybool_t _yht_remove(yhashtable_t *hashtable, yht_hash_value_t hash_value,
  * _yht_search
  * Search an element in a hash table, using a string or an integer key.
  */
-static void *_yht_search(yhashtable_t *hashtable, yht_hash_value_t hash_value, const char *key) {
+static void *_yht_search(yhashtable_t *hashtable, yht_hash_value_t hash_value, const char *key, size_t key_len) {
 	yht_hash_value_t	modulo_value;
 	yht_bucket_t		*bucket;
 	yht_element_t		*element;
+	yht_list_t		*item;
 	size_t			offset;
 
-	/* compute the key's hash value if necessary */
-	if (hash_value == 0 && key != NULL)
-		hash_value = yht_hash(key);
+	/* the Bloom filter tells if the key is surely missing */
+	if (hashtable->bloom != NULL && !_yht_bloom_test(hashtable, hash_value)) {
+		YHASH_STATS_LOOKUP(hashtable->stats, 0, YFALSE);
+		return (NULL);
+	}
+	/* small hash table: walk the list */
+	if (hashtable->buckets == NULL) {
+		item = _yht_small_find(hashtable, hash_value, key, key_len);
+		return (item ? item->element->data : NULL);
+	}
 	modulo_value = hash_value % hashtable->size;
 	/* retreiving the bucket */
 	bucket = &(hashtable->buckets[modulo_value]);
-	if (bucket->nbr_elements == 0)
-		return (NULL);
 	/* searching in the bucket's elements */
-	element = bucket->elements;
 	for (offset = 0, element = bucket->elements;
 	     offset < bucket->nbr_elements;
 	     offset++, element = element->next) {
-		if (element->hash_value == hash_value &&
-		    ((key == NULL && element->key == NULL) ||
-		     (key != NULL && element->key != NULL && !strcmp(key, element->key))))
+		if (_yht_match(element, hash_value, key, key_len)) {
+			YHASH_STATS_LOOKUP(hashtable->stats, offset + 1, YTRUE);
 			return (element->data);
+		}
 	}
+	YHASH_STATS_LOOKUP(hashtable->stats, offset, YFALSE);
 	return (NULL);
 }
 
@@ -299,67 +740,66 @@ static void *_yht_search(yhashtable_t *hashtable, yht_hash_value_t hash_value, c
  * _yht_add
  * Add an element to a hash table, using a string or an integer key.
  */
-static void _yht_add(yhashtable_t *hashtable, yht_hash_value_t hash_value, char *key, void *data) {
+static void _yht_add(yhashtable_t *hashtable, yht_hash_value_t hash_value, char *key, size_t key_len, void *data) {
 	float			load_factor;
-	yht_hash_value_t	modulo_value;
-	yht_bucket_t		*bucket;
+	yht_bucket_t		*bucket = NULL;
 	yht_element_t		*element;
 	yht_list_t		*item;
+	size_t			offset;
 
-	/* resize the table if its load factor would excess the limit */
-	load_factor = (float)(hashtable->used + 1) / hashtable->size;
-	if (load_factor > YHT_MAX_LOAD_FACTOR)
-		yht_resize(hashtable, (hashtable->size * 2));
-	/* compute the key's hash value */
-	if (key != NULL)
-		hash_value = yht_hash(key);
-	modulo_value = hash_value % hashtable->size;
-	/* checking the bucket */
-	bucket = &(hashtable->buckets[modulo_value]);
-	if (bucket->nbr_elements == 0) {
-		/* create the first element */
-		element = (yht_element_t*)YMALLOC(sizeof(yht_element_t));
-		item = (yht_list_t*)YMALLOC(sizeof(yht_list_t));
-		element->previous = element->next = element;
-		/* add the element to the bucket */
-		bucket->elements = element;
+	hashtable->version++;
+	if (hashtable->buckets == NULL) {
+		/* small hash table: checking if the element exists in the list */
+		if ((item = _yht_small_find(hashtable, hash_value, key, key_len)) != NULL) {
+			_yht_update_element(hashtable, item->element, key, data);
+			return;
+		}
+		/* switch to buckets when the list is full */
+		if (hashtable->used >= YHT_SMALL_SIZE)
+			yht_resize(hashtable, YHT_SIZE_MINI);
 	} else {
-		/* there is already some elements in the bucket, checking if the element exists and must be updated */
-		size_t	offset;
-
+		/* resize the table if its load factor would excess the limit */
+		load_factor = (float)(hashtable->used + 1) / hashtable->size;
+		if (load_factor > YHT_MAX_LOAD_FACTOR)
+			yht_resize(hashtable, (hashtable->size * 2));
+	}
+	if (hashtable->buckets != NULL) {
+		bucket = &(hashtable->buckets[hash_value % hashtable->size]);
+		/* checking if the element exists in the bucket and must be updated */
 		for (offset = 0, element = bucket->elements;
 		     offset < bucket->nbr_elements;
 		     offset++, element = element->next) {
-			if (element->hash_value == hash_value &&
-			    ((key == NULL && element->key == NULL) ||
-			     (key != NULL && element->key != NULL && !strcmp(key, element->key)))) {
-				/* an existing element was found */
-				/* removing old data */
-				if (hashtable->destroy_func != NULL)
-					hashtable->destroy_func(element->hash_value, element->key, element->data, hashtable->destroy_data);
-				/* updating the element */
-				element->key = key;
-				element->data = data;
+			if (_yht_match(element, hash_value, key, key_len)) {
+				YHASH_STATS_LOOKUP(hashtable->stats, offset + 1, YTRUE);
+				_yht_update_element(hashtable, element, key, data);
 				return;
 			}
 		}
-		/* no element was already existing with this key */
-		element = (yht_element_t*)YMALLOC(sizeof(yht_element_t));
-		item = (yht_list_t*)YMALLOC(sizeof(yht_list_t));
-		/* add the element to the bucket */
-		element->next = bucket->elements;
-		element->previous = bucket->elements->previous;
-		bucket->elements->previous->next = element;
-		bucket->elements->previous = element;
+		YHASH_STATS_LOOKUP(hashtable->stats, offset, YFALSE);
 	}
+	/* no element was already existing with this key */
+	element = _yht_new_element(hashtable, key, key_len);
+	item = (yht_list_t*)_YHT_ALLOC_OBJ(hashtable, sizeof(yht_list_t));
 	/* filling the element and the item */
+	if (hashtable->bloom != NULL)
+		_yht_bloom_set(hashtable, hash_value);
 	element->hash_value = hash_value;
-	element->key = key;
 	element->data = data;
 	element->item = item;
 	item->element = element;
-	/* update the bucket */
-	bucket->nbr_elements++;
+	/* add the element to the bucket */
+	if (bucket != NULL) {
+		if (bucket->nbr_elements == 0) {
+			element->previous = element->next = element;
+			bucket->elements = element;
+		} else {
+			element->next = bucket->elements;
+			element->previous = bucket->elements->previous;
+			bucket->elements->previous->next = element;
+			bucket->elements->previous = element;
+		}
+		bucket->nbr_elements++;
+	}
 	/* update the hash table */
 	hashtable->used++;
 	/* add the item to the list */
@@ -373,4 +813,3 @@ static void _yht_add(yhashtable_t *hashtable, yht_hash_value_t hash_value, char
 		hashtable->items->previous = item;
 	}
 }
-
@@ -15,6 +15,8 @@ extern "C" {
 #endif /* __cplusplus || c_plusplus */
 
 #include "ydefs.h"
+#include "yhashstats.h"
+#include "yarena.h"
 
 #ifdef USE_BOEHM_GC
 # include "gc.h"
@@ -26,6 +28,21 @@ extern "C" {
 /** @define YHT_MIN_LOAD_FACTOR Minimum load factor of a hash table before reducing it. */
 #define YHT_MIN_LOAD_FACTOR	0.25
 
+/** @define YHT_BATCH_SIZE Number of keys hashed and prefetched together by batched functions. */
+#define YHT_BATCH_SIZE		16
+
+/** @define YHT_INLINE_KEY_SIZE Owned keys shorter than this are stored inside their element. */
+#define YHT_INLINE_KEY_SIZE	48
+
+/** @define YHT_SMALL_SIZE Hash tables created in an arena keep up to this number of elements in a plain list, without buckets. */
+#define YHT_SMALL_SIZE		8
+
+/** @define YHT_BLOOM_BITS Minimum size of the Bloom filter of a hash table, in bits (a power of 2). */
+#define YHT_BLOOM_BITS		512
+
+/** @define YHT_BLOOM_RATIO Bits of the Bloom filter per bucket of a hash table. */
+#define YHT_BLOOM_RATIO		8
+
 /**
  * @typedef	yht_size_t
  *		Enum used to define the size of a hash table.
@@ -45,6 +62,19 @@ typedef enum yht_size_e {
 	YHT_SIZE_HUGE		= 1048576
 } yht_size_t;
 
+/**
+ * @typedef	yht_key_mode_t
+ *		Enum used to define how a hash table manages its string keys.
+ * @constant	YHT_KEYS_BORROWED	Keys are pointers given by the caller, which must keep
+ *					them alive as long as the element exists (default).
+ * @constant	YHT_KEYS_OWNED		Keys are copied by the hash table. Short keys are stored
+ *					inline, right after their element.
+ */
+typedef enum yht_key_mode_e {
+	YHT_KEYS_BORROWED = 0,
+	YHT_KEYS_OWNED
+} yht_key_mode_t;
+
 /**
  * typedef	yht_hash_value_t
  * 		An hash value.
@@ -56,6 +86,7 @@ typedef long int yht_hash_value_t;
  *		Structure used to store a hash table's element.
  * @field	hash_value	Element's hash value.
  * @field	key		Element's key.
+ * @field	key_len		Length of the element's key (0 for integer keys).
  * @field	data		Element's data.
  * @field	previous	Pointer to the previous element with the same hash value.
  * @field	next		Pointer to the next element with the same hash value.
@@ -63,6 +94,7 @@ typedef long int yht_hash_value_t;
 typedef struct yht_element_s {
 	yht_hash_value_t	hash_value;
 	char			*key;
+	size_t			key_len;
 	void			*data;
 	struct yht_element_s	*previous;
 	struct yht_element_s	*next;
@@ -110,6 +142,12 @@ typedef void (*yht_function_t)(yht_hash_value_t hash_value, char *key, void *dat
  * @field	buckets		Array of buckets.
  * @field	items		List of pointers to the stored elements.
  * @field	next_offset	Next free hash value.
+ * @field	key_mode	How string keys are stored.
+ * @field	stats		Activity counters, NULL if they are disabled.
+ * @field	version		Incremented each time an element is added, updated or removed.
+ * @field	bloom		Bloom filter of the stored hash values, NULL if it is disabled.
+ * @field	bloom_bits	Size of the Bloom filter, in bits.
+ * @field	arena		Arena the hash table's memory comes from, NULL for the heap.
  * @field	destroy_func	Pointer to the function called when an element is removed.
  * @field	destroy_data	Pointer to some user data given to the destroy function.
  */
@@ -119,6 +157,12 @@ typedef struct yhashtable_s {
 	yht_bucket_t	*buckets;
 	yht_list_t	*items;
 	size_t		next_offset;
+	yht_key_mode_t	key_mode;
+	yhash_stats_t	*stats;
+	size_t		version;
+	u64_t		*bloom;
+	size_t		bloom_bits;
+	yarena_t	*arena;
 	yht_function_t	destroy_func;
 	void		*destroy_data;
 } yhashtable_t;
@@ -134,6 +178,22 @@ typedef struct yhashtable_s {
  */
 yhashtable_t *yht_new(yht_size_t size, yht_function_t destroy_func, void *destroy_data);
 
+/**
+ * @function	yht_new_in_arena
+ *		Creates a new hash table whose memory (the table itself, its
+ *		buckets, elements and owned keys) is taken from an arena. It
+ *		starts without buckets: up to YHT_SMALL_SIZE elements are kept
+ *		in a list and searched linearly. The hash table can be destroyed
+ *		with yht_delete(), which calls the destroy function but frees
+ *		nothing, or by releasing the arena up to the hash table's
+ *		address, which doesn't call the destroy function.
+ * @param	arena		Pointer to the arena.
+ * @param	destroy_func	Pointer to the function called when an element is removed.
+ * @param	destroy_data	Pointer to some user data given to the destroy function.
+ * @return	The created hash table.
+ */
+yhashtable_t *yht_new_in_arena(yarena_t *arena, yht_function_t destroy_func, void *destroy_data);
+
 /**
  * @function	yht_delete
  *		Destroy a hash table.
@@ -141,6 +201,18 @@ yhashtable_t *yht_new(yht_size_t size, yht_function_t destroy_func, void *destro
  */
 void yht_delete(yhashtable_t *hashtable);
 
+/**
+ * @function	yht_set_key_mode
+ *		Define how a hash table stores its string keys. With owned keys,
+ *		the given keys are copied and the caller may free them as soon as
+ *		the add function returns; the keys given to the destroy function
+ *		are then the table's copies and must not be freed.
+ * @param	hashtable	Pointer to the hash table. It must be empty.
+ * @param	mode		The key mode.
+ * @return	YTRUE if the mode was set, YFALSE if the hash table is not empty.
+ */
+ybool_t yht_set_key_mode(yhashtable_t *hashtable, yht_key_mode_t mode);
+
 /**
  * @function	yht_add_from_string
  *		Add an element to a hash table, using a string key.
@@ -195,6 +267,33 @@ void *yht_search_from_int(yhashtable_t *hashtable, size_t key);
  */
 void *yht_search_from_hashed_string(yhashtable_t *hashtable, size_t hash_value, const char *key);
 
+/**
+ * @function	yht_search_many
+ *		Search a batch of elements in a hash table, from their string keys.
+ *		Keys are hashed and their buckets and elements are prefetched by
+ *		groups of YHT_BATCH_SIZE, so several lookups are in flight at once
+ *		instead of waiting for each cache miss in turn.
+ * @param	hashtable	Pointer to the hash table.
+ * @param	keys		Array of keys.
+ * @param	nbr_keys	Number of keys.
+ * @param	results		Array of at least nbr_keys pointers, filled with the
+ *				elements' data (NULL for the keys that were not found).
+ * @return	The number of keys found.
+ */
+size_t yht_search_many(yhashtable_t *hashtable, const char **keys, size_t nbr_keys, void **results);
+
+/**
+ * @function	yht_add_many
+ *		Add a batch of elements to a hash table, using string keys. The
+ *		hash table is resized once for the whole batch, then keys are
+ *		hashed and inserted with the same prefetching as yht_search_many().
+ * @param	hashtable	Pointer to the hash table.
+ * @param	keys		Array of keys.
+ * @param	data		Array of the elements' data.
+ * @param	nbr_keys	Number of elements.
+ */
+void yht_add_many(yhashtable_t *hashtable, char **keys, void **data, size_t nbr_keys);
+
 /**
  * @function	yht_pop_data
  *		Remove the last element of a hash table and returns it.
@@ -238,6 +337,36 @@ void yht_resize(yhashtable_t *hashtable, size_t size);
  */
 void yht_foreach(yhashtable_t *hashtable, yht_function_t func, void *user_data);
 
+/**
+ * @function	yht_stats_enable
+ *		Enable or disable the activity counters of a hash table. Enabling
+ *		them again resets them.
+ * @param	hashtable	Pointer to the hash table.
+ * @param	enable		YTRUE to enable the counters, YFALSE to disable them.
+ */
+void yht_stats_enable(yhashtable_t *hashtable, ybool_t enable);
+
+/**
+ * @function	yht_stats_report
+ *		Fill a report about a hash table. Its buckets are scanned, so the
+ *		cost is linear in the size of the hash table.
+ * @param	hashtable	Pointer to the hash table.
+ * @param	report		Pointer to the report.
+ */
+void yht_stats_report(yhashtable_t *hashtable, yhash_report_t *report);
+
+/**
+ * @function	yht_bloom_enable
+ *		Enable or disable the Bloom filter of a hash table. When it is
+ *		enabled, most searches of missing keys return without reading
+ *		any bucket. The filter is sized after the number of buckets, and
+ *		rebuilt when the hash table is resized, which clears the bits of
+ *		removed elements.
+ * @param	hashtable	Pointer to the hash table.
+ * @param	enable		YTRUE to enable the filter, YFALSE to disable it.
+ */
+void yht_bloom_enable(yhashtable_t *hashtable, ybool_t enable);
+
 /*!
  * @function	yht_hash
  *		Compute the hash value of a key, using the SDBM algorithm.
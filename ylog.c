@@ -1,3 +1,5 @@
+#define YMEM_TAG	YMEM_TAG_LOG
+
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -2,17 +2,49 @@
 #include "ylog.h"
 #include "ydefs.h"
 
+/* with YMEM_PROFILE, malloc0() and free0() are macros which count the allocations */
+#ifdef malloc0
+# undef malloc0
+# undef free0
+#endif /* malloc0 */
+
 /*
 ** malloc0()
-** Like malloc, but fill the allocated space with zeros.
+** Like malloc, but fill the allocated space with zeros. calloc() is
+** used, so big blocks are fresh pages mapped by the system, which are
+** already zeroed and are not filled again.
 */
 void *malloc0(size_t size)
 {
   void *p = NULL;
 
-  if (size > 0 && (p = malloc(size)))
-    p = memset(p, 0, size);
+  if (size > 0)
+    p = calloc(1, size);
   if (!p)
     YLOG_ADD(YLOG_ERR, "Malloc error - size=%d", size);
   return (p);
 }
+
+/*
+** ygrow()
+** Replace an array by a bigger one, keeping its used elements.
+*/
+void *ygrow(void *array, size_t *size, size_t elem_size, size_t used, size_t min_size)
+{
+  void *new_array;
+  size_t new_size;
+
+  new_size = *size ? (*size * 2) : min_size;
+  if (new_size <= used)
+    new_size = used + min_size;
+  if (!(new_array = YMALLOC_RAW(new_size * elem_size)))
+    {
+      YLOG_ADD(YLOG_ERR, "Unable to allocate memory");
+      return (NULL);
+    }
+  if (used && array)
+    memcpy(new_array, array, used * elem_size);
+  YFREE(array);
+  *size = new_size;
+  return (new_array);
+}
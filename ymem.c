@@ -0,0 +1,331 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "ymem.h"
+
+#ifdef __GNUC__
+/** @define _YMEM_ADD Atomically add a number to a counter, and return the new value. */
+# define _YMEM_ADD(var, n)		__sync_add_and_fetch(&(var), (n))
+/** @define _YMEM_SUB Atomically subtract a number from a counter. */
+# define _YMEM_SUB(var, n)		__sync_sub_and_fetch(&(var), (n))
+/** @define _YMEM_CAS Atomically replace the value of a counter if it didn't change. */
+# define _YMEM_CAS(var, old, new)	__sync_bool_compare_and_swap(&(var), (old), (new))
+#else
+# define _YMEM_ADD(var, n)		((var) += (n))
+# define _YMEM_SUB(var, n)		((var) -= (n))
+# define _YMEM_CAS(var, old, new)	((var) = (new), YTRUE)
+#endif /* __GNUC__ */
+
+/** @define _YMEM_MIX Spread an address over 64 bits. */
+#define _YMEM_MIX(ptr)		((u64_t)((size_t)(ptr) >> 4) * (((u64_t)0x9E3779B9 << 32) | 0x7F4A7C15))
+
+/** @define _YMEM_SHARD Shard of a mixed address, given by its upper half; the slot is given by the lower one. */
+#define _YMEM_SHARD(hash_value)	(&(_ymem_shards[(size_t)((hash_value) >> 32) % YMEM_NBR_SHARDS]))
+
+/** @define _YMEM_SHARD_MIN_SIZE Initial number of slots of a shard. */
+#define _YMEM_SHARD_MIN_SIZE	1024
+
+/**
+ * @typedef	_ymem_block_t
+ *		Live block, in the table of live blocks.
+ * @field	ptr	Address of the block; NULL for an empty slot.
+ * @field	size	Size of the block.
+ * @field	tag	Tag of the block.
+ */
+typedef struct _ymem_block_s {
+	void	*ptr;
+	size_t	size;
+	size_t	tag;
+} _ymem_block_t;
+
+/**
+ * @typedef	_ymem_shard_t
+ *		Part of the table of live blocks (open addressing, linear probing).
+ * @field	mutex	Lock of the shard.
+ * @field	size	Number of slots, a power of two.
+ * @field	used	Number of live blocks.
+ * @field	blocks	Slots.
+ */
+typedef struct _ymem_shard_s {
+	pthread_mutex_t	mutex;
+	size_t		size;
+	size_t		used;
+	_ymem_block_t	*blocks;
+} _ymem_shard_t;
+
+/** @var _ymem_shards Table of live blocks. */
+static _ymem_shard_t _ymem_shards[YMEM_NBR_SHARDS];
+/** @var _ymem_once Initialization of the table of live blocks. */
+static pthread_once_t _ymem_once = PTHREAD_ONCE_INIT;
+/** @var _ymem_stats Counters of each tag. */
+static ymem_stats_t _ymem_stats[YMEM_NBR_TAGS];
+/** @var _ymem_tag_names Names of the tags. */
+static const char *_ymem_tag_names[YMEM_NBR_TAGS] = {
+	"other", "str", "vect", "hash", "dom", "sax", "log", "cgi", "net", "slab", "arena"
+};
+/** @var _ymem_dump_mutex Lock of the periodic dump parameters. */
+static pthread_mutex_t _ymem_dump_mutex = PTHREAD_MUTEX_INITIALIZER;
+/** @var _ymem_dump_stream Output of the periodic dump. */
+static FILE *_ymem_dump_stream = NULL;
+/** @var _ymem_dump_period Period of the dump, in seconds; 0 if stopped. */
+static unsigned int _ymem_dump_period = 0;
+/** @var _ymem_dump_running YTRUE while the dump thread runs. */
+static ybool_t _ymem_dump_running = YFALSE;
+
+/* *** definition of private functions *** */
+static void _ymem_init(void);
+static void _ymem_insert(_ymem_shard_t *shard, u64_t hash_value, void *ptr, size_t size, size_t tag);
+static ybool_t _ymem_resize(_ymem_shard_t *shard);
+static size_t _ymem_size_class(size_t size);
+static void *_ymem_dump_thread(void *param);
+
+/*
+ * ymem_alloc()
+ * Allocate a zeroed memory block, accounted to a tag.
+ */
+void *ymem_alloc(ymem_tag_t tag, size_t size) {
+	return (ymem_track(tag, calloc(1, size), size));
+}
+
+/*
+ * ymem_alloc_raw()
+ * Allocate a memory block which is not zeroed, accounted to a tag.
+ */
+void *ymem_alloc_raw(ymem_tag_t tag, size_t size) {
+	return (ymem_track(tag, malloc(size), size));
+}
+
+/*
+ * ymem_free()
+ * Free a memory block, and account it to the tag it was allocated with.
+ */
+void ymem_free(void *ptr) {
+	ymem_untrack(ptr);
+	free(ptr);
+}
+
+/*
+ * ymem_track()
+ * Account a block given by another allocator.
+ */
+void *ymem_track(ymem_tag_t tag, void *ptr, size_t size) {
+	ymem_stats_t	*stats = &(_ymem_stats[tag]);
+	_ymem_shard_t	*shard;
+	u64_t		hash_value;
+	size_t		live, peak;
+
+	if (ptr == NULL)
+		return (NULL);
+	pthread_once(&_ymem_once, _ymem_init);
+	hash_value = _YMEM_MIX(ptr);
+	shard = _YMEM_SHARD(hash_value);
+	pthread_mutex_lock(&(shard->mutex));
+	/* if the table can't grow, it is filled up to its last free slot
+	   (lookups stop at a free slot); then blocks are not counted */
+	if ((shard->used + 1) * 2 > shard->size && !_ymem_resize(shard) &&
+	    shard->used + 1 >= shard->size) {
+		pthread_mutex_unlock(&(shard->mutex));
+		_YMEM_ADD(stats->nbr_dropped, 1);
+		return (ptr);
+	}
+	_ymem_insert(shard, hash_value, ptr, size, (size_t)tag);
+	shard->used++;
+	pthread_mutex_unlock(&(shard->mutex));
+	_YMEM_ADD(stats->nbr_allocs, 1);
+	_YMEM_ADD(stats->total_bytes, size);
+	_YMEM_ADD(stats->histogram[_ymem_size_class(size)], 1);
+	live = _YMEM_ADD(stats->live_bytes, size);
+	while ((peak = stats->peak_bytes) < live && !_YMEM_CAS(stats->peak_bytes, peak, live))
+		;
+	return (ptr);
+}
+
+/*
+ * ymem_untrack()
+ * Account the liberation of a block, to the tag it was allocated with.
+ */
+void ymem_untrack(void *ptr) {
+	_ymem_shard_t	*shard;
+	_ymem_block_t	block;
+	u64_t		hash_value;
+	size_t		i, j, ideal, mask;
+
+	if (ptr == NULL)
+		return;
+	pthread_once(&_ymem_once, _ymem_init);
+	hash_value = _YMEM_MIX(ptr);
+	shard = _YMEM_SHARD(hash_value);
+	block.ptr = NULL;
+	pthread_mutex_lock(&(shard->mutex));
+	if (shard->size > 0) {
+		mask = shard->size - 1;
+		for (i = (size_t)hash_value & mask; shard->blocks[i].ptr != NULL && shard->blocks[i].ptr != ptr; i = (i + 1) & mask)
+			;
+		if (shard->blocks[i].ptr == ptr) {
+			block = shard->blocks[i];
+			/* shift back the following blocks of the cluster */
+			for (j = (i + 1) & mask; shard->blocks[j].ptr != NULL; j = (j + 1) & mask) {
+				ideal = (size_t)_YMEM_MIX(shard->blocks[j].ptr) & mask;
+				if (((j - ideal) & mask) >= ((j - i) & mask)) {
+					shard->blocks[i] = shard->blocks[j];
+					i = j;
+				}
+			}
+			shard->blocks[i].ptr = NULL;
+			shard->used--;
+		}
+	}
+	pthread_mutex_unlock(&(shard->mutex));
+	if (block.ptr != NULL) {
+		_YMEM_ADD(_ymem_stats[block.tag].nbr_frees, 1);
+		_YMEM_SUB(_ymem_stats[block.tag].live_bytes, block.size);
+	}
+}
+
+/*
+ * ymem_get_stats()
+ * Copy the counters of a tag.
+ */
+void ymem_get_stats(ymem_tag_t tag, ymem_stats_t *stats) {
+	memcpy(stats, &(_ymem_stats[tag]), sizeof(ymem_stats_t));
+}
+
+/*
+ * ymem_tag_name()
+ * Return the name of a tag.
+ */
+const char *ymem_tag_name(ymem_tag_t tag) {
+	return ((tag < YMEM_NBR_TAGS) ? _ymem_tag_names[tag] : "unknown");
+}
+
+/*
+ * ymem_dump()
+ * Write the counters of all tags.
+ */
+void ymem_dump(FILE *stream) {
+	ymem_stats_t	stats;
+	size_t		tag, i;
+
+	fprintf(stream, "%-6s %12s %12s %14s %10s %10s %8s  histogram\n",
+		"tag", "live", "peak", "total", "allocs", "frees", "dropped");
+	for (tag = 0; tag < YMEM_NBR_TAGS; tag++) {
+		ymem_get_stats((ymem_tag_t)tag, &stats);
+		if (stats.nbr_allocs == 0 && stats.nbr_dropped == 0)
+			continue;
+		fprintf(stream, "%-6s %12lu %12lu %14lu %10lu %10lu %8lu ", _ymem_tag_names[tag],
+			(unsigned long)stats.live_bytes, (unsigned long)stats.peak_bytes,
+			(unsigned long)stats.total_bytes, (unsigned long)stats.nbr_allocs,
+			(unsigned long)stats.nbr_frees, (unsigned long)stats.nbr_dropped);
+		for (i = 0; i < YMEM_HISTOGRAM_SIZE; i++)
+			fprintf(stream, " %lu", (unsigned long)stats.histogram[i]);
+		fprintf(stream, "\n");
+	}
+	fflush(stream);
+}
+
+/*
+ * ymem_dump_every()
+ * Write the counters periodically, from a background thread.
+ */
+yerr_t ymem_dump_every(FILE *stream, unsigned int seconds) {
+	pthread_t	tid;
+	yerr_t		res = YENOERR;
+
+	pthread_mutex_lock(&_ymem_dump_mutex);
+	_ymem_dump_stream = stream;
+	_ymem_dump_period = seconds;
+	if (seconds > 0 && !_ymem_dump_running) {
+		if (pthread_create(&tid, NULL, _ymem_dump_thread, NULL))
+			res = YEAGAIN;
+		else {
+			pthread_detach(tid);
+			_ymem_dump_running = YTRUE;
+		}
+	}
+	pthread_mutex_unlock(&_ymem_dump_mutex);
+	return (res);
+}
+
+/* *************** PRIVATE FUNCTIONS ************** */
+/*
+ * _ymem_init()
+ * Initialize the locks of the table of live blocks, once.
+ */
+static void _ymem_init(void) {
+	size_t	i;
+
+	for (i = 0; i < YMEM_NBR_SHARDS; i++)
+		pthread_mutex_init(&(_ymem_shards[i].mutex), NULL);
+}
+
+/*
+ * _ymem_insert()
+ * Put a block in the first free slot after its ideal one.
+ */
+static void _ymem_insert(_ymem_shard_t *shard, u64_t hash_value, void *ptr, size_t size, size_t tag) {
+	size_t	i, mask = shard->size - 1;
+
+	for (i = (size_t)hash_value & mask; shard->blocks[i].ptr != NULL; i = (i + 1) & mask)
+		;
+	shard->blocks[i].ptr = ptr;
+	shard->blocks[i].size = size;
+	shard->blocks[i].tag = tag;
+}
+
+/*
+ * _ymem_resize()
+ * Double the number of slots of a shard. Its memory is not accounted.
+ * Return YFALSE if the allocation failed; then the shard is unchanged.
+ */
+static ybool_t _ymem_resize(_ymem_shard_t *shard) {
+	_ymem_block_t	*old_blocks = shard->blocks, *blocks;
+	size_t		old_size = shard->size, size, i;
+
+	size = old_size ? (old_size * 2) : _YMEM_SHARD_MIN_SIZE;
+	if ((blocks = (_ymem_block_t*)calloc(size, sizeof(_ymem_block_t))) == NULL)
+		return (YFALSE);
+	shard->blocks = blocks;
+	shard->size = size;
+	for (i = 0; i < old_size; i++)
+		if (old_blocks[i].ptr != NULL)
+			_ymem_insert(shard, _YMEM_MIX(old_blocks[i].ptr), old_blocks[i].ptr, old_blocks[i].size, old_blocks[i].tag);
+	free(old_blocks);
+	return (YTRUE);
+}
+
+/*
+ * _ymem_size_class()
+ * Return the histogram class of a size.
+ */
+static size_t _ymem_size_class(size_t size) {
+	size_t	class, limit;
+
+	for (class = 0, limit = 16; class < YMEM_HISTOGRAM_SIZE - 1 && size > limit; class++)
+		limit <<= 1;
+	return (class);
+}
+
+/*
+ * _ymem_dump_thread()
+ * Background thread of ymem_dump_every(). It ends when the period is set to 0.
+ */
+static void *_ymem_dump_thread(void *param) {
+	unsigned int	period;
+
+	(void)param;
+	for (; ; ) {
+		pthread_mutex_lock(&_ymem_dump_mutex);
+		if ((period = _ymem_dump_period) == 0) {
+			_ymem_dump_running = YFALSE;
+			pthread_mutex_unlock(&_ymem_dump_mutex);
+			return (NULL);
+		}
+		pthread_mutex_unlock(&_ymem_dump_mutex);
+		sleep(period);
+		pthread_mutex_lock(&_ymem_dump_mutex);
+		if (_ymem_dump_period > 0 && _ymem_dump_stream != NULL)
+			ymem_dump(_ymem_dump_stream);
+		pthread_mutex_unlock(&_ymem_dump_mutex);
+	}
+}
@@ -0,0 +1,188 @@
+/* Process this file with the HeaderBrowser tool (http://www.headerbrowser.org)
+   to create documentation. */
+/*!
+ * @header	ymem.h
+ * @abstract	Memory accounting by subsystem.
+ * @discussion	When the library is compiled with YMEM_PROFILE defined, the
+ *		YMALLOC(), YMALLOC_RAW(), YCALLOC(), YFREE(), malloc0() and
+ *		free0() macros go through this module, which tags each
+ *		allocation with the subsystem it comes from (the YMEM_TAG of
+ *		the source file) and keeps, for each tag, the live and peak
+ *		number of bytes, the number of allocations and liberations, and
+ *		a histogram of the allocated sizes. Objects taken from the slab
+ *		allocator are counted by the tag of their users too.
+ *		<p />
+ *		The size and tag of live blocks are kept in a table indexed by
+ *		address, split in YMEM_NBR_SHARDS independently locked parts, so
+ *		that a block is accounted to its tag whatever the function which
+ *		frees it (blocks are often given by one subsystem and freed by
+ *		another, with YFREE() or free0()). Freeing a block which wasn't
+ *		allocated through this module (a string given by strdup(), for
+ *		example) is not counted. Counters are updated with atomic
+ *		operations. The cost is low enough to be left on in staging.
+ *		<p />
+ *		A source file chooses its tag by defining YMEM_TAG before
+ *		including any header; files which don't are counted as
+ *		YMEM_TAG_OTHER. Without YMEM_PROFILE, the functions of this
+ *		module are available but all counters stay at zero.
+ *		Profiling can't be used with USE_BOEHM_GC.
+ * @version	1.0 Oct 19 2026
+ * @author	Amaury Bouchard <amaury@amaury.net>
+ */
+#ifndef __YMEM_H__
+#define __YMEM_H__
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif /* __cplusplus || c_plusplus */
+
+#include <stdio.h>
+#include "ydefs.h"
+#include "yerror.h"
+
+/** @define YMEM_NBR_SHARDS Number of independently locked parts of the table of live blocks. */
+#define YMEM_NBR_SHARDS		64
+
+/** @define YMEM_HISTOGRAM_SIZE Number of size classes of the histograms (powers of two, from 16 bytes). */
+#define YMEM_HISTOGRAM_SIZE	16
+
+/**
+ * @typedef	ymem_tag_t
+ *		Subsystems memory is accounted to.
+ * @constant	YMEM_TAG_OTHER	Files without tag.
+ * @constant	YMEM_TAG_STR	ystrings.
+ * @constant	YMEM_TAG_VECT	yvectors.
+ * @constant	YMEM_TAG_HASH	Hash tables, hash maps, caches and trees.
+ * @constant	YMEM_TAG_DOM	DOM documents and XPath.
+ * @constant	YMEM_TAG_SAX	SAX parser.
+ * @constant	YMEM_TAG_LOG	Logs.
+ * @constant	YMEM_TAG_CGI	CGI.
+ * @constant	YMEM_TAG_NET	Network servers.
+ * @constant	YMEM_TAG_SLAB	Slabs of the slab allocator.
+ * @constant	YMEM_TAG_ARENA	Chunks of arenas.
+ * @constant	YMEM_NBR_TAGS	Number of tags.
+ */
+typedef enum ymem_tag_e {
+	YMEM_TAG_OTHER = 0,
+	YMEM_TAG_STR,
+	YMEM_TAG_VECT,
+	YMEM_TAG_HASH,
+	YMEM_TAG_DOM,
+	YMEM_TAG_SAX,
+	YMEM_TAG_LOG,
+	YMEM_TAG_CGI,
+	YMEM_TAG_NET,
+	YMEM_TAG_SLAB,
+	YMEM_TAG_ARENA,
+	YMEM_NBR_TAGS
+} ymem_tag_t;
+
+/**
+ * @typedef	ymem_stats_t
+ *		Memory counters of a tag.
+ * @field	live_bytes	Number of bytes currently allocated.
+ * @field	peak_bytes	Highest value of live_bytes.
+ * @field	total_bytes	Number of bytes allocated since the start.
+ * @field	nbr_allocs	Number of allocations.
+ * @field	nbr_frees	Number of liberations.
+ * @field	nbr_dropped	Number of allocations which were not counted,
+ *				because the table of live blocks couldn't grow.
+ * @field	histogram	Number of allocations by size: the first class
+ *				counts blocks up to 16 bytes, each next class
+ *				doubles the limit, the last one counts the rest.
+ */
+typedef struct ymem_stats_s {
+	size_t	live_bytes;
+	size_t	peak_bytes;
+	size_t	total_bytes;
+	size_t	nbr_allocs;
+	size_t	nbr_frees;
+	size_t	nbr_dropped;
+	size_t	histogram[YMEM_HISTOGRAM_SIZE];
+} ymem_stats_t;
+
+/* ****************** FUNCTIONS **************** */
+/**
+ * @function	ymem_alloc
+ *		Allocate a zeroed memory block, accounted to a tag. Used by
+ *		YMALLOC() and YCALLOC() when YMEM_PROFILE is defined.
+ * @param	tag	The tag.
+ * @param	size	Size of the block.
+ * @return	A pointer to the block, or NULL.
+ */
+void *ymem_alloc(ymem_tag_t tag, size_t size);
+
+/**
+ * @function	ymem_alloc_raw
+ *		Allocate a memory block which is not zeroed, accounted to a
+ *		tag. Used by YMALLOC_RAW() when YMEM_PROFILE is defined.
+ * @param	tag	The tag.
+ * @param	size	Size of the block.
+ * @return	A pointer to the block, or NULL.
+ */
+void *ymem_alloc_raw(ymem_tag_t tag, size_t size);
+
+/**
+ * @function	ymem_free
+ *		Free a memory block, and account it to the tag it was allocated
+ *		with. Used by YFREE() and free0() when YMEM_PROFILE is defined.
+ * @param	ptr	Pointer to the block. Could be NULL.
+ */
+void ymem_free(void *ptr);
+
+/**
+ * @function	ymem_track
+ *		Account a block given by another allocator (the slab allocator,
+ *		for example), as if it was given by ymem_alloc().
+ * @param	tag	The tag.
+ * @param	ptr	Pointer to the block. Nothing is counted if it is NULL.
+ * @param	size	Size of the block.
+ * @return	The pointer to the block.
+ */
+void *ymem_track(ymem_tag_t tag, void *ptr, size_t size);
+
+/**
+ * @function	ymem_untrack
+ *		Account the liberation of a block, to the tag it was allocated
+ *		with. Nothing is counted for blocks which are not tracked.
+ * @param	ptr	Pointer to the block. Could be NULL.
+ */
+void ymem_untrack(void *ptr);
+
+/**
+ * @function	ymem_get_stats
+ *		Copy the counters of a tag.
+ * @param	tag	The tag.
+ * @param	stats	Pointer to the structure filled by the function.
+ */
+void ymem_get_stats(ymem_tag_t tag, ymem_stats_t *stats);
+
+/**
+ * @function	ymem_tag_name
+ *		Return the name of a tag.
+ * @param	tag	The tag.
+ * @return	A constant string.
+ */
+const char *ymem_tag_name(ymem_tag_t tag);
+
+/**
+ * @function	ymem_dump
+ *		Write the counters of all tags, one line per tag.
+ * @param	stream	Output stream.
+ */
+void ymem_dump(FILE *stream);
+
+/**
+ * @function	ymem_dump_every
+ *		Write the counters periodically, from a background thread.
+ * @param	stream	Output stream.
+ * @param	seconds	Period; 0 to stop.
+ * @return	YENOERR if OK, YEAGAIN if the thread couldn't be started.
+ */
+yerr_t ymem_dump_every(FILE *stream, unsigned int seconds);
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif /* __cplusplus || c_plusplus */
+
+#endif /* __YMEM_H__ */
@@ -1,3 +1,5 @@
+#define YMEM_TAG	YMEM_TAG_NET
+
 #include <limits.h>
 #include <linux/limits.h>
 #include <unistd.h>
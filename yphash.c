@@ -0,0 +1,286 @@
+#define YMEM_TAG	YMEM_TAG_HASH
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "yphash.h"
+
+/**
+ * @typedef	_yphash_bucket_t
+ *		Bucket used while building a table.
+ * @field	bucket		Index of the bucket.
+ * @field	nbr_keys	Number of keys in the bucket.
+ */
+typedef struct _yphash_bucket_s {
+	size_t	bucket;
+	size_t	nbr_keys;
+} _yphash_bucket_t;
+
+/* *** definition of private functions *** */
+static int _yphash_bucket_cmp(const void *p1, const void *p2);
+static ybool_t _yphash_build(size_t nbr_keys, const char * const *keys, const size_t *key_lens, const size_t *starts, const size_t *members, _yphash_bucket_t *buckets, char *taken, size_t *slots, long *displacements, size_t *indexes);
+static ybool_t _yphash_place(size_t nbr_keys, const char * const *keys, const size_t *key_lens, const size_t *members, size_t nbr_members, u32_t seed, char *taken, size_t *slots);
+static void _yphash_dump_key(ystr_t *s, const char *key, size_t key_len);
+
+/*
+ * yphash_new()
+ * Build a minimal perfect hash table from a list of keys.
+ */
+yphash_t *yphash_new(const char * const *keys, size_t nbr_keys) {
+	yphash_t		*phash;
+	_yphash_bucket_t	*buckets;
+	size_t			*key_lens, *indexes, *lens, *starts, *members, *slots;
+	size_t			i, b, total_len;
+	long			*displacements;
+	char			**copies, *taken, *pt;
+
+	/* group the keys by bucket, as a list of members per bucket */
+	key_lens = (size_t*)YCALLOC(nbr_keys + 1, sizeof(size_t));
+	starts = (size_t*)YCALLOC(nbr_keys + 2, sizeof(size_t));
+	members = (size_t*)YCALLOC(nbr_keys + 1, sizeof(size_t));
+	slots = (size_t*)YCALLOC(nbr_keys + 1, sizeof(size_t));
+	buckets = (_yphash_bucket_t*)YCALLOC(nbr_keys + 1, sizeof(_yphash_bucket_t));
+	taken = (char*)YMALLOC(nbr_keys + 1);
+	for (i = 0, total_len = 0; i < nbr_keys; i++) {
+		key_lens[i] = strlen(keys[i]);
+		total_len += key_lens[i] + 1;
+		starts[yphash_hash(0, keys[i], key_lens[i]) % nbr_keys + 1]++;
+	}
+	for (b = 0; b < nbr_keys; b++) {
+		buckets[b].bucket = b;
+		buckets[b].nbr_keys = starts[b + 1];
+		starts[b + 1] += starts[b];
+	}
+	for (i = 0; i < nbr_keys; i++) {
+		b = yphash_hash(0, keys[i], key_lens[i]) % nbr_keys;
+		members[starts[b] + slots[b]++] = i;
+	}
+	/* allocate the table and the copies of the keys in a single block */
+	phash = (yphash_t*)YMALLOC(sizeof(yphash_t) + nbr_keys * (2 * sizeof(size_t) + sizeof(char*) + sizeof(long)) + total_len);
+	phash->nbr_keys = nbr_keys;
+	indexes = (size_t*)(phash + 1);
+	lens = indexes + nbr_keys;
+	copies = (char**)(lens + nbr_keys);
+	displacements = (long*)(copies + nbr_keys);
+	pt = (char*)(displacements + nbr_keys);
+	phash->indexes = indexes;
+	phash->key_lens = lens;
+	phash->keys = (const char * const *)copies;
+	phash->displacements = displacements;
+	if (!_yphash_build(nbr_keys, keys, key_lens, starts, members, buckets, taken, slots, displacements, indexes)) {
+		YFREE(phash);
+	} else {
+		/* copy the keys in slot order */
+		for (i = 0; i < nbr_keys; i++) {
+			lens[i] = key_lens[indexes[i]];
+			copies[i] = pt;
+			memcpy(pt, keys[indexes[i]], lens[i] + 1);
+			pt += lens[i] + 1;
+		}
+	}
+	YFREE(key_lens);
+	YFREE(starts);
+	YFREE(members);
+	YFREE(slots);
+	YFREE(buckets);
+	YFREE(taken);
+	return (phash);
+}
+
+/*
+ * yphash_delete()
+ * Destroy a table created by yphash_new().
+ */
+void yphash_delete(yphash_t *phash) {
+	YFREE(phash);
+}
+
+/*
+ * yphash_search()
+ * Search a key in a minimal perfect hash table.
+ */
+size_t yphash_search(const yphash_t *phash, const char *key, size_t key_len) {
+	long	displacement;
+	size_t	slot;
+
+	if (phash->nbr_keys == 0)
+		return (YPHASH_NOT_FOUND);
+	displacement = phash->displacements[yphash_hash(0, key, key_len) % phash->nbr_keys];
+	if (displacement == 0)
+		return (YPHASH_NOT_FOUND);
+	if (displacement < 0)
+		slot = (size_t)(-displacement - 1);
+	else
+		slot = yphash_hash((u32_t)displacement, key, key_len) % phash->nbr_keys;
+	if (phash->key_lens[slot] != key_len || memcmp(phash->keys[slot], key, key_len))
+		return (YPHASH_NOT_FOUND);
+	return (phash->indexes[slot]);
+}
+
+/*
+ * yphash_dump_c()
+ * Write a table as C source code.
+ */
+ystr_t yphash_dump_c(const yphash_t *phash, const char *name) {
+	ystr_t	s;
+	char	buf[128];
+	size_t	i;
+
+	s = ys_new("");
+	ys_cat(&s, "static const long ");
+	ys_cat(&s, name);
+	ys_cat(&s, "_displacements[] = {");
+	for (i = 0; i < phash->nbr_keys; i++) {
+		sprintf(buf, "%s%ld", (i % 8) ? ", " : (i ? ",\n\t" : "\n\t"), phash->displacements[i]);
+		ys_cat(&s, buf);
+	}
+	ys_cat(&s, "\n};\nstatic const char * const ");
+	ys_cat(&s, name);
+	ys_cat(&s, "_keys[] = {");
+	for (i = 0; i < phash->nbr_keys; i++) {
+		ys_cat(&s, i ? ",\n\t" : "\n\t");
+		_yphash_dump_key(&s, phash->keys[i], phash->key_lens[i]);
+	}
+	ys_cat(&s, "\n};\nstatic const size_t ");
+	ys_cat(&s, name);
+	ys_cat(&s, "_key_lens[] = {");
+	for (i = 0; i < phash->nbr_keys; i++) {
+		sprintf(buf, "%s%lu", (i % 8) ? ", " : (i ? ",\n\t" : "\n\t"), (unsigned long)phash->key_lens[i]);
+		ys_cat(&s, buf);
+	}
+	ys_cat(&s, "\n};\nstatic const size_t ");
+	ys_cat(&s, name);
+	ys_cat(&s, "_indexes[] = {");
+	for (i = 0; i < phash->nbr_keys; i++) {
+		sprintf(buf, "%s%lu", (i % 8) ? ", " : (i ? ",\n\t" : "\n\t"), (unsigned long)phash->indexes[i]);
+		ys_cat(&s, buf);
+	}
+	ys_cat(&s, "\n};\nstatic const yphash_t ");
+	ys_cat(&s, name);
+	sprintf(buf, " = {\n\t%lu,\n\t", (unsigned long)phash->nbr_keys);
+	ys_cat(&s, buf);
+	ys_cat(&s, name);
+	ys_cat(&s, "_displacements,\n\t");
+	ys_cat(&s, name);
+	ys_cat(&s, "_keys,\n\t");
+	ys_cat(&s, name);
+	ys_cat(&s, "_key_lens,\n\t");
+	ys_cat(&s, name);
+	ys_cat(&s, "_indexes\n};\n");
+	return (s);
+}
+
+/*
+ * yphash_hash()
+ * Hash a key with a seed.
+ */
+u32_t yphash_hash(u32_t seed, const char *key, size_t key_len) {
+	u32_t	hash_value = 2166136261U ^ seed;
+	size_t	i;
+
+	for (i = 0; i < key_len; i++) {
+		hash_value ^= (unsigned char)key[i];
+		hash_value *= 16777619U;
+	}
+	/* final mix, so that close seeds give unrelated hash values */
+	hash_value ^= hash_value >> 16;
+	hash_value *= 0x85EBCA6BU;
+	hash_value ^= hash_value >> 13;
+	hash_value *= 0xC2B2AE35U;
+	hash_value ^= hash_value >> 16;
+	return (hash_value);
+}
+
+/* *************** PRIVATE FUNCTIONS ************** */
+/*
+ * _yphash_bucket_cmp()
+ * Compare two buckets for qsort(), the biggest first.
+ */
+static int _yphash_bucket_cmp(const void *p1, const void *p2) {
+	const _yphash_bucket_t	*b1 = (const _yphash_bucket_t*)p1;
+	const _yphash_bucket_t	*b2 = (const _yphash_bucket_t*)p2;
+
+	if (b1->nbr_keys != b2->nbr_keys)
+		return ((b1->nbr_keys > b2->nbr_keys) ? -1 : 1);
+	return ((b1->bucket < b2->bucket) ? -1 : (b1->bucket > b2->bucket));
+}
+
+/*
+ * _yphash_build()
+ * Compute the displacement of each bucket and the slot of each key. The
+ * biggest buckets are placed first, by searching a seed which sends all
+ * their keys to free slots; buckets of one key then take the remaining
+ * slots directly. Fail if two keys are identical.
+ */
+static ybool_t _yphash_build(size_t nbr_keys, const char * const *keys, const size_t *key_lens, const size_t *starts, const size_t *members, _yphash_bucket_t *buckets, char *taken, size_t *slots, long *displacements, size_t *indexes) {
+	size_t	i, j, k, b, free_slot;
+	u32_t	seed;
+
+	qsort(buckets, nbr_keys, sizeof(_yphash_bucket_t), _yphash_bucket_cmp);
+	for (k = 0; k < nbr_keys && buckets[k].nbr_keys > 1; k++) {
+		b = buckets[k].bucket;
+		for (i = starts[b]; i < starts[b + 1]; i++)
+			for (j = i + 1; j < starts[b + 1]; j++)
+				if (key_lens[members[i]] == key_lens[members[j]] &&
+				    !memcmp(keys[members[i]], keys[members[j]], key_lens[members[i]]))
+					return (YFALSE);
+		for (seed = 1; !_yphash_place(nbr_keys, keys, key_lens, &(members[starts[b]]), buckets[k].nbr_keys, seed, taken, slots); seed++)
+			if (seed == YPHASH_MAX_SEED)
+				return (YFALSE);
+		displacements[b] = (long)seed;
+		for (i = 0; i < buckets[k].nbr_keys; i++)
+			indexes[slots[i]] = members[starts[b] + i];
+	}
+	for (free_slot = 0; k < nbr_keys && buckets[k].nbr_keys == 1; k++) {
+		while (taken[free_slot])
+			free_slot++;
+		taken[free_slot] = 1;
+		b = buckets[k].bucket;
+		displacements[b] = -(long)free_slot - 1;
+		indexes[free_slot] = members[starts[b]];
+	}
+	return (YTRUE);
+}
+
+/*
+ * _yphash_place()
+ * Try to put all the keys of a bucket in free slots, using a seed. On
+ * success, the slots are marked as taken and written in the given array.
+ */
+static ybool_t _yphash_place(size_t nbr_keys, const char * const *keys, const size_t *key_lens, const size_t *members, size_t nbr_members, u32_t seed, char *taken, size_t *slots) {
+	size_t	i;
+
+	for (i = 0; i < nbr_members; i++) {
+		slots[i] = yphash_hash(seed, keys[members[i]], key_lens[members[i]]) % nbr_keys;
+		if (taken[slots[i]]) {
+			/* release the slots taken by the previous keys of the bucket */
+			while (i > 0)
+				taken[slots[--i]] = 0;
+			return (YFALSE);
+		}
+		taken[slots[i]] = 1;
+	}
+	return (YTRUE);
+}
+
+/*
+ * _yphash_dump_key()
+ * Write a key as a C string literal.
+ */
+static void _yphash_dump_key(ystr_t *s, const char *key, size_t key_len) {
+	char	buf[8];
+	size_t	i;
+
+	ys_addc(s, '"');
+	for (i = 0; i < key_len; i++) {
+		if (key[i] == '"' || key[i] == '\\') {
+			ys_addc(s, '\\');
+			ys_addc(s, key[i]);
+		} else if ((unsigned char)key[i] < 0x20 || (unsigned char)key[i] >= 0x7F) {
+			sprintf(buf, "\\%03o", (unsigned char)key[i]);
+			ys_cat(s, buf);
+		} else
+			ys_addc(s, key[i]);
+	}
+	ys_addc(s, '"');
+}
@@ -0,0 +1,113 @@
+/* Process this file with the HeaderBrowser tool (http://www.headerbrowser.org)
+   to create documentation. */
+/*!
+ * @header	yphash.h
+ * @abstract	Minimal perfect hashing of static key sets.
+ * @discussion	A minimal perfect hash maps each key of a fixed set to its own
+ *		slot, in a table which has exactly one slot per key: a search
+ *		costs two hash computations and one key comparison, whatever
+ *		the number of keys. The slot of a key is found by hashing it a
+ *		first time to get its bucket; the bucket's displacement is then
+ *		either the slot itself (for buckets of one key) or the seed of
+ *		a second hash giving the slot (hash and displace method).
+ *		<p />
+ *		Tables can be built at runtime from any key list (for example
+ *		loaded from a configuration file) with yphash_new(), or
+ *		generated as C source code by yphash_dump_c() and compiled as
+ *		constant data, for key sets known at build time.
+ * @version	1.0 Oct 19 2026
+ * @author	Amaury Bouchard <amaury@amaury.net>
+ */
+#ifndef __YPHASH_H__
+#define __YPHASH_H__
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif /* __cplusplus || c_plusplus */
+
+#include "ydefs.h"
+#include "ystr.h"
+
+/** @define YPHASH_NOT_FOUND Value returned by yphash_search() for unknown keys. */
+#define YPHASH_NOT_FOUND	((size_t)-1)
+
+/** @define YPHASH_MAX_SEED Highest seed tried for a bucket before giving up. */
+#define YPHASH_MAX_SEED		1048576
+
+/**
+ * @typedef	yphash_t
+ *		Minimal perfect hash table. All its fields are arrays of nbr_keys
+ *		elements, so that a table can be written as constant data.
+ * @field	nbr_keys	Number of keys.
+ * @field	displacements	Displacement of each bucket: 0 for empty buckets, a
+ *				negative number (-slot - 1) for buckets of one key,
+ *				or the seed of the hash giving the slot of the keys.
+ * @field	keys		Keys, by slot.
+ * @field	key_lens	Lengths of the keys, by slot.
+ * @field	indexes		Index of each key in the list it was built from, by slot.
+ */
+typedef struct yphash_s {
+	size_t		nbr_keys;
+	const long	*displacements;
+	const char	* const *keys;
+	const size_t	*key_lens;
+	const size_t	*indexes;
+} yphash_t;
+
+/* ****************** FUNCTIONS **************** */
+/**
+ * @function	yphash_new
+ *		Build a minimal perfect hash table from a list of keys. The keys
+ *		are copied.
+ * @param	keys		Array of keys.
+ * @param	nbr_keys	Number of keys.
+ * @return	The created table, or NULL if the list contains the same key
+ *		twice.
+ */
+yphash_t *yphash_new(const char * const *keys, size_t nbr_keys);
+
+/**
+ * @function	yphash_delete
+ *		Destroy a table created by yphash_new().
+ * @param	phash	Pointer to the table.
+ */
+void yphash_delete(yphash_t *phash);
+
+/**
+ * @function	yphash_search
+ *		Search a key in a minimal perfect hash table. The key is compared
+ *		to the stored one, so unknown keys are never mistaken for known
+ *		ones.
+ * @param	phash	Pointer to the table.
+ * @param	key	The key. It doesn't have to be null-terminated.
+ * @param	key_len	Length of the key.
+ * @return	The index of the key in the list the table was built from, or
+ *		YPHASH_NOT_FOUND.
+ */
+size_t yphash_search(const yphash_t *phash, const char *key, size_t key_len);
+
+/**
+ * @function	yphash_dump_c
+ *		Write a table as C source code: constant arrays, and a constant
+ *		yphash_t structure which can be given to yphash_search().
+ * @param	phash	Pointer to the table.
+ * @param	name	Name of the generated structure, and prefix of the arrays.
+ * @return	The generated code. It must be freed with ys_del().
+ */
+ystr_t yphash_dump_c(const yphash_t *phash, const char *name);
+
+/**
+ * @function	yphash_hash
+ *		Hash a key (FNV-1a with a final mix), with a seed.
+ * @param	seed	The seed.
+ * @param	key	The key.
+ * @param	key_len	Length of the key.
+ * @return	The hash value.
+ */
+u32_t yphash_hash(u32_t seed, const char *key, size_t key_len);
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif /* __cplusplus || c_plusplus */
+
+#endif /* __YPHASH_H__ */
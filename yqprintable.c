@@ -61,7 +61,7 @@ ybin_t yqprintable_decode(const char *pt)
   int i, j;
 
   YLOG_ADD(YLOG_DEBUG, "yqprintable_decode entering");
-  if (!(str = malloc0(strlen(pt) + 2)))
+  if (!(str = YMALLOC_RAW(strlen(pt) + 2)))
     {
       res.data = NULL;
       res.len = 0;
@@ -1,10 +1,102 @@
+#define YMEM_TAG	YMEM_TAG_SAX
+
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "ylog.h"
 #include "ysax.h"
+#include "yscan.h"
+
+/*
+** _YSAX_GETC()
+** Return the next character of the input (as an unsigned char), or EOF.
+** Characters are taken from the current block; a new one is read when
+** it is exhausted.
+*/
+#define _YSAX_GETC(sax)		(((sax)->pos < (sax)->end) ? \
+				 (int)(unsigned char)*((sax)->pos++) : _ysax_fill(sax))
+
+/*
+** _YSAX_UNGETC()
+** Put back the last character returned by _YSAX_GETC().
+*/
+#define _YSAX_UNGETC(sax)	((sax)->pos--)
+
+/*
+** _YSAX_WANTS_TEXT()
+** Tell if a handler receives the text found between tags.
+*/
+#define _YSAX_WANTS_TEXT(sax)	((sax)->inside_text_hdlr || (sax)->span_inside_text_hdlr)
+
+/*
+** _YSAX_SYNTAX_ERROR()
+** Log a syntax error, unless it comes from the end of the data given
+** to ysax_feed().
+*/
+#define _YSAX_SYNTAX_ERROR(sax)	do { if (!(sax)->starved) \
+				       YLOG_ADD(YLOG_ERR, "Syntax error"); \
+				   } while (0)
+
+/*
+** _YSAX_TRANSCODE()
+** Tell if the current input must be converted into UTF-8.
+*/
+#define _YSAX_TRANSCODE(sax)	((sax)->encoding == YENC_LATIN1 || \
+				 (sax)->encoding == YENC_UTF16LE || \
+				 (sax)->encoding == YENC_UTF16BE)
+
+/*
+** _YSAX_CHECK_UTF8()
+** Tell if the current input must be validated.
+*/
+#define _YSAX_CHECK_UTF8(sax)	((sax)->check_utf8 && (sax)->encoding == YENC_UTF8)
+
+/*
+** _YSAX_RAW_SIZE
+** Size of the blocks of data to convert: once converted (two bytes per
+** byte at most, plus a character begun in the previous block), they must
+** fit in a block.
+*/
+#define _YSAX_RAW_SIZE		(YSAX_BLOCK_SIZE / 2 - 4)
+
+/* Characters which end a run of text, an attribute value, a comment, a
+   CDATA section or a processing instruction (nul characters are skipped). */
+static yscan_set_t _ysax_text_set;
+static yscan_set_t _ysax_quote_set;
+static yscan_set_t _ysax_dquote_set;
+static yscan_set_t _ysax_minus_set;
+static yscan_set_t _ysax_rbracket_set;
+static yscan_set_t _ysax_interrog_set;
+static yscan_set_t _ysax_tag_end_set;
+static pthread_once_t _ysax_sets_once = PTHREAD_ONCE_INIT;
 
 /* Private prototypes */
+static void _ysax_init_sets(void);
+static void _ysax_set_source(ysax_t *sax);
 static yerr_t _ysax_parse(ysax_t *sax);
-static char _ysax_getc(ysax_t *sax);
-static void _ysax_ungetc(ysax_t *sax, char c);
+static yerr_t _ysax_parse_feed(ysax_t *sax);
+static yerr_t _ysax_starved(ysax_t *sax);
+static void _ysax_feed_wait(ysax_t *sax);
+static const char *_ysax_find_delim(const char *begin, const char *end, const char *delim);
+static yerr_t _ysax_parse_in_place(ysax_t *sax, const char *data, size_t len);
+static size_t _ysax_detect(ysax_t *sax, const char *data, size_t len);
+static yerr_t _ysax_feed_detect(ysax_t *sax);
+static int _ysax_fill(ysax_t *sax);
+static size_t _ysax_read(ysax_t *sax, char *block, size_t size);
+static size_t _ysax_read_decoded(ysax_t *sax);
+static size_t _ysax_decode(ysax_t *sax, const char *data, size_t len, char *dest);
+static yerr_t _ysax_check_utf8(ysax_t *sax, const char *begin, const char *end);
+static size_t _ysax_read_getc(ysax_t *sax, char *block, size_t size);
+static int _ysax_scan(ysax_t *sax, ystr_t *str, const yscan_set_t *set);
+static int _ysax_scan_in_place(ysax_t *sax, ystr_t *str, const yscan_set_t *set,
+			       ysax_span_t *span);
+static ysax_span_t _ysax_span(const char *ptr, size_t len);
+static yerr_t _ysax_add_span_attr(ysax_t *sax, ystr_t name, ysax_span_t value,
+				  size_t value_offset);
+static yerr_t _ysax_call_open_tag(ysax_t *sax, ystr_t name);
+static void _ysax_call_close_tag(ysax_t *sax, ystr_t name);
 static yerr_t _ysax_do_open_tag(ysax_t *sax);
 static ysax_attr_t *_ysax_add_attrs(yvect_t *attrs, char *attr_name, char *attr_value);
 static yerr_t _ysax_parse_open_tag(ysax_t *sax);
@@ -27,10 +119,20 @@ ysax_t *ysax_new(void *parse_data)
       YLOG_ADD(YLOG_ERR, "Memory allocation error");
       return (NULL);
     }
+  if (!(sax->text_buf = ys_new("")) || !(sax->name_buf = ys_new("")) ||
+      !(sax->attr_name_buf = ys_new("")) || !(sax->content_buf = ys_new("")) ||
+      !(sax->attr_data = ys_new("")))
+    {
+      YLOG_ADD(YLOG_ERR, "Memory allocation error");
+      ysax_del(sax);
+      return (NULL);
+    }
+  pthread_once(&_ysax_sets_once, _ysax_init_sets);
   sax->must_close_stream = YFALSE;
   sax->parse_data = parse_data;
   sax->error = YENOERR;
   sax->line_nbr = 0;
+  sax->feeding = YFALSE;
   YLOG_MOD("ysax", YLOG_DEBUG, "Exiting");
   return (sax);
 }
@@ -49,6 +151,7 @@ yerr_t ysax_read_handler(ysax_t *sax, char (*getc_hdlr)(void*),
       YLOG_ADD(YLOG_ERR, "Invalid handler");
       return (YEUNDEF);
     }
+  _ysax_set_source(sax);
   sax->getc_hdlr = getc_hdlr;
   sax->ungetc_hdlr = ungetc_hdlr;
   sax->xml_data = xml_data;
@@ -56,14 +159,62 @@ yerr_t ysax_read_handler(ysax_t *sax, char (*getc_hdlr)(void*),
   return (_ysax_parse(sax));
 }
 
+/*
+** ysax_read_block_handler()
+** Launch the parsing of some XML data, using a handler
+** to read blocks of data.
+*/
+yerr_t ysax_read_block_handler(ysax_t *sax,
+			       size_t (*read_hdlr)(void*, char*, size_t),
+			       void *xml_data)
+{
+  if (!read_hdlr)
+    {
+      YLOG_ADD(YLOG_ERR, "Invalid handler");
+      return (YEUNDEF);
+    }
+  _ysax_set_source(sax);
+  sax->read_hdlr = read_hdlr;
+  sax->xml_data = xml_data;
+  return (_ysax_parse(sax));
+}
+
 /*
 ** ysax_read_file()
 ** Launch the parsing of an XML file.
 */
 yerr_t ysax_read_file(ysax_t *sax, const char *filename)
 {
-  if (!filename || !(sax->file = fopen(filename, "r")))
+  struct stat st;
+  void *map;
+  yerr_t res;
+  int fd;
+
+  _ysax_set_source(sax);
+  if (!filename || (fd = open(filename, O_RDONLY)) == -1)
+    {
+      YLOG_ADD(YLOG_ERR, "Bad file parameter");
+      return (YEUNDEF);
+    }
+  /* regular files are parsed in place, other ones are read by blocks */
+  if (!fstat(fd, &st) && S_ISREG(st.st_mode) && st.st_size > 0 &&
+      (off_t)(size_t)st.st_size == st.st_size &&
+      (map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE,
+		  fd, 0)) != MAP_FAILED)
     {
+      close(fd);
+      madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+      sax->map = (char*)map;
+      sax->map_size = (size_t)st.st_size;
+      res = _ysax_parse_in_place(sax, sax->map, sax->map_size);
+      munmap(sax->map, sax->map_size);
+      sax->map = sax->pos = sax->end = NULL;
+      sax->map_size = 0;
+      return (res);
+    }
+  if (!(sax->file = fdopen(fd, "r")))
+    {
+      close(fd);
       YLOG_ADD(YLOG_ERR, "Bad file parameter");
       return (YEUNDEF);
     }
@@ -82,6 +233,7 @@ yerr_t ysax_read_stream(ysax_t *sax, FILE *stream)
       YLOG_ADD(YLOG_ERR, "Bad stream parameter");
       return (YEUNDEF);
     }
+  _ysax_set_source(sax);
   sax->file = stream;
   sax->must_close_stream = YFALSE;
   return (_ysax_parse(sax));
@@ -98,8 +250,143 @@ yerr_t ysax_read_memory(ysax_t *sax, char *mem)
       YLOG_ADD(YLOG_ERR, "Bad mem parameter");
       return (YEUNDEF);
     }
+  _ysax_set_source(sax);
   sax->mem = mem;
-  return (_ysax_parse(sax));
+  return (_ysax_parse_in_place(sax, mem, strlen(mem)));
+}
+
+/*
+** ysax_read_buffer()
+** Launch the parsing of an XML buffer of known length.
+*/
+yerr_t ysax_read_buffer(ysax_t *sax, const char *data, size_t len)
+{
+  if (!data && len)
+    {
+      YLOG_ADD(YLOG_ERR, "Bad data parameter");
+      return (YEUNDEF);
+    }
+  _ysax_set_source(sax);
+  return (_ysax_parse_in_place(sax, data, len));
+}
+
+/*
+** ysax_feed()
+** Give a chunk of XML data to the parser, and parse it as far
+** as possible.
+*/
+yerr_t ysax_feed(ysax_t *sax, const char *data, size_t len)
+{
+  char *feed, *start;
+  size_t size, need;
+  yerr_t res;
+
+  if (!sax || (!data && len))
+    {
+      YLOG_ADD(YLOG_ERR, "Bad parameter");
+      return (YEUNDEF);
+    }
+  if (!sax->feeding)
+    {
+      _ysax_set_source(sax);
+      sax->feeding = YTRUE;
+    }
+  if (sax->feed_ended)
+    return (sax->error);
+  /* converted data is at most twice as long */
+  need = (sax->detected && _YSAX_TRANSCODE(sax)) ? (2 * len + sizeof(sax->carry)) : len;
+  if (sax->feed_len + need > sax->feed_size)
+    {
+      for (size = sax->feed_size ? sax->feed_size : YSAX_BLOCK_SIZE;
+	   size < sax->feed_len + need; size *= 2)
+	;
+      if (!(feed = YMALLOC_RAW(size)))
+	{
+	  YLOG_ADD(YLOG_ERR, "Unable to allocate memory");
+	  sax->feed_ended = YTRUE;
+	  return ((sax->error = YENOMEM));
+	}
+      if (sax->feed_len)
+	memcpy(feed, sax->feed, sax->feed_len);
+      YFREE(sax->feed);
+      sax->feed = feed;
+      sax->feed_size = size;
+    }
+  start = sax->feed + sax->feed_len;
+  if (sax->detected && _YSAX_TRANSCODE(sax))
+    sax->feed_len += _ysax_decode(sax, data, len, start);
+  else
+    {
+      if (len)
+	memcpy(start, data, len);
+      sax->feed_len += len;
+    }
+  if (!sax->detected)
+    {
+      /* the encoding is detected from the XML declaration, or the
+	 first tag */
+      if (sax->feed_len < YENC_DETECT_SIZE &&
+	  !memchr(sax->feed, GT, sax->feed_len))
+	return (YEAGAIN);
+      if ((res = _ysax_feed_detect(sax)) != YENOERR)
+	return (res);
+      start = sax->feed;
+    }
+  else if (_YSAX_CHECK_UTF8(sax))
+    _ysax_check_utf8(sax, start, sax->feed + sax->feed_len);
+  if (sax->error != YENOERR)
+    {
+      sax->feed_ended = YTRUE;
+      return (sax->error);
+    }
+  if (sax->feed_wait)
+    {
+      /* an open comment, CDATA section or processing instruction can't
+	 be completed before its end delimiter, which is searched in the
+	 new data only */
+      if (!_ysax_find_delim(sax->feed + sax->feed_scanned,
+			    sax->feed + sax->feed_len, sax->feed_wait))
+	{
+	  need = strlen(sax->feed_wait) - 1;
+	  if (sax->feed_len - sax->feed_scanned > need)
+	    sax->feed_scanned = sax->feed_len - need;
+	  return (YEAGAIN);
+	}
+    }
+  /* nothing could be completed without a tag delimiter */
+  else if (yscan_find(start, sax->feed + sax->feed_len,
+		      &_ysax_tag_end_set) == sax->feed + sax->feed_len)
+    return (YEAGAIN);
+  return (_ysax_parse_feed(sax));
+}
+
+/*
+** ysax_finish()
+** Parse the data given by ysax_feed() which remains.
+*/
+yerr_t ysax_finish(ysax_t *sax)
+{
+  yerr_t res;
+
+  if (!sax || !sax->feeding)
+    {
+      YLOG_ADD(YLOG_ERR, "Bad parameter");
+      return (YEUNDEF);
+    }
+  if (!sax->feed_ended && !sax->detected && _ysax_feed_detect(sax) != YENOERR)
+    sax->feed_ended = YTRUE;
+  if (!sax->feed_ended && sax->carry_len)
+    {
+      YLOG_ADD(YLOG_ERR, "Truncated character at the end of data");
+      sax->error = YEILSEQ;
+      sax->feed_ended = YTRUE;
+    }
+  sax->feeding = YFALSE;
+  res = sax->feed_ended ? sax->error : _ysax_parse_feed(sax);
+  sax->feed_len = 0;
+  sax->feed_ended = YFALSE;
+  sax->pos = sax->end = NULL;
+  return (res);
 }
 
 /*
@@ -116,10 +403,49 @@ void ysax_del(ysax_t *sax)
     }
   if (sax->must_close_stream && fclose(sax->file))
     YLOG_ADD(YLOG_ERR, "Unable to close file");
+  YFREE(sax->block);
+  YFREE(sax->raw);
+  YFREE(sax->feed);
+  ys_del(&sax->text_buf);
+  ys_del(&sax->name_buf);
+  ys_del(&sax->attr_name_buf);
+  ys_del(&sax->content_buf);
+  ys_del(&sax->attr_data);
+  YFREE(sax->attrs);
+  YFREE(sax->attr_offsets);
   free0(sax);
   YLOG_MOD("ysax", YLOG_DEBUG, "Exiting");
 }
 
+/*
+** ysax_set_encoding()
+** Set the encoding of the next inputs.
+*/
+void ysax_set_encoding(ysax_t *sax, yenc_t enc)
+{
+  if (sax)
+    sax->input_encoding = enc;
+}
+
+/*
+** ysax_get_encoding()
+** Return the encoding of the current input.
+*/
+yenc_t ysax_get_encoding(ysax_t *sax)
+{
+  return (sax ? sax->encoding : YENC_UNKNOWN);
+}
+
+/*
+** ysax_set_utf8_check()
+** Ask the parser to validate UTF-8 input.
+*/
+void ysax_set_utf8_check(ysax_t *sax, ybool_t check)
+{
+  if (sax)
+    sax->check_utf8 = check;
+}
+
 /*
 ** ysax_set_tag_hdlr()
 ** Function used to set the handlers for open and clse tags.
@@ -179,6 +505,98 @@ void ysax_set_cdata_hdlr(ysax_t *sax,
     sax->cdata_hdlr = hdlr;
 }
 
+/*
+** ysax_set_span_tag_hdlr()
+** Function used to set the span handlers for open and close tags.
+*/
+void ysax_set_span_tag_hdlr(ysax_t *sax,
+			    void (*open_hdlr)(ysax_t*, ysax_span_t,
+					      const ysax_span_attr_t*, size_t),
+			    void (*close_hdlr)(ysax_t*, ysax_span_t))
+{
+  if (sax)
+    {
+      sax->span_open_tag_hdlr = open_hdlr;
+      sax->span_close_tag_hdlr = close_hdlr;
+    }
+}
+
+/*
+** ysax_set_span_inside_text_hdlr()
+** Function used to set the span handler for inside text.
+*/
+void ysax_set_span_inside_text_hdlr(ysax_t *sax,
+				    void (*hdlr)(ysax_t*, ysax_span_t))
+{
+  if (sax)
+    sax->span_inside_text_hdlr = hdlr;
+}
+
+/*
+** ysax_set_span_comment_hdlr()
+** Function used to set the span handler for XML comments.
+*/
+void ysax_set_span_comment_hdlr(ysax_t *sax,
+				void (*hdlr)(ysax_t*, ysax_span_t))
+{
+  if (sax)
+    sax->span_comment_hdlr = hdlr;
+}
+
+/*
+** ysax_set_span_process_instr_hdlr()
+** Function used to set the span handler for processing instructions.
+*/
+void ysax_set_span_process_instr_hdlr(ysax_t *sax,
+				      void (*hdlr)(ysax_t*, ysax_span_t,
+						   ysax_span_t))
+{
+  if (sax)
+    sax->span_process_instr_hdlr = hdlr;
+}
+
+/*
+** ysax_set_span_cdata_hdlr()
+** Function used to set the span handler for CDATA sections.
+*/
+void ysax_set_span_cdata_hdlr(ysax_t *sax,
+			      void (*hdlr)(ysax_t*, ysax_span_t))
+{
+  if (sax)
+    sax->span_cdata_hdlr = hdlr;
+}
+
+/*
+** ysax_span_dup()
+** Copy a span into a new nul-terminated string.
+*/
+char *ysax_span_dup(ysax_span_t span)
+{
+  char *res;
+
+  if (!(res = YMALLOC_RAW(span.len + 1)))
+    return (NULL);
+  if (span.len)
+    memcpy(res, span.ptr, span.len);
+  res[span.len] = '\0';
+  return (res);
+}
+
+/*
+** ysax_span_cmp()
+** Compare a span with a nul-terminated string.
+*/
+int ysax_span_cmp(ysax_span_t span, const char *str)
+{
+  size_t len = strlen(str);
+  int res;
+
+  if ((res = memcmp(span.ptr ? span.ptr : "", str,
+		    span.len < len ? span.len : len)))
+    return (res);
+  return ((span.len > len) - (span.len < len));
+}
+
 /*
 ** ysax_stop()
 ** Stop the Sax parser. Use this function if you detect an
@@ -212,10 +630,10 @@ void ysax_free_attr(void *e, void *data)
 */
 yerr_t _ysax_parse(ysax_t *sax)
 {
-  char c;
+  int c;
   char last = '\0';
   ybool_t inside_char = YFALSE;
-  ystr_t inside_str;
+  const char *run_end, *spaces;
 
   YLOG_MOD("ysax", YLOG_DEBUG, "Entering");
   if (!sax)
@@ -223,13 +641,10 @@ yerr_t _ysax_parse(ysax_t *sax)
       YLOG_ADD(YLOG_WARN, "Bad pointer");
       return (YEUNDEF);
     }
-  if (!(inside_str = ys_new("")))
-    {
-      YLOG_ADD(YLOG_ERR, "Unable to allocate memory");
-      return ((sax->error = YENOMEM));
-    }
-  sax->line_nbr = 1;
-  while ((c = _ysax_getc(sax)) != EOF && sax->error == YENOERR)
+  ys_trunc(sax->text_buf);
+  sax->checkpoint = sax->pos;
+  sax->checkpoint_line = sax->line_nbr;
+  while ((c = _YSAX_GETC(sax)) != EOF && sax->error == YENOERR)
     {
       if (IS_SPACE(c))
 	{
@@ -239,79 +654,714 @@ yerr_t _ysax_parse(ysax_t *sax)
 	}
       else if (c == LT)
 	{
-	  if (ys_len(inside_str))
+	  if (ys_len(sax->text_buf))
 	    {
-	      if (sax->inside_text_hdlr)
-		sax->inside_text_hdlr(sax, ys_string(inside_str));
-	      ys_trunc(inside_str);
+	      if (sax->span_inside_text_hdlr)
+		sax->span_inside_text_hdlr(sax, _ysax_span(sax->text_buf,
+							   ys_len(sax->text_buf)));
+	      else if (sax->inside_text_hdlr)
+		sax->inside_text_hdlr(sax, ys_string(sax->text_buf));
+	      ys_trunc(sax->text_buf);
 	    }
-	  if ((sax->error = _ysax_do_open_tag(sax)) != YENOERR)
+	  sax->checkpoint = sax->pos - 1;
+	  sax->checkpoint_line = sax->line_nbr;
+	  sax->error = _ysax_do_open_tag(sax);
+	  if (sax->starved)
+	    return (_ysax_starved(sax));
+	  if (sax->error != YENOERR)
 	    {
-	      ys_del(&inside_str);
+	      /* the end of the input could be due to a read or
+		 conversion error */
+	      if (sax->input_error != YENOERR)
+		sax->error = sax->input_error;
 	      YLOG_ADD(YLOG_ERR, "Bad end");
 	      return (sax->error);
 	    }
+	  sax->checkpoint = sax->pos;
+	  sax->checkpoint_line = sax->line_nbr;
 	  inside_char = YFALSE;
 	  last = '\0';
 	}
       else if (c == GT)
 	{
-	  ys_del(&inside_str);
 	  YLOG_MOD("ysax", YLOG_DEBUG, "Exiting");
 	  return ((sax->error = YENOERR));
 	}
       else
 	{
-	  if (inside_char && IS_SPACE(last) && sax->inside_text_hdlr)
-	    ys_addc(&inside_str, last);
+	  if (inside_char && IS_SPACE(last) && _YSAX_WANTS_TEXT(sax))
+	    ys_addc(&sax->text_buf, last);
 	  inside_char = YTRUE;
-	  if (sax->inside_text_hdlr)
-	    ys_addc(&inside_str, c);
+	  if (_YSAX_WANTS_TEXT(sax))
+	    ys_addc(&sax->text_buf, c);
 	  last = c;
+	  /* copy the rest of the run of text (in the current block) at once;
+	     trailing spaces and runs of spaces are left to the loop, which
+	     keeps only the last space of a run */
+	  run_end = yscan_find(sax->pos, sax->end, &_ysax_text_set);
+	  while (run_end > sax->pos && run_end[-1] == SPACE)
+	    run_end--;
+	  for (spaces = sax->pos;
+	       spaces < run_end && (spaces = memchr(spaces, SPACE, run_end - spaces));
+	       spaces++)
+	    if (spaces[1] == SPACE)
+	      {
+		run_end = spaces;
+		break;
+	      }
+	  if (run_end > sax->pos)
+	    {
+	      if (_YSAX_WANTS_TEXT(sax))
+		ys_ncat(&sax->text_buf, sax->pos, run_end - sax->pos);
+	      last = run_end[-1];
+	      sax->pos = (char*)run_end;
+	    }
 	}
     }
-  ys_del(&inside_str);
+  if (sax->starved)
+    return (_ysax_starved(sax));
   YLOG_MOD("ysax", YLOG_DEBUG, "Exiting");
   return (sax->error);
 }
 
 /*
-** _ysax_getc() -- PRIVATE FUNCTION
-** Function called by SAX parser to get the next character of the file/stream/string.
+** _ysax_parse_feed() -- PRIVATE FUNCTION
+** Parse the data given by ysax_feed(), and keep what follows the last
+** complete tag if more data is needed.
 */
-static char _ysax_getc(ysax_t *sax)
+static yerr_t _ysax_parse_feed(ysax_t *sax)
 {
-  char c;
+  yerr_t res;
 
-  if (!sax)
-    return (EOF);
+  sax->pos = sax->feed;
+  sax->end = sax->feed + sax->feed_len;
+  sax->eof = YTRUE;
+  if ((res = _ysax_parse(sax)) == YEAGAIN)
+    {
+      sax->feed_len = sax->end - sax->checkpoint;
+      memmove(sax->feed, sax->checkpoint, sax->feed_len);
+      _ysax_feed_wait(sax);
+    }
+  else
+    {
+      sax->feed_len = 0;
+      sax->feed_ended = YTRUE;
+      sax->feed_wait = NULL;
+    }
+  return (res);
+}
+
+/*
+** _ysax_feed_wait() -- PRIVATE FUNCTION
+** Check if the data kept by _ysax_parse_feed() starts with a comment,
+** a CDATA section or a processing instruction, which is not complete.
+** Then the next parsing waits for its end delimiter, so a long section
+** which contains some '>' is not parsed again for each chunk.
+*/
+static void _ysax_feed_wait(ysax_t *sax)
+{
+  const char *pt = sax->feed;
+  size_t len = sax->feed_len, skip = 0;
+
+  sax->feed_wait = NULL;
+  if (len >= 4 && !memcmp(pt, "<!--", 4))
+    {
+      sax->feed_wait = "-->";
+      skip = 4;
+    }
+  else if (len >= 3 && !memcmp(pt, "<![", 3))
+    {
+      sax->feed_wait = "]]>";
+      skip = 3;
+    }
+  else if (len >= 2 && !memcmp(pt, "<?", 2))
+    {
+      sax->feed_wait = "?>";
+      skip = 2;
+    }
+  else
+    return;
+  /* the delimiter could be cut by the end of the data */
+  sax->feed_scanned = len - skip > strlen(sax->feed_wait) - 1 ?
+    len - (strlen(sax->feed_wait) - 1) : skip;
+}
+
+/*
+** _ysax_find_delim() -- PRIVATE FUNCTION
+** Search a delimiter in some data. Return a pointer to its first
+** occurrence, or NULL.
+*/
+static const char *_ysax_find_delim(const char *begin, const char *end, const char *delim)
+{
+  size_t len = strlen(delim);
+
+  for (; (size_t)(end - begin) >= len &&
+	 (begin = memchr(begin, *delim, end - begin - len + 1)); begin++)
+    if (!memcmp(begin, delim, len))
+      return (begin);
+  return (NULL);
+}
+
+/*
+** _ysax_starved() -- PRIVATE FUNCTION
+** Go back to the end of the last complete tag, when the data given
+** to ysax_feed() ends in the middle of a tag or a text.
+*/
+static yerr_t _ysax_starved(ysax_t *sax)
+{
+  sax->pos = sax->checkpoint;
+  sax->line_nbr = sax->checkpoint_line;
+  sax->starved = YFALSE;
+  sax->error = YENOERR;
+  return (YEAGAIN);
+}
+
+/*
+** _ysax_init_sets() -- PRIVATE FUNCTION
+** Initialize the scan sets, once.
+*/
+static void _ysax_init_sets(void)
+{
+  yscan_set_init(&_ysax_text_set, "<>\t\n\r", 6);
+  yscan_set_init(&_ysax_quote_set, "'", 2);
+  yscan_set_init(&_ysax_dquote_set, "\"", 2);
+  yscan_set_init(&_ysax_minus_set, "-", 2);
+  yscan_set_init(&_ysax_rbracket_set, "]", 2);
+  yscan_set_init(&_ysax_interrog_set, "?", 2);
+  yscan_set_init(&_ysax_tag_end_set, "<>", 2);
+}
+
+/*
+** _ysax_set_source() -- PRIVATE FUNCTION
+** Forget the input of a previous parsing.
+*/
+static void _ysax_set_source(ysax_t *sax)
+{
+  if (sax->must_close_stream && sax->file)
+    fclose(sax->file);
+  if (sax->map)
+    munmap(sax->map, sax->map_size);
+  sax->file = NULL;
+  sax->must_close_stream = YFALSE;
+  sax->mem = NULL;
+  sax->map = NULL;
+  sax->map_size = 0;
+  sax->getc_hdlr = NULL;
+  sax->ungetc_hdlr = NULL;
+  sax->read_hdlr = NULL;
+  sax->pos = sax->end = NULL;
+  sax->eof = YFALSE;
+  sax->feeding = YFALSE;
+  sax->feed_len = 0;
+  sax->feed_ended = YFALSE;
+  sax->feed_wait = NULL;
+  sax->feed_scanned = 0;
+  sax->starved = YFALSE;
+  sax->encoding = YENC_UNKNOWN;
+  sax->detected = YFALSE;
+  sax->carry_len = 0;
+  sax->src = sax->src_end = NULL;
+  sax->input_error = YENOERR;
+  sax->error = YENOERR;
+  sax->line_nbr = 1;
+}
+
+/*
+** _ysax_parse_in_place() -- PRIVATE FUNCTION
+** Parse an input which is entirely in memory: UTF-8 data is parsed
+** in place (it is validated first if needed), other encodings are
+** converted block by block.
+*/
+static yerr_t _ysax_parse_in_place(ysax_t *sax, const char *data, size_t len)
+{
+  size_t bom_len;
+  yerr_t res;
+
+  bom_len = _ysax_detect(sax, data, len);
+  data += bom_len;
+  len -= bom_len;
+  if (_YSAX_TRANSCODE(sax))
+    {
+      sax->src = data;
+      sax->src_end = data + len;
+      res = _ysax_parse(sax);
+      sax->src = sax->src_end = NULL;
+      return (res);
+    }
+  if (_YSAX_CHECK_UTF8(sax) &&
+      _ysax_check_utf8(sax, data, data + len) != YENOERR)
+    return (sax->error);
+  if (sax->carry_len)
+    {
+      YLOG_ADD(YLOG_ERR, "Truncated character at the end of data");
+      return ((sax->error = YEILSEQ));
+    }
+  /* the parser never writes into its input */
+  sax->pos = (char*)data;
+  sax->end = (char*)data + len;
+  sax->eof = YTRUE;
+  return (_ysax_parse(sax));
+}
+
+/*
+** _ysax_detect() -- PRIVATE FUNCTION
+** Choose the encoding of the input from its first bytes (unless it was
+** set by ysax_set_encoding()), and return the length of its byte order
+** mark.
+*/
+static size_t _ysax_detect(ysax_t *sax, const char *data, size_t len)
+{
+  size_t bom_len;
+
+  sax->encoding = yenc_detect(data, len, &bom_len);
+  if (sax->input_encoding != YENC_UNKNOWN && sax->input_encoding != sax->encoding)
+    {
+      sax->encoding = sax->input_encoding;
+      bom_len = 0;
+    }
+  if (sax->encoding == YENC_UNKNOWN)
+    YLOG_ADD(YLOG_WARN, "Unsupported encoding, data is not converted");
+  sax->detected = YTRUE;
+  return (bom_len);
+}
+
+/*
+** _ysax_feed_detect() -- PRIVATE FUNCTION
+** Choose the encoding of the data given by ysax_feed() so far, and
+** convert (or validate) this data.
+*/
+static yerr_t _ysax_feed_detect(ysax_t *sax)
+{
+  char *raw;
+  size_t bom_len, size;
+
+  bom_len = _ysax_detect(sax, sax->feed, sax->feed_len);
+  if (!_YSAX_TRANSCODE(sax))
+    {
+      sax->feed_len -= bom_len;
+      memmove(sax->feed, sax->feed + bom_len, sax->feed_len);
+      if (_YSAX_CHECK_UTF8(sax))
+	_ysax_check_utf8(sax, sax->feed, sax->feed + sax->feed_len);
+    }
+  else
+    {
+      for (size = YSAX_BLOCK_SIZE; size < 2 * sax->feed_len; size *= 2)
+	;
+      raw = sax->feed;
+      if (!(sax->feed = YMALLOC_RAW(size)))
+	{
+	  YLOG_ADD(YLOG_ERR, "Unable to allocate memory");
+	  sax->feed = raw;
+	  sax->error = YENOMEM;
+	}
+      else
+	{
+	  sax->feed_size = size;
+	  sax->feed_len = _ysax_decode(sax, raw + bom_len, sax->feed_len - bom_len,
+				       sax->feed);
+	  YFREE(raw);
+	}
+    }
+  if (sax->error != YENOERR)
+    sax->feed_ended = YTRUE;
+  return (sax->error);
+}
+
+/*
+** _ysax_fill() -- PRIVATE FUNCTION
+** Read the next block of the file/stream/handler, and return
+** its first character (or EOF).
+*/
+static int _ysax_fill(ysax_t *sax)
+{
+  size_t len;
+
+  if (sax->eof)
+    {
+      if (sax->feeding)
+	sax->starved = YTRUE;
+      return (EOF);
+    }
+  if (!sax->block && !(sax->block = YMALLOC_RAW(YSAX_BLOCK_SIZE)))
+    {
+      YLOG_ADD(YLOG_ERR, "Unable to allocate memory");
+      sax->error = YENOMEM;
+      sax->eof = YTRUE;
+      return (EOF);
+    }
+  if (sax->src || !sax->detected || _YSAX_TRANSCODE(sax))
+    len = _ysax_read_decoded(sax);
+  else if ((len = _ysax_read(sax, sax->block, YSAX_BLOCK_SIZE)) &&
+	   _YSAX_CHECK_UTF8(sax) &&
+	   _ysax_check_utf8(sax, sax->block, sax->block + len) != YENOERR)
+    len = 0;
+  if (!len)
+    {
+      if (sax->carry_len && sax->error == YENOERR)
+	{
+	  YLOG_ADD(YLOG_ERR, "Truncated character at the end of data");
+	  sax->error = YEILSEQ;
+	}
+      sax->input_error = sax->error;
+      sax->eof = YTRUE;
+      return (EOF);
+    }
+  sax->pos = sax->block;
+  sax->end = sax->block + len;
+  return ((int)(unsigned char)*(sax->pos++));
+}
+
+/*
+** _ysax_read() -- PRIVATE FUNCTION
+** Read the next block of raw data from the file/stream/handler.
+*/
+static size_t _ysax_read(ysax_t *sax, char *block, size_t size)
+{
+  size_t len;
+
+  if (sax->read_hdlr)
+    return (sax->read_hdlr(sax->xml_data, block, size));
   if (sax->getc_hdlr)
-    c = sax->getc_hdlr(sax->xml_data);
-  else if (sax->mem)
+    return (_ysax_read_getc(sax, block, size));
+  len = fread(block, 1, size, sax->file);
+  if (len < size && ferror(sax->file))
+    {
+      YLOG_ADD(YLOG_ERR, "Read error");
+      sax->error = YEIO;
+    }
+  return (len);
+}
+
+/*
+** _ysax_read_decoded() -- PRIVATE FUNCTION
+** Fill the block with data converted into UTF-8, taken from the input
+** in memory or read from the file/stream/handler. The encoding is
+** detected from the first bytes read.
+*/
+static size_t _ysax_read_decoded(ysax_t *sax)
+{
+  const char *data;
+  size_t len = 0, raw_len, n;
+
+  if (sax->src)
+    {
+      while (!len && sax->src < sax->src_end && sax->error == YENOERR)
+	{
+	  raw_len = sax->src_end - sax->src;
+	  if (raw_len > _YSAX_RAW_SIZE)
+	    raw_len = _YSAX_RAW_SIZE;
+	  len = _ysax_decode(sax, sax->src, raw_len, sax->block);
+	  sax->src += raw_len;
+	}
+      return (sax->error == YENOERR ? len : 0);
+    }
+  if (!sax->raw && !(sax->raw = YMALLOC_RAW(_YSAX_RAW_SIZE)))
+    {
+      YLOG_ADD(YLOG_ERR, "Unable to allocate memory");
+      sax->error = YENOMEM;
+      return (0);
+    }
+  while (!len && sax->error == YENOERR &&
+	 (raw_len = _ysax_read(sax, sax->raw, _YSAX_RAW_SIZE)))
+    {
+      data = sax->raw;
+      if (!sax->detected)
+	{
+	  while (raw_len < YENC_DETECT_SIZE &&
+		 (n = _ysax_read(sax, sax->raw + raw_len, _YSAX_RAW_SIZE - raw_len)))
+	    raw_len += n;
+	  n = _ysax_detect(sax, data, raw_len);
+	  data += n;
+	  raw_len -= n;
+	}
+      if (_YSAX_TRANSCODE(sax))
+	len = _ysax_decode(sax, data, raw_len, sax->block);
+      else
+	{
+	  /* first block of UTF-8 data, next ones are read directly */
+	  memcpy(sax->block, data, raw_len);
+	  len = raw_len;
+	  if (_YSAX_CHECK_UTF8(sax))
+	    _ysax_check_utf8(sax, sax->block, sax->block + len);
+	}
+    }
+  return (sax->error == YENOERR ? len : 0);
+}
+
+/*
+** _ysax_decode() -- PRIVATE FUNCTION
+** Convert some data into UTF-8, and return the number of bytes written.
+** The bytes of a character cut by the end of the data are kept for the
+** next call.
+*/
+static size_t _ysax_decode(ysax_t *sax, const char *data, size_t len, char *dest)
+{
+  char seq[2 * sizeof(sax->carry)];
+  const char *pt;
+  char *out = dest;
+  size_t n, used;
+
+  if (sax->carry_len)
+    {
+      /* complete the character begun in the previous block */
+      n = sizeof(seq) - sax->carry_len;
+      if (n > len)
+	n = len;
+      memcpy(seq, sax->carry, sax->carry_len);
+      memcpy(seq + sax->carry_len, data, n);
+      pt = seq;
+      if (yenc_to_utf8(sax->encoding, &pt, seq + sax->carry_len + n, &out) != YENOERR)
+	{
+	  YLOG_ADD(YLOG_ERR, "Invalid character");
+	  sax->error = YEILSEQ;
+	  return (out - dest);
+	}
+      if ((used = pt - seq) < sax->carry_len)
+	{
+	  /* still incomplete: all the data was taken */
+	  memmove(sax->carry, pt, sax->carry_len + n - used);
+	  sax->carry_len += n - used;
+	  return (out - dest);
+	}
+      data += used - sax->carry_len;
+      len -= used - sax->carry_len;
+      sax->carry_len = 0;
+    }
+  pt = data;
+  if (yenc_to_utf8(sax->encoding, &pt, data + len, &out) != YENOERR)
+    {
+      YLOG_ADD(YLOG_ERR, "Invalid character");
+      sax->error = YEILSEQ;
+      return (out - dest);
+    }
+  sax->carry_len = data + len - pt;
+  memcpy(sax->carry, pt, sax->carry_len);
+  return (out - dest);
+}
+
+/*
+** _ysax_check_utf8() -- PRIVATE FUNCTION
+** Validate a block of UTF-8 data. The bytes of a sequence cut by the
+** end of the block are kept, to be validated with the next block.
+*/
+static yerr_t _ysax_check_utf8(ysax_t *sax, const char *begin, const char *end)
+{
+  char seq[2 * sizeof(sax->carry)];
+  const char *pt;
+  size_t n;
+
+  if (sax->carry_len)
+    {
+      /* complete the sequence begun in the previous block */
+      n = sizeof(sax->carry) - sax->carry_len;
+      if (n > (size_t)(end - begin))
+	n = end - begin;
+      memcpy(seq, sax->carry, sax->carry_len);
+      memcpy(seq + sax->carry_len, begin, n);
+      if ((pt = yenc_utf8_check(seq, seq + sax->carry_len + n)) == seq)
+	{
+	  if (!yenc_utf8_truncated(seq, seq + sax->carry_len + n))
+	    {
+	      YLOG_ADD(YLOG_ERR, "Invalid UTF-8 sequence");
+	      return ((sax->error = YEILSEQ));
+	    }
+	  memcpy(sax->carry + sax->carry_len, begin, n);
+	  sax->carry_len += n;
+	  return (YENOERR);
+	}
+      begin += (pt - seq) - sax->carry_len;
+      sax->carry_len = 0;
+    }
+  if ((pt = yenc_utf8_check(begin, end)) < end &&
+      end - pt < (int)sizeof(sax->carry) && yenc_utf8_truncated(pt, end))
+    {
+      sax->carry_len = end - pt;
+      memcpy(sax->carry, pt, sax->carry_len);
+      pt = end;
+    }
+  if (pt < end)
     {
-      if (!(c = *(sax->mem)))
+      YLOG_ADD(YLOG_ERR, "Invalid UTF-8 sequence");
+      return ((sax->error = YEILSEQ));
+    }
+  return (YENOERR);
+}
+
+/*
+** _ysax_read_getc() -- PRIVATE FUNCTION
+** Fill a block by calling the getc handler, for parsers created
+** by ysax_read_handler().
+*/
+static size_t _ysax_read_getc(ysax_t *sax, char *block, size_t size)
+{
+  size_t len;
+  char c;
+
+  for (len = 0; len < size && (c = sax->getc_hdlr(sax->xml_data)) != (char)EOF; ++len)
+    block[len] = c;
+  return (len);
+}
+
+/*
+** _ysax_scan() -- PRIVATE FUNCTION
+** Copy characters into a ystring (if not NULL) until one of a set is
+** found, and return this character (or EOF). Whole runs are copied
+** at once. Nul characters are skipped.
+*/
+static int _ysax_scan(ysax_t *sax, ystr_t *str, const yscan_set_t *set)
+{
+  const char *stop;
+
+  for (; ; )
+    {
+      stop = yscan_find(sax->pos, sax->end, set);
+      if (str && stop > sax->pos)
+	ys_ncat(str, sax->pos, stop - sax->pos);
+      sax->pos = (char*)stop;
+      if (stop < sax->end)
+	{
+	  sax->pos++;
+	  if (*stop)
+	    return ((int)(unsigned char)*stop);
+	}
+      else if (_ysax_fill(sax) == EOF)
 	return (EOF);
-      sax->mem++;
+      else
+	_YSAX_UNGETC(sax);
     }
-  else
-    c = (char)fgetc(sax->file);
+}
+
+/*
+** _ysax_scan_in_place() -- PRIVATE FUNCTION
+** Like _ysax_scan(), but when the whole input is in memory and the
+** run doesn't contain any nul character, nothing is copied: the span
+** points to the run in the input. Otherwise, the run is appended to
+** the ystring, and the span gets its length and a NULL pointer.
+*/
+static int _ysax_scan_in_place(ysax_t *sax, ystr_t *str, const yscan_set_t *set,
+			       ysax_span_t *span)
+{
+  const char *stop;
+  size_t offset;
+  int c;
+
+  if (sax->eof && sax->pos < sax->end &&
+      (stop = yscan_find(sax->pos, sax->end, set)) < sax->end && *stop)
+    {
+      span->ptr = sax->pos;
+      span->len = stop - sax->pos;
+      sax->pos = (char*)stop + 1;
+      return ((int)(unsigned char)*stop);
+    }
+  offset = ys_len(*str);
+  c = _ysax_scan(sax, str, set);
+  span->ptr = NULL;
+  span->len = ys_len(*str) - offset;
   return (c);
 }
 
 /*
-** _ysax_ungetc() -- PRIVATE FUNCTION
-** Function called to reput a character in the stream/string
+** _ysax_span() -- PRIVATE FUNCTION
+** Create a span.
 */
-static void _ysax_ungetc(ysax_t *sax, char c)
+static ysax_span_t _ysax_span(const char *ptr, size_t len)
 {
-  if (!sax)
-    return ;
-  if (sax->ungetc_hdlr)
-    sax->ungetc_hdlr(c, sax->xml_data);
-  else if (sax->mem)
-    sax->mem--;
-  else
-    ungetc(c, sax->file);
+  ysax_span_t span;
+
+  span.ptr = ptr;
+  span.len = len;
+  return (span);
+}
+
+/*
+** _ysax_add_span_attr() -- PRIVATE FUNCTION
+** Add an attribute to the current tag. The name is copied into the
+** attribute buffer; the value is already in it (at the given offset)
+** unless its span points into the input.
+*/
+static yerr_t _ysax_add_span_attr(ysax_t *sax, ystr_t name, ysax_span_t value,
+				  size_t value_offset)
+{
+  ysax_span_attr_t *attrs;
+  size_t *offsets, size;
+
+  if (sax->nbr_attrs == sax->attrs_size)
+    {
+      size = sax->attrs_size ? (sax->attrs_size * 2) : 8;
+      if (!(attrs = YMALLOC_RAW(size * sizeof(ysax_span_attr_t))) ||
+	  !(offsets = YMALLOC_RAW(size * 2 * sizeof(size_t))))
+	{
+	  YFREE(attrs);
+	  return (YENOMEM);
+	}
+      if (sax->nbr_attrs)
+	{
+	  memcpy(attrs, sax->attrs, sax->nbr_attrs * sizeof(ysax_span_attr_t));
+	  memcpy(offsets, sax->attr_offsets, sax->nbr_attrs * 2 * sizeof(size_t));
+	}
+      YFREE(sax->attrs);
+      YFREE(sax->attr_offsets);
+      sax->attrs = attrs;
+      sax->attr_offsets = offsets;
+      sax->attrs_size = size;
+    }
+  sax->attr_offsets[sax->nbr_attrs * 2] = ys_len(sax->attr_data);
+  sax->attr_offsets[sax->nbr_attrs * 2 + 1] = value_offset;
+  if (!ys_ncat(&sax->attr_data, name, ys_len(name)))
+    return (YENOMEM);
+  /* pointers into the buffer are set when the tag is complete, since
+     the buffer could be moved until then */
+  sax->attrs[sax->nbr_attrs].name = _ysax_span(NULL, ys_len(name));
+  sax->attrs[sax->nbr_attrs].value = value;
+  sax->nbr_attrs++;
+  return (YENOERR);
+}
+
+/*
+** _ysax_call_open_tag() -- PRIVATE FUNCTION
+** Call the span or string open tag handler, with the attributes of
+** the current tag.
+*/
+static yerr_t _ysax_call_open_tag(ysax_t *sax, ystr_t name)
+{
+  yvect_t attrs;
+  size_t i;
+
+  for (i = 0; i < sax->nbr_attrs; i++)
+    {
+      sax->attrs[i].name.ptr = sax->attr_data + sax->attr_offsets[i * 2];
+      if (!sax->attrs[i].value.ptr)
+	sax->attrs[i].value.ptr = sax->attr_data + sax->attr_offsets[i * 2 + 1];
+    }
+  if (sax->span_open_tag_hdlr)
+    sax->span_open_tag_hdlr(sax, _ysax_span(name, ys_len(name)),
+			    sax->attrs, sax->nbr_attrs);
+  else if (sax->open_tag_hdlr)
+    {
+      /* the handler owns the vector: it is sized to the attributes */
+      if (!(attrs = yv_create(sax->nbr_attrs + 1)))
+	{
+	  YLOG_ADD(YLOG_ERR, "Unable to allocate memory");
+	  return (YENOMEM);
+	}
+      for (i = 0; i < sax->nbr_attrs; i++)
+	_ysax_add_attrs(&attrs, ysax_span_dup(sax->attrs[i].name),
+			ysax_span_dup(sax->attrs[i].value));
+      sax->open_tag_hdlr(sax, ys_string(name), attrs);
+    }
+  return (YENOERR);
+}
+
+/*
+** _ysax_call_close_tag() -- PRIVATE FUNCTION
+** Call the span or string close tag handler.
+*/
+static void _ysax_call_close_tag(ysax_t *sax, ystr_t name)
+{
+  if (sax->span_close_tag_hdlr)
+    sax->span_close_tag_hdlr(sax, _ysax_span(name, ys_len(name)));
+  else if (sax->close_tag_hdlr)
+    sax->close_tag_hdlr(sax, ys_string(name));
 }
 
 /*
@@ -320,7 +1370,7 @@ static void _ysax_ungetc(ysax_t *sax, char c)
 */
 static yerr_t _ysax_do_open_tag(ysax_t *sax)
 {
-  char c;
+  int c;
 
   YLOG_MOD("ysax", YLOG_DEBUG, "Entering");
   if (!sax)
@@ -328,13 +1378,13 @@ static yerr_t _ysax_do_open_tag(ysax_t *sax)
       YLOG_ADD(YLOG_WARN, "Bad pointer");
       return (YEUNDEF);
     }
-  if ((c = _ysax_getc(sax)) == EOF)
+  if ((c = _YSAX_GETC(sax)) == EOF)
     return (YENOERR);
   if (c == INTERROG)
     return (_ysax_parse_process_instr(sax));
   else if (c == EXCLAM)
     {
-      if ((c = _ysax_getc(sax)) == EOF)
+      if ((c = _YSAX_GETC(sax)) == EOF)
 	return (YENOERR);
       if (c == MINUS)
 	return (_ysax_parse_comment(sax));
@@ -345,10 +1395,10 @@ static yerr_t _ysax_do_open_tag(ysax_t *sax)
     return (_ysax_parse_close_tag(sax));
   else
     {
-      _ysax_ungetc(sax, c);
+      _YSAX_UNGETC(sax);
       return (_ysax_parse_open_tag(sax));
     }
-  YLOG_ADD(YLOG_ERR, "Syntax error");
+  _YSAX_SYNTAX_ERROR(sax);
   return (YESYNTAX);
 }
 
@@ -381,10 +1431,11 @@ static ysax_attr_t *_ysax_add_attrs(yvect_t *attrs, char *attr_name, char *attr_
 */
 static yerr_t _ysax_parse_open_tag(ysax_t *sax)
 {
-  ystr_t name_buf, attr_name_buf, attr_value_buf;
-  yvect_t attrs;
-  char c;
+  ysax_span_t value;
+  size_t value_offset;
+  int c;
   ybool_t get_name = YTRUE, get_attr_name = YFALSE, get_attr_value = YFALSE;
+  yerr_t res = YESYNTAX;
 
   YLOG_MOD("ysax", YLOG_DEBUG, "Entering");
   if (!sax)
@@ -392,64 +1443,32 @@ static yerr_t _ysax_parse_open_tag(ysax_t *sax)
       YLOG_ADD(YLOG_WARN, "Bad pointer");
       return (YEUNDEF);
     }
-  if (!(name_buf = ys_new("")) || !(attr_name_buf = ys_new("")) ||
-      !(attr_value_buf = ys_new("")) || !(attrs = yv_new()))
-    {
-      YLOG_ADD(YLOG_ERR, "Unable to allocate memory");
-      return (YENOMEM);
-    }
-  while ((c = _ysax_getc(sax)) != EOF)
+  ys_trunc(sax->name_buf);
+  ys_trunc(sax->attr_name_buf);
+  ys_trunc(sax->attr_data);
+  sax->nbr_attrs = 0;
+  while ((c = _YSAX_GETC(sax)) != EOF)
     {
       if (!IS_SPACE(c))
 	{
 	  if (c == LT)
-	    {
-	      ys_del(&name_buf);
-	      ys_del(&attr_name_buf);
-	      ys_del(&attr_value_buf);
-	      yv_del(&attrs, ysax_free_attr, NULL);
-	      YLOG_ADD(YLOG_ERR, "Syntax error");
-	      return (YESYNTAX);
-	    }
+	    break;
 	  else if (c == SLASH)
 	    {
-	      if ((c = _ysax_getc(sax)) == EOF || c != GT)
-		{
-		  ys_del(&name_buf);
-		  ys_del(&attr_name_buf);
-		  ys_del(&attr_value_buf);
-		  yv_del(&attrs, ysax_free_attr, NULL);
-		  YLOG_ADD(YLOG_ERR, "Syntax error");
-		  return (YESYNTAX);
-		}
-	      if (sax->open_tag_hdlr)
-		sax->open_tag_hdlr(sax, ys_string(name_buf), attrs);
-	      if (sax->close_tag_hdlr)
-		sax->close_tag_hdlr(sax, ys_string(name_buf));
-	      ys_del(&name_buf);
-	      ys_del(&attr_name_buf);
-	      ys_del(&attr_value_buf);
+	      if ((c = _YSAX_GETC(sax)) == EOF || c != GT)
+		break;
+	      if ((res = _ysax_call_open_tag(sax, sax->name_buf)) == YENOERR)
+		_ysax_call_close_tag(sax, sax->name_buf);
 	      YLOG_MOD("ysax", YLOG_DEBUG, "Exiting");
-	      return (YENOERR);
+	      return (res);
 	    }
 	  else if (c == GT)
 	    {
-	      if (!ys_len(name_buf))
-		{
-		  ys_del(&name_buf);
-		  ys_del(&attr_name_buf);
-		  ys_del(&attr_value_buf);
-		  yv_del(&attrs, ysax_free_attr, NULL);
-		  YLOG_ADD(YLOG_ERR, "Syntax error");
-		  return (YESYNTAX);
-		}
-	      if (sax->open_tag_hdlr)
-		sax->open_tag_hdlr(sax, ys_string(name_buf), attrs);
-	      ys_del(&name_buf);
-	      ys_del(&attr_name_buf);
-	      ys_del(&attr_value_buf);
+	      if (!ys_len(sax->name_buf))
+		break;
+	      res = _ysax_call_open_tag(sax, sax->name_buf);
 	      YLOG_MOD("ysax", YLOG_DEBUG, "Exiting");
-	      return (YENOERR);
+	      return (res);
 	    }
 	  else if (c == EQ)
 	    {
@@ -457,36 +1476,29 @@ static yerr_t _ysax_parse_open_tag(ysax_t *sax)
 		{
 		  get_attr_name = YFALSE;
 		  get_attr_value = YTRUE;
-		  while ((c = _ysax_getc(sax)) != EOF)
+		  while ((c = _YSAX_GETC(sax)) != EOF)
 		    if (!IS_SPACE(c))
 		      break;
+		  value_offset = ys_len(sax->attr_data);
 		  if (c == QUOTE)
-		    while ((c = _ysax_getc(sax)) != EOF && c != QUOTE)
-		      ys_addc(&attr_value_buf, c);
+		    c = _ysax_scan_in_place(sax, &sax->attr_data,
+					    &_ysax_quote_set, &value);
 		  else if (c == DQUOTE)
-		    while ((c = _ysax_getc(sax)) != EOF && c != DQUOTE)
-		      ys_addc(&attr_value_buf, c);
+		    c = _ysax_scan_in_place(sax, &sax->attr_data,
+					    &_ysax_dquote_set, &value);
 		  else
+		    break;
+		  if (ys_len(sax->attr_name_buf) &&
+		      _ysax_add_span_attr(sax, sax->attr_name_buf, value,
+					  value_offset) != YENOERR)
 		    {
-		      ys_del(&name_buf);
-		      ys_del(&attr_name_buf);
-		      ys_del(&attr_value_buf);
-		      yv_del(&attrs, ysax_free_attr, NULL);
-		      YLOG_ADD(YLOG_ERR, "Syntax error");
-		      return (YESYNTAX);
+		      res = YENOMEM;
+		      break;
 		    }
-		  if (ys_len(attr_name_buf))
-		    _ysax_add_attrs(&attrs, ys_string(attr_name_buf),
-					ys_string(attr_value_buf));
-		  ys_trunc(attr_name_buf);
-		  ys_trunc(attr_value_buf);
+		  ys_trunc(sax->attr_name_buf);
 		}
 	      else
 		{
-		  ys_del(&name_buf);
-		  ys_del(&attr_name_buf);
-		  ys_del(&attr_value_buf);
-		  yv_del(&attrs, ysax_free_attr, NULL);
 		  YLOG_MOD("ysax", YLOG_DEBUG, "Exiting");
 		  return (YENOERR);
 		}
@@ -494,37 +1506,34 @@ static yerr_t _ysax_parse_open_tag(ysax_t *sax)
 	  else
 	    {
 	      if (get_name)
-		ys_addc(&name_buf, c);
+		ys_addc(&sax->name_buf, c);
 	      else if (get_attr_name)
-		ys_addc(&attr_name_buf, c);
+		ys_addc(&sax->attr_name_buf, c);
 	    }
 	}
       else
 	{
 	  if (c == CR)
 	    sax->line_nbr++;
-	  if (ys_len(name_buf) && get_name && !get_attr_name)
+	  if (ys_len(sax->name_buf) && get_name && !get_attr_name)
 	    {
 	      get_name = YFALSE;
 	      get_attr_name = YTRUE;
-	      ys_trunc(attr_name_buf);
-	      ys_trunc(attr_value_buf);
+	      ys_trunc(sax->attr_name_buf);
 	    }
 	  else if (!get_attr_name && get_attr_value)
 	    {
 	      get_attr_name = YTRUE;
 	      get_attr_value = YFALSE;
-	      ys_trunc(attr_name_buf);
-	      ys_trunc(attr_value_buf);
+	      ys_trunc(sax->attr_name_buf);
 	    }
 	}
     }
-  ys_del(&name_buf);
-  ys_del(&attr_name_buf);
-  ys_del(&attr_value_buf);
-  yv_del(&attrs, ysax_free_attr, NULL);
-  YLOG_ADD(YLOG_ERR, "Syntax error");
-  return (YESYNTAX);
+  if (res == YENOMEM)
+    YLOG_ADD(YLOG_ERR, "Unable to allocate memory");
+  else
+    _YSAX_SYNTAX_ERROR(sax);
+  return (res);
 }
 
 /*
@@ -534,9 +1543,8 @@ static yerr_t _ysax_parse_open_tag(ysax_t *sax)
 */
 static yerr_t _ysax_parse_close_tag(ysax_t *sax)
 {
-  ystr_t name_buff;
   ybool_t find_space = YFALSE, find_char = YFALSE;
-  char c;
+  int c;
 
   YLOG_MOD("ysax", YLOG_DEBUG, "Entering");
   if (!sax)
@@ -544,12 +1552,8 @@ static yerr_t _ysax_parse_close_tag(ysax_t *sax)
       YLOG_ADD(YLOG_WARN, "Bad pointer");
       return (YEUNDEF);
     }
-  if (!(name_buff = ys_new("")))
-    {
-      YLOG_ADD(YLOG_ERR, "Unable to allocate memory");
-      return (YENOMEM);
-    }
-  while ((c = _ysax_getc(sax)) != EOF)
+  ys_trunc(sax->name_buf);
+  while ((c = _YSAX_GETC(sax)) != EOF)
     {
       if (IS_SPACE(c))
 	{
@@ -558,15 +1562,10 @@ static yerr_t _ysax_parse_close_tag(ysax_t *sax)
 	  find_space = YTRUE;
 	}
       else if (c == LT)
-	{
-	  ys_del(&name_buff);
-	  return (YESYNTAX);
-	}
+	return (YESYNTAX);
       else if (c == GT)
 	{
-	  if (sax->close_tag_hdlr)
-	    sax->close_tag_hdlr(sax, ys_string(name_buff));
-	  ys_del(&name_buff);
+	  _ysax_call_close_tag(sax, sax->name_buf);
 	  YLOG_MOD("ysax", YLOG_DEBUG, "Exiting");
 	  return (YENOERR);
 	}
@@ -574,16 +1573,14 @@ static yerr_t _ysax_parse_close_tag(ysax_t *sax)
 	{
 	  if (find_char && find_space)
 	    {
-	      ys_del(&name_buff);
-	      YLOG_ADD(YLOG_ERR, "Syntax error");
+	      _YSAX_SYNTAX_ERROR(sax);
 	      return (YESYNTAX);
 	    }
 	  find_char = YTRUE;
-	  ys_addc(&name_buff, c);
+	  ys_addc(&sax->name_buf, c);
 	}
     }
-  ys_del(&name_buff);
-  YLOG_ADD(YLOG_ERR, "Syntax error");
+  _YSAX_SYNTAX_ERROR(sax);
   return (YESYNTAX);
 }
 
@@ -594,8 +1591,7 @@ static yerr_t _ysax_parse_close_tag(ysax_t *sax)
 */
 static yerr_t _ysax_parse_comment(ysax_t *sax)
 {
-  char c, next = EOF;
-  ystr_t s;
+  int c, next = EOF;
 
   YLOG_MOD("ysax", YLOG_DEBUG, "Entering");
   if (!sax)
@@ -603,37 +1599,29 @@ static yerr_t _ysax_parse_comment(ysax_t *sax)
       YLOG_ADD(YLOG_WARN, "Bad pointer");
       return (YEUNDEF);
     }
-  if (!(s = ys_new("")))
-    {
-      YLOG_ADD(YLOG_ERR, "Unable to allocate memory");
-      return (YENOMEM);
-    }
-  if ((c = _ysax_getc(sax)) == EOF || c != MINUS)
+  ys_trunc(sax->content_buf);
+  if ((c = _YSAX_GETC(sax)) == EOF || c != MINUS)
     {
-      YLOG_ADD(YLOG_ERR, "Syntax error");
+      _YSAX_SYNTAX_ERROR(sax);
       return (YESYNTAX);
     }
-  while ((c = _ysax_getc(sax)) != EOF)
+  while ((c = _ysax_scan(sax, &sax->content_buf, &_ysax_minus_set)) != EOF)
     {
-      if (c != MINUS)
-	ys_addc(&s, c);
-      else if (c == MINUS && (next = _ysax_getc(sax)) != EOF && next == MINUS)
+      if ((next = _YSAX_GETC(sax)) != EOF && next == MINUS)
 	break;
-      else
-	{
-	  ys_addc(&s, c);
-	  ys_addc(&s, next);
-	}
+      ys_addc(&sax->content_buf, c);
+      ys_addc(&sax->content_buf, next);
     }
-  if ((c = _ysax_getc(sax)) == EOF || c != GT)
+  if ((c = _YSAX_GETC(sax)) == EOF || c != GT)
     {
-      ys_del(&s);
-      YLOG_ADD(YLOG_ERR, "Syntax error");
+      _YSAX_SYNTAX_ERROR(sax);
       return (YESYNTAX);
     }
-  if (sax->comment_hdlr)
-    sax->comment_hdlr(sax, ys_string(s));
-  ys_del(&s);
+  if (sax->span_comment_hdlr)
+    sax->span_comment_hdlr(sax, _ysax_span(sax->content_buf,
+					   ys_len(sax->content_buf)));
+  else if (sax->comment_hdlr)
+    sax->comment_hdlr(sax, ys_string(sax->content_buf));
   YLOG_MOD("ysax", YLOG_DEBUG, "Exiting");
   return (YENOERR);
 }
@@ -645,8 +1633,8 @@ static yerr_t _ysax_parse_comment(ysax_t *sax)
 */
 static yerr_t _ysax_parse_process_instr(ysax_t *sax)
 {
-  char c;
-  ystr_t target, content;
+  int c;
+  ysax_span_t span;
 
   YLOG_MOD("ysax", YLOG_DEBUG, "Entering");
   if (!sax)
@@ -654,46 +1642,42 @@ static yerr_t _ysax_parse_process_instr(ysax_t *sax)
       YLOG_ADD(YLOG_WARN, "Bad pointer");
       return (YEUNDEF);
     }
-  if (!(target = ys_new("")))
+  ys_trunc(sax->name_buf);
+  while ((c = _YSAX_GETC(sax)) != EOF && c != INTERROG && !IS_SPACE(c))
+    ys_addc(&sax->name_buf, c);
+  if (c == INTERROG && (c = _YSAX_GETC(sax)) != EOF && c == GT)
     {
-      YLOG_ADD(YLOG_ERR, "Unable to allocate memory");
-      return (YENOMEM);
-    }
-  while ((c = _ysax_getc(sax)) != EOF && c != INTERROG && !IS_SPACE(c))
-    ys_addc(&target, c);
-  if (c == INTERROG && (c = _ysax_getc(sax)) != EOF && c == GT)
-    {
-      if (sax->process_instr_hdlr)
-	sax->process_instr_hdlr(sax, ys_string(target), NULL);
-      ys_del(&target);
+      if (sax->span_process_instr_hdlr)
+	sax->span_process_instr_hdlr(sax, _ysax_span(sax->name_buf,
+						     ys_len(sax->name_buf)),
+				     _ysax_span(NULL, 0));
+      else if (sax->process_instr_hdlr)
+	sax->process_instr_hdlr(sax, ys_string(sax->name_buf), NULL);
       YLOG_MOD("ysax", YLOG_DEBUG, "Exiting");
       return (YENOERR);
     }
-  if (!(content = ys_new("")))
-    {
-      YLOG_ADD(YLOG_ERR, "Unable to allocate memory");
-      return (YENOMEM);
-    }
-  while ((c = _ysax_getc(sax)) != EOF && c != INTERROG)
-    ys_addc(&content, c);
+  ys_trunc(sax->content_buf);
+  c = _ysax_scan_in_place(sax, &sax->content_buf, &_ysax_interrog_set,
+			  &span);
   if (c == EOF)
     {
-      ys_del(&target);
-      ys_del(&content);
-      YLOG_ADD(YLOG_ERR, "Syntax error");
+      _YSAX_SYNTAX_ERROR(sax);
       return (YESYNTAX);
     }
-  if ((c = _ysax_getc(sax)) == EOF || c != GT)
+  if ((c = _YSAX_GETC(sax)) == EOF || c != GT)
     {
-      ys_del(&target);
-      ys_del(&content);
-      YLOG_ADD(YLOG_ERR, "Syntax error");
+      _YSAX_SYNTAX_ERROR(sax);
       return (YESYNTAX);
     }
-  if (sax->process_instr_hdlr)
-    sax->process_instr_hdlr(sax, ys_string(target), ys_string(content));
-  ys_del(&target);
-  ys_del(&content);
+  if (sax->span_process_instr_hdlr)
+    sax->span_process_instr_hdlr(sax, _ysax_span(sax->name_buf,
+						 ys_len(sax->name_buf)),
+				 _ysax_span(span.ptr ? span.ptr :
+					    sax->content_buf, span.len));
+  else if (sax->process_instr_hdlr)
+    sax->process_instr_hdlr(sax, ys_string(sax->name_buf),
+			    span.ptr ? ysax_span_dup(span) :
+			    ys_string(sax->content_buf));
   YLOG_MOD("ysax", YLOG_DEBUG, "Exiting");
   return (YENOERR);
 }
@@ -705,10 +1689,10 @@ static yerr_t _ysax_parse_process_instr(ysax_t *sax)
 */
 static yerr_t _ysax_parse_cdata(ysax_t *sax)
 {
-  char c;
+  int c;
   char *pt;
   unsigned int i;
-  ystr_t content;
+  ysax_span_t span;
 	
   YLOG_MOD("ysax", YLOG_DEBUG, "Entering");
   if (!sax)
@@ -719,34 +1703,32 @@ static yerr_t _ysax_parse_cdata(ysax_t *sax)
   pt = CDATA;
   for (i = 0; i < strlen(CDATA); i++)
     {
-      if ((c = _ysax_getc(sax)) == EOF || c != *(pt + i))
+      if ((c = _YSAX_GETC(sax)) == EOF || c != *(pt + i))
 	{
-	  YLOG_ADD(YLOG_ERR, "Syntax error");
+	  _YSAX_SYNTAX_ERROR(sax);
 	  return (YESYNTAX);
 	}
     }
-  if ((c = _ysax_getc(sax)) == EOF || c != LBRACKET)
+  if ((c = _YSAX_GETC(sax)) == EOF || c != LBRACKET)
     {
-      YLOG_ADD(YLOG_ERR, "Syntax error");
+      _YSAX_SYNTAX_ERROR(sax);
       return (YESYNTAX);
     }
-  if (!(content = ys_new("")))
-    {
-      YLOG_ADD(YLOG_ERR, "Unable to allocate memory");
-      return (YENOMEM);
-    }
-  while ((c = _ysax_getc(sax)) != EOF && c != RBRACKET)
-    ys_addc(&content, c);
-  if ((c = _ysax_getc(sax)) == EOF || c != RBRACKET ||
-      (c = _ysax_getc(sax)) == EOF || c != GT)
+  ys_trunc(sax->content_buf);
+  c = _ysax_scan_in_place(sax, &sax->content_buf, &_ysax_rbracket_set,
+			  &span);
+  if ((c = _YSAX_GETC(sax)) == EOF || c != RBRACKET ||
+      (c = _YSAX_GETC(sax)) == EOF || c != GT)
     {
-      ys_del(&content);
-      YLOG_ADD(YLOG_ERR, "Syntax error");
+      _YSAX_SYNTAX_ERROR(sax);
       return (YESYNTAX);
     }
-  if (sax->cdata_hdlr)
-    sax->cdata_hdlr(sax, ys_string(content));
-  ys_del(&content);
+  if (sax->span_cdata_hdlr)
+    sax->span_cdata_hdlr(sax, _ysax_span(span.ptr ? span.ptr :
+					 sax->content_buf, span.len));
+  else if (sax->cdata_hdlr)
+    sax->cdata_hdlr(sax, span.ptr ? ysax_span_dup(span) :
+		    ys_string(sax->content_buf));
   YLOG_MOD("ysax", YLOG_DEBUG, "Exiting");
   return (YENOERR);
 }
@@ -59,10 +59,29 @@
  *		<li>A string which contains the CDATA content</li>
  *		</ul><p /></li>
  *		</ul>
+ *		Each handler also exists in a span version (set with
+ *		ysax_set_span_tag_hdlr(), ysax_set_span_inside_text_hdlr(), ...),
+ *		which receives ysax_span_t (pointer and length) instead of
+ *		allocated strings. Spans are only valid during the call; use
+ *		ysax_span_dup() to keep a copy. When the whole input is in
+ *		memory (ysax_read_memory(), or a mapped file), attribute values,
+ *		CDATA sections and processing instructions point directly into
+ *		it.<p />
  *		To launch the parser execution, you just have to call:
  *		<pre>ysax_parse(sax);</pre>
+ *		Data which arrives progressively (from a non-blocking socket,
+ *		for example) could be pushed with ysax_feed(), which returns
+ *		YEAGAIN until the parsing is over, and ysax_finish(); many
+ *		documents could then be parsed by the same thread.<p />
  *		This function return YENOERR if all is OK. It read the XML file, and call
- *		the handlers.<p />
+ *		the handlers. Files, streams and read handlers are read by blocks of
+ *		YSAX_BLOCK_SIZE characters.<p />
+ *		The encoding of the input is detected from its byte order mark
+ *		or its XML declaration (see yenc.h), or set with
+ *		ysax_set_encoding(). ISO-8859-1 and UTF-16 data is converted
+ *		into UTF-8 block by block, while it is parsed: handlers always
+ *		receive UTF-8. UTF-8 input could be validated the same way,
+ *		with ysax_set_utf8_check().<p />
  *		If an error is detected in a handler, you could stop the parsing be calling
  *		this function (and then the ysax_parse() function will return an YEL2HLT
  *		error):
@@ -84,10 +103,14 @@ extern "C" {
 #include "ystr.h"
 #include "yvect.h"
 #include "yerror.h"
+#include "yenc.h"
 
 /*! @define YSAX_DATA Rpovide direct access to SAX parsing data. */
 #define YSAX_DATA(x)	(((ysax_t*)x)->parse_data)
 
+/*! @define YSAX_BLOCK_SIZE Size of the blocks read from files, streams and read handlers. */
+#define YSAX_BLOCK_SIZE	65536
+
 /* XML strings definitions */
 #define	XML			"xml"
 #define	XML_VERSION		"version"
@@ -111,22 +134,110 @@ struct ysax_attr_s
 /*! @typedef ysax_attr_t See struct ysax_attr_s. */
 typedef struct ysax_attr_s ysax_attr_t;
 
+/*!
+ * @struct	ysax_span_s
+ *		A run of characters given to a span handler. It points into
+ *		the parsed data (when the whole input is in memory) or into a
+ *		buffer of the parser, is only valid during the call of the
+ *		handler, and is not nul-terminated.
+ * @field	ptr	Pointer to the first character.
+ * @field	len	Number of characters.
+ */
+struct ysax_span_s
+{
+  const char *ptr;
+  size_t len;
+};
+
+/*! @typedef ysax_span_t See struct ysax_span_s. */
+typedef struct ysax_span_s ysax_span_t;
+
+/*!
+ * @struct	ysax_span_attr_s
+ *		XML attribute given to a span open tag handler.
+ * @field	name	Attribute's name.
+ * @field	value	Attribute's value.
+ */
+struct ysax_span_attr_s
+{
+  ysax_span_t name;
+  ysax_span_t value;
+};
+
+/*! @typedef ysax_span_attr_t See struct ysax_span_attr_s. */
+typedef struct ysax_span_attr_s ysax_span_attr_t;
+
 /*!
  * @struct	ysax_s
  *		Object for SAX XML parser.
  * @field	file			Stream of the XML file
  * @field	file_mode		Set to TRUE if the file must be close.
  * @field	mem			Pointer to character string to parse.
- * @field	getc_hdlr		Function pointer to get data.
- * @field	ungetc_hdlr		Function pointer to unget data.
- * @field	xml_data		Pointer to data used by getc/ungetc handlers.
+ * @field	map			Mapping of the XML file, when it is parsed in place.
+ * @field	map_size		Size of the mapping.
+ * @field	getc_hdlr		Function pointer to get data (legacy interface).
+ * @field	ungetc_hdlr		Function pointer to unget data (not used any more).
+ * @field	read_hdlr		Function pointer to read a block of data.
+ * @field	xml_data		Pointer to data used by read/getc handlers.
  * @field	parse_data		Pointer to some data (for handlers using).
+ * @field	block			Buffer which receives the blocks of data.
+ * @field	pos			Next character to parse.
+ * @field	end			End of the current block.
+ * @field	eof			Set to TRUE when there is no more block to read.
+ * @field	feed			Data given to ysax_feed() and not parsed yet.
+ * @field	feed_len		Length of this data.
+ * @field	feed_size		Allocated size of the feed buffer.
+ * @field	feeding			Set to TRUE between the first call of
+ *					ysax_feed() and the call of ysax_finish().
+ * @field	feed_ended		Set to TRUE when the parsing of fed data is over.
+ * @field	feed_wait		End delimiter of the comment, CDATA section
+ *					or processing instruction which starts the
+ *					fed data, or NULL.
+ * @field	feed_scanned		Offset in the fed data up to which this
+ *					delimiter was searched.
+ * @field	starved			Set to TRUE when fed data is missing to end
+ *					the current tag.
+ * @field	checkpoint		Position after the last complete tag.
+ * @field	checkpoint_line		Line number at this position.
+ * @field	input_encoding		Encoding set by ysax_set_encoding(), or
+ *					YENC_UNKNOWN to detect it.
+ * @field	encoding		Encoding of the current input.
+ * @field	detected		Set to TRUE when the encoding of the
+ *					current input is known.
+ * @field	check_utf8		Set to TRUE to validate UTF-8 input.
+ * @field	carry			Bytes of a character cut by the end of
+ *					the previous block.
+ * @field	carry_len		Number of these bytes.
+ * @field	raw			Buffer which receives the blocks of data
+ *					to convert.
+ * @field	src			Input in memory which is converted block
+ *					by block.
+ * @field	src_end			End of this input.
  * @field	open_tag_hdlr		Function pointer to call when an open tag is finded.
  * @field	inside_text_hdlr	Function pointer for text inside tags.
  * @field	close_tag_hdlr		Function pointer for close tags.
  * @field	comment_hdlr		Function pointer for XML comments.
  * @field	process_instr_hdlr	Function pointer for processing instructions.
  * @field	cdata_hdlr		Function pointer for CDATA instructions.
+ * @field	span_open_tag_hdlr	Span handler for open tags.
+ * @field	span_inside_text_hdlr	Span handler for text inside tags.
+ * @field	span_close_tag_hdlr	Span handler for close tags.
+ * @field	span_comment_hdlr	Span handler for XML comments.
+ * @field	span_process_instr_hdlr	Span handler for processing instructions.
+ * @field	span_cdata_hdlr		Span handler for CDATA instructions.
+ * @field	text_buf		Buffer of the current text.
+ * @field	name_buf		Buffer of the current tag name (or
+ *					processing instruction target).
+ * @field	attr_name_buf		Buffer of the current attribute name.
+ * @field	content_buf		Buffer of the current comment, CDATA
+ *					section or processing instruction.
+ * @field	attr_data		Buffer of the names and values of the
+ *					attributes of the current tag.
+ * @field	attrs			Attributes of the current tag.
+ * @field	attr_offsets		Offsets of the names and values in attr_data.
+ * @field	nbr_attrs		Number of attributes of the current tag.
+ * @field	attrs_size		Allocated size of attrs and attr_offsets.
+ * @field	input_error		Error which ended the input, if any.
  * @field	error			Current status of SAX parsing.
  * @field	line_nbr		Current line of the file parsing.
  */
@@ -135,16 +246,59 @@ struct ysax_s
   FILE *file;
   ybool_t must_close_stream;
   char *mem;
+  char *map;
+  size_t map_size;
   char (*getc_hdlr)(void*);
   void (*ungetc_hdlr)(char, void*);
+  size_t (*read_hdlr)(void*, char*, size_t);
   void *xml_data;
   void *parse_data;
+  char *block;
+  char *pos;
+  char *end;
+  ybool_t eof;
+  char *feed;
+  size_t feed_len;
+  size_t feed_size;
+  ybool_t feeding;
+  ybool_t feed_ended;
+  const char *feed_wait;
+  size_t feed_scanned;
+  ybool_t starved;
+  char *checkpoint;
+  int checkpoint_line;
+  yenc_t input_encoding;
+  yenc_t encoding;
+  ybool_t detected;
+  ybool_t check_utf8;
+  char carry[4];
+  size_t carry_len;
+  char *raw;
+  const char *src;
+  const char *src_end;
   void (*open_tag_hdlr)(struct ysax_s*, char*, yvect_t);
   void (*inside_text_hdlr)(struct ysax_s*, char*);
   void (*close_tag_hdlr)(struct ysax_s*, char*);
   void (*comment_hdlr)(struct ysax_s*, char*);
   void (*process_instr_hdlr)(struct ysax_s*, char*, char*);
   void (*cdata_hdlr)(struct ysax_s*, char*);
+  void (*span_open_tag_hdlr)(struct ysax_s*, ysax_span_t,
+			     const ysax_span_attr_t*, size_t);
+  void (*span_inside_text_hdlr)(struct ysax_s*, ysax_span_t);
+  void (*span_close_tag_hdlr)(struct ysax_s*, ysax_span_t);
+  void (*span_comment_hdlr)(struct ysax_s*, ysax_span_t);
+  void (*span_process_instr_hdlr)(struct ysax_s*, ysax_span_t, ysax_span_t);
+  void (*span_cdata_hdlr)(struct ysax_s*, ysax_span_t);
+  ystr_t text_buf;
+  ystr_t name_buf;
+  ystr_t attr_name_buf;
+  ystr_t content_buf;
+  ystr_t attr_data;
+  ysax_span_attr_t *attrs;
+  size_t *attr_offsets;
+  size_t nbr_attrs;
+  size_t attrs_size;
+  yerr_t input_error;
   yerr_t error;
   int line_nbr;
 };
@@ -163,7 +317,9 @@ ysax_t *ysax_new(void *parse_data);
 /*!
  * @function	ysax_read_handler
  *		Launch the parsing of some XML data, using handlers
- *		to read data.
+ *		to read data. The getc handler is called to fill blocks of
+ *		YSAX_BLOCK_SIZE characters, until it returns EOF; the ungetc
+ *		handler is never called. Prefer ysax_read_block_handler().
  * @param	sax		A pointer to the SAX object.
  * @param	getc_hdlr	Handler called to get one character.
  * @param	ungetc_hdlr	Handler called to unget one character.
@@ -173,9 +329,28 @@ ysax_t *ysax_new(void *parse_data);
 yerr_t ysax_read_handler(ysax_t *sax, char (*getc_hdlr)(void*),
 			 void (*ungetc_hdlr)(char,void*), void *xml_data);
 
+/*!
+ * @function	ysax_read_block_handler
+ *		Launch the parsing of some XML data, using a handler to
+ *		read blocks of data.
+ * @param	sax		A pointer to the SAX object.
+ * @param	read_hdlr	Handler called to read data. It receives
+ *				xml_data, a buffer and its size, and returns the
+ *				number of characters written in the buffer (at
+ *				most the size), or 0 at the end of the data.
+ * @param	xml_data	Pointer to data used by the handler.
+ * @return	An error code that show the return status of parse action.
+ */
+yerr_t ysax_read_block_handler(ysax_t *sax,
+			       size_t (*read_hdlr)(void*, char*, size_t),
+			       void *xml_data);
+
 /*!
  * @function	ysax_read_file
- *		Launch the parsing of an XML file.
+ *		Launch the parsing of an XML file. Regular files are
+ *		mapped in memory (with sequential access advice) and
+ *		parsed in place; other files (pipes, devices) or files
+ *		which can't be mapped are read by blocks.
  * @param	sax		A pointer to the SAX object.
  * @param	filename	Path to the file to parse.
  * @param	An error code that shows the return status of parse action.
@@ -201,6 +376,44 @@ yerr_t ysax_read_stream(ysax_t *sax, FILE *stream);
  */
 yerr_t ysax_read_memory(ysax_t *sax, char *mem);
 
+/*!
+ * @function	ysax_read_buffer
+ *		Launch the parsing of an XML buffer of known length, which
+ *		doesn't need to be nul-terminated.
+ * @param	sax	A pointer to the SAX object.
+ * @param	data	A pointer to the XML data.
+ * @param	len	Length of the data.
+ * @return	An error code that shows the return status of parse action.
+ */
+yerr_t ysax_read_buffer(ysax_t *sax, const char *data, size_t len);
+
+/*!
+ * @function	ysax_feed
+ *		Give a chunk of XML data to the parser, which parses it as
+ *		far as possible and keeps the rest for the next call. The
+ *		data could be cut anywhere; handlers are called as soon as
+ *		each tag, text, comment, ... is complete. The first call
+ *		starts a new parsing.
+ * @param	sax	A pointer to the SAX object.
+ * @param	data	The chunk of data (copied by the parser).
+ * @param	len	Length of the chunk.
+ * @return	YEAGAIN once the chunk is parsed: more data is expected
+ *		until ysax_finish() is called, even after the end of the
+ *		root element. YENOERR if the parsing stopped on a '&gt;'
+ *		outside of any tag, or an error code; then the next calls
+ *		return the same status without parsing anything.
+ */
+yerr_t ysax_feed(ysax_t *sax, const char *data, size_t len);
+
+/*!
+ * @function	ysax_finish
+ *		Tell the parser that all data was given by ysax_feed(), and
+ *		parse what remains.
+ * @param	sax	A pointer to the SAX object.
+ * @return	An error code that shows the return status of parse action.
+ */
+yerr_t ysax_finish(ysax_t *sax);
+
 /*!
  * @function	ysax_del
  *		Delete a previously created Sax XML parser.
@@ -208,6 +421,35 @@ yerr_t ysax_read_memory(ysax_t *sax, char *mem);
  */
 void ysax_del(ysax_t *sax);
 
+/*!
+ * @function	ysax_set_encoding
+ *		Set the encoding of the next inputs of the parser, when their
+ *		byte order mark and XML declaration are missing or wrong.
+ * @param	sax	A pointer to the Sax parser.
+ * @param	enc	The encoding, or YENC_UNKNOWN to detect it (default).
+ */
+void ysax_set_encoding(ysax_t *sax, yenc_t enc);
+
+/*!
+ * @function	ysax_get_encoding
+ *		Return the encoding of the current (or last) input of the
+ *		parser, before its conversion into UTF-8.
+ * @param	sax	A pointer to the Sax parser.
+ * @return	The encoding; YENC_UNKNOWN if it is not supported (data
+ *		is then given as is).
+ */
+yenc_t ysax_get_encoding(ysax_t *sax);
+
+/*!
+ * @function	ysax_set_utf8_check
+ *		Ask the parser to validate UTF-8 input. The parsing stops with
+ *		a YEILSEQ error at the first invalid sequence. Without it,
+ *		bytes are given to the handlers as they are.
+ * @param	sax	A pointer to the Sax parser.
+ * @param	check	YTRUE to validate UTF-8 input.
+ */
+void ysax_set_utf8_check(ysax_t *sax, ybool_t check);
+
 /*!
  * @function	ysax_set_tag_hdlr
  *		Set the open tag and close tag handlers of the Sax XML parser.
@@ -261,6 +503,82 @@ void ysax_set_process_instr_hdlr(ysax_t *sax,
 void ysax_set_cdata_hdlr(ysax_t *sax,
 			 void (*hdlr)(ysax_t*, char*));
 
+/*!
+ * @function	ysax_set_span_tag_hdlr
+ *		Set the span handlers for open and close tags. When a span
+ *		handler is set, it is called instead of the corresponding
+ *		string handler, and no string is allocated for it.
+ * @param	sax		A pointer to the Sax parser.
+ * @param	open_hdlr	Handler called when an open tag is found. It
+ *				receives the name of the tag, an array of
+ *				attributes and the number of attributes.
+ * @param	close_hdlr	Handler called when a close tag is found.
+ */
+void ysax_set_span_tag_hdlr(ysax_t *sax,
+			    void (*open_hdlr)(ysax_t*, ysax_span_t,
+					      const ysax_span_attr_t*, size_t),
+			    void (*close_hdlr)(ysax_t*, ysax_span_t));
+
+/*!
+ * @function	ysax_set_span_inside_text_hdlr
+ *		Set the span handler for text inside tags.
+ * @param	sax	A pointer to the Sax parser.
+ * @param	hdlr	Handler called when some text is found between
+ *			an open and a close tag.
+ */
+void ysax_set_span_inside_text_hdlr(ysax_t *sax,
+				    void (*hdlr)(ysax_t*, ysax_span_t));
+
+/*!
+ * @function	ysax_set_span_comment_hdlr
+ *		Set the span handler for XML comments.
+ * @param	sax	A pointer to the Sax parser.
+ * @param	hdlr	Handler called when an XML comment is found.
+ */
+void ysax_set_span_comment_hdlr(ysax_t *sax,
+				void (*hdlr)(ysax_t*, ysax_span_t));
+
+/*!
+ * @function	ysax_set_span_process_instr_hdlr
+ *		Set the span handler for processing instructions.
+ * @param	sax	A pointer to the Sax parser.
+ * @param	hdlr	Handler called when a processing instruction is
+ *			found. It receives the target and the content (with
+ *			a NULL pointer if there is no content).
+ */
+void ysax_set_span_process_instr_hdlr(ysax_t *sax,
+				      void (*hdlr)(ysax_t*, ysax_span_t,
+						   ysax_span_t));
+
+/*!
+ * @function	ysax_set_span_cdata_hdlr
+ *		Set the span handler for CDATA sections.
+ * @param	sax	A pointer to the Sax parser.
+ * @param	hdlr	Handler called when a CDATA section is found.
+ */
+void ysax_set_span_cdata_hdlr(ysax_t *sax,
+			      void (*hdlr)(ysax_t*, ysax_span_t));
+
+/*!
+ * @function	ysax_span_dup
+ *		Copy a span into a new nul-terminated string, to keep it
+ *		after the call of a span handler.
+ * @param	span	The span.
+ * @return	The string (to be freed with free0()), or NULL if an
+ *		error occurs.
+ */
+char *ysax_span_dup(ysax_span_t span);
+
+/*!
+ * @function	ysax_span_cmp
+ *		Compare a span with a nul-terminated string.
+ * @param	span	The span.
+ * @param	str	The string.
+ * @return	An integer less than, equal to, or greater than zero,
+ *		like strcmp().
+ */
+int ysax_span_cmp(ysax_span_t span, const char *str);
+
 /*!
  * @function	ysax_stop
  *		Stop the Sax parser. Use this function if you detect an
@@ -274,7 +592,8 @@ void ysax_stop(ysax_t *sax);
  * @function	ysax_free_attr
  *		When a yvector of XML attributes is destroyed, this function
  *		can be passed as parameter to yv_del() to free all memory
- *		allocated for each element.
+ *		allocated for each element. Attributes and their name and value
+ *		are allocated on the heap.
  * @param	e	Pointer to the vector element (= ysax_attr_t*).
  * @param	data	Non used pointer, here for prototype compatibility.
  */
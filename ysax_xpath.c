@@ -0,0 +1,500 @@
+#define YMEM_TAG	YMEM_TAG_SAX
+
+#include <string.h>
+#include <limits.h>
+#include "ysax_xpath.h"
+
+/** @define _YSAX_XPATH_BITS Number of states in a word of a state set. */
+#define _YSAX_XPATH_BITS	(sizeof(unsigned long) * CHAR_BIT)
+
+/** @define _YSAX_XPATH_IS_SET Tell if a state belongs to a state set. */
+#define _YSAX_XPATH_IS_SET(set, i)	((set)[(i) / _YSAX_XPATH_BITS] & \
+					 (1UL << ((i) % _YSAX_XPATH_BITS)))
+
+/** @define _YSAX_XPATH_SET Add a state to a state set. */
+#define _YSAX_XPATH_SET(set, i)		((set)[(i) / _YSAX_XPATH_BITS] |= \
+					 (1UL << ((i) % _YSAX_XPATH_BITS)))
+
+/**
+ * @typedef	_ysax_xpath_pred_t
+ *		Predicate on an attribute.
+ * @field	attr	Name of the attribute.
+ * @field	value	Value to compare with, or NULL to check the
+ *			presence of the attribute.
+ * @field	negate	YTRUE if the value must be different.
+ * @field	next	Next predicate of the step.
+ */
+typedef struct _ysax_xpath_pred_s {
+	char				*attr;
+	char				*value;
+	ybool_t				negate;
+	struct _ysax_xpath_pred_s	*next;
+} _ysax_xpath_pred_t;
+
+/**
+ * @typedef	_ysax_xpath_step_t
+ *		Step of an expression, which matches an element.
+ * @field	descendant	YTRUE for the descendant axis ('//').
+ * @field	name		Name of the element, or NULL for any element.
+ * @field	preds		Predicates.
+ */
+typedef struct _ysax_xpath_step_s {
+	ybool_t			descendant;
+	char			*name;
+	_ysax_xpath_pred_t	*preds;
+} _ysax_xpath_step_t;
+
+/**
+ * @typedef	_ysax_xpath_expr_t
+ *		Compiled expression. The state 'first_state + k' of the
+ *		matcher means that the k first steps of the expression
+ *		matched the ancestors of the current element.
+ * @field	steps		Element steps.
+ * @field	nbr_steps	Number of element steps.
+ * @field	attr		Name of the selected attributes ("*" for all of
+ *				them), or NULL if the expression selects elements.
+ * @field	attr_self	YTRUE if the last step is the descendant step of
+ *				'//@attr', which selects the attributes of the
+ *				element matched by the previous step too.
+ * @field	first_state	First state of the expression.
+ * @field	hdlr		Handler of the matches.
+ * @field	data		Pointer given to the handler.
+ */
+typedef struct _ysax_xpath_expr_s {
+	_ysax_xpath_step_t	*steps;
+	size_t			nbr_steps;
+	char			*attr;
+	ybool_t			attr_self;
+	size_t			first_state;
+	ysax_xpath_hdlr_t	hdlr;
+	void			*data;
+} _ysax_xpath_expr_t;
+
+/**
+ * @typedef	_ysax_xpath_capture_t
+ *		Element selected by an expression, whose text is gathered
+ *		until its close tag.
+ * @field	expr	Index of the expression.
+ * @field	depth	Depth of the element.
+ * @field	offset	Offset of its text in the text buffer.
+ */
+typedef struct _ysax_xpath_capture_s {
+	size_t	expr;
+	size_t	depth;
+	size_t	offset;
+} _ysax_xpath_capture_t;
+
+/**
+ * @struct	ysax_xpath_s
+ *		Streaming XPath matcher.
+ * @field	sax		SAX parser.
+ * @field	exprs		Compiled expressions.
+ * @field	nbr_exprs	Number of expressions.
+ * @field	nbr_states	Number of states of all the expressions.
+ * @field	nbr_words	Number of words of a state set.
+ * @field	sets		Stack of state sets, one per open element
+ *				(plus one for the document).
+ * @field	sets_size	Number of sets the stack can hold.
+ * @field	depth		Number of open elements.
+ * @field	captures	Stack of selected elements.
+ * @field	nbr_captures	Number of selected elements.
+ * @field	captures_size	Number of selected elements the stack can hold.
+ * @field	text		Text of the selected elements.
+ */
+struct ysax_xpath_s {
+	ysax_t			*sax;
+	_ysax_xpath_expr_t	*exprs;
+	size_t			nbr_exprs;
+	size_t			nbr_states;
+	size_t			nbr_words;
+	unsigned long		*sets;
+	size_t			sets_size;
+	size_t			depth;
+	_ysax_xpath_capture_t	*captures;
+	size_t			nbr_captures;
+	size_t			captures_size;
+	ystr_t			text;
+};
+
+/* *** definition of private functions *** */
+static void _ysax_xpath_open_hdlr(ysax_t *sax, ysax_span_t name, const ysax_span_attr_t *attrs,
+				  size_t nbr_attrs);
+static void _ysax_xpath_close_hdlr(ysax_t *sax, ysax_span_t name);
+static void _ysax_xpath_text_hdlr(ysax_t *sax, ysax_span_t text);
+static ybool_t _ysax_xpath_match(const _ysax_xpath_step_t *step, ysax_span_t name,
+				 const ysax_span_attr_t *attrs, size_t nbr_attrs);
+static const ysax_span_attr_t *_ysax_xpath_get_attr(const char *attr_name, const ysax_span_attr_t *attrs,
+						    size_t nbr_attrs);
+static yerr_t _ysax_xpath_compile(_ysax_xpath_expr_t *expr, const char *pt);
+static char *_ysax_xpath_name(const char **pt);
+static void _ysax_xpath_free_expr(_ysax_xpath_expr_t *expr);
+
+/*
+ * ysax_xpath_new()
+ * Create a streaming XPath matcher.
+ */
+ysax_xpath_t *ysax_xpath_new() {
+	ysax_xpath_t	*xp;
+
+	if ((xp = YMALLOC(sizeof(ysax_xpath_t))) == NULL)
+		return (NULL);
+	if ((xp->sax = ysax_new(xp)) == NULL || (xp->text = ys_new("")) == NULL) {
+		ysax_del(xp->sax);
+		YFREE(xp);
+		return (NULL);
+	}
+	ysax_set_span_tag_hdlr(xp->sax, _ysax_xpath_open_hdlr, _ysax_xpath_close_hdlr);
+	ysax_set_span_inside_text_hdlr(xp->sax, _ysax_xpath_text_hdlr);
+	ysax_set_span_cdata_hdlr(xp->sax, _ysax_xpath_text_hdlr);
+	return (xp);
+}
+
+/*
+ * ysax_xpath_del()
+ * Delete a streaming XPath matcher.
+ */
+void ysax_xpath_del(ysax_xpath_t *xp) {
+	size_t	i;
+
+	if (xp == NULL)
+		return;
+	for (i = 0; i < xp->nbr_exprs; i++)
+		_ysax_xpath_free_expr(&xp->exprs[i]);
+	YFREE(xp->exprs);
+	YFREE(xp->sets);
+	YFREE(xp->captures);
+	ys_del(&xp->text);
+	ysax_del(xp->sax);
+	YFREE(xp);
+}
+
+/*
+ * ysax_xpath_add()
+ * Compile an expression and add it to a matcher.
+ */
+yerr_t ysax_xpath_add(ysax_xpath_t *xp, const char *expr, ysax_xpath_hdlr_t hdlr, void *data) {
+	_ysax_xpath_expr_t	*new_expr;
+	size_t			size;
+	yerr_t			res;
+
+	if (xp == NULL || expr == NULL || hdlr == NULL)
+		return (YEINVAL);
+	size = xp->nbr_exprs;
+	if ((new_expr = ygrow(xp->exprs, &size, sizeof(_ysax_xpath_expr_t),
+			      xp->nbr_exprs, 4)) == NULL)
+		return (YENOMEM);
+	xp->exprs = new_expr;
+	new_expr += xp->nbr_exprs;
+	memset(new_expr, 0, sizeof(_ysax_xpath_expr_t));
+	if ((res = _ysax_xpath_compile(new_expr, expr)) != YENOERR) {
+		_ysax_xpath_free_expr(new_expr);
+		return (res);
+	}
+	new_expr->first_state = xp->nbr_states;
+	new_expr->hdlr = hdlr;
+	new_expr->data = data;
+	xp->nbr_exprs++;
+	xp->nbr_states += new_expr->nbr_steps;
+	/* the state sets get bigger */
+	xp->nbr_words = (xp->nbr_states + _YSAX_XPATH_BITS - 1) / _YSAX_XPATH_BITS;
+	YFREE(xp->sets);
+	xp->sets_size = 0;
+	return (YENOERR);
+}
+
+/*
+ * ysax_xpath_get_sax()
+ * Return the SAX parser of a matcher, and reset the matcher.
+ */
+ysax_t *ysax_xpath_get_sax(ysax_xpath_t *xp) {
+	if (xp == NULL)
+		return (NULL);
+	/* forget what an interrupted parsing left */
+	xp->depth = 0;
+	xp->nbr_captures = 0;
+	ys_trunc(xp->text);
+	return (xp->sax);
+}
+
+/* *************** PRIVATE FUNCTIONS ************** */
+/*
+ * _ysax_xpath_open_hdlr()
+ * Compute the states of an element from the states of its parent, and
+ * handle the expressions it completes.
+ */
+static void _ysax_xpath_open_hdlr(ysax_t *sax, ysax_span_t name, const ysax_span_attr_t *attrs,
+				  size_t nbr_attrs) {
+	ysax_xpath_t		*xp = YSAX_DATA(sax);
+	_ysax_xpath_expr_t	*expr;
+	_ysax_xpath_capture_t	*capture;
+	unsigned long		*parent, *set, *sets;
+	size_t			e, k, i, size;
+	ybool_t			selected;
+
+	if (xp->depth + 2 > xp->sets_size) {
+		size = xp->sets_size;
+		if ((sets = ygrow(xp->sets, &size, xp->nbr_words * sizeof(unsigned long),
+				  xp->depth + 1, 4)) == NULL) {
+			ysax_stop(sax);
+			return;
+		}
+		xp->sets = sets;
+		xp->sets_size = size;
+	}
+	parent = xp->sets + xp->depth * xp->nbr_words;
+	set = parent + xp->nbr_words;
+	if (xp->depth == 0) {
+		/* new document: only the first steps are expected */
+		memset(parent, 0, xp->nbr_words * sizeof(unsigned long));
+		for (e = 0; e < xp->nbr_exprs; e++)
+			_YSAX_XPATH_SET(parent, xp->exprs[e].first_state);
+		xp->nbr_captures = 0;
+		ys_trunc(xp->text);
+	}
+	memset(set, 0, xp->nbr_words * sizeof(unsigned long));
+	xp->depth++;
+	for (e = 0; e < xp->nbr_exprs; e++) {
+		expr = &xp->exprs[e];
+		selected = YFALSE;
+		for (k = 0, i = expr->first_state; k < expr->nbr_steps; k++, i++) {
+			if (!_YSAX_XPATH_IS_SET(parent, i))
+				continue;
+			if (expr->steps[k].descendant)
+				_YSAX_XPATH_SET(set, i);
+			if (!_ysax_xpath_match(&expr->steps[k], name, attrs, nbr_attrs))
+				continue;
+			if (k + 1 < expr->nbr_steps) {
+				_YSAX_XPATH_SET(set, i + 1);
+				/* '//@attr' selects the attributes of this element too */
+				if (expr->attr_self && k + 2 == expr->nbr_steps)
+					selected = YTRUE;
+				continue;
+			}
+			selected = YTRUE;
+		}
+		/* the expression selects this element, or some of its attributes
+		   (once, even if several states lead to it) */
+		if (!selected)
+			continue;
+		if (expr->attr != NULL) {
+			for (size = 0; size < nbr_attrs; size++)
+				if (!strcmp(expr->attr, "*") ||
+				    !ysax_span_cmp(attrs[size].name, expr->attr))
+					expr->hdlr(xp, (int)e, attrs[size].name, attrs[size].value,
+						   expr->data);
+			continue;
+		}
+		if (xp->nbr_captures == xp->captures_size) {
+			size = xp->captures_size;
+			if ((capture = ygrow(xp->captures, &size,
+					     sizeof(_ysax_xpath_capture_t),
+					     xp->nbr_captures, 4)) == NULL) {
+				ysax_stop(sax);
+				return;
+			}
+			xp->captures = capture;
+			xp->captures_size = size;
+		}
+		capture = &xp->captures[xp->nbr_captures++];
+		capture->expr = e;
+		capture->depth = xp->depth;
+		capture->offset = ys_len(xp->text);
+	}
+}
+
+/*
+ * _ysax_xpath_close_hdlr()
+ * Give the text of the selected elements which are closed.
+ */
+static void _ysax_xpath_close_hdlr(ysax_t *sax, ysax_span_t name) {
+	ysax_xpath_t		*xp = YSAX_DATA(sax);
+	_ysax_xpath_capture_t	*capture;
+	ysax_span_t		value;
+	size_t			first, i;
+
+	if (xp->depth == 0)
+		return;
+	/* the element's captures are on top of the stack; give them in the
+	   order of the expressions */
+	for (first = xp->nbr_captures;
+	     first && xp->captures[first - 1].depth == xp->depth; first--)
+		;
+	for (i = first; i < xp->nbr_captures; i++) {
+		capture = &xp->captures[i];
+		value.ptr = xp->text + capture->offset;
+		value.len = ys_len(xp->text) - capture->offset;
+		xp->exprs[capture->expr].hdlr(xp, (int)capture->expr, name, value,
+					      xp->exprs[capture->expr].data);
+	}
+	xp->nbr_captures = first;
+	if (!xp->nbr_captures)
+		ys_trunc(xp->text);
+	xp->depth--;
+}
+
+/*
+ * _ysax_xpath_text_hdlr()
+ * Keep the text (or CDATA section) found inside selected elements.
+ */
+static void _ysax_xpath_text_hdlr(ysax_t *sax, ysax_span_t text) {
+	ysax_xpath_t	*xp = YSAX_DATA(sax);
+
+	if (xp->nbr_captures && text.len && !ys_ncat(&xp->text, text.ptr, text.len))
+		ysax_stop(sax);
+}
+
+/*
+ * _ysax_xpath_match()
+ * Tell if an element matches a step.
+ */
+static ybool_t _ysax_xpath_match(const _ysax_xpath_step_t *step, ysax_span_t name,
+				 const ysax_span_attr_t *attrs, size_t nbr_attrs) {
+	const _ysax_xpath_pred_t	*pred;
+	const ysax_span_attr_t		*attr;
+
+	if (step->name != NULL && ysax_span_cmp(name, step->name))
+		return (YFALSE);
+	for (pred = step->preds; pred != NULL; pred = pred->next) {
+		if ((attr = _ysax_xpath_get_attr(pred->attr, attrs, nbr_attrs)) == NULL)
+			return (YFALSE);
+		if (pred->value != NULL &&
+		    (!ysax_span_cmp(attr->value, pred->value)) == pred->negate)
+			return (YFALSE);
+	}
+	return (YTRUE);
+}
+
+/*
+ * _ysax_xpath_get_attr()
+ * Search an attribute by its name.
+ */
+static const ysax_span_attr_t *_ysax_xpath_get_attr(const char *attr_name, const ysax_span_attr_t *attrs,
+						    size_t nbr_attrs) {
+	size_t	i;
+
+	for (i = 0; i < nbr_attrs; i++)
+		if (!ysax_span_cmp(attrs[i].name, attr_name))
+			return (&attrs[i]);
+	return (NULL);
+}
+
+/*
+ * _ysax_xpath_compile()
+ * Compile an expression into steps.
+ */
+static yerr_t _ysax_xpath_compile(_ysax_xpath_expr_t *expr, const char *pt) {
+	_ysax_xpath_step_t	*step;
+	_ysax_xpath_pred_t	*pred, **last_pred;
+	const char		*s;
+	char			quote;
+	size_t			nbr;
+
+	if (*pt != '/')
+		return (YEINVAL);
+	/* at most one step per slash, plus one for '//@attr' */
+	for (s = pt, nbr = 1; *s; s++)
+		if (*s == '/')
+			nbr++;
+	if ((expr->steps = YMALLOC(nbr * sizeof(_ysax_xpath_step_t))) == NULL)
+		return (YENOMEM);
+	while (*pt) {
+		if (*pt != '/')
+			return (YEINVAL);
+		step = &expr->steps[expr->nbr_steps];
+		if (*++pt == '/') {
+			step->descendant = YTRUE;
+			pt++;
+		}
+		if (*pt == '@') {
+			/* final attribute step; '//@attr' selects the attributes
+			   of the context element and of all its descendants */
+			pt++;
+			if (step->descendant) {
+				expr->nbr_steps++;
+				expr->attr_self = YTRUE;
+			}
+			if ((expr->attr = _ysax_xpath_name(&pt)) == NULL || *pt)
+				return (YEINVAL);
+			break;
+		}
+		if ((step->name = _ysax_xpath_name(&pt)) == NULL)
+			return (YEINVAL);
+		expr->nbr_steps++;
+		if (!strcmp(step->name, "*"))
+			YFREE(step->name);
+		for (last_pred = &step->preds; *pt == '['; last_pred = &pred->next) {
+			if (*++pt != '@')
+				return (YEINVAL);
+			pt++;
+			if ((pred = YMALLOC(sizeof(_ysax_xpath_pred_t))) == NULL)
+				return (YENOMEM);
+			*last_pred = pred;
+			if ((pred->attr = _ysax_xpath_name(&pt)) == NULL)
+				return (YEINVAL);
+			if (*pt == '!') {
+				pred->negate = YTRUE;
+				pt++;
+			}
+			if (*pt == '=') {
+				if ((quote = *++pt) != '\'' && quote != '"')
+					return (YEINVAL);
+				for (s = ++pt; *pt && *pt != quote; pt++)
+					;
+				if (!*pt || (pred->value = YMALLOC_RAW(pt - s + 1)) == NULL)
+					return (*pt ? YENOMEM : YEINVAL);
+				memcpy(pred->value, s, pt - s);
+				pred->value[pt - s] = '\0';
+				pt++;
+			} else if (pred->negate)
+				return (YEINVAL);
+			if (*pt++ != ']')
+				return (YEINVAL);
+		}
+	}
+	return (expr->nbr_steps ? YENOERR : YEINVAL);
+}
+
+/*
+ * _ysax_xpath_name()
+ * Copy the name (or '*') which begins an expression, and move the pointer
+ * after it. Return NULL if there is no name.
+ */
+static char *_ysax_xpath_name(const char **pt) {
+	const char	*s = *pt;
+	char		*name;
+
+	if (*s == '*')
+		s++;
+	else
+		for (; *s && *s != '/' && *s != '[' && *s != ']' && *s != '=' && *s != '!' &&
+		     *s != '@' && !IS_SPACE(*s); s++)
+			;
+	if (s == *pt || (name = YMALLOC_RAW(s - *pt + 1)) == NULL)
+		return (NULL);
+	memcpy(name, *pt, s - *pt);
+	name[s - *pt] = '\0';
+	*pt = s;
+	return (name);
+}
+
+/*
+ * _ysax_xpath_free_expr()
+ * Free the steps of an expression.
+ */
+static void _ysax_xpath_free_expr(_ysax_xpath_expr_t *expr) {
+	_ysax_xpath_pred_t	*pred;
+	size_t			i;
+
+	/* a step whose compilation failed could be partly filled */
+	for (i = 0; expr->steps != NULL && i <= expr->nbr_steps; i++) {
+		YFREE(expr->steps[i].name);
+		while ((pred = expr->steps[i].preds) != NULL) {
+			expr->steps[i].preds = pred->next;
+			YFREE(pred->attr);
+			YFREE(pred->value);
+			YFREE(pred);
+		}
+	}
+	YFREE(expr->steps);
+	YFREE(expr->attr);
+}
@@ -0,0 +1,107 @@
+/* Process this file with the HeaderBrowser tool (http://www.headerbrowser.org)
+   to create documentation. */
+/*!
+ * @header	ysax_xpath.h
+ * @abstract	Streaming evaluation of simple XPath expressions.
+ * @discussion	A streaming XPath matcher owns a SAX parser. Expressions are
+ *		compiled into steps, and evaluated as a state machine during
+ *		the parsing: each open tag advances the steps matched by its
+ *		parent; nothing is kept from the document but the states of
+ *		the open elements, and the text of the matching elements.
+ *		Memory doesn't depend on the size of the document.<p />
+ *		Supported expressions are absolute paths made of:
+ *		<ul>
+ *		<li>child steps: <tt>/a/b</tt></li>
+ *		<li>descendant steps: <tt>//b</tt>, <tt>/a//c</tt></li>
+ *		<li>wildcards: <tt>/a/&#42;/c</tt></li>
+ *		<li>predicates on attributes: <tt>[@id]</tt>,
+ *		<tt>[@id='42']</tt>, <tt>[@id!='42']</tt> (several
+ *		predicates could follow a step)</li>
+ *		<li>a final attribute step: <tt>/a/b/@id</tt>,
+ *		<tt>//b/@&#42;</tt>, <tt>/a//@id</tt> (attributes of
+ *		<tt>a</tt> and of its descendants)</li>
+ *		</ul>
+ *		When an expression selects an element, its handler is called
+ *		at the close tag, with the text of the element (and of its
+ *		descendants). When it selects an attribute, its handler is
+ *		called at the open tag, with the value of the attribute.
+ *		<pre>ysax_xpath_t *xp = ysax_xpath_new();
+ *ysax_xpath_add(xp, "//record[@type='book']/title", func, data);
+ *ysax_read_file(ysax_xpath_get_sax(xp), "big.xml");
+ *ysax_xpath_del(xp);</pre>
+ * @version	1.0 Oct 19 2026
+ * @author	Amaury Bouchard <amaury@amaury.net>
+ */
+#ifndef __YSAX_XPATH_H__
+#define __YSAX_XPATH_H__
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif /* __cplusplus || c_plusplus */
+
+#include "ydefs.h"
+#include "yerror.h"
+#include "ysax.h"
+
+/*! @typedef ysax_xpath_t Streaming XPath matcher (opaque structure). */
+typedef struct ysax_xpath_s ysax_xpath_t;
+
+/**
+ * @typedef	ysax_xpath_hdlr_t
+ *		Handler called for each match of an expression.
+ * @param	xp	The matcher.
+ * @param	id	Identifier of the expression (its rank of addition,
+ *			starting at 0).
+ * @param	name	Name of the matching element or attribute.
+ * @param	value	Text of the element, or value of the attribute.
+ * @param	data	Pointer given with the expression.
+ */
+typedef void (*ysax_xpath_hdlr_t)(ysax_xpath_t *xp, int id, ysax_span_t name,
+				  ysax_span_t value, void *data);
+
+/* ****************** FUNCTIONS **************** */
+/**
+ * @function	ysax_xpath_new
+ *		Create a streaming XPath matcher, and its SAX parser.
+ * @return	The matcher, or NULL if an error occurs.
+ */
+ysax_xpath_t *ysax_xpath_new(void);
+
+/**
+ * @function	ysax_xpath_del
+ *		Delete a streaming XPath matcher and its SAX parser.
+ * @param	xp	The matcher.
+ */
+void ysax_xpath_del(ysax_xpath_t *xp);
+
+/**
+ * @function	ysax_xpath_add
+ *		Compile an expression and add it to a matcher. Must not be
+ *		called during a parsing.
+ * @param	xp	The matcher.
+ * @param	expr	The expression.
+ * @param	hdlr	Handler called for each match.
+ * @param	data	Pointer given to the handler.
+ * @return	YENOERR if OK, YEINVAL if the expression is not supported,
+ *		YENOMEM if an allocation failed.
+ */
+yerr_t ysax_xpath_add(ysax_xpath_t *xp, const char *expr,
+		      ysax_xpath_hdlr_t hdlr, void *data);
+
+/**
+ * @function	ysax_xpath_get_sax
+ *		Return the SAX parser of a matcher, to parse a document with
+ *		any of the ysax_read_*() functions, or with ysax_feed(). Its
+ *		span handlers are used by the matcher. The matcher is reset,
+ *		so this function should be called before each parsing (a
+ *		stopped or erroneous parsing leaves elements open).
+ * @param	xp	The matcher.
+ * @return	The SAX parser.
+ */
+ysax_t *ysax_xpath_get_sax(ysax_xpath_t *xp);
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif /* __cplusplus || c_plusplus */
+
+#endif /* __YSAX_XPATH_H__ */
@@ -0,0 +1,184 @@
+#include <string.h>
+#include "yscan.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define _YSCAN_X86
+# include <immintrin.h>
+#endif /* __GNUC__ && (__x86_64__ || __i386__) */
+
+/** @define _YSCAN_PREFIX Number of bytes checked one by one before using vectors, for short runs. */
+#define _YSCAN_PREFIX		16
+
+/**
+ * @typedef	_yscan_func_t
+ *		Implementation of yscan_find().
+ */
+typedef const char *(*_yscan_func_t)(const char *begin, const char *end, const yscan_set_t *set);
+
+/* *** definition of private functions *** */
+static const char *_yscan_dispatch(const char *begin, const char *end, const yscan_set_t *set);
+static _yscan_func_t _yscan_select(yscan_impl_t impl);
+static const char *_yscan_find_scalar(const char *begin, const char *end, const yscan_set_t *set);
+#ifdef _YSCAN_X86
+static const char *_yscan_find_sse2(const char *begin, const char *end, const yscan_set_t *set) __attribute__((target("sse2")));
+static const char *_yscan_find_avx2(const char *begin, const char *end, const yscan_set_t *set) __attribute__((target("avx2")));
+#endif /* _YSCAN_X86 */
+
+/** @var _yscan_func Current implementation; the first call chooses it. */
+static _yscan_func_t _yscan_func = _yscan_dispatch;
+
+/*
+ * yscan_set_init()
+ * Initialize a scan set.
+ */
+void yscan_set_init(yscan_set_t *set, const char *chars, size_t nbr_chars) {
+	size_t	i;
+
+	if (nbr_chars > YSCAN_MAX_CHARS)
+		nbr_chars = YSCAN_MAX_CHARS;
+	memset(set->table, 0, sizeof(set->table));
+	for (i = 0; i < nbr_chars; i++) {
+		set->chars[i] = (unsigned char)chars[i];
+		set->table[set->chars[i]] = 1;
+	}
+	set->nbr_chars = nbr_chars;
+}
+
+/*
+ * yscan_find()
+ * Search the first character of a buffer which belongs to a set.
+ */
+const char *yscan_find(const char *begin, const char *end, const yscan_set_t *set) {
+	return (_yscan_func(begin, end, set));
+}
+
+/*
+ * yscan_set_implementation()
+ * Choose the implementation of yscan_find().
+ */
+yerr_t yscan_set_implementation(yscan_impl_t impl) {
+	_yscan_func_t	func;
+
+	if ((func = _yscan_select(impl)) == NULL)
+		return (YENOSYS);
+	_yscan_func = func;
+	return (YENOERR);
+}
+
+/*
+ * yscan_implementation_name()
+ * Return the name of the implementation used by yscan_find().
+ */
+const char *yscan_implementation_name(void) {
+	if (_yscan_func == _yscan_dispatch)
+		_yscan_func = _yscan_select(YSCAN_AUTO);
+#ifdef _YSCAN_X86
+	if (_yscan_func == _yscan_find_avx2)
+		return ("avx2");
+	if (_yscan_func == _yscan_find_sse2)
+		return ("sse2");
+#endif /* _YSCAN_X86 */
+	return ("scalar");
+}
+
+/* *************** PRIVATE FUNCTIONS ************** */
+/*
+ * _yscan_dispatch()
+ * Initial implementation: choose the best one, and use it.
+ */
+static const char *_yscan_dispatch(const char *begin, const char *end, const yscan_set_t *set) {
+	_yscan_func = _yscan_select(YSCAN_AUTO);
+	return (_yscan_func(begin, end, set));
+}
+
+/*
+ * _yscan_select()
+ * Return an implementation, or NULL if the processor doesn't support it.
+ */
+static _yscan_func_t _yscan_select(yscan_impl_t impl) {
+#ifdef _YSCAN_X86
+	if ((impl == YSCAN_AUTO || impl == YSCAN_AVX2) && __builtin_cpu_supports("avx2"))
+		return (_yscan_find_avx2);
+	if ((impl == YSCAN_AUTO || impl == YSCAN_SSE2) && __builtin_cpu_supports("sse2"))
+		return (_yscan_find_sse2);
+#endif /* _YSCAN_X86 */
+	if (impl == YSCAN_AUTO || impl == YSCAN_SCALAR)
+		return (_yscan_find_scalar);
+	return (NULL);
+}
+
+/*
+ * _yscan_find_scalar()
+ * Byte by byte implementation. Also used for the tail of the buffer by the
+ * vectorized ones.
+ */
+static const char *_yscan_find_scalar(const char *begin, const char *end, const yscan_set_t *set) {
+	const unsigned char	*pt = (const unsigned char*)begin;
+
+	while (pt < (const unsigned char*)end && !set->table[*pt])
+		pt++;
+	return ((const char*)pt);
+}
+
+#ifdef _YSCAN_X86
+/*
+ * _yscan_find_sse2()
+ * Compare 16 bytes at a time with each character of the set. The first bytes
+ * are checked one by one: most runs of XML text between two structural
+ * characters are short.
+ */
+static const char *_yscan_find_sse2(const char *begin, const char *end, const yscan_set_t *set) {
+	__m128i		needles[YSCAN_MAX_CHARS];
+	__m128i		block, match;
+	const char	*pt = begin;
+	size_t		i;
+	int		mask;
+
+	for (i = 0; i < _YSCAN_PREFIX; i++, pt++)
+		if (pt == end || set->table[(unsigned char)*pt])
+			return (pt);
+	if (set->nbr_chars == 0)
+		return (end);
+	for (i = 0; i < set->nbr_chars; i++)
+		needles[i] = _mm_set1_epi8((char)set->chars[i]);
+	for (; end - pt >= 16; pt += 16) {
+		block = _mm_loadu_si128((const __m128i*)pt);
+		match = _mm_cmpeq_epi8(block, needles[0]);
+		for (i = 1; i < set->nbr_chars; i++)
+			match = _mm_or_si128(match, _mm_cmpeq_epi8(block, needles[i]));
+		if ((mask = _mm_movemask_epi8(match)) != 0)
+			return (pt + __builtin_ctz((unsigned int)mask));
+	}
+	return (_yscan_find_scalar(pt, end, set));
+}
+
+/*
+ * _yscan_find_avx2()
+ * Compare 32 bytes at a time with each character of the set, after checking
+ * the first bytes one by one.
+ */
+static const char *_yscan_find_avx2(const char *begin, const char *end, const yscan_set_t *set) {
+	__m256i		needles[YSCAN_MAX_CHARS];
+	__m256i		block, match;
+	const char	*pt = begin;
+	size_t		i;
+	unsigned int	mask;
+
+	for (i = 0; i < _YSCAN_PREFIX; i++, pt++)
+		if (pt == end || set->table[(unsigned char)*pt])
+			return (pt);
+	if (set->nbr_chars == 0)
+		return (end);
+	for (i = 0; i < set->nbr_chars; i++)
+		needles[i] = _mm256_set1_epi8((char)set->chars[i]);
+	for (; end - pt >= 32; pt += 32) {
+		block = _mm256_loadu_si256((const __m256i*)pt);
+		match = _mm256_cmpeq_epi8(block, needles[0]);
+		for (i = 1; i < set->nbr_chars; i++)
+			match = _mm256_or_si256(match, _mm256_cmpeq_epi8(block, needles[i]));
+		if ((mask = (unsigned int)_mm256_movemask_epi8(match)) != 0)
+			return (pt + __builtin_ctz(mask));
+	}
+	return (_yscan_find_sse2(pt, end, set));
+}
+#endif /* _YSCAN_X86 */
@@ -0,0 +1,99 @@
+/* Process this file with the HeaderBrowser tool (http://www.headerbrowser.org)
+   to create documentation. */
+/*!
+ * @header	yscan.h
+ * @abstract	Vectorized search of a set of characters.
+ * @discussion	A scan set holds a few characters (the structural characters
+ *		of an XML parser, for example); yscan_find() returns the first
+ *		occurrence of any of them in a buffer. On x86 processors, the
+ *		buffer is compared 32 bytes at a time with AVX2, or 16 bytes at
+ *		a time with SSE2; the implementation is chosen at runtime, the
+ *		first time yscan_find() is called, from the instructions the
+ *		processor supports. Other processors use a lookup table.
+ * @version	1.0 Oct 19 2026
+ * @author	Amaury Bouchard <amaury@amaury.net>
+ */
+#ifndef __YSCAN_H__
+#define __YSCAN_H__
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif /* __cplusplus || c_plusplus */
+
+#include "ydefs.h"
+#include "yerror.h"
+
+/** @define YSCAN_MAX_CHARS Maximum number of characters of a scan set. */
+#define YSCAN_MAX_CHARS		8
+
+/**
+ * @typedef	yscan_impl_t
+ *		Implementations of yscan_find().
+ * @constant	YSCAN_AUTO	The best implementation supported by the processor.
+ * @constant	YSCAN_SCALAR	Byte by byte, with a lookup table.
+ * @constant	YSCAN_SSE2	16 bytes at a time.
+ * @constant	YSCAN_AVX2	32 bytes at a time.
+ */
+typedef enum yscan_impl_e {
+	YSCAN_AUTO = 0,
+	YSCAN_SCALAR,
+	YSCAN_SSE2,
+	YSCAN_AVX2
+} yscan_impl_t;
+
+/**
+ * @typedef	yscan_set_t
+ *		Set of characters to search.
+ * @field	nbr_chars	Number of characters.
+ * @field	chars		The characters.
+ * @field	table		One byte per character value, non-zero for the
+ *				characters of the set.
+ */
+typedef struct yscan_set_s {
+	size_t		nbr_chars;
+	unsigned char	chars[YSCAN_MAX_CHARS];
+	unsigned char	table[256];
+} yscan_set_t;
+
+/* ****************** FUNCTIONS **************** */
+/**
+ * @function	yscan_set_init
+ *		Initialize a scan set.
+ * @param	set		Pointer to the set.
+ * @param	chars		The characters. Could contain '\0'.
+ * @param	nbr_chars	Number of characters (at most YSCAN_MAX_CHARS,
+ *				further characters are ignored).
+ */
+void yscan_set_init(yscan_set_t *set, const char *chars, size_t nbr_chars);
+
+/**
+ * @function	yscan_find
+ *		Search the first character of a buffer which belongs to a set.
+ * @param	begin	Beginning of the buffer.
+ * @param	end	End of the buffer (first byte after it).
+ * @param	set	The set of characters.
+ * @return	A pointer to the character, or end if there is none.
+ */
+const char *yscan_find(const char *begin, const char *end, const yscan_set_t *set);
+
+/**
+ * @function	yscan_set_implementation
+ *		Choose the implementation of yscan_find(), for all threads.
+ *		Used to compare implementations; the default is YSCAN_AUTO.
+ * @param	impl	The implementation.
+ * @return	YENOERR if OK, YENOSYS if the processor doesn't support it.
+ */
+yerr_t yscan_set_implementation(yscan_impl_t impl);
+
+/**
+ * @function	yscan_implementation_name
+ *		Return the name of the implementation used by yscan_find().
+ * @return	"avx2", "sse2" or "scalar".
+ */
+const char *yscan_implementation_name(void);
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif /* __cplusplus || c_plusplus */
+
+#endif /* __YSCAN_H__ */
@@ -0,0 +1,186 @@
+#define YMEM_TAG	YMEM_TAG_SLAB
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "yslab.h"
+
+/** @define _YSLAB_CLASS Size class of an object size. */
+#define _YSLAB_CLASS(s)		((((s) ? (s) : 1) - 1) / YSLAB_QUANTUM)
+
+/** @define _YSLAB_CLASS_SIZE Size of the objects of a size class. */
+#define _YSLAB_CLASS_SIZE(c)	(((c) + 1) * YSLAB_QUANTUM)
+
+/**
+ * @typedef	_yslab_pool_t
+ *		Shared pool of a size class.
+ * @field	mutex		Lock of the pool.
+ * @field	free_list	Free objects, linked by their first bytes.
+ * @field	pos		Next unused object of the current slab.
+ * @field	end		End of the current slab.
+ */
+typedef struct _yslab_pool_s {
+	pthread_mutex_t	mutex;
+	void		*free_list;
+	char		*pos;
+	char		*end;
+} _yslab_pool_t;
+
+/** @var _yslab_pools Shared pools, one per size class. */
+static _yslab_pool_t _yslab_pools[YSLAB_NBR_CLASSES];
+/** @var _yslab_once Initialization of the pools. */
+static pthread_once_t _yslab_once = PTHREAD_ONCE_INIT;
+/** @var _yslab_key Key used to flush the magazines of exiting threads. */
+static pthread_key_t _yslab_key;
+/** @var _yslab_magazines Magazines of the current thread. */
+static __thread yslab_magazine_t _yslab_magazines[YSLAB_NBR_CLASSES];
+/** @var _yslab_registered YTRUE once the current thread's magazines must be flushed at exit. */
+static __thread ybool_t _yslab_registered;
+
+/* *** definition of private functions *** */
+static void _yslab_init(void);
+static void _yslab_register(void);
+static void _yslab_thread_exit(void *magazines);
+static ybool_t _yslab_refill(size_t class, yslab_magazine_t *magazine);
+static void _yslab_give_back(size_t class, yslab_magazine_t *magazine, size_t nbr_objects);
+
+/*
+ * yslab_alloc()
+ * Allocate a zeroed object.
+ */
+void *yslab_alloc(size_t size) {
+	yslab_magazine_t	*magazine;
+	size_t			class;
+	void			*ptr;
+
+	if (size > YSLAB_MAX_SIZE)
+		return (YMALLOC(size));
+	if (!_yslab_registered)
+		_yslab_register();
+	class = _YSLAB_CLASS(size);
+	magazine = &(_yslab_magazines[class]);
+	if (magazine->nbr_objects == 0 && !_yslab_refill(class, magazine))
+		return (NULL);
+	ptr = magazine->objects[--magazine->nbr_objects];
+	memset(ptr, 0, _YSLAB_CLASS_SIZE(class));
+	return (ptr);
+}
+
+/*
+ * yslab_free()
+ * Free an object allocated by yslab_alloc().
+ */
+void yslab_free(void *ptr, size_t size) {
+	yslab_magazine_t	*magazine;
+	size_t			class;
+
+	if (ptr == NULL)
+		return;
+	if (size > YSLAB_MAX_SIZE) {
+		YFREE(ptr);
+		return;
+	}
+	if (!_yslab_registered)
+		_yslab_register();
+	class = _YSLAB_CLASS(size);
+	magazine = &(_yslab_magazines[class]);
+	if (magazine->nbr_objects == YSLAB_MAGAZINE_SIZE)
+		_yslab_give_back(class, magazine, YSLAB_MAGAZINE_SIZE / 2);
+	magazine->objects[magazine->nbr_objects++] = ptr;
+}
+
+/*
+ * yslab_flush()
+ * Give the free objects kept by the current thread back to the shared pools.
+ */
+void yslab_flush(void) {
+	size_t	class;
+
+	for (class = 0; class < YSLAB_NBR_CLASSES; class++)
+		if (_yslab_magazines[class].nbr_objects > 0)
+			_yslab_give_back(class, &(_yslab_magazines[class]), _yslab_magazines[class].nbr_objects);
+}
+
+/* *************** PRIVATE FUNCTIONS ************** */
+/*
+ * _yslab_init()
+ * Initialize the shared pools, once.
+ */
+static void _yslab_init(void) {
+	size_t	class;
+
+	for (class = 0; class < YSLAB_NBR_CLASSES; class++)
+		pthread_mutex_init(&(_yslab_pools[class].mutex), NULL);
+	pthread_key_create(&_yslab_key, _yslab_thread_exit);
+}
+
+/*
+ * _yslab_register()
+ * Make sure the magazines of the current thread are flushed when it exits.
+ */
+static void _yslab_register(void) {
+	pthread_once(&_yslab_once, _yslab_init);
+	pthread_setspecific(_yslab_key, _yslab_magazines);
+	_yslab_registered = YTRUE;
+}
+
+/*
+ * _yslab_thread_exit()
+ * Flush the magazines of an exiting thread. If objects are freed later by
+ * other destructors, the thread registers itself again.
+ */
+static void _yslab_thread_exit(void *magazines) {
+	(void)magazines;
+	_yslab_registered = YFALSE;
+	yslab_flush();
+}
+
+/*
+ * _yslab_refill()
+ * Fill half a magazine from the shared pool, cutting new objects from the
+ * current slab when there is no free one.
+ */
+static ybool_t _yslab_refill(size_t class, yslab_magazine_t *magazine) {
+	_yslab_pool_t	*pool = &(_yslab_pools[class]);
+	size_t		object_size = _YSLAB_CLASS_SIZE(class);
+
+	pthread_mutex_lock(&(pool->mutex));
+	while (magazine->nbr_objects < YSLAB_MAGAZINE_SIZE / 2) {
+		if (pool->free_list != NULL) {
+			magazine->objects[magazine->nbr_objects++] = pool->free_list;
+			pool->free_list = *(void**)pool->free_list;
+			continue;
+		}
+		if (pool->pos == NULL || (size_t)(pool->end - pool->pos) < object_size) {
+			if ((pool->pos = (char*)YMALLOC(YSLAB_SLAB_SIZE)) == NULL) {
+				pool->end = NULL;
+				break;
+			}
+			pool->end = pool->pos + YSLAB_SLAB_SIZE;
+			/* no object has the address of its slab, so that the memory
+			   profiler can tell them apart */
+			pool->pos += YSLAB_QUANTUM;
+		}
+		magazine->objects[magazine->nbr_objects++] = pool->pos;
+		pool->pos += object_size;
+	}
+	pthread_mutex_unlock(&(pool->mutex));
+	return (magazine->nbr_objects > 0);
+}
+
+/*
+ * _yslab_give_back()
+ * Move objects from a magazine to the shared pool.
+ */
+static void _yslab_give_back(size_t class, yslab_magazine_t *magazine, size_t nbr_objects) {
+	_yslab_pool_t	*pool = &(_yslab_pools[class]);
+	void		*ptr;
+
+	pthread_mutex_lock(&(pool->mutex));
+	while (nbr_objects-- > 0) {
+		ptr = magazine->objects[--magazine->nbr_objects];
+		*(void**)ptr = pool->free_list;
+		pool->free_list = ptr;
+	}
+	pthread_mutex_unlock(&(pool->mutex));
+}
@@ -0,0 +1,109 @@
+/* Process this file with the HeaderBrowser tool (http://www.headerbrowser.org)
+   to create documentation. */
+/*!
+ * @header	yslab.h
+ * @abstract	Pools of small fixed-size objects.
+ * @discussion	The library allocates many small objects of a few sizes (DOM
+ *		nodes, hash table elements, SAX attributes, CGI items). The slab
+ *		allocator gives them memory from big slabs, one pool per size
+ *		class (multiples of YSLAB_QUANTUM bytes, up to YSLAB_MAX_SIZE):
+ *		objects of the same type are packed together, and freed objects
+ *		are reused for objects of the same size instead of fragmenting
+ *		the heap of long-running programs.
+ *		<p />
+ *		Each thread keeps a magazine of free objects per size class, so
+ *		that most allocations and liberations take no lock. Objects are
+ *		exchanged with the shared pool by half magazines. The magazines
+ *		of a thread are given back to the pool when it exits.
+ *		<p />
+ *		Memory taken by slabs is never given back to the system. Bigger
+ *		objects are allocated with YMALLOC(). The size given to
+ *		YSLAB_FREE() must be the size given to YSLAB_ALLOC() for the
+ *		same object.
+ *		<p />
+ *		When compiled with USE_BOEHM_GC or YSLAB_DISABLE (useful for
+ *		memory debuggers), YSLAB_ALLOC() and YSLAB_FREE() are
+ *		YMALLOC() and YFREE(). With YMEM_PROFILE, objects are tracked
+ *		by ymem_track(), with the tag of the file which allocates them.
+ * @version	1.0 Oct 19 2026
+ * @author	Amaury Bouchard <amaury@amaury.net>
+ */
+#ifndef __YSLAB_H__
+#define __YSLAB_H__
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif /* __cplusplus || c_plusplus */
+
+#include "ydefs.h"
+
+/** @define YSLAB_QUANTUM Granularity of the size classes. */
+#define YSLAB_QUANTUM		16
+
+/** @define YSLAB_MAX_SIZE Size of the biggest objects taken from slabs. */
+#define YSLAB_MAX_SIZE		256
+
+/** @define YSLAB_NBR_CLASSES Number of size classes. */
+#define YSLAB_NBR_CLASSES	(YSLAB_MAX_SIZE / YSLAB_QUANTUM)
+
+/** @define YSLAB_MAGAZINE_SIZE Number of free objects a thread keeps per size class. */
+#define YSLAB_MAGAZINE_SIZE	64
+
+/** @define YSLAB_SLAB_SIZE Size of the slabs objects are cut from. */
+#define YSLAB_SLAB_SIZE		65536
+
+#if defined(USE_BOEHM_GC) || defined(YSLAB_DISABLE)
+/*! @define YSLAB_ALLOC Small object allocation macro. */
+# define YSLAB_ALLOC(s)		YMALLOC(s)
+/*! @define YSLAB_FREE Small object liberation macro. */
+# define YSLAB_FREE(p, s)	YFREE(p)
+#elif defined(YMEM_PROFILE)
+# define YSLAB_ALLOC(s)		(((s) > YSLAB_MAX_SIZE) ? YMALLOC(s) : ymem_track(YMEM_TAG, yslab_alloc(s), (s)))
+# define YSLAB_FREE(p, s)	(((s) > YSLAB_MAX_SIZE) ? YFREE(p) : (ymem_untrack((void*)(p)), yslab_free((void*)(p), (s)), p = NULL))
+#else
+/*! @define YSLAB_ALLOC Small object allocation macro. */
+# define YSLAB_ALLOC(s)		yslab_alloc(s)
+/*! @define YSLAB_FREE Small object liberation macro. */
+# define YSLAB_FREE(p, s)	(yslab_free((void*)(p), (s)), p = NULL)
+#endif /* USE_BOEHM_GC || YSLAB_DISABLE */
+
+/**
+ * @typedef	yslab_magazine_t
+ *		Free objects of a size class, kept by a thread.
+ * @field	nbr_objects	Number of objects in the magazine.
+ * @field	objects		The objects.
+ */
+typedef struct yslab_magazine_s {
+	size_t	nbr_objects;
+	void	*objects[YSLAB_MAGAZINE_SIZE];
+} yslab_magazine_t;
+
+/* ****************** FUNCTIONS **************** */
+/**
+ * @function	yslab_alloc
+ *		Allocate a zeroed object.
+ * @param	size	Size of the object.
+ * @return	A pointer to the object, or NULL if memory is exhausted.
+ */
+void *yslab_alloc(size_t size);
+
+/**
+ * @function	yslab_free
+ *		Free an object allocated by yslab_alloc().
+ * @param	ptr	Pointer to the object. Could be NULL.
+ * @param	size	Size of the object, as given to yslab_alloc().
+ */
+void yslab_free(void *ptr, size_t size);
+
+/**
+ * @function	yslab_flush
+ *		Give the free objects kept by the current thread back to the
+ *		shared pools. It is done automatically when a thread exits.
+ */
+void yslab_flush(void);
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif /* __cplusplus || c_plusplus */
+
+#endif /* __YSLAB_H__ */
@@ -1,3 +1,5 @@
+#define YMEM_TAG	YMEM_TAG_STR
+
 #include <stdio.h>
 #include <stdarg.h>
 #include <string.h>
@@ -9,6 +11,15 @@
 ** Create a new ystring.
 */
 ystr_t ys_new(const char *s)
+{
+  return (ys_new_in(NULL, s));
+}
+
+/*
+** ys_new_in()
+** Create a new ystring, whose memory is given by an allocator.
+*/
+ystr_t ys_new_in(yalloc_t *allocator, const char *s)
 {
   char *res;
   unsigned int strsz, totalsz, leap;
@@ -23,10 +34,11 @@ ystr_t ys_new(const char *s)
 	(strsz < YSTR_SIZE_HUGE) ? YSTR_SIZE_BIG : YSTR_SIZE_HUGE;
       totalsz = (((strsz + 1) / leap) + 1) * leap;
     }
-  if (!(res = (char*)YMALLOC(totalsz + sizeof(ystr_head_t))))
+  if (!(res = (char*)YALLOC_MALLOC_RAW(allocator, totalsz + sizeof(ystr_head_t))))
     return (res);
   y = (ystr_head_t*)res;
   res += sizeof(ystr_head_t);
+  y->allocator = allocator;
   y->total = totalsz;
   y->used = strsz;
   if (!strsz)
@@ -47,10 +59,11 @@ ystr_t ys_copy(const char *s) {
 
 	strsz = (!s) ? 0 : strlen(s);
 	totalsz = strsz + 1;
-	if (!(res = (char*)YMALLOC(totalsz + sizeof(ystr_head_t))))
+	if (!(res = (char*)YMALLOC_RAW(totalsz + sizeof(ystr_head_t))))
 		return (res);
 	y = (ystr_head_t*)res;
 	res += sizeof(ystr_head_t);
+	y->allocator = NULL;
 	y->total = totalsz;
 	y->used = strsz;
 	if (!strsz)
@@ -71,7 +84,7 @@ void ys_del(ystr_t *s)
   if (!s || !*s)
     return ;
   y = (ystr_head_t*)(*s - sizeof(ystr_head_t));
-  YFREE(y);
+  YALLOC_FREE(y->allocator, y);
   *s = NULL;
 }
 
@@ -85,7 +98,7 @@ void ys_free(ystr_t s) {
 	if (!s)
 		return;
 	y = (ystr_head_t*)(s - sizeof(ystr_head_t));
-	YFREE(y);
+	YALLOC_FREE(y->allocator, y);
 }
 
 /*
@@ -121,14 +134,15 @@ int ys_setsz(ystr_t *s, unsigned int sz)
   leap = (sz < YSTR_SIZE_BIG) ? YSTR_SIZE :
     (sz < YSTR_SIZE_HUGE) ? YSTR_SIZE_BIG : YSTR_SIZE_HUGE;
   totalsz = (((sz + 1) / leap) + 1) * leap;
-  if (!(ns = (char*)YMALLOC(totalsz + sizeof(ystr_head_t))))
+  if (!(ns = (char*)YALLOC_MALLOC_RAW(y->allocator, totalsz + sizeof(ystr_head_t))))
     return (0);
   ny = (ystr_head_t*)ns;
   ns += sizeof(ystr_head_t);
   ny->total = totalsz;
+  ny->allocator = y->allocator;
   ny->used = y->used;
-  memcpy(ns, s, y->used + 1);
-  YFREE(y);
+  memcpy(ns, *s, y->used + 1);
+  YALLOC_FREE(y->allocator, y);
   *s = ns;
   return (1);
 }
@@ -172,15 +186,16 @@ int ys_cat(ystr_t *dest, const char *src)
   leap = (strsz < YSTR_SIZE_BIG) ? YSTR_SIZE :
     (strsz < YSTR_SIZE_HUGE) ? YSTR_SIZE_BIG : YSTR_SIZE_HUGE;
   totalsz = (((strsz + 1) / leap) + 1) * leap;
-  if (!(ns = (char*)YMALLOC(totalsz + sizeof(ystr_head_t))))
+  if (!(ns = (char*)YALLOC_MALLOC_RAW(y->allocator, totalsz + sizeof(ystr_head_t))))
     return (0);
   ny = (ystr_head_t*)ns;
   ns += sizeof(ystr_head_t);
   ny->total = totalsz;
+  ny->allocator = y->allocator;
   ny->used = strsz;
   memcpy(ns, *dest, y->used);
   memcpy(ns + y->used, src, srcsz + 1);
-  YFREE(y);
+  YALLOC_FREE(y->allocator, y);
   *dest = ns;
   return (1);
 }
@@ -217,15 +232,16 @@ int ys_tac(ystr_t *dest, const char *src)
   leap = (strsz < YSTR_SIZE_BIG) ? YSTR_SIZE :
     (strsz < YSTR_SIZE_HUGE) ? YSTR_SIZE_BIG : YSTR_SIZE_HUGE;
   totalsz = (((strsz + 1) / leap) + 1) * leap;
-  if (!(ns = (char*)YMALLOC(totalsz + sizeof(ystr_head_t))))
+  if (!(ns = (char*)YALLOC_MALLOC_RAW(y->allocator, totalsz + sizeof(ystr_head_t))))
     return (0);
   ny = (ystr_head_t*)ns;
   ns += sizeof(ystr_head_t);
   ny->total = totalsz;
+  ny->allocator = y->allocator;
   ny->used = strsz;
   memcpy(ns, src, srcsz);
   memcpy(ns + srcsz, *dest, y->used + 1);
-  YFREE(y);
+  YALLOC_FREE(y->allocator, y);
   *dest = ns;
   return (1);
 }
@@ -259,16 +275,17 @@ int ys_ncat(ystr_t *dest, const char *src, unsigned int n)
   leap = (strsz < YSTR_SIZE_BIG) ? YSTR_SIZE :
     (strsz < YSTR_SIZE_HUGE) ? YSTR_SIZE_BIG : YSTR_SIZE_HUGE;
   totalsz = (((strsz + 1) / leap) + 1) * leap;
-  if (!(ns = (char*)YMALLOC(totalsz + sizeof(ystr_head_t))))
+  if (!(ns = (char*)YALLOC_MALLOC_RAW(y->allocator, totalsz + sizeof(ystr_head_t))))
     return (0);
   ny = (ystr_head_t*)ns;
   ns += sizeof(ystr_head_t);
   ny->total = totalsz;
+  ny->allocator = y->allocator;
   ny->used = strsz;
   strcpy(ns, *dest);
   strncpy(ns + y->used, src, n);
   ns[ny->used] = '\0';
-  YFREE(y);
+  YALLOC_FREE(y->allocator, y);
   *dest = ns;
   return (1);
 }
@@ -306,15 +323,16 @@ int ys_ntac(ystr_t *dest, const char *src, unsigned int n)
   leap = (strsz < YSTR_SIZE_BIG) ? YSTR_SIZE :
     (strsz < YSTR_SIZE_HUGE) ? YSTR_SIZE_BIG : YSTR_SIZE_HUGE;
   totalsz = (((strsz + 1) / leap) + 1) * leap;
-  if (!(ns = (char*)YMALLOC(totalsz + sizeof(ystr_head_t))))
+  if (!(ns = (char*)YALLOC_MALLOC_RAW(y->allocator, totalsz + sizeof(ystr_head_t))))
     return (0);
   ny = (ystr_head_t*)ns;
   ns += sizeof(ystr_head_t);
   ny->total = totalsz;
+  ny->allocator = y->allocator;
   ny->used = strsz;
   memcpy(ns, src, n);
   memcpy(ns + n, *dest, y->used + 1);
-  YFREE(y);
+  YALLOC_FREE(y->allocator, y);
   *dest = ns;
   return (1);
 }
@@ -331,10 +349,11 @@ ystr_t ys_dup(const ystr_t s)
   if (!s)
     return (ys_new(""));
   y = (ystr_head_t*)(s - sizeof(ystr_head_t));
-  if (!(ns = (char*)YMALLOC(y->total + sizeof(ystr_head_t))))
+  if (!(ns = (char*)YMALLOC_RAW(y->total + sizeof(ystr_head_t))))
     return (ns);
   ny = (ystr_head_t*)ns;
   ns += sizeof(ystr_head_t);
+  ny->allocator = NULL;
   ny->total = y->total;
   ny->used = y->used;
   memcpy(ns, s, y->used);
@@ -355,7 +374,7 @@ char *ys_string(const ystr_t s)
   if (!s)
     return (NULL);
   y = (ystr_head_t*)(s - sizeof(ystr_head_t));
-  if (!(res = (char*)YMALLOC(y->used + 1)))
+  if (!(res = (char*)YMALLOC_RAW(y->used + 1)))
     return (NULL);
   return (memcpy(res, s, y->used + 1));
 }
@@ -497,15 +516,16 @@ int ys_putc(ystr_t *s, char c)
   leap = (y->used < YSTR_SIZE_BIG) ? YSTR_SIZE :
     (y->used < YSTR_SIZE_HUGE) ? YSTR_SIZE_BIG : YSTR_SIZE_HUGE;
   totalsz = (((y->used + 2) / leap) + 1) * leap;
-  if (!(ns = (char*)YMALLOC(totalsz + sizeof(ystr_head_t))))
+  if (!(ns = (char*)YALLOC_MALLOC_RAW(y->allocator, totalsz + sizeof(ystr_head_t))))
     return (0);
   ny = (ystr_head_t*)ns;
   ns += sizeof(ystr_head_t);
   ny->total = totalsz;
+  ny->allocator = y->allocator;
   ny->used = y->used + 1;
   *ns = c;
   memcpy(ns + 1, *s, y->used + 1);
-  YFREE(y);
+  YALLOC_FREE(y->allocator, y);
   *s = ns;
   return (1);
 }
@@ -562,19 +582,20 @@ int ys_printf(ystr_t *s, char *format, ...)
   char *ns;
 
   y = (ystr_head_t*)(*s - sizeof(ystr_head_t));
-  if (!(ns = (char*)YMALLOC(y->total + sizeof(ystr_head_t))))
+  if (!(ns = (char*)YALLOC_MALLOC_RAW(y->allocator, y->total + sizeof(ystr_head_t))))
     return (0);
   ny = (ystr_head_t*)ns;
   ns += sizeof(ystr_head_t);
   ny->total = y->total;
+  ny->allocator = y->allocator;
   va_start(p_list, format);
   if ((i = vsnprintf(ns, y->total, format, p_list)) == -1)
     {
-      YFREE(ny);
+      YALLOC_FREE(y->allocator, ny);
       return (0);
     }
   ny->used = i;
-  YFREE(y);
+  YALLOC_FREE(y->allocator, y);
   *s = ns;
   va_end(p_list);
   return (1);
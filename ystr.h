@@ -9,7 +9,8 @@
  *		there is more allocated memory than used memory. It is usefull
  *		to extend the string without new memory allocation and copy. 
  *		And before the address of the first character of the string,
- *		there is two integers ; the first that contains the total
+ *		there is a pointer to the allocator of the string (NULL for
+ *		YMALLOC()) and two integers ; the first that contains the total
  *		allocated size (used string memory + '\0' + free memory size) ;
  *		the second that contains the used memory size. The used size 
  *		doesn't count the ending '\0' character of the string.
@@ -26,6 +27,7 @@ extern "C" {
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
+#include "ydefs.h"
 
 /*! @define YSTR_SIZE Default size for ystrings. */
 #define YSTR_SIZE	4096
@@ -39,11 +41,13 @@ extern "C" {
 /*!
  * @struct	ystr_head_s
  *		Structure used for the head of ystrings.
- * @field	total	Total size of the ystring.
- * @field	used	Used size of the ystring.
+ * @field	allocator	Allocator of the ystring, NULL for YMALLOC().
+ * @field	total		Total size of the ystring.
+ * @field	used		Used size of the ystring.
  */
 struct ystr_head_s
 {
+  yalloc_t *allocator;
   unsigned int total;
   unsigned int used;
 };
@@ -63,6 +67,17 @@ typedef char* ystr_t;
  */
 ystr_t ys_new(const char *s);
 
+/*!
+ * @function	ys_new_in
+ *		Create a new ystring, whose memory is given by an allocator. The
+ *		ystring keeps using this allocator when it grows.
+ * @param	allocator	The allocator (NULL for YMALLOC()).
+ * @param	s		A character string that will be copied into the
+ *				ystring. Could be NULL to create an empty ystring.
+ * @return	The created ystring.
+ */
+ystr_t ys_new_in(yalloc_t *allocator, const char *s);
+
 /*!
  * @function	ys_copy
  *		Create a minimal ystring that contains a copy of the given string.
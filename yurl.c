@@ -3,6 +3,7 @@
 #include "ydefs.h"
 #include "ystr.h"
 #include "yurl.h"
+#include "yphash.h"
 
 static yurl_protocol_def_t _yurl_proto_table[] =
 {
@@ -21,6 +22,45 @@ static yurl_protocol_def_t _yurl_proto_table[] =
   {0, 0, 0}
 };
 
+/*
+** Minimal perfect hash of the protocol strings of _yurl_proto_table (the
+** indexes are positions in this table). Generated by yphash_dump_c(); it
+** must be generated again when the table is modified.
+*/
+static const long _yurl_proto_phash_displacements[] = {
+	-1, 1, 0, -2, -3, -4, -5, -6,
+	-7, -8, -9, -12
+};
+static const char * const _yurl_proto_phash_keys[] = {
+	"mailto",
+	"telnet",
+	"nntp",
+	"file",
+	"pop",
+	"smtp",
+	"http",
+	"wais",
+	"ftp",
+	"oabp",
+	"https",
+	""
+};
+static const size_t _yurl_proto_phash_key_lens[] = {
+	6, 6, 4, 4, 3, 4, 4, 4,
+	3, 4, 5, 0
+};
+static const size_t _yurl_proto_phash_indexes[] = {
+	2, 7, 6, 10, 4, 3, 0, 8,
+	5, 9, 1, 11
+};
+static const yphash_t _yurl_proto_phash = {
+	12,
+	_yurl_proto_phash_displacements,
+	_yurl_proto_phash_keys,
+	_yurl_proto_phash_key_lens,
+	_yurl_proto_phash_indexes
+};
+
 /*
 ** yurl_create()
 ** Create a yurl_t. Parameters are copied.
@@ -61,14 +101,12 @@ yurl_t *yurl_parse(const char *url, ybool_t strict)
   /* search for protocol */
   if ((pt = strstr(url, "://")))
     {
-      int i;
-      for (i = 0; _yurl_proto_table[i].string; ++i)
-	if (!strncmp(_yurl_proto_table[i].string, url, pt - url))
-	  {
-	    res->proto = _yurl_proto_table[i].proto;
-	    res->port = _yurl_proto_table[i].port;
-	    break ;
-	  }
+      size_t i;
+      if ((i = yphash_search(&_yurl_proto_phash, url, pt - url)) != YPHASH_NOT_FOUND)
+	{
+	  res->proto = _yurl_proto_table[i].proto;
+	  res->port = _yurl_proto_table[i].port;
+	}
       url = pt + strlen("://");
     }
   /* search for login/password and authentication type*/
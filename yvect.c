@@ -1,3 +1,5 @@
+#define YMEM_TAG	YMEM_TAG_VECT
+
 #include <string.h>
 #include <stdio.h>
 #include "ydefs.h"
@@ -16,16 +18,26 @@ yvect_t yv_new() {
  * Creates a new yvector of the given size.
  */
 yvect_t yv_create(yv_size_t size) {
+	return (yv_create_in(NULL, size));
+}
+
+/*
+ * yv_create_in()
+ * Creates a new yvector of the given size, whose memory is given by an allocator.
+ */
+yvect_t yv_create_in(yalloc_t *allocator, yv_size_t size) {
 	void		**nv;
 	yvect_head_t	*y;
 
-	if (!(nv = (void**)YMALLOC((size * sizeof(void*)) +
-				   sizeof(yvect_head_t))))
+	if (!(nv = (void**)YALLOC_MALLOC_RAW(allocator, (size * sizeof(void*)) +
+					 sizeof(yvect_head_t))))
 		return (NULL);
 	y = (yvect_head_t*)nv;
 	nv = (void**)((void*)nv + sizeof(yvect_head_t));
+	y->allocator = allocator;
 	y->total = size;
 	y->used = 0;
+	y->stamp = 0;
 	*nv = NULL;
 	return ((yvect_t)nv);
 }
@@ -45,7 +57,7 @@ void yv_del(yvect_t *v, void (*f)(void*, void*), void *data)
   if (f)
     for (i = 0; i < y->used; ++i)
       f((*v)[i], data);
-  YFREE(y);
+  YALLOC_FREE(y->allocator, y);
   *v = NULL;
 }
 
@@ -80,21 +92,23 @@ int yv_setsz(yvect_t *v, size_t sz)
 
   if (!v || !*v)
     return (0);
-  y = (yvect_head_t*)((void*)**v - sizeof(yvect_head_t));
+  y = (yvect_head_t*)((void*)*v - sizeof(yvect_head_t));
   if (sz < y->total)
     return (1);
   leap = (sz < YVECT_SIZE_BIG) ? YVECT_SIZE_DEFAULT :
     (sz < YVECT_SIZE_HUGE) ? YVECT_SIZE_BIG : YVECT_SIZE_HUGE;
   totalsz = (((sz + 1) / leap) + 1) * leap;
-  if (!(nv = (void**)YMALLOC((totalsz * sizeof(void*)) +
+  if (!(nv = (void**)YALLOC_MALLOC_RAW(y->allocator, (totalsz * sizeof(void*)) +
 			     sizeof(yvect_head_t))))
     return (0);
   ny = (yvect_head_t*)nv;
   nv = (void**)((void*)nv + sizeof(yvect_head_t));
   ny->total = totalsz;
+  ny->allocator = y->allocator;
+  ny->stamp = y->stamp;
   ny->used = y->used;
-  memcpy(nv, **v, (y->used + 1) * sizeof(void*));
-  YFREE(y);
+  memcpy(nv, *v, (y->used + 1) * sizeof(void*));
+  YALLOC_FREE(y->allocator, y);
   *v = nv;
   return (1);
 }
@@ -133,16 +147,18 @@ int yv_cat(yvect_t *dest, yvect_t src)
   leap = (vectsz < YVECT_SIZE_BIG) ? YVECT_SIZE_DEFAULT :
     (vectsz < YVECT_SIZE_HUGE) ? YVECT_SIZE_BIG : YVECT_SIZE_HUGE;
   totalsz = (((vectsz + 1) / leap) + 1) * leap;
-  if (!(nv = (void**)YMALLOC((totalsz * sizeof(void*)) +
+  if (!(nv = (void**)YALLOC_MALLOC_RAW(y->allocator, (totalsz * sizeof(void*)) +
 			     sizeof(yvect_head_t))))
     return (0);
   ny = (yvect_head_t*)nv;
   nv = (void**)((void*)nv + sizeof(yvect_head_t));
   ny->total = totalsz;
+  ny->allocator = y->allocator;
+  ny->stamp = y->stamp;
   ny->used = vectsz;
   memcpy(nv, *dest, y->used * sizeof(void*));
   memcpy(nv + y->used, src, (srcsz + 1) * sizeof(void*));
-  YFREE(y);
+  YALLOC_FREE(y->allocator, y);
   *dest = nv;
   return (1);
 }
@@ -172,17 +188,19 @@ int yv_ncat(yvect_t *dest, yvect_t src, unsigned int n)
   leap = (vectsz < YVECT_SIZE_BIG) ? YVECT_SIZE_DEFAULT :
     (vectsz < YVECT_SIZE_HUGE) ? YVECT_SIZE_BIG : YVECT_SIZE_HUGE;
   totalsz = (((vectsz + 1) / leap) + 1) * leap;
-  if (!(nv = (void**)YMALLOC((totalsz * sizeof(void*)) +
+  if (!(nv = (void**)YALLOC_MALLOC_RAW(y->allocator, (totalsz * sizeof(void*)) +
 			     sizeof(yvect_head_t))))
     return (0);
   ny = (yvect_head_t*)nv;
   nv = (void**)((void*)nv + sizeof(yvect_head_t));
   ny->total = totalsz;
+  ny->allocator = y->allocator;
+  ny->stamp = y->stamp;
   ny->used = vectsz;
   memcpy(nv, *dest, y->used * sizeof(void*));
   memcpy(nv + y->used, src, n * sizeof(void*));
   nv[ny->used] = NULL;
-  YFREE(y);
+  YALLOC_FREE(y->allocator, y);
   *dest = nv;
   return (1);
 }
@@ -199,11 +217,13 @@ yvect_t yv_dup(yvect_t v)
   if (!v)
     return (NULL);
   y = (yvect_head_t*)((void*)v - sizeof(yvect_head_t));
-  if (!(nv = (void**)YMALLOC((y->total * sizeof(void*)) +
-			     sizeof(yvect_head_t))))
+  if (!(nv = (void**)YMALLOC_RAW((y->total * sizeof(void*)) +
+				 sizeof(yvect_head_t))))
     return (NULL);
   ny = (yvect_head_t*)nv;
   nv = (void**)((void*)nv + sizeof(yvect_head_t));
+  ny->allocator = NULL;
+  ny->stamp = y->stamp;
   ny->total = y->total;
   ny->used = y->used;
   memcpy(nv, v, (y->used + 1) * sizeof(void*));
@@ -249,16 +269,18 @@ int yv_put(yvect_t *v, void *e)
   leap = (vectsz < YVECT_SIZE_BIG) ? YVECT_SIZE_DEFAULT :
     (vectsz < YVECT_SIZE_HUGE) ? YVECT_SIZE_BIG : YVECT_SIZE_HUGE;
   totalsz = (((vectsz + 1) / leap) + 1) * leap;
-  if (!(nv = (void**)YMALLOC((totalsz * sizeof(void*)) +
+  if (!(nv = (void**)YALLOC_MALLOC_RAW(y->allocator, (totalsz * sizeof(void*)) +
 			     sizeof(yvect_head_t))))
     return (0);
   ny = (yvect_head_t*)nv;
   nv = (void**)((void*)nv + sizeof(yvect_head_t));
   ny->total = totalsz;
+  ny->allocator = y->allocator;
+  ny->stamp = y->stamp;
   ny->used = vectsz;
   nv[0] = e;
   memcpy((void*)((void*)nv + sizeof(void*)), *v, (y->used + 1) * sizeof(void*));
-  YFREE(y);
+  YALLOC_FREE(y->allocator, y);
   *v = nv;
   return (1);
 }
@@ -311,17 +333,19 @@ int yv_add(yvect_t *v, void *e)
   leap = (vectsz < YVECT_SIZE_BIG) ? YVECT_SIZE_DEFAULT :
     (vectsz < YVECT_SIZE_HUGE) ? YVECT_SIZE_BIG : YVECT_SIZE_HUGE;
   totalsz = (((vectsz + 1) / leap) + 1) * leap;
-  if (!(nv = (void**)YMALLOC((totalsz * sizeof(void*)) +
+  if (!(nv = (void**)YALLOC_MALLOC_RAW(y->allocator, (totalsz * sizeof(void*)) +
 			     sizeof(yvect_head_t))))
     return (0);
   ny = (yvect_head_t*)nv;
   nv = (void**)((void*)nv + sizeof(yvect_head_t));
   ny->total = totalsz;
+  ny->allocator = y->allocator;
+  ny->stamp = y->stamp;
   ny->used = vectsz;
   memcpy(nv, *v, y->used * sizeof(void*));
   nv[y->used] = e;
   nv[ny->used] = NULL;
-  YFREE(y);
+  YALLOC_FREE(y->allocator, y);
   *v = nv;
   return (1);
 }
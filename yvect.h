@@ -15,6 +15,7 @@ extern "C" {
 #endif /* __cplusplus || c_plusplus */
 
 #include <stdlib.h>
+#include "ydefs.h"
 
 /* ************** TYPE DEFINITIONS ************* */
 
@@ -40,13 +41,19 @@ typedef enum yv_size_e {
 /*!
  * @struct	yvect_head_s
  *		Structure used for the head of yvectors.
- * @field	total	Total size of the yvector.
- * @field	used	Used size of the yvector.
+ * @field	allocator	Allocator of the yvector, NULL for YMALLOC().
+ * @field	total		Total size of the yvector.
+ * @field	used		Used size of the yvector.
+ * @field	stamp		Counter left to the owner of the yvector, kept
+ *				when it grows (hash stacks count their changes
+ *				in it). Zero when the yvector is created.
  */
 struct yvect_head_s
 {
+  yalloc_t *allocator;
   size_t total;
   size_t used;
+  size_t stamp;
 };
 
 /*! @typedef yvect_head_t See yvect_head_s structure. */
@@ -72,6 +79,16 @@ yvect_t yv_new(void);
  */
 yvect_t yv_create(yv_size_t size);
 
+/*!
+ * @function	yv_create_in
+ *		Create a new yvector, whose memory is given by an allocator. The
+ *		yvector keeps using this allocator when it grows.
+ * @param	allocator	The allocator (NULL for YMALLOC()).
+ * @param	size		The initial size.
+ * @return	The created yvector.
+ */
+yvect_t yv_create_in(yalloc_t *allocator, yv_size_t size);
+
 /*!
  * @function	yv_del
  *		Delete an existing yvector.
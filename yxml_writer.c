@@ -0,0 +1,532 @@
+#define YMEM_TAG	YMEM_TAG_DOM
+
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "yscan.h"
+#include "yxml_writer.h"
+
+/**
+ * @typedef	_yxml_writer_target_t
+ *		Destination of a writer.
+ * @constant	_YXML_WRITER_FD		File descriptor.
+ * @constant	_YXML_WRITER_STREAM	FILE stream.
+ * @constant	_YXML_WRITER_STR	ystring.
+ */
+typedef enum _yxml_writer_target_e {
+	_YXML_WRITER_FD = 0,
+	_YXML_WRITER_STREAM,
+	_YXML_WRITER_STR
+} _yxml_writer_target_t;
+
+/**
+ * @typedef	_yxml_writer_level_t
+ *		Open element.
+ * @field	offset		Offset of its name in the names buffer.
+ * @field	has_child	YTRUE if it contains elements or comments.
+ * @field	has_text	YTRUE if it contains text or CDATA sections.
+ */
+typedef struct _yxml_writer_level_s {
+	size_t	offset;
+	ybool_t	has_child;
+	ybool_t	has_text;
+} _yxml_writer_level_t;
+
+/**
+ * @struct	yxml_writer_s
+ *		Streaming XML writer.
+ * @field	target		Type of destination.
+ * @field	fd		File descriptor.
+ * @field	stream		FILE stream.
+ * @field	str		Pointer to the ystring.
+ * @field	error		First output error.
+ * @field	indent		YTRUE to indent the elements.
+ * @field	started		YTRUE once something was written.
+ * @field	tag_open	YTRUE while the start tag of the current element
+ *				could receive attributes.
+ * @field	levels		Stack of open elements.
+ * @field	depth		Number of open elements.
+ * @field	levels_size	Number of elements the stack can hold.
+ * @field	names		Names of the open elements, one after the other.
+ * @field	names_len	Used size of the names buffer.
+ * @field	names_size	Size of the names buffer.
+ * @field	len		Used size of the output buffer.
+ * @field	buffer		Output buffer.
+ */
+struct yxml_writer_s {
+	_yxml_writer_target_t	target;
+	int			fd;
+	FILE			*stream;
+	ystr_t			*str;
+	yerr_t			error;
+	ybool_t			indent;
+	ybool_t			started;
+	ybool_t			tag_open;
+	_yxml_writer_level_t	*levels;
+	size_t			depth;
+	size_t			levels_size;
+	char			*names;
+	size_t			names_len;
+	size_t			names_size;
+	size_t			len;
+	char			buffer[YXML_WRITER_BUFFER_SIZE];
+};
+
+/** @define _YXML_WRITER_PUTS Write a string literal to the output buffer. */
+#define _YXML_WRITER_PUTS(w, s)	_yxml_writer_put((w), (s), sizeof(s) - 1)
+
+/* scan sets of the characters to escape, initialized once */
+static pthread_once_t _yxml_writer_sets_once = PTHREAD_ONCE_INIT;
+static yscan_set_t _yxml_writer_text_set;
+static yscan_set_t _yxml_writer_attr_set;
+
+/* *** definition of private functions *** */
+static yxml_writer_t *_yxml_writer_new(_yxml_writer_target_t target);
+static void _yxml_writer_init_sets(void);
+static yerr_t _yxml_writer_put(yxml_writer_t *w, const char *data, size_t len);
+static yerr_t _yxml_writer_output(yxml_writer_t *w, const char *data, size_t len);
+static yerr_t _yxml_writer_escape(yxml_writer_t *w, const char *s, const char *end,
+				  const yscan_set_t *set);
+static yerr_t _yxml_writer_content(yxml_writer_t *w, ybool_t is_text);
+static yerr_t _yxml_writer_newline(yxml_writer_t *w, size_t depth);
+
+/*
+ * yxml_writer_new_fd()
+ * Create a writer which writes to a file descriptor.
+ */
+yxml_writer_t *yxml_writer_new_fd(int fd) {
+	yxml_writer_t	*w;
+
+	if ((w = _yxml_writer_new(_YXML_WRITER_FD)) != NULL)
+		w->fd = fd;
+	return (w);
+}
+
+/*
+ * yxml_writer_new_stream()
+ * Create a writer which writes to a FILE stream.
+ */
+yxml_writer_t *yxml_writer_new_stream(FILE *stream) {
+	yxml_writer_t	*w;
+
+	if (stream == NULL)
+		return (NULL);
+	if ((w = _yxml_writer_new(_YXML_WRITER_STREAM)) != NULL)
+		w->stream = stream;
+	return (w);
+}
+
+/*
+ * yxml_writer_new_str()
+ * Create a writer which appends to a ystring.
+ */
+yxml_writer_t *yxml_writer_new_str(ystr_t *str) {
+	yxml_writer_t	*w;
+
+	if (str == NULL)
+		return (NULL);
+	if ((w = _yxml_writer_new(_YXML_WRITER_STR)) != NULL)
+		w->str = str;
+	return (w);
+}
+
+/*
+ * yxml_writer_del()
+ * Flush the output of a writer and delete it.
+ */
+yerr_t yxml_writer_del(yxml_writer_t *w) {
+	yerr_t	res;
+
+	if (w == NULL)
+		return (YEINVAL);
+	res = yxml_writer_flush(w);
+	YFREE(w->levels);
+	YFREE(w->names);
+	YFREE(w);
+	return (res);
+}
+
+/*
+ * yxml_writer_set_indent()
+ * Set the indentation of the elements.
+ */
+void yxml_writer_set_indent(yxml_writer_t *w, ybool_t indent) {
+	if (w != NULL)
+		w->indent = indent;
+}
+
+/*
+ * yxml_writer_declaration()
+ * Write the XML declaration.
+ */
+yerr_t yxml_writer_declaration(yxml_writer_t *w, const char *version, const char *encoding) {
+	if (w == NULL || w->started)
+		return (YEINVAL);
+	if (w->error != YENOERR)
+		return (w->error);
+	_YXML_WRITER_PUTS(w, "<?xml version=\"");
+	if (version == NULL)
+		version = "1.0";
+	_yxml_writer_put(w, version, strlen(version));
+	if (encoding != NULL) {
+		_YXML_WRITER_PUTS(w, "\" encoding=\"");
+		_yxml_writer_put(w, encoding, strlen(encoding));
+	}
+	_YXML_WRITER_PUTS(w, "\"?>\n");
+	w->started = YTRUE;
+	return (w->error);
+}
+
+/*
+ * yxml_writer_start_element()
+ * Open an element.
+ */
+yerr_t yxml_writer_start_element(yxml_writer_t *w, const char *name) {
+	_yxml_writer_level_t	*level;
+	void			*array;
+	size_t			name_len;
+	yerr_t			res;
+
+	if (w == NULL || name == NULL || !(name_len = strlen(name)))
+		return (YEINVAL);
+	if (w->depth == w->levels_size) {
+		if ((array = ygrow(w->levels, &w->levels_size,
+				   sizeof(_yxml_writer_level_t), w->depth, 16)) == NULL)
+			return (YENOMEM);
+		w->levels = array;
+	}
+	while (w->names_len + name_len > w->names_size) {
+		if ((array = ygrow(w->names, &w->names_size, 1,
+				   w->names_len, 16)) == NULL)
+			return (YENOMEM);
+		w->names = array;
+	}
+	if ((res = _yxml_writer_content(w, YFALSE)) != YENOERR)
+		return (res);
+	_YXML_WRITER_PUTS(w, "<");
+	_yxml_writer_put(w, name, name_len);
+	level = &w->levels[w->depth++];
+	level->offset = w->names_len;
+	level->has_child = level->has_text = YFALSE;
+	memcpy(w->names + w->names_len, name, name_len);
+	w->names_len += name_len;
+	w->tag_open = YTRUE;
+	return (w->error);
+}
+
+/*
+ * yxml_writer_attribute()
+ * Add an attribute to the element which was just opened.
+ */
+yerr_t yxml_writer_attribute(yxml_writer_t *w, const char *name, const char *value) {
+	if (w == NULL || name == NULL || !*name || !w->tag_open)
+		return (YEINVAL);
+	if (w->error != YENOERR)
+		return (w->error);
+	if (value == NULL)
+		value = "";
+	_YXML_WRITER_PUTS(w, " ");
+	_yxml_writer_put(w, name, strlen(name));
+	_YXML_WRITER_PUTS(w, "=\"");
+	_yxml_writer_escape(w, value, value + strlen(value), &_yxml_writer_attr_set);
+	_YXML_WRITER_PUTS(w, "\"");
+	return (w->error);
+}
+
+/*
+ * yxml_writer_end_element()
+ * Close the current element.
+ */
+yerr_t yxml_writer_end_element(yxml_writer_t *w) {
+	_yxml_writer_level_t	*level;
+
+	if (w == NULL || !w->depth)
+		return (YEINVAL);
+	if (w->error != YENOERR)
+		return (w->error);
+	level = &w->levels[--w->depth];
+	if (w->tag_open) {
+		_YXML_WRITER_PUTS(w, "/>");
+		w->tag_open = YFALSE;
+	} else {
+		if (level->has_child && !level->has_text)
+			_yxml_writer_newline(w, w->depth);
+		_YXML_WRITER_PUTS(w, "</");
+		_yxml_writer_put(w, w->names + level->offset, w->names_len - level->offset);
+		_YXML_WRITER_PUTS(w, ">");
+	}
+	w->names_len = level->offset;
+	if (!w->depth && w->indent)
+		_YXML_WRITER_PUTS(w, "\n");
+	return (w->error);
+}
+
+/*
+ * yxml_writer_text()
+ * Add text to the current element.
+ */
+yerr_t yxml_writer_text(yxml_writer_t *w, const char *text) {
+	if (text == NULL)
+		return (YEINVAL);
+	return (yxml_writer_ntext(w, text, strlen(text)));
+}
+
+/*
+ * yxml_writer_ntext()
+ * Add text of a given length to the current element.
+ */
+yerr_t yxml_writer_ntext(yxml_writer_t *w, const char *text, size_t len) {
+	yerr_t	res;
+
+	if (w == NULL || text == NULL || !w->depth)
+		return (YEINVAL);
+	if ((res = _yxml_writer_content(w, YTRUE)) != YENOERR)
+		return (res);
+	return (_yxml_writer_escape(w, text, text + len, &_yxml_writer_text_set));
+}
+
+/*
+ * yxml_writer_cdata()
+ * Add a CDATA section to the current element.
+ */
+yerr_t yxml_writer_cdata(yxml_writer_t *w, const char *text) {
+	const char	*pt;
+	yerr_t		res;
+
+	if (w == NULL || text == NULL || !w->depth)
+		return (YEINVAL);
+	if ((res = _yxml_writer_content(w, YTRUE)) != YENOERR)
+		return (res);
+	_YXML_WRITER_PUTS(w, "<![CDATA[");
+	/* "]]>" ends a section: the '>' goes to the next one */
+	while ((pt = strstr(text, "]]>")) != NULL) {
+		_yxml_writer_put(w, text, pt + 2 - text);
+		_YXML_WRITER_PUTS(w, "]]><![CDATA[");
+		text = pt + 2;
+	}
+	_yxml_writer_put(w, text, strlen(text));
+	_YXML_WRITER_PUTS(w, "]]>");
+	return (w->error);
+}
+
+/*
+ * yxml_writer_comment()
+ * Write a comment.
+ */
+yerr_t yxml_writer_comment(yxml_writer_t *w, const char *text) {
+	size_t	len;
+	yerr_t	res;
+
+	if (w == NULL || text == NULL || strstr(text, "--") != NULL ||
+	    ((len = strlen(text)) && text[len - 1] == '-'))
+		return (YEINVAL);
+	if ((res = _yxml_writer_content(w, YFALSE)) != YENOERR)
+		return (res);
+	_YXML_WRITER_PUTS(w, "<!--");
+	_yxml_writer_put(w, text, len);
+	_YXML_WRITER_PUTS(w, "-->");
+	if (!w->depth && w->indent)
+		_YXML_WRITER_PUTS(w, "\n");
+	return (w->error);
+}
+
+/*
+ * yxml_writer_end_document()
+ * Close all the open elements and flush the output.
+ */
+yerr_t yxml_writer_end_document(yxml_writer_t *w) {
+	yerr_t	res;
+
+	if (w == NULL)
+		return (YEINVAL);
+	while (w->depth)
+		if ((res = yxml_writer_end_element(w)) != YENOERR)
+			return (res);
+	return (yxml_writer_flush(w));
+}
+
+/*
+ * yxml_writer_flush()
+ * Write the content of the output buffer.
+ */
+yerr_t yxml_writer_flush(yxml_writer_t *w) {
+	if (w == NULL)
+		return (YEINVAL);
+	if (w->error == YENOERR && w->len)
+		_yxml_writer_output(w, w->buffer, w->len);
+	w->len = 0;
+	return (w->error);
+}
+
+/* *************** PRIVATE FUNCTIONS ************** */
+/*
+ * _yxml_writer_new()
+ * Create a writer.
+ */
+static yxml_writer_t *_yxml_writer_new(_yxml_writer_target_t target) {
+	yxml_writer_t	*w;
+
+	pthread_once(&_yxml_writer_sets_once, _yxml_writer_init_sets);
+	if ((w = YMALLOC_RAW(sizeof(yxml_writer_t))) == NULL)
+		return (NULL);
+	/* the output buffer is left uninitialized */
+	memset(w, 0, offsetof(yxml_writer_t, buffer));
+	w->target = target;
+	w->error = YENOERR;
+	return (w);
+}
+
+/*
+ * _yxml_writer_init_sets()
+ * Initialize the scan sets, once.
+ */
+static void _yxml_writer_init_sets(void) {
+	/* '>' is escaped for "]]>"; CR, and whitespaces in attribute
+	   values, are escaped to survive the normalizations of parsers */
+	yscan_set_init(&_yxml_writer_text_set, "&<>\r", 4);
+	yscan_set_init(&_yxml_writer_attr_set, "&<>\"\t\n\r", 7);
+}
+
+/*
+ * _yxml_writer_put()
+ * Add data to the output buffer, which is flushed when full.
+ */
+static yerr_t _yxml_writer_put(yxml_writer_t *w, const char *data, size_t len) {
+	if (w->error != YENOERR)
+		return (w->error);
+	if (w->len + len > YXML_WRITER_BUFFER_SIZE) {
+		if (yxml_writer_flush(w) != YENOERR)
+			return (w->error);
+		/* big chunks are not copied */
+		if (len >= YXML_WRITER_BUFFER_SIZE)
+			return (_yxml_writer_output(w, data, len));
+	}
+	memcpy(w->buffer + w->len, data, len);
+	w->len += len;
+	return (YENOERR);
+}
+
+/*
+ * _yxml_writer_output()
+ * Write data to the destination of a writer.
+ */
+static yerr_t _yxml_writer_output(yxml_writer_t *w, const char *data, size_t len) {
+	ssize_t		bytes;
+	unsigned int	chunk;
+
+	switch (w->target) {
+	case _YXML_WRITER_FD:
+		while (len) {
+			if ((bytes = write(w->fd, data, len)) < 0) {
+				if (errno == EINTR)
+					continue;
+				return (w->error = YEIO);
+			}
+			data += bytes;
+			len -= bytes;
+		}
+		break;
+	case _YXML_WRITER_STREAM:
+		if (fwrite(data, 1, len, w->stream) != len)
+			return (w->error = YEIO);
+		break;
+	case _YXML_WRITER_STR:
+		for (; len; data += chunk, len -= chunk) {
+			chunk = (len > YXML_WRITER_BUFFER_SIZE) ? YXML_WRITER_BUFFER_SIZE : len;
+			if (!ys_ncat(w->str, data, chunk))
+				return (w->error = YENOMEM);
+		}
+		break;
+	}
+	return (YENOERR);
+}
+
+/*
+ * _yxml_writer_escape()
+ * Write a text, escaping the characters of a set.
+ */
+static yerr_t _yxml_writer_escape(yxml_writer_t *w, const char *s, const char *end,
+				  const yscan_set_t *set) {
+	const char	*pt;
+
+	while (w->error == YENOERR) {
+		pt = yscan_find(s, end, set);
+		if (pt != s)
+			_yxml_writer_put(w, s, pt - s);
+		if (pt == end)
+			break;
+		switch (*pt) {
+		case '&':
+			_YXML_WRITER_PUTS(w, "&amp;");
+			break;
+		case '<':
+			_YXML_WRITER_PUTS(w, "&lt;");
+			break;
+		case '>':
+			_YXML_WRITER_PUTS(w, "&gt;");
+			break;
+		case '"':
+			_YXML_WRITER_PUTS(w, "&quot;");
+			break;
+		case '\t':
+			_YXML_WRITER_PUTS(w, "&#9;");
+			break;
+		case '\n':
+			_YXML_WRITER_PUTS(w, "&#10;");
+			break;
+		case '\r':
+			_YXML_WRITER_PUTS(w, "&#13;");
+			break;
+		}
+		s = pt + 1;
+	}
+	return (w->error);
+}
+
+/*
+ * _yxml_writer_content()
+ * Prepare the current element to receive some content: close its start
+ * tag, and indent the new line of a child.
+ */
+static yerr_t _yxml_writer_content(yxml_writer_t *w, ybool_t is_text) {
+	_yxml_writer_level_t	*level;
+
+	if (w->error != YENOERR)
+		return (w->error);
+	w->started = YTRUE;
+	if (w->tag_open) {
+		_YXML_WRITER_PUTS(w, ">");
+		w->tag_open = YFALSE;
+	}
+	if (!w->depth)
+		return (w->error);
+	level = &w->levels[w->depth - 1];
+	if (is_text)
+		level->has_text = YTRUE;
+	else {
+		level->has_child = YTRUE;
+		if (!level->has_text)
+			_yxml_writer_newline(w, w->depth);
+	}
+	return (w->error);
+}
+
+/*
+ * _yxml_writer_newline()
+ * Start a new indented line, if the writer indents the elements.
+ */
+static yerr_t _yxml_writer_newline(yxml_writer_t *w, size_t depth) {
+	static const char	tabs[] = "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t";
+	size_t			n;
+
+	if (!w->indent)
+		return (w->error);
+	_YXML_WRITER_PUTS(w, "\n");
+	for (; depth; depth -= n) {
+		n = (depth < sizeof(tabs) - 1) ? depth : (sizeof(tabs) - 1);
+		_yxml_writer_put(w, tabs, n);
+	}
+	return (w->error);
+}
@@ -0,0 +1,196 @@
+/* Process this file with the HeaderBrowser tool (http://www.headerbrowser.org)
+   to create documentation. */
+/*!
+ * @header	yxml_writer.h
+ * @abstract	Streaming XML writer.
+ * @discussion	An XML writer produces a document call after call, without
+ *		building a DOM tree. Its output goes through an internal buffer
+ *		to a file descriptor, a FILE stream or a ystring; nothing is
+ *		kept from the document but the names of the open elements, so
+ *		memory doesn't depend on the size of the document.<p />
+ *		Text and attribute values are escaped; CDATA sections which
+ *		contain "]]&gt;" are split. Names are written as is and must be
+ *		valid XML names. Carriage returns can't be kept in CDATA
+ *		sections. With indentation, each element starts on its own
+ *		line, indented by tabulations, unless its parent already holds
+ *		some text (text which follows is written as given).
+ *		<pre>yxml_writer_t *w = yxml_writer_new_fd(fd);
+ *yxml_writer_declaration(w, "1.0", "UTF-8");
+ *yxml_writer_start_element(w, "record");
+ *yxml_writer_attribute(w, "type", "book");
+ *yxml_writer_start_element(w, "title");
+ *yxml_writer_text(w, "Dungeons & Dragons");
+ *yxml_writer_end_document(w);
+ *yxml_writer_del(w);</pre>
+ * @version	1.0 Oct 19 2026
+ * @author	Amaury Bouchard <amaury@amaury.net>
+ */
+#ifndef __YXML_WRITER_H__
+#define __YXML_WRITER_H__
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif /* __cplusplus || c_plusplus */
+
+#include <stdio.h>
+#include "ydefs.h"
+#include "yerror.h"
+#include "ystr.h"
+
+/** @define YXML_WRITER_BUFFER_SIZE Size of the output buffer of a writer. */
+#define YXML_WRITER_BUFFER_SIZE	65536
+
+/*! @typedef yxml_writer_t Streaming XML writer (opaque structure). */
+typedef struct yxml_writer_s yxml_writer_t;
+
+/* ****************** FUNCTIONS **************** */
+/**
+ * @function	yxml_writer_new_fd
+ *		Create a writer which writes to a file descriptor.
+ * @param	fd	The file descriptor. It is not closed by the writer.
+ * @return	The writer, or NULL if an error occurs.
+ */
+yxml_writer_t *yxml_writer_new_fd(int fd);
+
+/**
+ * @function	yxml_writer_new_stream
+ *		Create a writer which writes to a FILE stream.
+ * @param	stream	The stream. It is neither flushed nor closed by the
+ *			writer.
+ * @return	The writer, or NULL if an error occurs.
+ */
+yxml_writer_t *yxml_writer_new_stream(FILE *stream);
+
+/**
+ * @function	yxml_writer_new_str
+ *		Create a writer which appends to a ystring.
+ * @param	str	Pointer to the ystring (it could be reallocated).
+ * @return	The writer, or NULL if an error occurs.
+ */
+yxml_writer_t *yxml_writer_new_str(ystr_t *str);
+
+/**
+ * @function	yxml_writer_del
+ *		Flush the output of a writer and delete it. Open elements are
+ *		not closed (see yxml_writer_end_document()).
+ * @param	w	The writer.
+ * @return	YENOERR if OK, or the first output error of the writer.
+ */
+yerr_t yxml_writer_del(yxml_writer_t *w);
+
+/**
+ * @function	yxml_writer_set_indent
+ *		Set the indentation of the elements. Disabled by default.
+ * @param	w	The writer.
+ * @param	indent	YTRUE to indent the elements.
+ */
+void yxml_writer_set_indent(yxml_writer_t *w, ybool_t indent);
+
+/**
+ * @function	yxml_writer_declaration
+ *		Write the XML declaration. Must be the first call.
+ * @param	w		The writer.
+ * @param	version		XML version (NULL for "1.0").
+ * @param	encoding	Encoding, or NULL to omit it.
+ * @return	YENOERR if OK, YEINVAL if something was already written,
+ *		or an output error.
+ */
+yerr_t yxml_writer_declaration(yxml_writer_t *w, const char *version, const char *encoding);
+
+/**
+ * @function	yxml_writer_start_element
+ *		Open an element. Its attributes could be written until any
+ *		content is given.
+ * @param	w	The writer.
+ * @param	name	Name of the element.
+ * @return	YENOERR if OK, YEINVAL if the name is empty, YENOMEM if an
+ *		allocation failed, or an output error.
+ */
+yerr_t yxml_writer_start_element(yxml_writer_t *w, const char *name);
+
+/**
+ * @function	yxml_writer_attribute
+ *		Add an attribute to the element which was just opened.
+ * @param	w	The writer.
+ * @param	name	Name of the attribute.
+ * @param	value	Value of the attribute (escaped by the writer).
+ * @return	YENOERR if OK, YEINVAL if the element has already some
+ *		content, or an output error.
+ */
+yerr_t yxml_writer_attribute(yxml_writer_t *w, const char *name, const char *value);
+
+/**
+ * @function	yxml_writer_end_element
+ *		Close the current element. An element without content is
+ *		written as an empty-element tag.
+ * @param	w	The writer.
+ * @return	YENOERR if OK, YEINVAL if no element is open, or an output
+ *		error.
+ */
+yerr_t yxml_writer_end_element(yxml_writer_t *w);
+
+/**
+ * @function	yxml_writer_text
+ *		Add text to the current element.
+ * @param	w	The writer.
+ * @param	text	The text (escaped by the writer).
+ * @return	YENOERR if OK, YEINVAL if no element is open, or an output
+ *		error.
+ */
+yerr_t yxml_writer_text(yxml_writer_t *w, const char *text);
+
+/**
+ * @function	yxml_writer_ntext
+ *		Add text of a given length to the current element.
+ * @param	w	The writer.
+ * @param	text	The text (escaped by the writer).
+ * @param	len	Length of the text.
+ * @return	YENOERR if OK, YEINVAL if no element is open, or an output
+ *		error.
+ */
+yerr_t yxml_writer_ntext(yxml_writer_t *w, const char *text, size_t len);
+
+/**
+ * @function	yxml_writer_cdata
+ *		Add a CDATA section to the current element.
+ * @param	w	The writer.
+ * @param	text	Content of the section (split where it contains
+ *			"]]&gt;").
+ * @return	YENOERR if OK, YEINVAL if no element is open, or an output
+ *		error.
+ */
+yerr_t yxml_writer_cdata(yxml_writer_t *w, const char *text);
+
+/**
+ * @function	yxml_writer_comment
+ *		Write a comment, inside the current element or outside the
+ *		root element.
+ * @param	w	The writer.
+ * @param	text	Content of the comment.
+ * @return	YENOERR if OK, YEINVAL if the text contains "--" or ends
+ *		with '-', or an output error.
+ */
+yerr_t yxml_writer_comment(yxml_writer_t *w, const char *text);
+
+/**
+ * @function	yxml_writer_end_document
+ *		Close all the open elements and flush the output.
+ * @param	w	The writer.
+ * @return	YENOERR if OK, or an output error.
+ */
+yerr_t yxml_writer_end_document(yxml_writer_t *w);
+
+/**
+ * @function	yxml_writer_flush
+ *		Write the content of the output buffer.
+ * @param	w	The writer.
+ * @return	YENOERR if OK, YEIO if the output failed (errors are kept:
+ *		every following call fails).
+ */
+yerr_t yxml_writer_flush(yxml_writer_t *w);
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif /* __cplusplus || c_plusplus */
+
+#endif /* __YXML_WRITER_H__ */